@@ -0,0 +1,198 @@
+/**
+    \file adcBlock.c
+    \brief Implementation file for the DTC-driven S12ADC block acquisition
+           library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <os.h>
+#include "platform.h"
+#include "trace.h"
+#include "adcBlock.h"
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** DTC transfer information, full-address mode. */
+typedef struct DTCTransferInfo_struct {
+    uint32_t mode;      /**< MRA (b31:b24) and MRB (b23:b16). */
+    uint32_t source;    /**< SAR: transfer source address. */
+    uint32_t dest;      /**< DAR: transfer destination address. */
+    uint32_t count;     /**< CRA (b31:b16) and CRB (b15:b0). */
+} DTCTransferInfo;
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/* MRA: MD = 00 normal transfer, SZ = 01 word, SM = 00 SAR fixed.
+   MRB: CHNE = 0 no chain, DISEL = 0 interrupt CPU after last transfer,
+        DTS = 0, DM = 10 DAR incremented. */
+
+/** DTC transfer mode for S12ADC result to sample block. */
+#define DTC_MODE_ADC_BLOCK ((0x10ul << 24) | (0x08ul << 16))
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Double-buffered sample block. */
+static uint16_t blocks[2][ADC_BLOCK_SIZE];
+
+/** DTC vector table. Must be placed at a 1 KB aligned address. */
+#pragma section B DTC_VECT
+static uint32_t dtcVectorTable[256];
+#pragma section
+
+/** DTC transfer information for the S12ADI0 activation source. */
+static DTCTransferInfo adcTransfer;
+
+/** Index of the block being filled by the DTC. */
+static volatile uint8_t fillIndex = 0;
+
+/** Number of blocks completed since start. */
+static volatile uint32_t blocksDone = 0;
+
+/** Number of blocks taken by adcBlock_get(). */
+static uint32_t blocksTaken = 0;
+
+/** Number of blocks not taken before the next one completed. */
+static uint32_t overruns = 0;
+
+/** Task signaled when a block is complete. */
+static OS_TCB* consumerTCB;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief S12ADC scan end interrupt service routine, block complete.
+    \return None
+ */
+static void adcBlock_isr (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void adcBlock_init (OS_TCB* consumer) {
+    consumerTCB = consumer;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up the DTC and TMR0. */
+    MSTP(DTC) = 0;
+    MSTP(TMR0) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Transfer one result per scan from ADDR3 into the first block. */
+    adcTransfer.mode   = DTC_MODE_ADC_BLOCK;
+    adcTransfer.source = (uint32_t)&S12AD.ADDR3;
+    adcTransfer.dest   = (uint32_t)&blocks[0][0];
+    adcTransfer.count  = (uint32_t)ADC_BLOCK_SIZE << 16;
+
+    dtcVectorTable[VECT(S12AD,S12ADI0)] = (uint32_t)&adcTransfer;
+
+    /* Full-address mode, no transfer information read skip. */
+    DTC.DTCVBR = (uint32_t)dtcVectorTable;
+    DTC.DTCADMOD.BIT.SHORT = 0;
+    DTC.DTCCR.BIT.RRS = 0;
+
+    /* S12ADI0 activates the DTC instead of the CPU. */
+    DTCE(S12AD,S12ADI0) = 1;
+
+    /* Block complete interrupt goes to the CPU once DTCE is cleared. */
+    IPR(S12AD,S12ADI0) = 0x03;
+    IR(S12AD,S12ADI0) = 0;
+    IEN(S12AD,S12ADI0) = 1;
+
+    DTC.DTCST.BIT.DTCST = 1;
+
+    /* ADCSR: A/D Control Register
+    b6    ADCS     0 Single-scan mode
+    b4    ADIE     1 Scan end interrupt enabled (DTC activation)
+    b1    TRGE     1 Conversion started by trigger
+    b0    EXTRG    0 Trigger selected by ADSTRGR
+    */
+    S12AD.ADCSR.BYTE = 0x12;
+    S12AD.ADANS0.WORD = 0x0008; /* Read AN003, connected to JN1, 12. */
+    S12AD.ADSTRGR.BYTE = ADC_BLOCK_TRIGGER;
+
+    /* TMR0 compare match A clears the counter and triggers the S12ADC. */
+    TMR0.TCORA = ADC_BLOCK_TCORA;
+    TMR0.TCSR.BYTE = 0x10;      /* ADTE = 1: A/D trigger on compare match A. */
+    TMR0.TCR.BYTE = 0x08;       /* CCLR = 01: clear on compare match A. */
+    TMR0.TCCR.BYTE = 0x0B;      /* CSS = 01, CKS = 011: PCLK/64, start. */
+}
+
+const uint16_t* adcBlock_get (void) {
+    uint32_t done = blocksDone;
+
+    if ((done - blocksTaken) > 1u) {
+        overruns += done - blocksTaken - 1u;
+    }
+
+    blocksTaken = done;
+
+    /* The completed block is the one not being filled. */
+    return blocks[fillIndex ^ 1u];
+}
+
+uint32_t adcBlock_overruns (void) {
+    return overruns;
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#pragma interrupt (adcBlock_isr (vect=VECT(S12AD,S12ADI0)))
+void adcBlock_isr (void) {
+    OS_ERR err;
+    uint8_t next;
+
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_ADC_BLOCK);
+
+    /* Hand the full block over and let the DTC fill the other one. */
+    next = fillIndex ^ 1u;
+
+    adcTransfer.dest  = (uint32_t)&blocks[next][0];
+    adcTransfer.count = (uint32_t)ADC_BLOCK_SIZE << 16;
+
+    fillIndex = next;
+    blocksDone++;
+
+    /* The DTC cleared DTCE after the last transfer; re-arm it. */
+    DTCE(S12AD,S12ADI0) = 1;
+
+    OSTaskSemPost(consumerTCB, OS_OPT_POST_NONE, &err);
+
+    TRACE_ISR_EXIT(TRACE_ISR_ADC_BLOCK);
+    OSIntExit();
+}
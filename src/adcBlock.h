@@ -0,0 +1,90 @@
+/**
+    \file adcBlock.h
+    \brief Header file for the DTC-driven S12ADC block acquisition library.
+    \details When enabled, TMR0 triggers PV conversions at
+             ADC_BLOCK_SAMPLE_HZ and the DTC moves each result into one half
+             of a double-buffered sample block. When a block is full the
+             S12ADI0 interrupt swaps the halves and wakes ControllerTask,
+             which filters and decimates the whole block at once. The default
+             settings keep the 10 ms control period (64 samples at 6400 Hz).
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef ADCBLOCK_H
+#define ADCBLOCK_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <os.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Block acquisition enable flag. When disabled the PV is polled. */
+#define ADC_BLOCK_ENABLED (0)
+
+/** Number of samples per block (16 - 1024). */
+#define ADC_BLOCK_SIZE (64u)
+
+/** Number of samples averaged into each decimated sample. */
+#define ADC_BLOCK_DECIMATION (ADC_BLOCK_SIZE)
+
+/** Number of decimated samples per block. */
+#define ADC_BLOCK_OUT_SIZE (ADC_BLOCK_SIZE / ADC_BLOCK_DECIMATION)
+
+/** S12ADC sample rate in Hz. */
+#define ADC_BLOCK_SAMPLE_HZ (6400u)
+
+/** Peripheral clock feeding TMR0, in Hz. */
+#define ADC_BLOCK_PCLK_HZ (48000000u)
+
+/** TMR0 compare match A value for PCLK/64 count source. */
+#define ADC_BLOCK_TCORA ((ADC_BLOCK_PCLK_HZ / 64u) / ADC_BLOCK_SAMPLE_HZ - 1u)
+
+/** S12ADC start trigger: TMR0 compare match A (TMTRG0AN_0). */
+#define ADC_BLOCK_TRIGGER (0x09)
+
+#if ((ADC_BLOCK_SIZE % ADC_BLOCK_DECIMATION) != 0)
+#error "ADC_BLOCK_SIZE must be a multiple of ADC_BLOCK_DECIMATION."
+#endif
+
+#if (ADC_BLOCK_TCORA > 255u)
+#error "ADC_BLOCK_SAMPLE_HZ too low for the 8-bit TMR0."
+#endif
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize TMR0, S12ADC and DTC and start block acquisition.
+    \param consumer Task to be signaled, through its task semaphore, every
+           time a block is complete.
+    \return None
+ */
+void adcBlock_init (OS_TCB* consumer);
+
+/**
+    \brief Get the most recently completed sample block.
+    \details The block stays valid until the DTC finishes filling the other
+             half, i.e. for one block period.
+    \return Pointer to ADC_BLOCK_SIZE raw S12ADC samples.
+ */
+const uint16_t* adcBlock_get (void);
+
+/**
+    \brief Get number of blocks completed before the previous one was taken.
+    \return Block overrun count.
+ */
+uint32_t adcBlock_overruns (void);
+
+#endif /* ADCBLOCK_H */
@@ -19,19 +19,127 @@
 ******************************************************************************/
 
 #include <includes.h>
-#include <stdio.h>
+#include "platform.h"
 
 
 
 /******************************************************************************
-*                              TYPE DEFINITIONS                               *
+*                            CONFIGURATION CHECKS                             *
 ******************************************************************************/
 
-/** Screen control structure. */
-typedef struct ScreenControl_struct {
-    uint8_t update;     /**< Screen update flag. */
-    uint8_t action;     /**< Requested action, indicated by button press. */
-} ScreenControl;
+#if (FAST_LOOP_ENABLED) && (ADC_BLOCK_ENABLED)
+#error "FAST_LOOP_ENABLED and ADC_BLOCK_ENABLED are mutually exclusive."
+#endif
+
+#if (LOOP_TIMING_ENABLED) && defined(CPU_CFG_TS_TMR_SIZE)
+#if (CPU_CFG_TS_TMR_SIZE < CPU_WORD_SIZE_32)
+#error "Loop timing needs a 32-bit timestamp timer."
+#endif
+#endif
+
+#if (TRACE_ENABLED) && defined(CPU_CFG_TS_TMR_SIZE)
+#if (CPU_CFG_TS_TMR_SIZE < CPU_WORD_SIZE_32)
+#error "Event trace needs a 32-bit timestamp timer."
+#endif
+#endif
+
+#if (TRACE_ENABLED) && (OS_CFG_APP_HOOKS_EN == 0u)
+#error "Event trace needs OS_CFG_APP_HOOKS_EN for task switch events."
+#endif
+
+#if (MEM_BUDGET_ENABLED) && !(STATS_ENABLED)
+#error "The memory budget samples stacks from the statistics coroutine."
+#endif
+
+#if (TELEMETRY_ENABLED) && ((TELEMETRY_FRAME_SIZE * 10u * 1000u) >         \
+     (TELEMETRY_BAUD * CONTROLLER_TASK_PERIOD_MS * TELEMETRY_DECIMATION))
+#error "The telemetry stream is faster than its bit rate."
+#endif
+
+#if (DISPLAY_MIN_PERIOD_MS < UI_TASK_PERIOD_MS)
+#error "The display refresh releases the UI task faster than its table period."
+#endif
+
+/* Response time analysis of the task table, with the kernel tick. */
+RTA_CHECK(APP_TASK_TABLE_INDIRECT,
+          (1000000u / OS_CFG_TICK_RATE_HZ, APP_TICK_BUDGET_US));
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Control loop period, in kernel ticks; rounded up. */
+#define CONTROLLER_PERIOD_TICKS \
+    (((CONTROLLER_TASK_PERIOD_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Control cycle completion deadline after its release, in kernel ticks. */
+#define CONTROLLER_DEADLINE_TICKS (CONTROLLER_PERIOD_TICKS)
+
+/** Control cycle overrun policy. */
+#define CONTROLLER_OVERRUN_POLICY (DEADLINE_SKIP)
+
+/** Controller output raw value driven while the deadline alarm is on. */
+#define CONTROLLER_SAFE_OP (U_MIN)
+
+/** LED lit while the deadline alarm is on. */
+#define DEADLINE_ALARM_LED (LED15)
+
+/** Deadlines are monitored when the task loop paces the controller. */
+#define DEADLINE_MONITORED \
+    ((DEADLINE_ENABLED) && !(FAST_LOOP_ENABLED) && !(ADC_BLOCK_ENABLED))
+
+/** Minimum time between LCD value refreshes, in kernel ticks. */
+#define REFRESH_LCD_PERIOD_TICKS \
+    (((DISPLAY_MIN_PERIOD_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Task statistics collection period, in kernel ticks. */
+#define STATS_PERIOD_TICKS \
+    (((STATS_PERIOD_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** UDP monitoring service poll period, in kernel ticks. */
+#define NET_POLL_TICKS \
+    (((NET_SERVICE_POLL_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Modbus slave line error check period, in kernel ticks. */
+#define MODBUS_POLL_TICKS \
+    (((MODBUS_SLAVE_POLL_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Console line error check period, in kernel ticks. */
+#define CONSOLE_POLL_TICKS \
+    (((CONSOLE_SERIAL_POLL_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Switch sampling period, in kernel ticks; rounded up, at least one. */
+#define DEBOUNCE_PERIOD_TICKS \
+    (((DEBOUNCE_PERIOD_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Declare the control block and stack of a task of the table. */
+#define APP_TASK_DECLARE(unused, task, name, prio, periodMs, budgetUs, stk) \
+    static OS_TCB task##TCB;                                                \
+    static CPU_STK task##Stk[stk];
+
+/** Create a task of the table. */
+#define APP_TASK_CREATE(p_err, task, name, prio, periodMs, budgetUs, stk)   \
+    OSTaskCreate((OS_TCB     *)&task##TCB,                                  \
+                 (CPU_CHAR   *)name,                                        \
+                 (OS_TASK_PTR ) task,                                       \
+                 (void       *) 0,                                          \
+                 (OS_PRIO     ) prio,                                       \
+                 (CPU_STK    *)&task##Stk[0],                               \
+                 (CPU_STK_SIZE) stk / 10u,                                  \
+                 (CPU_STK_SIZE) stk,                                        \
+                 (OS_MSG_QTY  ) 0u,                                         \
+                 (OS_TICK     ) 0u,                                         \
+                 (void       *) 0,                                          \
+                 (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR), \
+                 (OS_ERR     *)p_err);
 
 
 
@@ -39,36 +147,66 @@ typedef struct ScreenControl_struct {
 *                               LOCAL VARIABLES                               *
 ******************************************************************************/
 
-/* Declare task control blocks. */
-static OS_TCB AppTaskStartTCB;
-static OS_TCB ControllerTaskTCB;
-static OS_TCB SwitchDebounceTaskTCB;
-static OS_TCB RefreshLCDTaskTCB;
+/* Start task stack and control block, in one region so that both are
+   reclaimed as the memory pool once the task is deleted. */
+static struct {
+    CPU_STK stk[APP_TASK_START_STK_SIZE];
+    OS_TCB tcb;
+} AppTaskStartMem;
+
+/* Declare task control blocks and CPU stacks. */
+APP_TASK_TABLE(APP_TASK_DECLARE, 0)
+
+/* Declare UI coroutines and their scheduler. */
+static CoroutineScheduler UIScheduler;
+static Coroutine SwitchDebounceCoroutineCB;
+static Coroutine RefreshLCDCoroutineCB;
+#if (STATS_ENABLED)
+static Coroutine StatsCoroutineCB;
+#endif
+#if (NET_SERVICE_ENABLED)
+static Coroutine NetCoroutineCB;
+#endif
+#if (MODBUS_SLAVE_ENABLED)
+static Coroutine ModbusCoroutineCB;
+#endif
+#if (CONSOLE_SERIAL_ENABLED)
+static Coroutine ConsoleCoroutineCB;
+#endif
+
+#if (DEADLINE_MONITORED)
+/** Control cycle deadline monitor; written by the controller task. */
+static DeadlineMonitor controllerDeadline;
+#endif
 
-/* Declare task CPU stacks. */
-static CPU_STK AppTaskStartStk[APP_TASK_START_STK_SIZE];
-static CPU_STK ControllerTaskStk[CONTROLLER_TASK_STK_SIZE];
-static CPU_STK SwitchDebounceTaskStk[SWITCH_DEBOUNCE_TASK_STK_SIZE];
-static CPU_STK RefreshLCDTaskStk[REFRESH_LCD_TASK_STK_SIZE];
+/** Queue of button actions pending for the menu. */
+EventQueue screenQueue = {0, 0, 0, {0}};
 
-/** System control function pointer. */
-void  (*sysControl)(uint8_t) = onOffSelectionControl;
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
 
-/** Menu control function pointer. */
-void (*menuControl)(uint8_t) = onOffSelectionMenu;
+/** Engineering unit range of each signal (0 - 1023 raw to 0 - 100 %). */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
 
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
 
-/** Screen control structure variable. */
-ScreenControl screen = {0, 0};
+#if (WCET_ENABLED)
+/** Execution time table, read with the debugger. */
+static char wcetReport[WCET_TEXT_SIZE];
+#endif
 
-/** Cursor control structure variable. */
-CursorControl cursor = {ON_OFF_SEL, VIEW};
+#if (MEM_BUDGET_ENABLED)
+/** Generated stack size header, read with the debugger. */
+static char memBudgetReport[MEM_BUDGET_TEXT_SIZE];
+#endif
 
 /** PID control structure variable. */
-PIDControl pid  = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-/** General controller control structure variable. */
-ControllerControl controller = {ON_OFF_SEL, VIEW};
+PIDControl pid  = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
 
 
 /** Array of current and previous setpoint values. */
@@ -113,35 +251,81 @@ static void AppTaskStart (void *p_arg);
 static void ControllerTask (void *p_arg);
 
 /**
-    \brief Switch debounce task.
-    \details Reads the input from switches and does some debouncing.
-    \param p_arg Argument passed to 'SwitchDebounceTask()' by 'OSTaskCreate()'.
+    \brief User interface task.
+    \details Runs the user interface coroutines. Sleeps until the earliest
+             coroutine deadline or until posted by a switch interrupt or by
+             a displayed value change.
+    \param p_arg Argument passed to 'UITask()' by 'OSTaskCreate()'.
     \return None.
     \note The first line of code is used to prevent a compiler warning because
           'p_arg' is not used. The compiler should not generate any code for
           this statement.
  */
-static void SwitchDebounceTask (void *p_arg);
+static void UITask (void *p_arg);
 
 /**
-    \brief Refresh LCD task.
-    \details Refreshes the LCD screen with new values from variables and
-             switch input.
-    \param p_arg Argument passed to 'RefreshLCDTask()' by 'OSTaskCreate()'.
-    \return None.
-    \note The first line of code is used to prevent a compiler warning because
-          'p_arg' is not used. The compiler should not generate any code for
-          this statement.
+    \brief Switch debounce coroutine.
+    \details Reads the input from switches, debounces it and queues the
+             button actions for the menu.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
  */
-static void RefreshLCDTask (void *p_arg);
+static uint8_t SwitchDebounceCoroutine (Coroutine* cr);
 
 /**
-    \brief Insert new value into an array of int16_t values.
-    \param array Pointer to array of values in which to insert new value.
-    \param data New value to insert.
-    \return None.
+    \brief Refresh LCD coroutine.
+    \details Performs the menu transitions requested by switch input and
+             redraws only the LCD fields that changed, at most once per
+             REFRESH_LCD_PERIOD_TICKS for value changes.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
+ */
+static uint8_t RefreshLCDCoroutine (Coroutine* cr);
+
+#if (STATS_ENABLED)
+/**
+    \brief Task statistics coroutine.
+    \details Collects the task statistics once per STATS_PERIOD_TICKS and
+             marks the diagnostics values for redrawing.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
  */
-void insertArray (int16_t* array, int16_t data);
+static uint8_t StatsCoroutine (Coroutine* cr);
+#endif
+
+#if (NET_SERVICE_ENABLED)
+/**
+    \brief UDP monitoring service coroutine.
+    \details Polls the service once per NET_POLL_TICKS: applies received
+             commands and sends the due sample batches and status.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
+ */
+static uint8_t NetCoroutine (Coroutine* cr);
+#endif
+
+#if (MODBUS_SLAVE_ENABLED)
+/**
+    \brief Modbus RTU slave coroutine.
+    \details Serves each request as its frame ends, and clears the line
+             errors once per MODBUS_POLL_TICKS.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
+ */
+static uint8_t ModbusCoroutine (Coroutine* cr);
+#endif
+
+#if (CONSOLE_SERIAL_ENABLED)
+/**
+    \brief Serial command console coroutine.
+    \details Runs each command line as it ends, sends the trace dump a
+             reply buffer at a time, and clears the line errors once per
+             CONSOLE_POLL_TICKS.
+    \param cr Pointer to coroutine control structure.
+    \return Coroutine status.
+ */
+static uint8_t ConsoleCoroutine (Coroutine* cr);
+#endif
 
 
 
@@ -165,7 +349,9 @@ int main (void) {
     switches_initialize();
     S12ADC_init();
     DAC_init();
+    initUnits();
     printMainMenu();
+    frameBuffer_flush();
 
     /* Disable all interrupts. */
     CPU_IntDis();
@@ -174,12 +360,12 @@ int main (void) {
     OSInit(&err);
 
     /* Create the start task. */
-    OSTaskCreate((OS_TCB     *)&AppTaskStartTCB,
+    OSTaskCreate((OS_TCB     *)&AppTaskStartMem.tcb,
                  (CPU_CHAR   *)"App Task Start",
                  (OS_TASK_PTR ) AppTaskStart,
                  (void       *) 0,
                  (OS_PRIO     ) APP_TASK_START_PRIO,
-                 (CPU_STK    *)&AppTaskStartStk[0],
+                 (CPU_STK    *)&AppTaskStartMem.stk[0],
                  (CPU_STK_SIZE) APP_TASK_START_STK_SIZE / 10u,
                  (CPU_STK_SIZE) APP_TASK_START_STK_SIZE,
                  (OS_MSG_QTY  ) 0u,
@@ -203,6 +389,14 @@ static void AppTaskStart (void *p_arg) {
 
     OS_ERR err;
 
+#if (TRACE_ENABLED) || (WCET_ENABLED)
+    CPU_ERR cpuErr;
+#endif
+
+#if (TRACE_ENABLED)
+    CPU_SR_ALLOC();
+#endif
+
     BSP_Init();         /* Initialize BSP functions. */
     CPU_Init();         /* Initialize the uC/CPU services. */
     OS_CPU_TickInit();  /* Initialize uC/OS periodic time source (SysTick). */
@@ -211,57 +405,59 @@ static void AppTaskStart (void *p_arg) {
     OSStatTaskCPUUsageInit(&err);
 #endif
 
-    /* Create PID controller task. */
-    OSTaskCreate((OS_TCB     *)&ControllerTaskTCB,
-                 (CPU_CHAR   *)"Controller Task",
-                 (OS_TASK_PTR ) ControllerTask,
-                 (void       *) 0,
-                 (OS_PRIO     ) CONTROLLER_TASK_PRIO,
-                 (CPU_STK    *)&ControllerTaskStk[0],
-                 (CPU_STK_SIZE) CONTROLLER_TASK_STK_SIZE / 10u,
-                 (CPU_STK_SIZE) CONTROLLER_TASK_STK_SIZE,
-                 (OS_MSG_QTY  ) 0u,
-                 (OS_TICK     ) 0u,
-                 (void       *) 0,
-                 (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
-                 (OS_ERR     *)&err);
+#if (WCET_ENABLED)
+    /* Time the hot functions before any task uses their state. */
+    wcet_run(CPU_TS_TmrFreqGet(&cpuErr));
+    wcet_format(wcetReport);
+#endif
 
-    /* Create switch debounce task. */
-    OSTaskCreate((OS_TCB     *)&SwitchDebounceTaskTCB,
-                 (CPU_CHAR   *)"Switch Debounce Task",
-                 (OS_TASK_PTR ) SwitchDebounceTask,
-                 (void       *) 0,
-                 (OS_PRIO     ) SWITCH_DEBOUNCE_TASK_PRIO,
-                 (CPU_STK    *)&SwitchDebounceTaskStk[0],
-                 (CPU_STK_SIZE) SWITCH_DEBOUNCE_TASK_STK_SIZE / 10u,
-                 (CPU_STK_SIZE) SWITCH_DEBOUNCE_TASK_STK_SIZE,
-                 (OS_MSG_QTY  ) 0u,
-                 (OS_TICK     ) 0u,
-                 (void       *) 0,
-                 (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
-                 (OS_ERR     *)&err);
+#if (TRACE_ENABLED)
+    /* Start the event trace; record every task switch from now on. */
+    trace_init(CPU_TS_TmrFreqGet(&cpuErr));
 
-    /* Create LCD refresh task. */
-    OSTaskCreate((OS_TCB     *)&RefreshLCDTaskTCB,
-                 (CPU_CHAR   *)"Refresh LCD Task",
-                 (OS_TASK_PTR ) RefreshLCDTask,
-                 (void       *) 0,
-                 (OS_PRIO     ) REFRESH_LCD_TASK_PRIO,
-                 (CPU_STK    *)&RefreshLCDTaskStk[0],
-                 (CPU_STK_SIZE) REFRESH_LCD_TASK_STK_SIZE / 10u,
-                 (CPU_STK_SIZE) REFRESH_LCD_TASK_STK_SIZE,
-                 (OS_MSG_QTY  ) 0u,
-                 (OS_TICK     ) 0u,
-                 (void       *) 0,
-                 (OS_OPT      )(OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR),
-                 (OS_ERR     *)&err);
+    CPU_CRITICAL_ENTER();
+    OS_AppTaskSwHookPtr = trace_taskSwitchHook;
+    CPU_CRITICAL_EXIT();
+#endif
+
+    /* Sleep in the idle task, across ticks with no deadline. */
+    tickless_init();
+
+#if (TELEMETRY_ENABLED)
+    /* Stream the loop state on SCI2 from the first control cycle. */
+    telemetry_init();
+#endif
+
+    /* Create the PID controller and user interface tasks. */
+    APP_TASK_TABLE(APP_TASK_CREATE, &err)
+
+#if (STATS_ENABLED)
+    /* Register application and kernel tasks for statistics. */
+    stats_addTask(&ControllerTaskTCB, "CTRL");
+    stats_addTask(&UITaskTCB, "UI");
+    stats_addTask(&OSTickTaskTCB, "TICK");
+    stats_addTask(&OSStatTaskTCB, "STAT");
+    stats_addTask(&OSIdleTaskTCB, "IDLE");
+#endif
+
+#if (MEM_BUDGET_ENABLED)
+    /* Register task stacks for the memory budget. */
+    memBudget_addTask(&AppTaskStartMem.tcb, "APP_TASK_START");
+    memBudget_addTask(&ControllerTaskTCB, "CONTROLLER_TASK");
+    memBudget_addTask(&UITaskTCB, "UI_TASK");
+#endif
 
 #ifdef CPU_CFG_INT_DIS_MEAS_EN
     CPU_IntDisMeasMaxCurReset();
 #endif
 
+#if (MEM_BUDGET_ENABLED)
+    /* The deepest use of this stack is behind us. */
+    memBudget_retire(&AppTaskStartMem.tcb);
+#endif
+
     /* Delete task because its work is complete. */
-    OSTaskDel(&AppTaskStartTCB, &err);
+    OSTaskDel(&AppTaskStartMem.tcb, &err);
 
     while (DEF_ON) {
         ; /* Should not get here! */
@@ -273,18 +469,123 @@ static void ControllerTask (void *p_arg) {
 
     OS_ERR err;
 
+#if (FAST_LOOP_ENABLED)
+    FastLoopSnapshot snapshot;
+#else
     int16_t pvADC_counts;
+#endif
+
+#if (ADC_BLOCK_ENABLED)
+    const uint16_t* block;
+    int16_t pvBlock[ADC_BLOCK_OUT_SIZE];
+#endif
+
+#if (LOOP_TIMING_ENABLED) && !(FAST_LOOP_ENABLED)
+    CPU_ERR cpuErr;
+#endif
+
+#if (DEADLINE_MONITORED)
+    bool deadlineAlarm;
+    uint32_t delay;
+#endif
+
+#if (TRACE_ENABLED)
+    /* Last traced SP; out of range so the first cycle records it. */
+    int16_t tracedSp = INT16_MIN;
+#endif
 
     initController();
 
+#if (LOOP_TIMING_ENABLED) && !(FAST_LOOP_ENABLED)
+    /* Histograms of the task loop timing, against the nominal period. */
+    loopTiming_init((uint32_t)(((uint64_t)CPU_TS_TmrFreqGet(&cpuErr) *
+                                CONTROLLER_TASK_PERIOD_MS) / 1000u));
+    loopTiming_enable(true);
+#endif
+
+#if (FAST_LOOP_ENABLED)
+    /* Start the interrupt-context fast loop. */
+    fastLoop_init();
+#elif (ADC_BLOCK_ENABLED)
+    /* Start DTC-driven block acquisition; this task is signaled per block. */
+    adcBlock_init(&ControllerTaskTCB);
+#elif (DEADLINE_MONITORED)
+    /* First release now; cycles follow an absolute release schedule. */
+    deadline_init(&controllerDeadline, CONTROLLER_PERIOD_TICKS,
+                  CONTROLLER_DEADLINE_TICKS, CONTROLLER_OVERRUN_POLICY,
+                  OSTimeGet(&err));
+#endif
+
     /* Task body, always written as an infinite loop. */
     while (DEF_ON) {
+#if (FAST_LOOP_ENABLED)
+        /* The control loop runs in the fast loop ISR; only take its
+           decimated snapshot for the UI and supervisory logic. */
+        if (fastLoop_getSnapshot(&snapshot)) {
+            pid.pv = snapshot.pv;
+            insertArray(pvArray, snapshot.pv);
+
+            if (pid.mode == PID_MAN) {
+                /* MANUAL MODE: SP follows PV. */
+                pid.sp = snapshot.sp;
+            } else {
+                /* AUTOMATIC MODE */
+                pid.er = snapshot.er;
+                pid.op = snapshot.op;
+            }
+
+            insertArray(spArray, snapshot.sp);
+            insertArray(erArray, snapshot.er);
+            insertArray(opArray, snapshot.op);
+        }
+#else
+#if (ADC_BLOCK_ENABLED)
+        /* Wait for the next sample block; the first one too. */
+        OSTaskSemPend(0u, OS_OPT_PEND_BLOCKING, (CPU_TS *)0, &err);
+#endif
+
+        LOOP_TIMING_MARK(LOOP_TIMING_TICK);
+
 #if (MY_DEBUG_ACTIVE)
         /* Turn debug pin on. */
         MY_DEBUG_1 = MY_DEBUG_ON;
 #endif
 
+#if (ADC_BLOCK_ENABLED)
+        /* Take the block completed by the DTC. */
+        block = adcBlock_get();
+#endif
+
+#if (DEADLINE_MONITORED)
+        if (pid.active == PID_OFF) {
+            /* Switching the controller off acknowledges the alarm. */
+            deadline_clearAlarm(&controllerDeadline);
+        }
+
+        deadlineAlarm = deadline_alarm(&controllerDeadline);
+
+        if (deadlineAlarm) {
+            /* A cycle missed its deadline under the safe policy: drive the
+               safe output instead of the controller. */
+            pid.op = CONTROLLER_SAFE_OP;
+            insertArray(opArray, pid.op);
+            DAC_set(pid.op);
+        }
+
+        DEADLINE_ALARM_LED = deadlineAlarm ? LED_ON : LED_OFF;
+
+        if ((pid.active == PID_ON) && !deadlineAlarm) {
+#else
         if (pid.active == PID_ON) {
+#endif
+#if (ADC_BLOCK_ENABLED)
+            /* Pre-filter and decimate the whole block in one pass. */
+            blockFilter_decimate(block, ADC_BLOCK_SIZE, ADC_BLOCK_DECIMATION,
+                                 pvBlock);
+
+            /* Control on the newest decimated sample. */
+            pvADC_counts = pvBlock[ADC_BLOCK_OUT_SIZE - 1u];
+#else
             /* Start PV ADC conversion. */
             pvADC_start();
 
@@ -298,7 +599,9 @@ static void ControllerTask (void *p_arg) {
 
             /* Discard two LSB to have the same resolution as DAC. */
             pvADC_counts = pvADC_counts >> 2;
+#endif
 
+            LOOP_TIMING_MARK(LOOP_TIMING_ADC);
 
             /* Save PV ADC value in PID control structure. */
             pid.pv = pvADC_counts;
@@ -330,11 +633,15 @@ static void ControllerTask (void *p_arg) {
                 pid.op = getOP_PID(opArray, erArray);
             }
 
+            LOOP_TIMING_MARK(LOOP_TIMING_PID);
+
             /* Save new OP value in data array. */
             insertArray(opArray, pid.op);
 
             /* Set DAC output with new OP value. */
             DAC_set(pid.op);
+
+            LOOP_TIMING_MARK(LOOP_TIMING_DAC);
         }
 
 #if (MY_DEBUG_ACTIVE)
@@ -342,153 +649,331 @@ static void ControllerTask (void *p_arg) {
         MY_DEBUG_1 = MY_DEBUG_OFF;
 #endif
 
+#if (LOOP_TIMING_ENABLED)
+        /* Count this cycle in the timing histograms. */
+        loopTiming_fold();
+#endif
+#endif
+
+        /* Publish loop state for the other tasks. */
+        pidSnapshot_publish(&pid);
+
+#if (TRACE_ENABLED)
+        /* Trace the cycle; SP only when it moves. */
+        if (pid.sp != tracedSp) {
+            tracedSp = pid.sp;
+            TRACE_SAMPLE(SIGNAL_SP, tracedSp);
+        }
+
+        TRACE_SAMPLE(SIGNAL_PV, pid.pv);
+        TRACE_SAMPLE(SIGNAL_OP, pid.op);
+#endif
+
+#if (TELEMETRY_ENABLED)
+        /* Queue the loop state for the telemetry stream. */
+        telemetry_put(pid.sp, pid.pv, pid.op, pid.er);
+#endif
+
+#if (NET_SERVICE_ENABLED)
+        /* Queue the loop state for the network batches. */
+        netService_put(pid.sp, pid.pv, pid.op, pid.er);
+#endif
+
+        /* Wake the UI if a displayed value changed. */
+        displayDirty_check(&pid);
+
+        /* Feed the trend chart; wake the UI once per new column. */
+        if (trend_sample(pid.pv, pid.sp)) {
+            displayDirty_set(DISPLAY_TREND);
+        }
+
+#if (DEADLINE_MONITORED)
+        /* Check the cycle deadline; wait for the next release. */
+        delay = deadline_end(&controllerDeadline, OSTimeGet(&err));
+
+        if (delay > 0u) {
+            OSTimeDly((OS_TICK)delay, OS_OPT_TIME_DLY, &err);
+        }
+#elif !(ADC_BLOCK_ENABLED)
         /* Start task delay. */
-        OSTimeDlyHMSM(0u,                       // Hours
-                      0u,                       // Minutes
-                      0u,                       // Seconds
-                      10u,                      // Milliseconds
-                      OS_OPT_TIME_HMSM_STRICT,  // STRICT or NON_STRICT
+        OSTimeDlyHMSM(0u,                           // Hours
+                      0u,                           // Minutes
+                      0u,                           // Seconds
+                      CONTROLLER_TASK_PERIOD_MS,    // Milliseconds
+                      OS_OPT_TIME_HMSM_STRICT,      // STRICT or NON_STRICT
                       &err);
+#endif
     }
 }
 
-static void SwitchDebounceTask (void *p_arg) {
+static void UITask (void *p_arg) {
     (void)&p_arg;
 
-    OS_ERR   err;
+    OS_ERR err;
 
-    /* Define and initialize new debounce control structure variable. */
-    static DebounceControlType switchCtrl = {0, 0xFF, 0xFF, 0};
+    uint32_t wait;
+
+    /* The start task has deleted itself; reuse its memory. */
+    memBudget_reclaim(&AppTaskStartMem, sizeof(AppTaskStartMem));
+
+    /* Displayed value changes wake this task. */
+    displayDirty_init(&UITaskTCB);
+
+    coroutine_schedInit(&UIScheduler);
+
+    /* Switches first, so actions reach the LCD in the same pass. */
+    coroutine_add(&UIScheduler, &SwitchDebounceCoroutineCB,
+                  SwitchDebounceCoroutine);
+    coroutine_add(&UIScheduler, &RefreshLCDCoroutineCB, RefreshLCDCoroutine);
+#if (STATS_ENABLED)
+    coroutine_add(&UIScheduler, &StatsCoroutineCB, StatsCoroutine);
+#endif
+#if (NET_SERVICE_ENABLED)
+    coroutine_add(&UIScheduler, &NetCoroutineCB, NetCoroutine);
+#endif
+#if (MODBUS_SLAVE_ENABLED)
+    coroutine_add(&UIScheduler, &ModbusCoroutineCB, ModbusCoroutine);
+#endif
+#if (CONSOLE_SERIAL_ENABLED)
+    coroutine_add(&UIScheduler, &ConsoleCoroutineCB, ConsoleCoroutine);
+#endif
 
     /* Task body, always written as an infinite loop. */
     while (DEF_ON) {
-        /* Read switches status. */
-        switchCtrl.current = read_switches();
-
-        /* If debouncing is currently in progress. */
-        if (switchCtrl.debounce) {
-            /* DEBOUNCE IN PROGRESS. */
-
-            /* Compare current switch status with previous status. */
-            if (switchCtrl.current == switchCtrl.previous) {
-                /* SWITCH STATUS UNCHAGED. */
-
-                /* Increment debounce counter. */
-                switchCtrl.counter++;
-
-                /* Check if max debounce counter value reached. */
-                if ((switchCtrl.counter == DEBOUNCE_MAX)) {
-                    /* BUTTON PRESSED AND DEBOUNCE TIME IS OVER. */
-
-                    /* Check which button was pressed. */
-                    switch (switchCtrl.current) {
-                        case SWITCH_1_ON:
-                            /* Perform button action. */
-                            (*sysControl)(1);
-
-                            /* Prepare action for screen control. */
-                            screen.action = 1;
-                        break;
-                        case SWITCH_2_ON:
-                            /* Perform button action. */
-                            (*sysControl)(2);
-
-                            /* Prepare action for screen control. */
-                            screen.action = 2;
-                        break;
-                        case SWITCH_3_ON:
-                            /* Perform button action. */
-                            (*sysControl)(3);
-
-                            /* Prepare action for screen control. */
-                            screen.action = 3;
-                        break;
-                        default:
-                            /* Any other value is error, do nothing. */
-                            nop();
-                        break;
-                    }
-
-                    /* Reset debounce counter. */
-                    switchCtrl.counter = 0;
-
-                    /* Turn off debounce-in-progress flag. */
-                    switchCtrl.debounce = 0;
-                }
-            } else {
-                /* SWITCH STATUS CHANGED WHEN DEBOUNCE WAS IN PROGRESS. */
+        wait = coroutine_run(&UIScheduler, OSTimeGet(&err));
 
-                /* Reset debounce counter. */
-                switchCtrl.counter = 0;
+        if (wait == 0u) {
+            /* A coroutine yielded; run the next pass right away. */
+            continue;
+        }
 
-                /* Turn off debounce-in-progress flag. */
-                switchCtrl.debounce = 0;
-            }
-        } else {
-            /* DEBOUNCE NOT IN PROGRESS. */
+        if (wait == COROUTINE_FOREVER) {
+            /* Only a switch interrupt or a value change can wake a
+               coroutine. */
+            wait = 0u;
+        }
+
+        /* Wait for a post or the earliest deadline. */
+        OSTaskSemPend((OS_TICK)wait, OS_OPT_PEND_BLOCKING, (CPU_TS *)0, &err);
+    }
+}
+
+static uint8_t SwitchDebounceCoroutine (Coroutine* cr) {
+    /* Debounce control structure variable; kept across waits. */
+    static DebounceControlType keyCtrl;
 
-            /* Compare current switch status with previous status. */
-            if (switchCtrl.current != switchCtrl.previous) {
-                /* SWITCH STATUS CHANGED. */
+    uint8_t events[DEBOUNCE_MAX_EVENTS];
+    uint8_t count;
+    uint8_t i;
 
-                /* Turn on debounce-in-progress flag. */
-                switchCtrl.debounce = 1;
+    COROUTINE_BEGIN(cr);
 
-                /* Update previous switch status with current status. */
-                switchCtrl.previous = switchCtrl.current;
+    debounce_init(&keyCtrl, DEBOUNCE_PERIOD_MS, SWITCH_REPEAT_KEYS);
+
+    while (DEF_ON) {
+#if (SWITCH_IRQ_ENABLED)
+        /* Nothing to debounce: sleep until a switch interrupt arrives. */
+        if (debounce_idle(&keyCtrl)) {
+            switches_irqArm(&UITaskTCB);
+
+            COROUTINE_WAIT_UNTIL(cr, switches_irqFired());
+        }
+#endif
+
+        /* Read switches status and debounce all of them at once. */
+        count = debounce_update(&keyCtrl, read_keys(), events);
+
+        for (i = 0; i < count; i++) {
+            TRACE_BUTTON(events[i]);
+
+            switch (KEY_EVENT_TYPE(events[i])) {
+                case KEY_EVENT_PRESS:
+                case KEY_EVENT_REPEAT:
+                    /* Prepare button action for the menu. */
+                    eventQueue_post(&screenQueue, KEY_EVENT_KEY(events[i]));
+                break;
+                default:
+                    /* Release and long press have no action yet. */
+                    nop();
+                break;
             }
         }
 
-        /* Start task delay. */
-        OSTimeDlyHMSM(0u,                       // Hours
-                      0u,                       // Minutes
-                      0u,                       // Seconds
-                      50u,                      // Milliseconds
-                      OS_OPT_TIME_HMSM_STRICT,  // STRICT or NON_STRICT
-                      &err);
+        COROUTINE_DELAY(cr, DEBOUNCE_PERIOD_TICKS);
     }
+
+    COROUTINE_END(cr);
 }
 
-static void RefreshLCDTask (void *p_arg) {
-    (void)&p_arg;
+static uint8_t RefreshLCDCoroutine (Coroutine* cr) {
+    PIDSnapshot state;
 
-    OS_ERR   err;
+    uint8_t action;
+    uint8_t regions;
+
+    COROUTINE_BEGIN(cr);
 
-    /* Task body, always written as an infinite loop. */
     while (DEF_ON) {
 #if (MY_DEBUG_ACTIVE)
         /* Turn debug pin on. */
         MY_DEBUG_2 = MY_DEBUG_ON;
 #endif
 
-        /* Check if there is an action pending for the screen. */
-        if (screen.action) {
-            (*menuControl)(screen.action);
-            screen.action = 0;
+        /* Perform every action requested since the last refresh. */
+        regions = 0;
+
+        while (eventQueue_get(&screenQueue, &action)) {
+            regions |= menuDispatch(action);
+        }
+
+        /* Take changed values before reading them. */
+        if (displayDirty_take(DISPLAY_SP)) {
+            regions |= REGION_SP;
         }
 
-        /* Update controller values on the screen. */
-        printSP();      // Update setpoint.
-        printOP();      // Update controller output.
-        printPV();      // Update process variable.
+        if (displayDirty_take(DISPLAY_OP)) {
+            regions |= REGION_OP;
+        }
+
+        if (displayDirty_take(DISPLAY_PV)) {
+            regions |= REGION_PV;
+        }
+
+        if (displayDirty_take(DISPLAY_TREND)) {
+            regions |= REGION_PAGE;
+        }
+
+        if (displayDirty_take(DISPLAY_DIAG)) {
+            regions |= REGION_PAGE;
+        }
+
+        if (displayDirty_take(DISPLAY_MODE)) {
+            /* The cursor too: a mode change may end a value edit. */
+            regions |= REGION_CURSOR | REGION_ON_OFF | REGION_MAN_AUT |
+                       REGION_SP | REGION_OP;
+        }
+
+        /* Redraw the menu regions; keep the values still to be drawn. */
+        regions = menuRender(regions);
+
+        /* Take a consistent copy of the loop state. */
+        pidSnapshot_read(&state);
+
+        /* Update changed controller values on the screen. */
+        if (regions & REGION_SP) {
+            printSP(&state);    // Update setpoint.
+        }
+
+        if (regions & REGION_OP) {
+            printOP(&state);    // Update controller output.
+        }
+
+        if (regions & REGION_PV) {
+            printPV(&state);    // Update process variable.
+        }
+
+        /* Send only the changed cells to the LCD. */
+        frameBuffer_flush();
 
 #if (MY_DEBUG_ACTIVE)
         /* Turn debug pin off. */
         MY_DEBUG_2 = MY_DEBUG_OFF;;
 #endif
 
-        /* Start task delay. */
-        OSTimeDlyHMSM(0u,                       // Hours
-                      0u,                       // Minutes
-                      0u,                       // Seconds
-                      500u,                     // Milliseconds
-                      OS_OPT_TIME_HMSM_STRICT,  // STRICT or NON_STRICT
-                      &err);
+        /* Rate cap: value changes wait out the refresh period, button
+           actions do not. */
+        COROUTINE_WAIT_TIMEOUT(cr, !eventQueue_isEmpty(&screenQueue),
+                               REFRESH_LCD_PERIOD_TICKS);
+
+        /* Sleep until there is something to redraw. */
+        COROUTINE_WAIT_UNTIL(cr, !eventQueue_isEmpty(&screenQueue) ||
+                                 displayDirty_pending());
     }
+
+    COROUTINE_END(cr);
 }
 
-void insertArray (int16_t* array, int16_t data) {
-    array[2] = array[1];
-    array[1] = array[0];
-    array[0] = data;
+#if (STATS_ENABLED)
+static uint8_t StatsCoroutine (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    while (DEF_ON) {
+        COROUTINE_DELAY(cr, STATS_PERIOD_TICKS);
+
+        stats_collect();
+
+#if (MEM_BUDGET_ENABLED)
+        memBudget_sample();
+        memBudget_format(memBudgetReport);
+#endif
+
+        /* Only shown on the diagnostics screen. */
+        if (menu.state == MENU_DIAG_EDIT) {
+            displayDirty_set(DISPLAY_DIAG);
+        }
+    }
+
+    COROUTINE_END(cr);
 }
+#endif
+
+#if (NET_SERVICE_ENABLED)
+static uint8_t NetCoroutine (Coroutine* cr) {
+    OS_ERR err;
+
+    COROUTINE_BEGIN(cr);
+
+    netService_init();
+
+    while (DEF_ON) {
+        COROUTINE_DELAY(cr, NET_POLL_TICKS);
+
+#if (DEADLINE_MONITORED)
+        netService_poll(OSTimeGet(&err), &controllerDeadline);
+#else
+        netService_poll(OSTimeGet(&err), (DeadlineMonitor*)0);
+#endif
+    }
+
+    COROUTINE_END(cr);
+}
+#endif
+
+#if (MODBUS_SLAVE_ENABLED)
+static uint8_t ModbusCoroutine (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    /* Frame ends post this task. */
+#if (DEADLINE_MONITORED)
+    modbusSlave_init(&UITaskTCB, &controllerDeadline);
+#else
+    modbusSlave_init(&UITaskTCB, (DeadlineMonitor*)0);
+#endif
+
+    while (DEF_ON) {
+        COROUTINE_WAIT_TIMEOUT(cr, modbusSlave_ready(), MODBUS_POLL_TICKS);
+
+        modbusSlave_serve();
+    }
+
+    COROUTINE_END(cr);
+}
+#endif
+
+#if (CONSOLE_SERIAL_ENABLED)
+static uint8_t ConsoleCoroutine (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    /* Line ends and reply ends post this task. */
+    consoleSerial_init(&UITaskTCB);
+
+    while (DEF_ON) {
+        COROUTINE_WAIT_TIMEOUT(cr, consoleSerial_ready(),
+                               CONSOLE_POLL_TICKS);
+
+        consoleSerial_serve();
+    }
+
+    COROUTINE_END(cr);
+}
+#endif
@@ -23,8 +23,7 @@
 
 #define APP_TASK_START_PRIO         1u
 #define CONTROLLER_TASK_PRIO        2u
-#define SWITCH_DEBOUNCE_TASK_PRIO   3u
-#define REFRESH_LCD_TASK_PRIO       4u
+#define UI_TASK_PRIO                3u
 
 
 
@@ -32,9 +31,58 @@
 *                              TASK STACK SIZES                               *
 ******************************************************************************/
 
+/* Take the sizes from the header memBudget_format() generates. */
+#define APP_CFG_STK_BUDGET              (0)
+
+#if (APP_CFG_STK_BUDGET)
+#include "app_stk_budget.h"
+#else
 #define APP_TASK_START_STK_SIZE         512u
 #define CONTROLLER_TASK_STK_SIZE        512u
-#define SWITCH_DEBOUNCE_TASK_STK_SIZE   512u
-#define REFRESH_LCD_TASK_STK_SIZE       512u
+#define UI_TASK_STK_SIZE                512u
+#endif
+
+
+
+
+/******************************************************************************
+*                         TASK PERIODS AND BUDGETS                            *
+******************************************************************************/
+
+/* Shortest time between releases, in milliseconds. The UI task is released
+   at most once per display refresh; the switch polls in between are in its
+   budget. */
+#define CONTROLLER_TASK_PERIOD_MS       10u
+#define UI_TASK_PERIOD_MS               50u
+
+/* Worst case execution time budgets per release, in microseconds. With a
+   1 ms tick the response times are 520 us for the controller task and
+   8680 us for the UI task. */
+#define CONTROLLER_TASK_BUDGET_US       500u
+#define UI_TASK_BUDGET_US               8000u
+
+/* Kernel tick interrupt and tick task budget per tick, in microseconds. */
+#define APP_TICK_BUDGET_US              20u
+
+
+
+/******************************************************************************
+*                                 TASK TABLE                                  *
+******************************************************************************/
+
+/* Application tasks, created by the start task in this order:
+   X(..., task, name, priority, period, budget, stack size). The build fails
+   if the response time analysis in app.c finds a task that cannot meet its
+   period. */
+#define APP_TASK_TABLE(X, ...)                                              \
+    X(__VA_ARGS__, ControllerTask, "Controller Task", CONTROLLER_TASK_PRIO, \
+      CONTROLLER_TASK_PERIOD_MS, CONTROLLER_TASK_BUDGET_US,                 \
+      CONTROLLER_TASK_STK_SIZE)                                             \
+    X(__VA_ARGS__, UITask, "UI Task", UI_TASK_PRIO,                         \
+      UI_TASK_PERIOD_MS, UI_TASK_BUDGET_US,                                 \
+      UI_TASK_STK_SIZE)
+
+/* The table, named on a later scan; for walks nested in a walk. */
+#define APP_TASK_TABLE_INDIRECT() APP_TASK_TABLE
 
 #endif /* __APP_CFG_H__ */
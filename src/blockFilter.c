@@ -0,0 +1,129 @@
+/**
+    \file blockFilter.c
+    \brief Implementation file for the sample block filtering library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include "blockFilter.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+#if (BLOCK_FILTER_VECTOR_EN) && defined(__GNUC__) && \
+    (defined(__SSE2__) || defined(__ARM_NEON))
+/** Vectorized path in use. */
+#define BLOCK_FILTER_VECTOR (1)
+
+/** Number of samples per vector. */
+#define BLOCK_FILTER_LANES (8)
+#else
+#define BLOCK_FILTER_VECTOR (0)
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+#if (BLOCK_FILTER_VECTOR)
+/** Vector of eight 16-bit samples. */
+typedef uint16_t v8u16 __attribute__ ((vector_size (16)));
+
+/** Vector of eight 32-bit sums. */
+typedef uint32_t v8u32 __attribute__ ((vector_size (32)));
+#endif
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Add up a run of samples.
+    \param in Pointer to first sample.
+    \param count Number of samples.
+    \return Sum of the samples.
+ */
+static uint32_t blockFilter_sum (const uint16_t* in, uint16_t count);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+uint16_t blockFilter_decimate (const uint16_t* in, uint16_t count,
+                               uint16_t factor, int16_t* out) {
+    uint16_t outCount = 0;
+    uint32_t sum;
+
+    while (count >= factor) {
+        sum = blockFilter_sum(in, factor);
+
+        /* Rounded average, scaled to DAC resolution. */
+        out[outCount++] = (int16_t)(((sum + factor / 2u) / factor)
+                                    >> BLOCK_FILTER_SHIFT);
+
+        in += factor;
+        count -= factor;
+    }
+
+    return outCount;
+}
+
+void blockFilter_minMax (const uint16_t* in, uint16_t count,
+                         uint16_t* min, uint16_t* max) {
+    uint16_t lo = in[0];
+    uint16_t hi = in[0];
+    uint16_t i;
+
+    for (i = 1; i < count; i++) {
+        if (in[i] < lo) {
+            lo = in[i];
+        }
+
+        if (in[i] > hi) {
+            hi = in[i];
+        }
+    }
+
+    *min = lo;
+    *max = hi;
+}
+
+static uint32_t blockFilter_sum (const uint16_t* in, uint16_t count) {
+    uint32_t sum = 0;
+    uint16_t i = 0;
+
+#if (BLOCK_FILTER_VECTOR)
+    v8u32 acc = {0, 0, 0, 0, 0, 0, 0, 0};
+    v8u16 samples;
+
+    /* Widen eight samples at a time into 32-bit lanes. */
+    for (; (uint16_t)(count - i) >= BLOCK_FILTER_LANES;
+         i += BLOCK_FILTER_LANES) {
+        memcpy(&samples, &in[i], sizeof(samples));
+        acc += __builtin_convertvector(samples, v8u32);
+    }
+
+    sum = acc[0] + acc[1] + acc[2] + acc[3] + acc[4] + acc[5] + acc[6] + acc[7];
+#endif
+
+    for (; i < count; i++) {
+        sum += in[i];
+    }
+
+    return sum;
+}
@@ -0,0 +1,63 @@
+/**
+    \file blockFilter.h
+    \brief Header file for the sample block filtering library.
+    \details Pre-filtering and decimation kernels run over a whole block of
+             S12ADC samples at once. The kernels are plain C with no
+             peripheral access. When built with GCC for a host with SIMD
+             support (SSE2 or NEON) an explicitly vectorized path is used.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef BLOCKFILTER_H
+#define BLOCKFILTER_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Vectorized path enable flag; only takes effect on SIMD capable hosts. */
+#define BLOCK_FILTER_VECTOR_EN (1)
+
+/** Number of bits discarded from the S12ADC result to match the DAC. */
+#define BLOCK_FILTER_SHIFT (2)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Boxcar filter and decimate a block of S12ADC samples.
+    \details Every 'factor' consecutive input samples are averaged into one
+             output sample, which is scaled down to DAC resolution.
+    \param in Pointer to block of raw S12ADC samples.
+    \param count Number of input samples; must be a multiple of 'factor'.
+    \param factor Decimation factor (1 - 4096).
+    \param out Pointer to array receiving count/factor filtered samples.
+    \return Number of output samples written.
+ */
+uint16_t blockFilter_decimate (const uint16_t* in, uint16_t count,
+                               uint16_t factor, int16_t* out);
+
+/**
+    \brief Find minimum and maximum values of a block of S12ADC samples.
+    \param in Pointer to block of raw S12ADC samples.
+    \param count Number of input samples, greater than zero.
+    \param min Pointer to variable receiving the minimum value.
+    \param max Pointer to variable receiving the maximum value.
+    \return None
+ */
+void blockFilter_minMax (const uint16_t* in, uint16_t count,
+                         uint16_t* min, uint16_t* max);
+
+#endif /* BLOCKFILTER_H */
@@ -0,0 +1,285 @@
+/**
+    \file console.c
+    \brief Implementation file for the command console library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "format.h"
+#include "console.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Largest int32_t magnitude. */
+#define CONSOLE_INT32_MAX (2147483647ul)
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check for a word separator.
+    \param c Character.
+    \return True for a space or a tab.
+ */
+static bool console_isSpace (char c);
+
+/**
+    \brief Add a decimal digit to a magnitude, if it stays within a limit.
+    \param magnitude Magnitude, updated.
+    \param digit Digit value (0 - 9).
+    \param limit Largest magnitude allowed.
+    \return False, and magnitude unchanged, if it would exceed the limit.
+ */
+static bool console_addDigit (uint32_t* magnitude, uint8_t digit,
+                              uint32_t limit);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+uint8_t console_split (char* line, uint16_t length, char* argv[]) {
+    uint8_t argc = 0;
+    uint16_t i = 0;
+
+    line[length] = '\0';
+
+    while (i < length) {
+        /* Terminate the previous word over its separator. */
+        while ((i < length) && console_isSpace(line[i])) {
+            line[i] = '\0';
+            i++;
+        }
+
+        if (i >= length) {
+            break;
+        }
+
+        if (argc >= CONSOLE_ARGS_MAX) {
+            return (uint8_t)(CONSOLE_ARGS_MAX + 1u);
+        }
+
+        argv[argc] = &line[i];
+        argc++;
+
+        while ((i < length) && !console_isSpace(line[i])) {
+            i++;
+        }
+    }
+
+    return argc;
+}
+
+const ConsoleCommand* console_find (const ConsoleCommand* table,
+                                    uint8_t count, const char* name) {
+    uint8_t low = 0;
+    uint8_t high = count;
+    uint8_t middle;
+    int order;
+
+    while (low < high) {
+        middle = (uint8_t)((low + high) / 2u);
+        order = strcmp(name, table[middle].name);
+
+        if (order < 0) {
+            high = middle;
+        } else if (order > 0) {
+            low = (uint8_t)(middle + 1u);
+        } else {
+            return &table[middle];
+        }
+    }
+
+    return (const ConsoleCommand*)0;
+}
+
+uint8_t console_execute (const ConsoleCommand* table, uint8_t count,
+                         char* line, uint16_t length, ConsoleOutput* out) {
+    const ConsoleCommand* command = (const ConsoleCommand*)0;
+    char* argv[CONSOLE_ARGS_MAX];
+    uint8_t argc;
+    uint8_t result;
+
+    if (length >= CONSOLE_LINE_SIZE) {
+        result = CONSOLE_TOO_LONG;
+    } else {
+        argc = console_split(line, length, argv);
+
+        if (argc == 0u) {
+            return CONSOLE_EMPTY;
+        }
+
+        command = console_find(table, count, argv[0]);
+
+        if (command == (const ConsoleCommand*)0) {
+            result = CONSOLE_UNKNOWN;
+        } else if ((argc > CONSOLE_ARGS_MAX) ||
+                   ((argc - 1u) < command->minArgs) ||
+                   ((argc - 1u) > command->maxArgs)) {
+            result = CONSOLE_USAGE;
+        } else {
+            result = command->run(argc, argv, out);
+        }
+    }
+
+    switch (result) {
+        case CONSOLE_OK:
+            console_print(out, "ok\n");
+        break;
+        case CONSOLE_UNKNOWN:
+            console_print(out, "error: unknown command, try help\n");
+        break;
+        case CONSOLE_USAGE:
+            console_print(out, "error: usage: ");
+            console_help(command, 1u, out);
+        break;
+        case CONSOLE_BAD_VALUE:
+            console_print(out, "error: bad value\n");
+        break;
+        case CONSOLE_REFUSED:
+            console_print(out, "error: not allowed now\n");
+        break;
+        case CONSOLE_TOO_LONG:
+            console_print(out, "error: line too long\n");
+        break;
+        default:
+        break;
+    }
+
+    return result;
+}
+
+void console_help (const ConsoleCommand* table, uint8_t count,
+                   ConsoleOutput* out) {
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+        console_print(out, table[i].name);
+
+        if (table[i].usage[0] != '\0') {
+            console_print(out, " ");
+            console_print(out, table[i].usage);
+        }
+
+        console_print(out, "\n");
+    }
+}
+
+void console_print (ConsoleOutput* out, const char* text) {
+    while ((*text != '\0') && (out->length < out->size)) {
+        out->text[out->length] = *text++;
+        out->length++;
+    }
+}
+
+void console_printFixed (ConsoleOutput* out, int32_t value,
+                         uint8_t decimals) {
+    char number[FORMAT_INT32_SIZE];
+
+    (void)format_fixed(number, value, decimals, 0u);
+    console_print(out, number);
+}
+
+void console_printUnsigned (ConsoleOutput* out, uint32_t value) {
+    char digit[2] = { '0', '\0' };
+
+    /* The leading digits fit an int32_t; the last one is added alone. */
+    if (value >= 10u) {
+        console_printFixed(out, (int32_t)(value / 10u), 0u);
+    }
+
+    digit[0] = (char)('0' + (value % 10u));
+    console_print(out, digit);
+}
+
+bool console_parseFixed (const char* text, uint8_t decimals,
+                         int32_t* value) {
+    bool negative = false;
+    bool point = false;
+    bool digits = false;
+    uint32_t magnitude = 0;
+    uint32_t limit = CONSOLE_INT32_MAX;
+    uint8_t fraction = 0;
+
+    if ((*text == '-') || (*text == '+')) {
+        negative = (*text == '-');
+        text++;
+    }
+
+    /* INT32_MIN has no positive counterpart. */
+    if (negative) {
+        limit++;
+    }
+
+    for (; *text != '\0'; text++) {
+        if ((*text == '.') && !point) {
+            point = true;
+        } else if ((*text >= '0') && (*text <= '9')) {
+            if (point && (fraction == decimals)) {
+                /* Past the decimals: only zeros, nothing is rounded. */
+                if (*text != '0') {
+                    return false;
+                }
+            } else {
+                if (point) {
+                    fraction++;
+                }
+
+                if (!console_addDigit(&magnitude, (uint8_t)(*text - '0'),
+                                      limit)) {
+                    return false;
+                }
+            }
+
+            digits = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (!digits) {
+        return false;
+    }
+
+    /* Scale the decimals not given. */
+    for (; fraction < decimals; fraction++) {
+        if (!console_addDigit(&magnitude, 0u, limit)) {
+            return false;
+        }
+    }
+
+    /* Unsigned negation also covers INT32_MIN. */
+    *value = negative ? (int32_t)(0u - magnitude) : (int32_t)magnitude;
+
+    return true;
+}
+
+static bool console_isSpace (char c) {
+    return (c == ' ') || (c == '\t');
+}
+
+static bool console_addDigit (uint32_t* magnitude, uint8_t digit,
+                              uint32_t limit) {
+    if (*magnitude > ((limit - digit) / 10u)) {
+        return false;
+    }
+
+    *magnitude = (*magnitude * 10u) + digit;
+
+    return true;
+}
@@ -0,0 +1,179 @@
+/**
+    \file console.h
+    \brief Header file for the command console library.
+    \details Line tokenizing, command dispatch and reply building of a text
+             console, in portable C with no kernel or board dependency, so
+             that the same code runs on the host. The serial side and the
+             commands of this controller are in consoleSerial.c.
+             \par
+             A line is split in place: the spaces between the words are
+             overwritten with terminators and the words are left where the
+             receiver put them, so nothing is copied and nothing is
+             allocated. The first word names the command, looked up by
+             binary search in a static table of ConsoleCommand entries
+             sorted by name; the table also gives the number of arguments
+             the command takes, checked before its handler runs.
+             \par
+             The handler writes its reply into a ConsoleOutput buffer, and
+             console_execute() ends it with a status line: "ok" or
+             "error: " and the reason. Lines end with a single '\\n'.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Line buffer size, terminator included. */
+#define CONSOLE_LINE_SIZE (64u)
+
+/** Most words in a line, command included. */
+#define CONSOLE_ARGS_MAX (6u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Command results. */
+enum ConsoleResult {
+    CONSOLE_OK,             /**< Done. */
+    CONSOLE_EMPTY,          /**< Blank line; no reply. */
+    CONSOLE_UNKNOWN,        /**< No such command. */
+    CONSOLE_USAGE,          /**< Wrong arguments. */
+    CONSOLE_BAD_VALUE,      /**< Value not a number or out of range. */
+    CONSOLE_REFUSED,        /**< Not allowed in the current state. */
+    CONSOLE_TOO_LONG,       /**< Line longer than the buffer. */
+    CONSOLE_PENDING         /**< Reply continues; its owner ends it. */
+};
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Reply buffer. */
+typedef struct ConsoleOutput_struct {
+    char* text;             /**< Reply text; not terminated. */
+    uint16_t size;          /**< Buffer size, in characters. */
+    uint16_t length;        /**< Characters written. */
+} ConsoleOutput;
+
+/** Command table entry. */
+typedef struct ConsoleCommand_struct {
+    const char* name;       /**< Command word. */
+    const char* usage;      /**< Arguments, for help and usage errors. */
+    uint8_t minArgs;        /**< Fewest arguments, command excluded. */
+    uint8_t maxArgs;        /**< Most arguments, command excluded. */
+    uint8_t (*run)(uint8_t argc, char* argv[], ConsoleOutput* out);
+                            /**< Handler: argv[0] is the command; returns a
+                                 ConsoleResult. */
+} ConsoleCommand;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Split a line into words, in place.
+    \param line Line; its words are terminated where they are.
+    \param length Line length, without a terminator; line[length] must be
+           writable.
+    \param argv Word pointers, CONSOLE_ARGS_MAX entries.
+    \return Number of words; CONSOLE_ARGS_MAX + 1 if there are more.
+ */
+uint8_t console_split (char* line, uint16_t length, char* argv[]);
+
+/**
+    \brief Find a command.
+    \param table Commands, sorted by name as strcmp() orders them.
+    \param count Number of commands.
+    \param name Command word.
+    \return Command; null if not found.
+ */
+const ConsoleCommand* console_find (const ConsoleCommand* table,
+                                    uint8_t count, const char* name);
+
+/**
+    \brief Split a line, run its command and end the reply with the status
+           line, unless the result is CONSOLE_EMPTY or CONSOLE_PENDING.
+    \param table Commands, sorted by name.
+    \param count Number of commands.
+    \param line Line, changed by the split; CONSOLE_LINE_SIZE characters.
+    \param length Line length; CONSOLE_LINE_SIZE or more if it overflowed
+           the buffer.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+uint8_t console_execute (const ConsoleCommand* table, uint8_t count,
+                         char* line, uint16_t length, ConsoleOutput* out);
+
+/**
+    \brief List the commands with their arguments, one per line.
+    \param table Commands.
+    \param count Number of commands.
+    \param out Reply buffer.
+    \return None
+ */
+void console_help (const ConsoleCommand* table, uint8_t count,
+                   ConsoleOutput* out);
+
+/**
+    \brief Append text to a reply; what does not fit is dropped.
+    \param out Reply buffer.
+    \param text Text.
+    \return None
+ */
+void console_print (ConsoleOutput* out, const char* text);
+
+/**
+    \brief Append a fixed-point value, value / 10^decimals, to a reply.
+    \param out Reply buffer.
+    \param value Scaled value.
+    \param decimals Number of decimals (0 - FORMAT_MAX_DECIMALS).
+    \return None
+ */
+void console_printFixed (ConsoleOutput* out, int32_t value,
+                         uint8_t decimals);
+
+/**
+    \brief Append an unsigned integer to a reply.
+    \param out Reply buffer.
+    \param value Value.
+    \return None
+ */
+void console_printUnsigned (ConsoleOutput* out, uint32_t value);
+
+/**
+    \brief Parse a decimal number to a given number of decimals, e.g.
+           "-42.5" with 2 decimals is -4250. Digits past the decimals must
+           be zeros: "42.50" with 1 decimal is 425, "42.5" with none is
+           refused rather than rounded.
+    \param text Number text: an optional sign, digits, and optionally a
+           point and more digits.
+    \param decimals Decimals of the result (0 - 9).
+    \param value Scaled result.
+    \return False, and value unchanged, if the text is not such a number,
+            is finer than the decimals or does not fit an int32_t.
+ */
+bool console_parseFixed (const char* text, uint8_t decimals,
+                         int32_t* value);
+
+#endif /* CONSOLE_H */
@@ -0,0 +1,903 @@
+/**
+    \file consoleSerial.c
+    \brief Implementation file for the serial command console library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <machine.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "platform.h"
+#include "memBarrier.h"
+#include "units.h"
+#include "controller.h"
+#include "controllerSysControl.h"
+#include "displayDirty.h"
+#include "stats.h"
+#include "trace.h"
+#include "loopTiming.h"
+#include "fastLoop.h"
+#include "console.h"
+#include "consoleSerial.h"
+#include "memBudget.h"
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (CONSOLE_LINE_SIZE > MEM_BUDGET_BLK_SIZE)
+#error "A console line must fit a block of the reclaimed memory pool."
+#endif
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Line ring index mask. */
+#define CONSOLE_SERIAL_LINE_MASK (CONSOLE_SERIAL_LINES - 1u)
+
+/** Busy loop iterations covering one bit time after setting the bit rate. */
+#define CONSOLE_SERIAL_BIT_WAIT (5000u)
+
+/** SCR: receiver and its interrupt on, transmitter off. */
+#define CONSOLE_SERIAL_SCR_RECEIVE (0x50u)
+
+/** SCR: TIE and TE set together, which raises the first TXI. */
+#define CONSOLE_SERIAL_SCR_SEND (0xF0u)
+
+/** SCR transmit end interrupt enable bit. */
+#define CONSOLE_SERIAL_SCR_TEIE (0x04u)
+
+/** SSR overrun, framing and parity error flags. */
+#define CONSOLE_SERIAL_SSR_ERRORS (0x38u)
+
+/** Longest trace dump line: four numbers, separators and line feed. */
+#define CONSOLE_SERIAL_EVENT_CHARS (26u)
+
+/** PID coefficient scale: 10^CONSOLE_SERIAL_GAIN_DECIMALS. */
+#define CONSOLE_SERIAL_GAIN_SCALE (10000.0f)
+
+/** Backspace character. */
+#define CONSOLE_SERIAL_BS (0x08u)
+
+/** Delete character, sent by many terminals for backspace. */
+#define CONSOLE_SERIAL_DEL (0x7Fu)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern PIDControl pid;
+
+extern const UnitsConfig signalUnitsConfig[SIGNALS];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief gains command: show or set the PID coefficients.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_gains (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out);
+
+/**
+    \brief get command: show a signal or setting.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_get (uint8_t argc, char* argv[],
+                                  ConsoleOutput* out);
+
+/**
+    \brief help command: list the commands.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_help (uint8_t argc, char* argv[],
+                                   ConsoleOutput* out);
+
+/**
+    \brief mode command: switch between manual and automatic.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_mode (uint8_t argc, char* argv[],
+                                   ConsoleOutput* out);
+
+/**
+    \brief power command: switch the controller on or off.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_power (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out);
+
+/**
+    \brief set command: apply a setpoint or controller output.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_set (uint8_t argc, char* argv[],
+                                  ConsoleOutput* out);
+
+/**
+    \brief stats command: show the task statistics.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_stats (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out);
+
+/**
+    \brief timing command: switch, clear or show the control loop timing
+           histograms.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_timing (uint8_t argc, char* argv[],
+                                     ConsoleOutput* out);
+
+/**
+    \brief trace command: start a dump, or start or stop recording.
+    \param argc Number of words.
+    \param argv Words.
+    \param out Reply buffer.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_trace (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out);
+
+/**
+    \brief Append a signal in engineering units, with its unit and raw
+           value.
+    \param out Reply buffer.
+    \param signal Signal type.
+    \param raw Raw value.
+    \return None
+ */
+static void consoleSerial_printSignal (ConsoleOutput* out, uint8_t signal,
+                                       int16_t raw);
+
+/**
+    \brief Append a setting as applied, e.g. "sp 42 %".
+    \param out Reply buffer.
+    \param name Setting name.
+    \param signal Signal type.
+    \param value Value in engineering units.
+    \return None
+ */
+static void consoleSerial_printApplied (ConsoleOutput* out,
+                                        const char* name, uint8_t signal,
+                                        int32_t value);
+
+/**
+    \brief Append a PID coefficient, rounded to
+           CONSOLE_SERIAL_GAIN_DECIMALS.
+    \param out Reply buffer.
+    \param gain Coefficient, within PID_COEFFICIENT_MAX.
+    \return None
+ */
+static void consoleSerial_printGain (ConsoleOutput* out, float gain);
+
+/**
+    \brief Map the result of a controller setting to its command result.
+    \param result PIDSettingResult.
+    \return ConsoleResult.
+ */
+static uint8_t consoleSerial_result (uint8_t result);
+
+/**
+    \brief Fill the reply buffer with the next trace events, and end the
+           dump once all are out.
+    \param out Reply buffer.
+    \return None
+ */
+static void consoleSerial_dump (ConsoleOutput* out);
+
+#if (CONSOLE_SERIAL_ENABLED)
+/**
+    \brief SCI0 receive interrupt service routine.
+    \return None
+ */
+static void consoleSerial_rxIsr (void);
+
+/**
+    \brief SCI0 transmit data empty interrupt service routine.
+    \return None
+ */
+static void consoleSerial_txIsr (void);
+
+/**
+    \brief SCI0 transmit end interrupt service routine.
+    \return None
+ */
+static void consoleSerial_txEndIsr (void);
+#endif
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Commands, sorted by name. */
+static const ConsoleCommand commands[] = {
+    { "gains", "[b1 b2 b3]", 0u, 3u, consoleSerial_gains },
+    { "get", "sp|pv|op|mode|power", 1u, 1u, consoleSerial_get },
+    { "help", "", 0u, 0u, consoleSerial_help },
+    { "mode", "man|auto", 1u, 1u, consoleSerial_mode },
+    { "power", "on|off", 1u, 1u, consoleSerial_power },
+    { "set", "sp|op value", 2u, 2u, consoleSerial_set },
+    { "stats", "", 0u, 0u, consoleSerial_stats },
+    { "timing", "on|off|reset|show", 1u, 1u, consoleSerial_timing },
+    { "trace", "dump|on|off", 1u, 1u, consoleSerial_trace }
+};
+
+#if (LOOP_TIMING_ENABLED) && !(FAST_LOOP_ENABLED)
+/** Loop timing histogram names, by LoopTimingHistogramType. */
+static const char* const timingNames[LOOP_TIMING_HISTOGRAMS] = {
+    "jitter",
+    "compute",
+    "latency"
+};
+#endif
+
+/** Number of commands. */
+static const uint8_t commandCount =
+    (uint8_t)(sizeof(commands) / sizeof(commands[0]));
+
+/** Received lines, blocks of the reclaimed memory pool; the receive
+    interrupt fills the one at lineHead. */
+static char* lines[CONSOLE_SERIAL_LINES];
+
+/** The line buffers are taken and SCI0 is set up. */
+static bool started = false;
+
+/** Length of each received line; CONSOLE_LINE_SIZE if it overflowed. */
+static uint8_t lineLength[CONSOLE_SERIAL_LINES];
+
+/** Lines received; only written by the receive interrupt. */
+static volatile uint8_t lineHead = 0;
+
+/** Lines run; only written by the task. */
+static volatile uint8_t lineTail = 0;
+
+/** Characters of the line being received, up to CONSOLE_LINE_SIZE. */
+static uint8_t rxLength = 0;
+
+/** The line being received is dropped at its end. */
+static volatile bool rxDrop = false;
+
+/** Lines dropped: ring full or line error. */
+static volatile uint16_t dropped = 0;
+
+/** Reply being built, then sent. */
+static char reply[CONSOLE_SERIAL_REPLY_SIZE];
+
+/** Reply length, in characters. */
+static uint16_t txLength = 0;
+
+/** Next reply character to send. */
+static volatile uint16_t txIndex = 0;
+
+/** The carriage return before the next line feed is out. */
+static volatile bool txReturnSent = false;
+
+/** A reply is going out. */
+static volatile bool sending = false;
+
+/** A trace dump is going on. */
+static bool dumping = false;
+
+/** Next trace event to dump, as a ring count. */
+static uint32_t dumpNext = 0;
+
+/** End of the dump, as a ring count. */
+static uint32_t dumpEnd = 0;
+
+/** Trace recording state before the dump froze it. */
+static bool dumpTraceEnabled = false;
+
+/** Task posted at each line end and reply end. */
+static OS_TCB* notify = (OS_TCB*)0;
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void consoleSerial_init (OS_TCB* notifyTCB) {
+    OS_MEM* pool = memBudget_pool();
+    OS_ERR err;
+    uint16_t i;
+
+    notify = notifyTCB;
+
+    /* The line buffers come from the memory of the start task; without
+       them the console stays off. */
+    if (pool == (OS_MEM*)0) {
+        return;
+    }
+
+    for (i = 0; i < CONSOLE_SERIAL_LINES; i++) {
+        lines[i] = (char*)OSMemGet(pool, &err);
+
+        if (err != OS_ERR_NONE) {
+            /* Give back the blocks already taken. */
+            while (i > 0u) {
+                i--;
+                OSMemPut(pool, lines[i], &err);
+            }
+
+            return;
+        }
+    }
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up SCI0. */
+    MSTP(SCI0) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Set up port 20 (TXD0) and port 21 (RXD0) for SCI0. */
+    PORT2.PODR.BIT.B0 = 1;      /* Idle line level while still GPIO. */
+    PORT2.PDR.BIT.B0  = 1;      /* Set I/O pin direction to output. */
+    PORT2.PDR.BIT.B1  = 0;      /* Set I/O pin direction to input. */
+    PORT2.PMR.BIT.B0  = 0;      /* First set I/O pins to GPIO mode. */
+    PORT2.PMR.BIT.B1  = 0;
+    MPC.P20PFS.BYTE = 0x0A;     /* P20 is used as TXD0. */
+    MPC.P21PFS.BYTE = 0x0A;     /* P21 is used as RXD0. */
+    PORT2.PMR.BIT.B0  = 1;      /* Hand the pins over to SCI0. */
+    PORT2.PMR.BIT.B1  = 1;
+
+    /* Asynchronous 8N1, PCLK/1 count source; receiver still off. */
+    SCI0.SCR.BYTE = 0x00;
+    SCI0.SMR.BYTE = 0x00;
+    SCI0.SCMR.BYTE = 0xF2;      /* Serial mode, LSB first. */
+    SCI0.SEMR.BYTE = 0x00;
+    SCI0.BRR = CONSOLE_SERIAL_BRR;
+
+    /* The bit rate settles within one bit time. */
+    for (i = 0; i < CONSOLE_SERIAL_BIT_WAIT; i++) {
+        nop();
+    }
+
+    IPR(SCI0,RXI0) = CONSOLE_SERIAL_IPL;
+    IR(SCI0,RXI0) = 0;
+    IR(SCI0,TXI0) = 0;
+    IR(SCI0,TEI0) = 0;
+    IEN(SCI0,RXI0) = 1;
+    IEN(SCI0,TXI0) = 1;
+    IEN(SCI0,TEI0) = 1;
+
+    SCI0.SCR.BYTE = CONSOLE_SERIAL_SCR_RECEIVE;
+
+    started = true;
+}
+
+bool consoleSerial_ready (void) {
+    return !sending && (dumping || (lineTail != lineHead));
+}
+
+void consoleSerial_serve (void) {
+    ConsoleOutput out;
+    uint8_t slot;
+
+    if (!started) {
+        return;
+    }
+
+    /* A line error stops the receiver until its flag is cleared. The
+       characters lost may belong to the line being received, or be its
+       end: drop it rather than run a command with a digit missing. */
+    if ((SCI0.SSR.BYTE & CONSOLE_SERIAL_SSR_ERRORS) != 0u) {
+        SCI0.SSR.BYTE = (uint8_t)(SCI0.SSR.BYTE &
+                                  ~CONSOLE_SERIAL_SSR_ERRORS);
+        rxDrop = true;
+    }
+
+    if (sending) {
+        return;
+    }
+
+    out.text = reply;
+    out.size = CONSOLE_SERIAL_REPLY_SIZE;
+    out.length = 0;
+
+    /* A dump holds the lines received meanwhile until it ends. */
+    if (dumping) {
+        consoleSerial_dump(&out);
+    } else if (lineTail != lineHead) {
+        MEM_BARRIER_ACQUIRE();
+        slot = (uint8_t)(lineTail & CONSOLE_SERIAL_LINE_MASK);
+
+        (void)console_execute(commands, commandCount,
+                              lines[slot], lineLength[slot], &out);
+
+        /* The slot is free again once the command is done with it. */
+        MEM_BARRIER_RELEASE();
+        lineTail = (uint8_t)(lineTail + 1u);
+    }
+
+    if (out.length == 0u) {
+        return;
+    }
+
+    txLength = out.length;
+    txIndex = 0;
+    txReturnSent = false;
+    sending = true;
+    SCI0.SCR.BYTE = CONSOLE_SERIAL_SCR_SEND;
+}
+
+static uint8_t consoleSerial_gains (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out) {
+    PIDCoefficients coefficients;
+    int32_t value[3];
+    uint8_t i;
+
+    if (argc == 1u) {
+        getCoefficients_PID(&coefficients);
+
+        console_print(out, "b1 ");
+        consoleSerial_printGain(out, coefficients.b1);
+        console_print(out, " b2 ");
+        consoleSerial_printGain(out, coefficients.b2);
+        console_print(out, " b3 ");
+        consoleSerial_printGain(out, coefficients.b3);
+        console_print(out, "\n");
+
+        return CONSOLE_OK;
+    }
+
+    if (argc != 4u) {
+        return CONSOLE_USAGE;
+    }
+
+    for (i = 0; i < 3u; i++) {
+        if (!console_parseFixed(argv[i + 1u], CONSOLE_SERIAL_GAIN_DECIMALS,
+                                &value[i])) {
+            return CONSOLE_BAD_VALUE;
+        }
+    }
+
+    coefficients.b1 = (float)value[0] / CONSOLE_SERIAL_GAIN_SCALE;
+    coefficients.b2 = (float)value[1] / CONSOLE_SERIAL_GAIN_SCALE;
+    coefficients.b3 = (float)value[2] / CONSOLE_SERIAL_GAIN_SCALE;
+
+    return setCoefficients_PID(&coefficients) ? CONSOLE_OK :
+                                                CONSOLE_BAD_VALUE;
+}
+
+static uint8_t consoleSerial_get (uint8_t argc, char* argv[],
+                                  ConsoleOutput* out) {
+    (void)argc;
+
+    if (strcmp(argv[1], "sp") == 0) {
+        consoleSerial_printSignal(out, SIGNAL_SP, pid.sp);
+    } else if (strcmp(argv[1], "pv") == 0) {
+        consoleSerial_printSignal(out, SIGNAL_PV, pid.pv);
+    } else if (strcmp(argv[1], "op") == 0) {
+        consoleSerial_printSignal(out, SIGNAL_OP, pid.op);
+    } else if (strcmp(argv[1], "mode") == 0) {
+        console_print(out, (pid.mode == PID_AUTO) ? "auto\n" : "man\n");
+    } else if (strcmp(argv[1], "power") == 0) {
+        console_print(out, (pid.active == PID_ON) ? "on\n" : "off\n");
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    return CONSOLE_OK;
+}
+
+static uint8_t consoleSerial_help (uint8_t argc, char* argv[],
+                                   ConsoleOutput* out) {
+    (void)argc;
+    (void)argv;
+
+    console_help(commands, commandCount, out);
+
+    return CONSOLE_OK;
+}
+
+static uint8_t consoleSerial_mode (uint8_t argc, char* argv[],
+                                   ConsoleOutput* out) {
+    (void)argc;
+    (void)out;
+
+    if (strcmp(argv[1], "man") == 0) {
+        setMode(PID_MAN);
+    } else if (strcmp(argv[1], "auto") == 0) {
+        setMode(PID_AUTO);
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    displayDirty_set(DISPLAY_MODE);
+
+    return CONSOLE_OK;
+}
+
+static uint8_t consoleSerial_power (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out) {
+    (void)argc;
+    (void)out;
+
+    if (strcmp(argv[1], "on") == 0) {
+        setActive(PID_ON);
+    } else if (strcmp(argv[1], "off") == 0) {
+        setActive(PID_OFF);
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    displayDirty_set(DISPLAY_MODE);
+
+    return CONSOLE_OK;
+}
+
+static uint8_t consoleSerial_set (uint8_t argc, char* argv[],
+                                  ConsoleOutput* out) {
+    int32_t value;
+    uint8_t result;
+
+    (void)argc;
+
+    if (strcmp(argv[1], "sp") == 0) {
+        if (!console_parseFixed(argv[2],
+                                signalUnitsConfig[SIGNAL_SP].decimals,
+                                &value)) {
+            return CONSOLE_BAD_VALUE;
+        }
+
+        result = setSetpoint(value);
+
+        if (result == PID_SETTING_OK) {
+            displayDirty_set(DISPLAY_SP);
+            consoleSerial_printApplied(out, "sp", SIGNAL_SP, pid.spValue);
+        }
+    } else if (strcmp(argv[1], "op") == 0) {
+        if (!console_parseFixed(argv[2],
+                                signalUnitsConfig[SIGNAL_OP].decimals,
+                                &value)) {
+            return CONSOLE_BAD_VALUE;
+        }
+
+        result = setOutput(value);
+
+        if (result == PID_SETTING_OK) {
+            displayDirty_set(DISPLAY_OP);
+            consoleSerial_printApplied(out, "op", SIGNAL_OP, pid.opValue);
+        }
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    return consoleSerial_result(result);
+}
+
+static uint8_t consoleSerial_stats (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out) {
+    (void)argc;
+    (void)argv;
+
+#if (STATS_ENABLED)
+    /* The reply buffer is empty and holds STATS_TEXT_SIZE and more. */
+    out->length = (uint16_t)(out->length +
+                             stats_format(&out->text[out->length]));
+#endif
+    console_print(out, "console lines dropped ");
+    console_printUnsigned(out, dropped);
+    console_print(out, "\n");
+
+    return CONSOLE_OK;
+}
+
+static uint8_t consoleSerial_timing (uint8_t argc, char* argv[],
+                                     ConsoleOutput* out) {
+#if (LOOP_TIMING_ENABLED) && !(FAST_LOOP_ENABLED)
+    LoopTimingHistogram histogram;
+    CPU_ERR err;
+    uint8_t i;
+    uint8_t b;
+
+    (void)argc;
+
+    if (strcmp(argv[1], "on") == 0) {
+        loopTiming_enable(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        loopTiming_enable(false);
+    } else if (strcmp(argv[1], "reset") == 0) {
+        /* Carried out by the next control cycle. */
+        loopTiming_reset();
+    } else if (strcmp(argv[1], "show") == 0) {
+        console_print(out, loopTiming_enabled() ? "timing on, " :
+                                                  "timing off, ");
+        console_printUnsigned(out, (uint32_t)CPU_TS_TmrFreqGet(&err));
+        console_print(out, " Hz: name samples max <counts:number\n");
+
+        for (i = 0; i < LOOP_TIMING_HISTOGRAMS; i++) {
+            loopTiming_get(i, &histogram);
+
+            console_print(out, timingNames[i]);
+            console_print(out, " ");
+            console_printUnsigned(out, histogram.samples);
+            console_print(out, " ");
+            console_printUnsigned(out, histogram.max);
+
+            /* Bucket b counts the values below 2^b not in bucket b - 1;
+               the last one also counts everything above. */
+            for (b = 0; b < LOOP_TIMING_BUCKETS; b++) {
+                if (histogram.bucket[b] == 0u) {
+                    continue;
+                }
+
+                if (b < (LOOP_TIMING_BUCKETS - 1u)) {
+                    console_print(out, " <");
+                    console_printUnsigned(out, 1ul << b);
+                } else {
+                    console_print(out, " >=");
+                    console_printUnsigned(out, 1ul << (b - 1u));
+                }
+
+                console_print(out, ":");
+                console_printUnsigned(out, histogram.bucket[b]);
+            }
+
+            console_print(out, "\n");
+        }
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    return CONSOLE_OK;
+#else
+    (void)argc;
+    (void)argv;
+    (void)out;
+
+    /* The fast loop runs without the task loop timing marks. */
+    return CONSOLE_REFUSED;
+#endif
+}
+
+static uint8_t consoleSerial_trace (uint8_t argc, char* argv[],
+                                    ConsoleOutput* out) {
+    (void)argc;
+
+    if (strcmp(argv[1], "on") == 0) {
+        trace_enable(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        trace_enable(false);
+    } else if (strcmp(argv[1], "dump") == 0) {
+        /* Freeze the ring; the oldest event is TRACE_SIZE back. */
+        dumpTraceEnabled = (traceBuffer.enabled != 0u);
+        trace_enable(false);
+        dumpEnd = traceBuffer.head;
+        dumpNext = (dumpEnd > TRACE_SIZE) ? (dumpEnd - TRACE_SIZE) : 0u;
+        dumping = true;
+
+        console_print(out, "trace ");
+        console_printUnsigned(out, dumpEnd - dumpNext);
+        console_print(out, " events, ");
+        console_printUnsigned(out, traceBuffer.frequency);
+        console_print(out, " Hz: time type arg value\n");
+
+        return CONSOLE_PENDING;
+    } else {
+        return CONSOLE_USAGE;
+    }
+
+    return CONSOLE_OK;
+}
+
+static void consoleSerial_printSignal (ConsoleOutput* out, uint8_t signal,
+                                       int16_t raw) {
+    const UnitsConfig* config = &signalUnitsConfig[signal];
+
+    console_printFixed(out, toValue(signal, raw), config->decimals);
+    console_print(out, " ");
+    console_print(out, config->unit);
+    console_print(out, " raw ");
+    console_printFixed(out, raw, 0u);
+    console_print(out, "\n");
+}
+
+static void consoleSerial_printApplied (ConsoleOutput* out,
+                                        const char* name, uint8_t signal,
+                                        int32_t value) {
+    const UnitsConfig* config = &signalUnitsConfig[signal];
+
+    console_print(out, name);
+    console_print(out, " ");
+    console_printFixed(out, value, config->decimals);
+    console_print(out, " ");
+    console_print(out, config->unit);
+    console_print(out, "\n");
+}
+
+static void consoleSerial_printGain (ConsoleOutput* out, float gain) {
+    /* Within PID_COEFFICIENT_MAX the scaled value fits an int32_t. */
+    int32_t value = (int32_t)((gain * CONSOLE_SERIAL_GAIN_SCALE) +
+                              ((gain < 0.0f) ? -0.5f : 0.5f));
+
+    console_printFixed(out, value, CONSOLE_SERIAL_GAIN_DECIMALS);
+}
+
+static uint8_t consoleSerial_result (uint8_t result) {
+    if (result == PID_SETTING_REFUSED) {
+        return CONSOLE_REFUSED;
+    }
+
+    if (result == PID_SETTING_BAD_VALUE) {
+        return CONSOLE_BAD_VALUE;
+    }
+
+    return CONSOLE_OK;
+}
+
+static void consoleSerial_dump (ConsoleOutput* out) {
+    const TraceEvent* event;
+
+    while ((dumpNext != dumpEnd) &&
+           ((uint16_t)(out->size - out->length) >=
+            CONSOLE_SERIAL_EVENT_CHARS)) {
+        event = &traceBuffer.event[dumpNext & TRACE_MASK];
+        dumpNext++;
+
+        console_printUnsigned(out, event->time);
+        console_print(out, " ");
+        console_printUnsigned(out, event->type);
+        console_print(out, " ");
+        console_printUnsigned(out, event->arg);
+        console_print(out, " ");
+        console_printUnsigned(out, event->value);
+        console_print(out, "\n");
+    }
+
+    if (dumpNext == dumpEnd) {
+        console_print(out, "ok\n");
+        dumping = false;
+        trace_enable(dumpTraceEnabled);
+    }
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#if (CONSOLE_SERIAL_ENABLED)
+#pragma interrupt (consoleSerial_rxIsr (vect=VECT(SCI0,RXI0)))
+void consoleSerial_rxIsr (void) {
+    char data = (char)SCI0.RDR;
+    uint8_t slot = (uint8_t)(lineHead & CONSOLE_SERIAL_LINE_MASK);
+    OS_ERR err;
+
+    if ((data == '\r') || (data == '\n')) {
+        /* Blank lines, and the line feed after a return, are no lines. */
+        if ((rxLength == 0u) && !rxDrop) {
+            return;
+        }
+
+        if (rxDrop) {
+            dropped = dropped + 1u;
+        } else {
+            /* Only the end of a line is kernel-aware. */
+            OSIntEnter();
+            TRACE_ISR_ENTER(TRACE_ISR_CONSOLE);
+
+            lineLength[slot] = rxLength;
+            MEM_BARRIER_RELEASE();
+            lineHead = (uint8_t)(lineHead + 1u);
+
+            if (notify != (OS_TCB*)0) {
+                OSTaskSemPost(notify, OS_OPT_POST_NONE, &err);
+            }
+
+            TRACE_ISR_EXIT(TRACE_ISR_CONSOLE);
+            OSIntExit();
+        }
+
+        rxLength = 0;
+        rxDrop = false;
+    } else if ((data == (char)CONSOLE_SERIAL_BS) ||
+               (data == (char)CONSOLE_SERIAL_DEL)) {
+        if ((rxLength > 0u) && (rxLength < CONSOLE_LINE_SIZE)) {
+            rxLength--;
+        }
+    } else if ((uint8_t)(lineHead - lineTail) >= CONSOLE_SERIAL_LINES) {
+        /* The slot is still in use by the task. */
+        rxDrop = true;
+    } else if (rxLength < (CONSOLE_LINE_SIZE - 1u)) {
+        lines[slot][rxLength] = data;
+        rxLength++;
+    } else {
+        /* Too long: the task answers it with an error. */
+        rxLength = CONSOLE_LINE_SIZE;
+    }
+}
+
+#pragma interrupt (consoleSerial_txIsr (vect=VECT(SCI0,TXI0)))
+void consoleSerial_txIsr (void) {
+    char data = reply[txIndex];
+
+    /* Terminals want a return before each line feed. */
+    if ((data == '\n') && !txReturnSent) {
+        SCI0.TDR = (uint8_t)'\r';
+        txReturnSent = true;
+        return;
+    }
+
+    SCI0.TDR = (uint8_t)data;
+    txReturnSent = false;
+    txIndex = txIndex + 1u;
+
+    /* Last character loaded: wait for it to leave the shift register. */
+    if (txIndex >= txLength) {
+        SCI0.SCR.BYTE = (uint8_t)((SCI0.SCR.BYTE & ~0x80u) |
+                                  CONSOLE_SERIAL_SCR_TEIE);
+    }
+}
+
+#pragma interrupt (consoleSerial_txEndIsr (vect=VECT(SCI0,TEI0)))
+void consoleSerial_txEndIsr (void) {
+    OS_ERR err;
+
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_CONSOLE);
+
+    SCI0.SCR.BYTE = CONSOLE_SERIAL_SCR_RECEIVE;
+    sending = false;
+
+    /* Lines may have queued up behind the reply. */
+    if (notify != (OS_TCB*)0) {
+        OSTaskSemPost(notify, OS_OPT_POST_NONE, &err);
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_CONSOLE);
+    OSIntExit();
+}
+#endif
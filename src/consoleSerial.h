@@ -0,0 +1,135 @@
+/**
+    \file consoleSerial.h
+    \brief Header file for the serial command console library.
+    \details Text console on SCI0 (TXD0 on P20, RXD0 on P21) at 115200
+             bit/s, 8N1, for live inspection and tuning without the board
+             buttons. Commands, one per line:
+             \code
+             gains [b1 b2 b3]       show or set the PID coefficients
+             get sp|pv|op|mode|power
+             help                   list the commands
+             mode man|auto
+             power on|off
+             set sp|op value        in engineering units, e.g. set sp 42
+             stats                  task statistics
+             timing on|off|reset|show
+                                    control loop timing histograms, in
+                                    timer counts
+             trace dump|on|off      list the event trace ring, or start or
+                                    stop recording
+             \endcode
+             Each reply ends with "ok" or "error: " and the reason; the
+             characters are not echoed, so use the local echo of the
+             terminal. Values take the decimals of their signal in
+             signalUnitsConfig, and the PID coefficients
+             CONSOLE_SERIAL_GAIN_DECIMALS decimals; finer values are
+             refused rather than rounded: with whole percent, set sp 42.5
+             is a bad value. set replies with the value applied, e.g.
+             "sp 42 %". A setpoint is taken in automatic mode only and an
+             output in manual mode only, as in the menu; a setting made
+             during a menu edit leaves the edit alone.
+             \par
+             The receive interrupt stores each character straight into a
+             ring of CONSOLE_SERIAL_LINES line buffers, blocks of the
+             memory reclaimed from the start task (memBudget.h), where the
+             command is later split and run in place; at the end of a line
+             it posts the UI task, where consoleSerial_serve() runs it, so
+             the settings are still written by the UI task alone. The reply
+             is built in one buffer and sent from there by the transmit
+             interrupt, which adds a carriage return before each line feed.
+             Lines that arrive while the ring is full are dropped, and
+             counted in the stats reply. The trace dump is sent one reply
+             buffer at a time.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef CONSOLE_SERIAL_H
+#define CONSOLE_SERIAL_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+#include "stats.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Serial command console enable flag (compile time). */
+#define CONSOLE_SERIAL_ENABLED (1)
+
+/** SCI0 bit rate, in bits per second. */
+#define CONSOLE_SERIAL_BAUD (115200ul)
+
+/** Peripheral clock feeding SCI0, in Hz. */
+#define CONSOLE_SERIAL_PCLK_HZ (48000000ul)
+
+/** SCI0 bit rate register value for the PCLK/1 count source, rounded. */
+#define CONSOLE_SERIAL_BRR                                                  \
+    (((CONSOLE_SERIAL_PCLK_HZ + (16u * CONSOLE_SERIAL_BAUD)) /              \
+      (32u * CONSOLE_SERIAL_BAUD)) - 1u)
+
+#if (CONSOLE_SERIAL_BRR > 255u)
+#error "CONSOLE_SERIAL_BAUD too low for the PCLK/1 count source."
+#endif
+
+/** Received lines waiting for the UI task; a power of two. */
+#define CONSOLE_SERIAL_LINES (4u)
+
+#if (CONSOLE_SERIAL_LINES & (CONSOLE_SERIAL_LINES - 1u)) ||                 \
+    (CONSOLE_SERIAL_LINES > 128u)
+#error "CONSOLE_SERIAL_LINES must be a power of two, up to 128."
+#endif
+
+/** Reply buffer size; holds the whole stats reply. */
+#define CONSOLE_SERIAL_REPLY_SIZE (STATS_TEXT_SIZE + 32u)
+
+/** Decimals of the PID coefficients, shown and accepted. */
+#define CONSOLE_SERIAL_GAIN_DECIMALS (4u)
+
+/** Line error check period while no line comes, in milliseconds. */
+#define CONSOLE_SERIAL_POLL_MS (100u)
+
+/** Interrupt priority of SCI0; kernel-aware. */
+#define CONSOLE_SERIAL_IPL (3u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Take the line buffers from memBudget_pool(), set up SCI0 and its
+           pins, and start receiving. Without the buffers the console
+           stays off. Call after memBudget_reclaim().
+    \param notifyTCB Task posted at each line end and reply end; it must
+           call consoleSerial_serve().
+    \return None
+ */
+void consoleSerial_init (OS_TCB* notifyTCB);
+
+/**
+    \brief Check for work.
+    \return True if a line or the rest of a trace dump waits for
+            consoleSerial_serve() and the transmitter is free.
+ */
+bool consoleSerial_ready (void);
+
+/**
+    \brief Run the next received line, or continue a trace dump, and start
+           its reply; clear the line errors. Call from the task given to
+           consoleSerial_init(), when ready and every
+           CONSOLE_SERIAL_POLL_MS.
+    \return None
+ */
+void consoleSerial_serve (void);
+
+#endif /* CONSOLE_SERIAL_H */
@@ -10,7 +10,9 @@
 ******************************************************************************/
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "controller.h"
+#include "memBarrier.h"
 
 
 
@@ -18,14 +20,29 @@
 *                                  CONSTANTS                                  *
 ******************************************************************************/
 
-/** Controller b coefficient 1. */
-const float bc1 = 2.55025;
+/** Controller b coefficient 1, at start. */
+#define PID_BC1 (2.55025f)
 
-/** Controller b coefficient 2. */
-const float bc2 = 2.828;
+/** Controller b coefficient 2, at start. */
+#define PID_BC2 (2.828f)
 
-/** Controller b coefficient 3. */
-const float bc3 = 0.404;
+/** Controller b coefficient 3, at start. */
+#define PID_BC3 (0.404f)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Coefficient sets: the one in use and the one being written. */
+static PIDCoefficients coefficientSets[2] = {
+    { PID_BC1, PID_BC2, PID_BC3 },
+    { PID_BC1, PID_BC2, PID_BC3 }
+};
+
+/** Index of the set in use; a single byte store switches sets. */
+static volatile uint8_t coefficientsInUse = 0;
 
 
 
@@ -34,15 +51,19 @@ const float bc3 = 0.404;
 ******************************************************************************/
 
 int16_t getOP_PID (int16_t* u, int16_t* e) {
+    const PIDCoefficients* bc = &coefficientSets[coefficientsInUse];
     int16_t opNew;
 
     float t2 = 0.0;
     float t3 = 0.0;
     float t4 = 0.0;
 
-    t2 = bc1*e[0];
-    t3 = bc2*e[1];
-    t4 = bc3*e[2];
+    /* The set named by the index is whole. */
+    MEM_BARRIER_ACQUIRE();
+
+    t2 = bc->b1*e[0];
+    t3 = bc->b2*e[1];
+    t4 = bc->b3*e[2];
 
     opNew = (int16_t)(u[0] + t2 - t3 + t4);
 
@@ -68,3 +89,39 @@ int16_t getOP_onOff (int16_t er) {
 
     return opNew;
 }
+
+bool checkCoefficient_PID (float value) {
+    /* Comparisons are false for NaN; infinities are out of range. */
+    return (value > -PID_COEFFICIENT_MAX) && (value < PID_COEFFICIENT_MAX);
+}
+
+bool setCoefficients_PID (const PIDCoefficients* coefficients) {
+    uint8_t next = coefficientsInUse ^ 1u;
+
+    if (!(checkCoefficient_PID(coefficients->b1) &&
+          checkCoefficient_PID(coefficients->b2) &&
+          checkCoefficient_PID(coefficients->b3))) {
+        return false;
+    }
+
+    /* Fill the spare set, then switch to it; the set is whole before the
+       index names it. */
+    coefficientSets[next] = *coefficients;
+    MEM_BARRIER_RELEASE();
+    coefficientsInUse = next;
+
+    return true;
+}
+
+void getCoefficients_PID (PIDCoefficients* coefficients) {
+    const PIDCoefficients* bc = &coefficientSets[coefficientsInUse];
+
+    MEM_BARRIER_ACQUIRE();
+    *coefficients = *bc;
+}
+
+void insertArray (int16_t* array, int16_t data) {
+    array[2] = array[1];
+    array[1] = array[0];
+    array[0] = data;
+}
@@ -1,6 +1,12 @@
 /**
     \file controller.h
     \brief Header file for the controller library.
+    \details The PID coefficients can be changed while the loop runs. They
+             are kept in two sets: setCoefficients_PID() fills the spare
+             set and then switches to it with a single byte store, so
+             getOP_PID() always computes with one whole set. The writer
+             must run at a lower priority than every caller of getOP_PID(),
+             which then never sees a set half written.
     \date Dec 5, 2014
     \author Luis M. Gallegos C.
  */
@@ -8,6 +14,15 @@
 #ifndef PID_H
 #define PID_H
 
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
 /******************************************************************************
 *                                  CONSTANTS                                  *
 ******************************************************************************/
@@ -18,6 +33,23 @@
 /** Maximum allowed value for the controller output. */
 #define U_MAX 1023
 
+/** Magnitude bound of a PID coefficient. */
+#define PID_COEFFICIENT_MAX (1000.0f)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** PID controller b coefficients; op(k) = op(k-1) + b1 e(k) - b2 e(k-1)
+    + b3 e(k-2). */
+typedef struct PIDCoefficients_struct {
+    float b1;           /**< Coefficient of the current error. */
+    float b2;           /**< Coefficient of the previous error. */
+    float b3;           /**< Coefficient of the error before. */
+} PIDCoefficients;
+
 
 
 /******************************************************************************
@@ -39,4 +71,34 @@ int16_t getOP_PID (int16_t* u, int16_t* e);
  */
 int16_t getOP_onOff (int16_t er);
 
+/**
+    \brief Check one PID coefficient as setCoefficients_PID() does.
+    \param value Coefficient.
+    \return False if not a number or not within PID_COEFFICIENT_MAX.
+ */
+bool checkCoefficient_PID (float value);
+
+/**
+    \brief Replace the PID coefficients. Must not preempt getOP_PID().
+    \param coefficients New coefficients.
+    \return False, and nothing changed, if a coefficient is not a number
+            or not within PID_COEFFICIENT_MAX.
+ */
+bool setCoefficients_PID (const PIDCoefficients* coefficients);
+
+/**
+    \brief Get the PID coefficients in use.
+    \param coefficients Structure receiving the coefficients.
+    \return None.
+ */
+void getCoefficients_PID (PIDCoefficients* coefficients);
+
+/**
+    \brief Insert new value into an array of int16_t values.
+    \param array Pointer to array of values in which to insert new value.
+    \param data New value to insert.
+    \return None.
+ */
+void insertArray (int16_t* array, int16_t data);
+
 #endif /* PID_H */
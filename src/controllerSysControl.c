@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include "platform.h"
 #include "S12ADC.h"
+#include "units.h"
 #include "menu.h"
 #include "controllerSysControl.h"
 
@@ -21,9 +22,10 @@
 *                             EXTERNAL VARIABLES                              *
 ******************************************************************************/
 
-extern void* sysControl;
 extern PIDControl pid;
-extern ControllerControl controller;
+extern MenuControl menu;
+extern const UnitsConfig signalUnitsConfig[SIGNALS];
+extern UnitsRange signalUnits[SIGNALS];
 
 
 
@@ -31,6 +33,20 @@ extern ControllerControl controller;
 *                          FUNCTION IMPLEMENTATIONS                           *
 ******************************************************************************/
 
+void initUnits (void) {
+    uint8_t signal;
+
+    for (signal = 0; signal < SIGNALS; signal++) {
+        if (units_init(&signalUnits[signal],
+                       &signalUnitsConfig[signal]) == false) {
+            /* Invalid range configuration; stop here. */
+            while (1) {
+                ;
+            }
+        }
+    }
+}
+
 void initController (void) {
     int16_t pvADC_counts;
 
@@ -47,9 +63,6 @@ void initController (void) {
     /* Discard first two bits to have same resolution as DAC. */
     pvADC_counts = pvADC_counts >> 2;
 
-    /* Convert raw data to percent. */
-    pid.pvPercent = toPercent(pvADC_counts);
-
     /* Save raw data. */
     pid.pv = pvADC_counts;
 
@@ -60,241 +73,190 @@ void initController (void) {
     LED7 = LED_ON;
 }
 
-void onOffSelectionControl (uint8_t action) {
-    static uint8_t activeTemp = PID_OFF;
-
-    if (controller.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Nothing happens. */
-            break;
-            case 2:
-                activeTemp = pid.active;
-
-                /* Change to edit mode. */
-                controller.mode = EDIT;
-            break;
-            case 3:
-                /* Update selection. */
-                controller.selection = MAN_AUT_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = manAutSelectionControl;
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-                activeTemp = PID_ON;
-            break;
-            case 2:
-                if (activeTemp == PID_ON) {
-                    /* Turn controller on. */
-                    /* Turn LED4 on. */
-                    LED4 = LED_ON;
-
-                } else {
-                    /* Turn controller off. */
-                    /* Turn LED4 off. */
-                    LED4 = LED_OFF;
-                } 
-
-                pid.active = activeTemp;
-
-                /* Change to view mode. */
-                controller.mode = VIEW;
-            break;
-            case 3:
-                activeTemp = PID_OFF;
-            break;
-        }
+void onOffEditBegin (void) {
+    menu.activeTemp = pid.active;
+}
+
+void onOffSelectOn (void) {
+    menu.activeTemp = PID_ON;
+}
+
+void onOffSelectOff (void) {
+    menu.activeTemp = PID_OFF;
+}
+
+void onOffCommit (void) {
+    setActive(menu.activeTemp);
+}
+
+void setActive (uint8_t active) {
+    if (active == PID_ON) {
+        /* Turn controller on. */
+        /* Turn LED4 on. */
+        LED4 = LED_ON;
+    } else {
+        /* Turn controller off. */
+        /* Turn LED4 off. */
+        LED4 = LED_OFF;
+    }
+
+    /* Show the new setting, unless the option is being edited. */
+    if (menu.state != MENU_ON_OFF_EDIT) {
+        menu.activeTemp = active;
     }
+
+    pid.active = active;
 }
 
-void manAutSelectionControl (uint8_t action) {
-    static uint8_t modeTemp = PID_MAN;
-
-    if (controller.mode == VIEW) // VIEW mode
-        switch(action) {
-            case 1:
-                /* Update selection. */
-                controller.selection = ON_OFF_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = onOffSelectionControl;
-            break;
-            case 2:
-                modeTemp = pid.mode;
-
-                /* Change to edit mode. */
-                controller.mode = EDIT;
-            break;
-            case 3:
-                /* Update selection. */
-                controller.selection = SP_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = spSelectionControl;
-            break;
-        }
-    else { // EDIT mode
-        switch(action) {
-            case 1:
-                modeTemp = PID_MAN;
-            break;
-            case 2:
-                if (modeTemp == PID_MAN) {
-                    /* Switch controller to manual. */
-                    /* Turn LED7 on. */
-                    LED7 = LED_ON;
-
-                    /* Turn LED13 off. */
-                    LED13 = LED_OFF;
-
-                    pid.opPercent = toPercent(pid.op);
-                } else {
-                    /* Switch controller to automatic. */
-                    /* Turn LED13 on. */
-                    LED13 = LED_ON;
-
-                    /* Turn LED7 off. */
-                    LED7 = LED_OFF;
-
-                    pid.spPercent = toPercent(pid.sp);
-                }
-
-                pid.mode = modeTemp;
-
-                /* Change to view mode. */
-                controller.mode = VIEW;
-            break;
-            case 3:
-                modeTemp = PID_AUTO;
-            break;
-        }
+void manAutEditBegin (void) {
+    menu.modeTemp = pid.mode;
+}
+
+void manAutSelectMan (void) {
+    menu.modeTemp = PID_MAN;
+}
+
+void manAutSelectAut (void) {
+    menu.modeTemp = PID_AUTO;
+}
+
+void manAutCommit (void) {
+    setMode(menu.modeTemp);
+}
+
+void setMode (uint8_t mode) {
+    if (mode == PID_MAN) {
+        /* Switch controller to manual. */
+        /* Turn LED7 on. */
+        LED7 = LED_ON;
+
+        /* Turn LED13 off. */
+        LED13 = LED_OFF;
+
+        pid.opValue = toValue(SIGNAL_OP, pid.op);
+    } else {
+        /* Switch controller to automatic. */
+        /* Turn LED13 on. */
+        LED13 = LED_ON;
+
+        /* Turn LED7 off. */
+        LED7 = LED_OFF;
+
+        pid.spValue = toValue(SIGNAL_SP, pid.sp);
+    }
+
+    /* Show the new mode, unless the option is being edited. */
+    if (menu.state != MENU_MAN_AUT_EDIT) {
+        menu.modeTemp = mode;
+    }
+
+    /* A mode set from outside the menu ends a value edit it no longer
+       allows; the edited value is dropped. */
+    if ((mode == PID_MAN) && (menu.state == MENU_SP_EDIT)) {
+        menu.state = MENU_SP_VIEW;
+    } else if ((mode == PID_AUTO) && (menu.state == MENU_OP_EDIT)) {
+        menu.state = MENU_OP_VIEW;
     }
+
+    pid.mode = mode;
 }
 
-void spSelectionControl (uint8_t action) {
-    int16_t spTemp;
-    // static int8_t spPercentTemp;
-
-    if (controller.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Update selection. */
-                controller.selection = MAN_AUT_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = manAutSelectionControl;
-            break;
-            case 2:
-                /* Edit only allowed in automatic mode. */
-                if (pid.mode == PID_AUTO) {
-                    /* Change to edit mode. */
-                    controller.mode = EDIT;
-                    // spPercentTemp = pid.spPercent;
-                }
-            break;
-            case 3:
-                /* Update selection. */
-                controller.selection = OP_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = opSelectionControl;
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-                if (pid.spPercent < 100)
-                    pid.spPercent++;
-            break;
-            case 2:
-                /* Convert percent to raw data. */
-                spTemp = toRaw(pid.spPercent);
-
-                /* Update controller setting. */
-                pid.sp = spTemp;
-
-                /* Change to view mode. */
-                controller.mode = VIEW;
-
-                /* Save new percent value. */
-                // pid.spPercent = spPercentTemp;
-            break;
-            case 3:
-                if (pid.spPercent > 0)
-                    pid.spPercent--;
-            break;
-        }
+void spEditBegin (void) {
+    menu.spTemp = pid.spValue;
+}
+
+void spIncrement (void) {
+    if (menu.spTemp < signalUnitsConfig[SIGNAL_SP].euMax)
+        menu.spTemp++;
+}
+
+void spDecrement (void) {
+    if (menu.spTemp > signalUnitsConfig[SIGNAL_SP].euMin)
+        menu.spTemp--;
+}
+
+void spCommit (void) {
+    (void)setSetpoint(menu.spTemp);
+}
+
+uint8_t checkSetpoint (int32_t value) {
+    if (pid.mode != PID_AUTO) {
+        return PID_SETTING_REFUSED;
+    }
+
+    if ((value < signalUnitsConfig[SIGNAL_SP].euMin) ||
+        (value > signalUnitsConfig[SIGNAL_SP].euMax)) {
+        return PID_SETTING_BAD_VALUE;
     }
+
+    return PID_SETTING_OK;
 }
 
-void opSelectionControl (uint8_t action) {
-    int16_t opTemp;
-    // static int8_t opPercentTemp;
-
-    if (controller.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Update selection. */
-                controller.selection = SP_SEL;
-
-                /* Update PID system control pointer. */
-                sysControl = spSelectionControl;
-            break;
-            case 2:
-                /* Edit only allowed in manual mode. */
-                if (pid.mode == PID_MAN) {
-                    /* Change to edit mode. */
-                    controller.mode = EDIT;
-                    // pid.opPercentView = pid.opPercent;
-                }
-            break;
-            case 3:
-                /* Nothing happens. */
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-                if (pid.opPercent < 100)
-                    pid.opPercent++;
-            break;
-            case 2:
-                /* Convert percent to raw data. */
-                opTemp = toRaw(pid.opPercent);
-
-                /* Update controller setting. */
-                pid.op = opTemp;
-
-                /* Change to view mode. */
-                controller.mode = VIEW;
-
-                /* Save new percent value. */
-                // pid.opPercent = pid.opPercentView;
-            break;
-            case 3:
-                if (pid.opPercent > 0)
-                    pid.opPercent--;
-            break;
-        }
+uint8_t setSetpoint (int32_t value) {
+    uint8_t result = checkSetpoint(value);
+
+    if (result != PID_SETTING_OK) {
+        return result;
     }
+
+    /* Convert engineering units to raw data; update controller setting.
+       An edit in progress keeps its own value. */
+    pid.spValue = value;
+    pid.sp = toRaw(SIGNAL_SP, value);
+
+    return PID_SETTING_OK;
+}
+
+void opEditBegin (void) {
+    menu.opTemp = pid.opValue;
+}
+
+void opIncrement (void) {
+    if (menu.opTemp < signalUnitsConfig[SIGNAL_OP].euMax)
+        menu.opTemp++;
+}
+
+void opDecrement (void) {
+    if (menu.opTemp > signalUnitsConfig[SIGNAL_OP].euMin)
+        menu.opTemp--;
+}
+
+void opCommit (void) {
+    (void)setOutput(menu.opTemp);
 }
 
-int8_t toPercent (int16_t raw) {
-    int32_t temp;
+uint8_t checkOutput (int32_t value) {
+    if (pid.mode != PID_MAN) {
+        return PID_SETTING_REFUSED;
+    }
 
-    temp = 100*raw;
+    if ((value < signalUnitsConfig[SIGNAL_OP].euMin) ||
+        (value > signalUnitsConfig[SIGNAL_OP].euMax)) {
+        return PID_SETTING_BAD_VALUE;
+    }
 
-    return temp/1023;
+    return PID_SETTING_OK;
 }
 
-int16_t toRaw (int8_t percent) {
-    int32_t temp;
+uint8_t setOutput (int32_t value) {
+    uint8_t result = checkOutput(value);
+
+    if (result != PID_SETTING_OK) {
+        return result;
+    }
 
-    temp = 1023*percent;
+    /* Convert engineering units to raw data; update controller setting.
+       An edit in progress keeps its own value. */
+    pid.opValue = value;
+    pid.op = toRaw(SIGNAL_OP, value);
+
+    return PID_SETTING_OK;
+}
+
+int32_t toValue (uint8_t signal, int16_t raw) {
+    return units_toEu(&signalUnits[signal], raw);
+}
 
-    return temp/100;
+int16_t toRaw (uint8_t signal, int32_t value) {
+    return units_toRaw(&signalUnits[signal], value);
 }
@@ -8,6 +8,15 @@
 #ifndef PIDSYSCONTROL_H_
 #define PIDSYSCONTROL_H_
 
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
 /******************************************************************************
 *                                ENUMERATIONS                                 *
 ******************************************************************************/
@@ -24,6 +33,21 @@ enum PIDPowerMode {
     PID_OFF     /**< Controller off. */
 };
 
+/** Results of a setting from outside the menu. */
+enum PIDSettingResult {
+    PID_SETTING_OK,         /**< Applied, or would be. */
+    PID_SETTING_REFUSED,    /**< Not allowed in the current mode. */
+    PID_SETTING_BAD_VALUE   /**< Out of range. */
+};
+
+/** Signals with an engineering unit range. */
+enum SignalType {
+    SIGNAL_SP,  /**< Setpoint. */
+    SIGNAL_OP,  /**< Controller output. */
+    SIGNAL_PV,  /**< Process variable. */
+    SIGNALS     /**< Number of signals. */
+};
+
 
 
 /******************************************************************************
@@ -38,24 +62,21 @@ typedef struct PIDControl_struct {
     int16_t op;             /**< Controller output raw value. (0 - 1023)*/
     int16_t pv;             /**< Process variable raw value. (0 - 1023)*/
     int16_t er;             /**< Error raw value. (0 - 1023)*/
-    int8_t spPercent;       /**< Setpoint percent value. */
-    int8_t spPercentView;   /**< Displayed setpoint percent value. */
-    int8_t opPercent;       /**< Controller output percent value. */
-    int8_t opPercentView;   /**< Displayed controller output percent value. */
-    int8_t pvPercent;       /**< Process variable percent value. */
+    int32_t spValue;        /**< Setpoint in engineering units. */
+    int32_t opValue;        /**< Controller output in engineering units. */
 } PIDControl;
 
-/** General controller control structure. */
-typedef struct {
-    uint8_t selection;  /**< Selected menu value: on/off, man/auto, OP, SP. */
-    uint8_t mode;       /**< Controller mode, view or edit*/
-} ControllerControl;
-
 
 /******************************************************************************
 *                             FUNCTION PROTOTYPES                             *
 ******************************************************************************/
 
+/**
+    \brief Prepare the engineering unit range of every signal.
+    \return None.
+ */
+void initUnits (void);
+
 /**
     \brief Initialize controller and peripherals.
     \return None.
@@ -63,45 +84,164 @@ typedef struct {
 void initController (void);
 
 /**
-    \brief Controller actions when on/off option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Start editing the on/off option with the current setting.
+    \return None.
+ */
+void onOffEditBegin (void);
+
+/**
+    \brief Select controller on while editing.
+    \return None.
+ */
+void onOffSelectOn (void);
+
+/**
+    \brief Select controller off while editing.
+    \return None.
+ */
+void onOffSelectOff (void);
+
+/**
+    \brief Apply the edited on/off setting.
     \return None.
  */
-void onOffSelectionControl (uint8_t action);
+void onOffCommit (void);
 
 /**
-    \brief Controller actions when manual/automatic option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Switch the controller on or off, as a committed menu edit does.
+    \param active New setting: PID_ON or PID_OFF.
     \return None.
  */
-void manAutSelectionControl (uint8_t action);
+void setActive (uint8_t active);
 
 /**
-    \brief Controller actions when setpoint option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Start editing the manual/automatic option with the current
+           setting.
     \return None.
  */
-void spSelectionControl (uint8_t action);
+void manAutEditBegin (void);
 
 /**
-    \brief Controller actions when controller output option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Select manual mode while editing.
     \return None.
  */
-void opSelectionControl (uint8_t action);
+void manAutSelectMan (void);
+
+/**
+    \brief Select automatic mode while editing.
+    \return None.
+ */
+void manAutSelectAut (void);
+
+/**
+    \brief Apply the edited manual/automatic setting.
+    \return None.
+ */
+void manAutCommit (void);
+
+/**
+    \brief Switch the controller mode, as a committed menu edit does. A
+           setpoint or output edit the new mode does not allow is ended.
+    \param mode New mode: PID_MAN or PID_AUTO.
+    \return None.
+ */
+void setMode (uint8_t mode);
+
+/**
+    \brief Start editing the setpoint with the current setting.
+    \return None.
+ */
+void spEditBegin (void);
+
+/**
+    \brief Increment setpoint percent value while editing.
+    \return None.
+ */
+void spIncrement (void);
+
+/**
+    \brief Decrement setpoint percent value while editing.
+    \return None.
+ */
+void spDecrement (void);
+
+/**
+    \brief Apply the edited setpoint.
+    \return None.
+ */
+void spCommit (void);
+
+/**
+    \brief Check a setpoint as setSetpoint() does, without applying it. As
+           in the menu, the setpoint tracks the PV in manual mode.
+    \param value Setpoint in engineering units.
+    \return PIDSettingResult.
+ */
+uint8_t checkSetpoint (int32_t value);
+
+/**
+    \brief Apply a setpoint, as a committed menu edit does; an edit in
+           progress is left alone.
+    \param value Setpoint in engineering units.
+    \return PIDSettingResult; nothing changed unless PID_SETTING_OK.
+ */
+uint8_t setSetpoint (int32_t value);
+
+/**
+    \brief Start editing the controller output with the current setting.
+    \return None.
+ */
+void opEditBegin (void);
+
+/**
+    \brief Increment controller output percent value while editing.
+    \return None.
+ */
+void opIncrement (void);
+
+/**
+    \brief Decrement controller output percent value while editing.
+    \return None.
+ */
+void opDecrement (void);
+
+/**
+    \brief Apply the edited controller output.
+    \return None.
+ */
+void opCommit (void);
+
+/**
+    \brief Check a controller output as setOutput() does, without applying
+           it. As in the menu, the output is the controller's in automatic
+           mode.
+    \param value Controller output in engineering units.
+    \return PIDSettingResult.
+ */
+uint8_t checkOutput (int32_t value);
+
+/**
+    \brief Apply a controller output, as a committed menu edit does; an
+           edit in progress is left alone.
+    \param value Controller output in engineering units.
+    \return PIDSettingResult; nothing changed unless PID_SETTING_OK.
+ */
+uint8_t setOutput (int32_t value);
 
 /**
-    \brief Convert raw value to percent value.
+    \brief Convert a raw value to the engineering units of a signal.
+    \param signal Signal type.
     \param raw Raw value.
-    \return Percent value.
+    \return Value in engineering units.
  */
-int8_t toPercent (int16_t raw);
+int32_t toValue (uint8_t signal, int16_t raw);
 
 /**
-    \brief Convert percent value to raw value.
-    \param percent Percent value.
+    \brief Convert a value in the engineering units of a signal to raw.
+    \param signal Signal type.
+    \param value Value in engineering units.
     \return Raw value.
  */
-int16_t toRaw (int8_t percent);
+int16_t toRaw (uint8_t signal, int32_t value);
 
 #endif /* PIDSYSCONTROL_H_ */
@@ -0,0 +1,93 @@
+/**
+    \file coroutine.c
+    \brief Implementation file for the stackless coroutine library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "coroutine.h"
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void coroutine_schedInit (CoroutineScheduler* sched) {
+    sched->head = NULL;
+}
+
+void coroutine_add (CoroutineScheduler* sched, Coroutine* cr,
+                    uint8_t (*body)(Coroutine* cr)) {
+    Coroutine** link = &sched->head;
+
+    cr->body   = body;
+    cr->next   = NULL;
+    cr->now    = 0;
+    cr->wake   = 0;
+    cr->resume = 0;
+    cr->wait   = COROUTINE_WAIT_NONE;
+    cr->status = COROUTINE_WAITING;
+
+    /* Append, so coroutines run in the order they were added. */
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+
+    *link = cr;
+}
+
+uint32_t coroutine_run (CoroutineScheduler* sched, uint32_t now) {
+    Coroutine* cr;
+    uint32_t next = COROUTINE_FOREVER;
+    uint32_t remaining;
+
+    for (cr = sched->head; cr != NULL; cr = cr->next) {
+        if (cr->status == COROUTINE_ENDED) {
+            continue;
+        }
+
+        /* Resume unless sleeping on a deadline still in the future. */
+        if ((cr->wait != COROUTINE_WAIT_SLEEP) || coroutine_expired(cr, now)) {
+            cr->now = now;
+            cr->wait = COROUTINE_WAIT_NONE;
+            cr->status = (*cr->body)(cr);
+
+            if (cr->status == COROUTINE_ENDED) {
+                continue;
+            }
+        }
+
+        /* Find out when this coroutine needs the next pass. */
+        switch (cr->wait) {
+            case COROUTINE_WAIT_SLEEP:
+            case COROUTINE_WAIT_TIMED:
+                remaining = coroutine_expired(cr, now) ? 0u : cr->wake - now;
+            break;
+            case COROUTINE_WAIT_EVENT:
+                remaining = COROUTINE_FOREVER;
+            break;
+            default:
+                remaining = 0u;
+            break;
+        }
+
+        if (remaining < next) {
+            next = remaining;
+        }
+    }
+
+    return next;
+}
+
+bool coroutine_expired (const Coroutine* cr, uint32_t now) {
+    /* Wrap-safe comparison of free-running ticks. */
+    return ((int32_t)(now - cr->wake) >= 0);
+}
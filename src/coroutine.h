@@ -0,0 +1,187 @@
+/**
+    \file coroutine.h
+    \brief Header file for the stackless coroutine library.
+    \details Protothread-style coroutines let several cooperative activities
+             share one kernel task and one stack. A coroutine body is a
+             plain function that resumes where it last waited, through a
+             switch on the saved resume point; local variables are not kept
+             across waits, so any state that must survive a wait has to be
+             static or live in a structure.
+             \par
+             The scheduler has no kernel dependency: the owning task passes
+             the current tick to coroutine_run() and sleeps for the number of
+             ticks it returns, or until something posts the task.
+             \par
+             Restrictions: at most one wait macro per source line, and no
+             wait macro inside a switch statement of the coroutine body.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Value returned by coroutine_run() when no coroutine has a deadline. */
+#define COROUTINE_FOREVER (0xFFFFFFFFul)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Coroutine body return values. */
+enum CoroutineStatusType {
+    COROUTINE_WAITING,  /**< Coroutine is waiting; run it again later. */
+    COROUTINE_ENDED     /**< Coroutine has finished; never run again. */
+};
+
+/** What a waiting coroutine is waiting for. */
+enum CoroutineWaitType {
+    COROUTINE_WAIT_NONE,    /**< Nothing; resume on the next pass. */
+    COROUTINE_WAIT_EVENT,   /**< A condition; checked on every pass. */
+    COROUTINE_WAIT_TIMED,   /**< A condition or a deadline. */
+    COROUTINE_WAIT_SLEEP    /**< A deadline; not run until it expires. */
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+#if defined(__GNUC__) && (__GNUC__ >= 7)
+/** Marks the wait macros' fall into their resume point as intended, for
+    -Wimplicit-fallthrough. */
+#define COROUTINE_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define COROUTINE_FALLTHROUGH
+#endif
+
+/** Start of a coroutine body. */
+#define COROUTINE_BEGIN(cr) switch ((cr)->resume) { case 0u:
+
+/** End of a coroutine body. */
+#define COROUTINE_END(cr) } (cr)->resume = 0u; return COROUTINE_ENDED
+
+/** Give way to the other coroutines; resume on the next pass. */
+#define COROUTINE_YIELD(cr)                                                 \
+    do {                                                                    \
+        (cr)->resume = __LINE__;                                            \
+        return COROUTINE_WAITING;                                           \
+        case __LINE__: ;                                                    \
+    } while (0)
+
+/** Wait until a condition holds. */
+#define COROUTINE_WAIT_UNTIL(cr, cond)                                      \
+    do {                                                                    \
+        (cr)->resume = __LINE__;                                            \
+        COROUTINE_FALLTHROUGH;                                              \
+        case __LINE__:                                                      \
+        if (!(cond)) {                                                      \
+            (cr)->wait = COROUTINE_WAIT_EVENT;                              \
+            return COROUTINE_WAITING;                                       \
+        }                                                                   \
+    } while (0)
+
+/** Wait until a condition holds or a number of ticks has elapsed. */
+#define COROUTINE_WAIT_TIMEOUT(cr, cond, ticks)                             \
+    do {                                                                    \
+        (cr)->wake = (cr)->now + (uint32_t)(ticks);                         \
+        (cr)->resume = __LINE__;                                            \
+        COROUTINE_FALLTHROUGH;                                              \
+        case __LINE__:                                                      \
+        if (!(cond) && !coroutine_expired((cr), (cr)->now)) {               \
+            (cr)->wait = COROUTINE_WAIT_TIMED;                              \
+            return COROUTINE_WAITING;                                       \
+        }                                                                   \
+    } while (0)
+
+/** Sleep for a number of ticks. */
+#define COROUTINE_DELAY(cr, ticks)                                          \
+    do {                                                                    \
+        (cr)->wake = (cr)->now + (uint32_t)(ticks);                         \
+        (cr)->wait = COROUTINE_WAIT_SLEEP;                                  \
+        (cr)->resume = __LINE__;                                            \
+        return COROUTINE_WAITING;                                           \
+        case __LINE__: ;                                                    \
+    } while (0)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Coroutine control structure. */
+typedef struct Coroutine_struct {
+    uint8_t (*body)(struct Coroutine_struct* cr); /**< Coroutine body. */
+    struct Coroutine_struct* next;  /**< Next coroutine in the scheduler. */
+    uint32_t now;       /**< Tick of the current scheduler pass. */
+    uint32_t wake;      /**< Deadline tick for timed waits. */
+    uint16_t resume;    /**< Resume point; zero to start from the top. */
+    uint8_t wait;       /**< What the coroutine is waiting for. */
+    uint8_t status;     /**< Last status returned by the body. */
+} Coroutine;
+
+/** Coroutine scheduler structure. */
+typedef struct CoroutineScheduler_struct {
+    Coroutine* head;    /**< First coroutine, run first on every pass. */
+} CoroutineScheduler;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize an empty scheduler.
+    \param sched Pointer to scheduler.
+    \return None
+ */
+void coroutine_schedInit (CoroutineScheduler* sched);
+
+/**
+    \brief Initialize a coroutine and append it to a scheduler.
+    \details Coroutines run in the order they were added.
+    \param sched Pointer to scheduler.
+    \param cr Pointer to coroutine control structure.
+    \param body Coroutine body.
+    \return None
+ */
+void coroutine_add (CoroutineScheduler* sched, Coroutine* cr,
+                    uint8_t (*body)(Coroutine* cr));
+
+/**
+    \brief Run one scheduler pass: every coroutine that is not sleeping on a
+           deadline still in the future is resumed once.
+    \param sched Pointer to scheduler.
+    \param now Current tick.
+    \return Ticks until the earliest deadline; zero if a coroutine yielded,
+            COROUTINE_FOREVER if only events can wake a coroutine.
+ */
+uint32_t coroutine_run (CoroutineScheduler* sched, uint32_t now);
+
+/**
+    \brief Check whether a coroutine deadline has been reached.
+    \param cr Pointer to coroutine control structure.
+    \param now Current tick.
+    \return True if the deadline has been reached.
+ */
+bool coroutine_expired (const Coroutine* cr, uint32_t now);
+
+#endif /* COROUTINE_H */
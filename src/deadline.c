@@ -0,0 +1,90 @@
+/**
+    \file deadline.c
+    \brief Implementation file for the control cycle deadline monitor
+           library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "deadline.h"
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void deadline_init (DeadlineMonitor* monitor, uint32_t period,
+                    uint32_t deadline, uint8_t policy, uint32_t now) {
+    monitor->period = period;
+    monitor->deadline = (deadline < period) ? deadline : period;
+    monitor->policy = policy;
+    monitor->alarm = false;
+    monitor->release = now;
+    monitor->cycles = 0;
+    monitor->misses = 0;
+    monitor->skipped = 0;
+    monitor->caughtUp = 0;
+    monitor->maxLateness = 0;
+}
+
+uint32_t deadline_end (DeadlineMonitor* monitor, uint32_t now) {
+    /* Unsigned differences stay right across a tick counter wrap. */
+    uint32_t elapsed = now - monitor->release;
+    uint32_t next = monitor->release + monitor->period;
+    uint32_t behind;
+    uint32_t dropped;
+
+    monitor->cycles++;
+
+    if (elapsed > monitor->deadline) {
+        monitor->misses++;
+
+        if ((elapsed - monitor->deadline) > monitor->maxLateness) {
+            monitor->maxLateness = elapsed - monitor->deadline;
+        }
+
+        if (monitor->policy == DEADLINE_SAFE) {
+            monitor->alarm = true;
+        }
+    }
+
+    if (elapsed <= monitor->period) {
+        /* On schedule: the next release is now or later. */
+        monitor->release = next;
+
+        return next - now;
+    }
+
+    behind = elapsed - monitor->period;
+
+    if ((monitor->policy == DEADLINE_CATCH_UP) &&
+        (behind <= (DEADLINE_MAX_CATCH_UP * monitor->period))) {
+        /* Run the missed release right away, on the original grid. */
+        monitor->release = next;
+        monitor->caughtUp++;
+
+        return 0;
+    }
+
+    /* Drop every release before now; resume on the original grid. */
+    dropped = ((behind - 1u) / monitor->period) + 1u;
+    monitor->release = next + (dropped * monitor->period);
+    monitor->skipped += dropped;
+
+    return monitor->release - now;
+}
+
+bool deadline_alarm (const DeadlineMonitor* monitor) {
+    return monitor->alarm;
+}
+
+void deadline_clearAlarm (DeadlineMonitor* monitor) {
+    monitor->alarm = false;
+}
@@ -0,0 +1,129 @@
+/**
+    \file deadline.h
+    \brief Header file for the control cycle deadline monitor library.
+    \details The monitor keeps the release schedule of a periodic task in
+             kernel ticks: cycle k is released at start + k * period and
+             must complete within deadline ticks of its release. The task
+             calls deadline_end() when a cycle completes; the call checks
+             the deadline, updates the counters and returns the delay to
+             the next release, so the task runs on an absolute schedule
+             instead of sleeping a fixed time after each cycle.
+             \par
+             A cycle that completes later than its deadline is a miss. What
+             happens to the releases it ran into depends on the policy:
+             - DEADLINE_SKIP: releases already past are dropped and the
+               output holds its last value until the next release on the
+               original grid;
+             - DEADLINE_CATCH_UP: every release runs, back to back, until
+               the task is on schedule again; a backlog of more than
+               DEADLINE_MAX_CATCH_UP periods is dropped as with skip;
+             - DEADLINE_SAFE: as skip, and the alarm is latched so the task
+               drives its output to a safe value until deadline_clearAlarm().
+             \par
+             A check is a subtraction and a compare per cycle, plus one
+             division when releases were missed. Resolution is one kernel
+             tick; loopTiming.h gives finer timing. Counters are written
+             only by the monitored task; other tasks may read them.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Deadline monitor enable flag (compile time). */
+#define DEADLINE_ENABLED (1)
+
+/** Largest backlog, in periods, the catch-up policy runs back to back. */
+#define DEADLINE_MAX_CATCH_UP (2u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Overrun policies. */
+enum DeadlinePolicyType {
+    DEADLINE_SKIP,          /**< Drop missed releases; hold the output. */
+    DEADLINE_CATCH_UP,      /**< Run missed releases back to back. */
+    DEADLINE_SAFE           /**< Drop missed releases; latch the alarm. */
+};
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Deadline monitor of one periodic task; times in kernel ticks. */
+typedef struct DeadlineMonitor_struct {
+    uint32_t period;        /**< Release period. */
+    uint32_t deadline;      /**< Completion deadline after each release. */
+    uint8_t policy;         /**< Overrun policy. */
+    volatile bool alarm;    /**< Miss seen under DEADLINE_SAFE. */
+    uint32_t release;       /**< Release time of the current cycle. */
+    uint32_t cycles;        /**< Cycles completed. */
+    uint32_t misses;        /**< Cycles completed past their deadline. */
+    uint32_t skipped;       /**< Releases dropped. */
+    uint32_t caughtUp;      /**< Releases run late, back to back. */
+    uint32_t maxLateness;   /**< Longest completion past the deadline. */
+} DeadlineMonitor;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize a monitor, with counters cleared and the first cycle
+           released now.
+    \param monitor Pointer to the monitor.
+    \param period Release period, in ticks; not zero.
+    \param deadline Completion deadline after each release, in ticks; up to
+           the period.
+    \param policy Overrun policy.
+    \param now Current time, in ticks.
+    \return None
+ */
+void deadline_init (DeadlineMonitor* monitor, uint32_t period,
+                    uint32_t deadline, uint8_t policy, uint32_t now);
+
+/**
+    \brief Check the completion of the current cycle and move to the next
+           release, following the policy on a miss.
+    \param monitor Pointer to the monitor.
+    \param now Current time, in ticks.
+    \return Ticks to wait for the next release; zero to run it right away.
+ */
+uint32_t deadline_end (DeadlineMonitor* monitor, uint32_t now);
+
+/**
+    \brief Tell whether the alarm is latched.
+    \param monitor Pointer to the monitor.
+    \return True after a miss under DEADLINE_SAFE, until cleared.
+ */
+bool deadline_alarm (const DeadlineMonitor* monitor);
+
+/**
+    \brief Clear the alarm.
+    \param monitor Pointer to the monitor.
+    \return None
+ */
+void deadline_clearAlarm (DeadlineMonitor* monitor);
+
+#endif /* DEADLINE_H */
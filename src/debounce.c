@@ -0,0 +1,107 @@
+/**
+    \file debounce.c
+    \brief Implementation file for the switch debouncing state machine.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "debounce.h"
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void debounce_init (DebounceControlType* ctrl, uint8_t periodMs,
+                    uint8_t repeatMask) {
+    uint8_t key;
+
+    ctrl->state = 0;
+    ctrl->count0 = 0;
+    ctrl->count1 = 0;
+    ctrl->repeatMask = repeatMask;
+    ctrl->longTicks = (uint8_t)(DEBOUNCE_LONG_PRESS_MS / periodMs);
+    ctrl->repeatTicks = (uint8_t)(DEBOUNCE_REPEAT_START_MS / periodMs);
+
+    if (ctrl->repeatTicks == 0) {
+        ctrl->repeatTicks = 1;
+    }
+
+    for (key = 0; key < DEBOUNCE_KEYS; key++) {
+        ctrl->hold[key] = 0;
+        ctrl->countdown[key] = 0;
+        ctrl->interval[key] = 0;
+    }
+}
+
+uint8_t debounce_update (DebounceControlType* ctrl, uint8_t sample,
+                         uint8_t* events) {
+    uint8_t delta;
+    uint8_t toggle;
+    uint8_t key;
+    uint8_t mask;
+    uint8_t count = 0;
+
+    /* Vertical counter: each input whose sample differs from its debounced
+       state counts 1, 2, 3, 0; it toggles when the count wraps. Inputs that
+       match their state have their counter cleared. */
+    delta = sample ^ ctrl->state;
+    ctrl->count1 = (ctrl->count1 ^ ctrl->count0) & delta;
+    ctrl->count0 = (uint8_t)(~ctrl->count0) & delta;
+    toggle = delta & (uint8_t)~(ctrl->count0 | ctrl->count1);
+    ctrl->state ^= toggle;
+
+    /* Per key events. */
+    for (key = 0, mask = 0x01; key < DEBOUNCE_KEYS; key++, mask <<= 1) {
+        if (toggle & mask) {
+            if (ctrl->state & mask) {
+                /* KEY PRESSED. */
+                events[count++] = KEY_EVENT(KEY_EVENT_PRESS, key + 1);
+                ctrl->hold[key] = 0;
+            } else {
+                /* KEY RELEASED. */
+                events[count++] = KEY_EVENT(KEY_EVENT_RELEASE, key + 1);
+                ctrl->interval[key] = 0;
+            }
+        } else if (ctrl->state & mask) {
+            /* KEY HELD. */
+            if (ctrl->hold[key] < UINT8_MAX) {
+                ctrl->hold[key]++;
+            }
+
+            if (ctrl->hold[key] == ctrl->longTicks) {
+                events[count++] = KEY_EVENT(KEY_EVENT_LONG, key + 1);
+
+                /* Start auto-repeat. */
+                if (ctrl->repeatMask & mask) {
+                    ctrl->interval[key] = ctrl->repeatTicks;
+                    ctrl->countdown[key] = ctrl->repeatTicks;
+                }
+            } else if (ctrl->interval[key] != 0) {
+                if (--ctrl->countdown[key] == 0) {
+                    events[count++] = KEY_EVENT(KEY_EVENT_REPEAT, key + 1);
+
+                    /* Accelerate: halve the interval down to one sample. */
+                    if (ctrl->interval[key] > 1) {
+                        ctrl->interval[key] >>= 1;
+                    }
+
+                    ctrl->countdown[key] = ctrl->interval[key];
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+bool debounce_idle (const DebounceControlType* ctrl) {
+    return (ctrl->state == 0) && ((ctrl->count0 | ctrl->count1) == 0);
+}
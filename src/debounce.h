@@ -0,0 +1,132 @@
+/**
+    \file debounce.h
+    \brief Header file for the switch debouncing state machine.
+    \details Hardware independent: it is fed one sample of up to eight key
+             inputs per debounce period (bit set = key pressed). All inputs
+             are debounced in parallel with a two-bit vertical counter: an
+             input must read the same for DEBOUNCE_SAMPLES consecutive
+             samples before its debounced state changes. On top of the
+             debounced state each key generates press, release and
+             long-press events, and keys in the repeat mask generate
+             auto-repeat events whose interval shrinks while held.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Consecutive equal samples needed to change a debounced key state. */
+#define DEBOUNCE_SAMPLES (4)
+
+#if (DEBOUNCE_SAMPLES != 4)
+#error "The two-bit vertical counter counts exactly four samples."
+#endif
+
+/** Number of keys with press/release/long-press/repeat events. */
+#define DEBOUNCE_KEYS (3)
+
+/** Hold time before a long-press event, in milliseconds. */
+#define DEBOUNCE_LONG_PRESS_MS (400u)
+
+/** First auto-repeat interval after a long press, in milliseconds. */
+#define DEBOUNCE_REPEAT_START_MS (80u)
+
+
+/** Key pressed event type. */
+#define KEY_EVENT_PRESS (0x00)
+
+/** Key released event type. */
+#define KEY_EVENT_RELEASE (0x10)
+
+/** Key held past DEBOUNCE_LONG_PRESS_MS event type. */
+#define KEY_EVENT_LONG (0x20)
+
+/** Key auto-repeat event type. */
+#define KEY_EVENT_REPEAT (0x30)
+
+/** Maximum number of events generated by one debounce_update() call: each
+    key makes at most one. */
+#define DEBOUNCE_MAX_EVENTS (DEBOUNCE_KEYS)
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Build key event from event type and key number (1 - DEBOUNCE_KEYS). */
+#define KEY_EVENT(type, key) ((uint8_t)((type) | (key)))
+
+/** Get event type from key event. */
+#define KEY_EVENT_TYPE(event) ((uint8_t)((event) & 0xF0))
+
+/** Get key number from key event. */
+#define KEY_EVENT_KEY(event) ((uint8_t)((event) & 0x0F))
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Debounce control structure. */
+typedef struct DebounceControlType_struct {
+    uint8_t state;                      /**< Debounced key states. */
+    uint8_t count0;                     /**< Vertical counter, bit 0. */
+    uint8_t count1;                     /**< Vertical counter, bit 1. */
+    uint8_t repeatMask;                 /**< Keys with auto-repeat. */
+    uint8_t longTicks;                  /**< Long-press time in samples. */
+    uint8_t repeatTicks;                /**< First repeat interval. */
+    uint8_t hold[DEBOUNCE_KEYS];        /**< Samples each key was held. */
+    uint8_t countdown[DEBOUNCE_KEYS];   /**< Samples to next repeat. */
+    uint8_t interval[DEBOUNCE_KEYS];    /**< Current repeat interval. */
+} DebounceControlType;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize debounce control structure, all keys released.
+    \param ctrl Pointer to debounce control structure.
+    \param periodMs Sampling period in milliseconds.
+    \param repeatMask Keys that auto-repeat when held (bit 0 = key 1).
+    \return None
+ */
+void debounce_init (DebounceControlType* ctrl, uint8_t periodMs,
+                    uint8_t repeatMask);
+
+/**
+    \brief Feed a new key sample to the debounce state machine.
+    \param ctrl Pointer to debounce control structure.
+    \param sample Key sample, bit set = key pressed (bit 0 = key 1).
+    \param events Array receiving up to DEBOUNCE_MAX_EVENTS key events.
+    \return Number of key events written.
+ */
+uint8_t debounce_update (DebounceControlType* ctrl, uint8_t sample,
+                         uint8_t* events);
+
+/**
+    \brief Check if the debounce state machine can be left unattended.
+    \param ctrl Pointer to debounce control structure.
+    \return True if every key is released and no change is being counted.
+ */
+bool debounce_idle (const DebounceControlType* ctrl);
+
+#endif /* DEBOUNCE_H */
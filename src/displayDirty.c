@@ -0,0 +1,152 @@
+/**
+    \file displayDirty.c
+    \brief Implementation file for the LCD field change tracking library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+#include "controllerSysControl.h"
+#include "memBarrier.h"
+#include "displayDirty.h"
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Dirty flag per field; one byte each so no read-modify-write is shared. */
+static volatile uint8_t dirty[DISPLAY_FIELDS] = {1, 1, 1, 1, 1, 1};
+
+/** Task signaled when a field becomes dirty. */
+static OS_TCB* notifyTCB = (OS_TCB*)0;
+
+/* Values last marked for display. Only touched by the publishing task. */
+
+/** Controller mode last marked; SP and OP are drawn differently per mode. */
+static uint8_t markedMode = PID_MAN;
+
+/** Setpoint value last marked, in engineering units. */
+static int32_t markedSp = 0;
+
+/** Controller output value last marked, in engineering units. */
+static int32_t markedOp = 0;
+
+/** Process variable raw value last marked. */
+static int16_t markedPv = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Raise the dirty flag of a field.
+    \param field Tracked field.
+    \return True if the flag was clear, i.e. the UI must be signaled.
+ */
+static bool displayDirty_mark (uint8_t field);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void displayDirty_init (OS_TCB* notify) {
+    uint8_t field;
+
+    notifyTCB = notify;
+
+    for (field = 0; field < DISPLAY_FIELDS; field++) {
+        dirty[field] = 1;
+    }
+}
+
+void displayDirty_check (const PIDControl* source) {
+    OS_ERR err;
+    bool notify = false;
+    int32_t sp = toValue(SIGNAL_SP, source->sp);
+    int32_t op = toValue(SIGNAL_OP, source->op);
+    int16_t pvChange = source->pv - markedPv;
+
+    if (source->mode != markedMode) {
+        markedMode = source->mode;
+        notify |= displayDirty_mark(DISPLAY_SP);
+        notify |= displayDirty_mark(DISPLAY_OP);
+    }
+
+    if (sp != markedSp) {
+        markedSp = sp;
+        notify |= displayDirty_mark(DISPLAY_SP);
+    }
+
+    if (op != markedOp) {
+        markedOp = op;
+        notify |= displayDirty_mark(DISPLAY_OP);
+    }
+
+    /* PV noise within the deadband is not worth a redraw. */
+    if ((pvChange >= DISPLAY_PV_DEADBAND) ||
+        (pvChange <= -DISPLAY_PV_DEADBAND)) {
+        markedPv = source->pv;
+        notify |= displayDirty_mark(DISPLAY_PV);
+    }
+
+    /* Only a clear-to-dirty change is signaled; while fields are pending
+       the UI picks them up without further posts. */
+    if (notify && (notifyTCB != (OS_TCB*)0)) {
+        OSTaskSemPost(notifyTCB, OS_OPT_POST_NONE, &err);
+    }
+}
+
+void displayDirty_set (uint8_t field) {
+    OS_ERR err;
+
+    if (displayDirty_mark(field) && (notifyTCB != (OS_TCB*)0)) {
+        OSTaskSemPost(notifyTCB, OS_OPT_POST_NONE, &err);
+    }
+}
+
+bool displayDirty_pending (void) {
+    uint8_t field;
+
+    for (field = 0; field < DISPLAY_FIELDS; field++) {
+        if (dirty[field] != 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool displayDirty_take (uint8_t field) {
+    bool wasDirty = (dirty[field] != 0);
+
+    if (wasDirty) {
+        dirty[field] = 0;
+
+        /* Flag must be cleared before the field's value is read. */
+        MEM_BARRIER_FULL();
+    }
+
+    return wasDirty;
+}
+
+static bool displayDirty_mark (uint8_t field) {
+    bool wasClear = (dirty[field] == 0);
+
+    /* Value was published before the flag is raised. */
+    MEM_BARRIER_RELEASE();
+    dirty[field] = 1;
+
+    return wasClear;
+}
@@ -0,0 +1,101 @@
+/**
+    \file displayDirty.h
+    \brief Header file for the LCD field change tracking library.
+    \details ControllerTask checks every published loop state against what
+             was last marked for display and raises a per-field dirty flag
+             only when the displayed value would change; PV is compared
+             with a deadband so noise does not redraw it. Raising a flag
+             posts the UI task once, until the flag is taken again.
+             \par
+             The UI takes (clears) a flag before reading the snapshot, so a
+             change published while the field is being drawn raises the
+             flag again instead of being lost.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef DISPLAYDIRTY_H
+#define DISPLAYDIRTY_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+#include "controllerSysControl.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** PV change, in raw counts (0 - 1023), needed to redraw PV. */
+#define DISPLAY_PV_DEADBAND (4)
+
+/** Minimum time between two LCD value refreshes, in milliseconds. */
+#define DISPLAY_MIN_PERIOD_MS (50u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Tracked LCD fields. */
+enum DisplayFieldType {
+    DISPLAY_SP,     /**< Setpoint value. */
+    DISPLAY_OP,     /**< Controller output value. */
+    DISPLAY_PV,     /**< Process variable value. */
+    DISPLAY_TREND,  /**< Trend chart. */
+    DISPLAY_DIAG,   /**< Diagnostics values. */
+    DISPLAY_MODE,   /**< Mode or on/off setting, set outside the menu. */
+    DISPLAY_FIELDS  /**< Number of tracked fields. */
+};
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize change tracking with every field dirty.
+    \param notify Task to be signaled, through its task semaphore, when a
+           field becomes dirty.
+    \return None
+ */
+void displayDirty_init (OS_TCB* notify);
+
+/**
+    \brief Mark the fields whose displayed value changed. Only the task that
+           publishes the loop state may call this, right after publishing.
+    \param source Pointer to the PID control structure just published.
+    \return None
+ */
+void displayDirty_check (const PIDControl* source);
+
+/**
+    \brief Mark a field dirty unconditionally. Each field may only be set
+           from one task.
+    \param field Tracked field.
+    \return None
+ */
+void displayDirty_set (uint8_t field);
+
+/**
+    \brief Check whether any field is dirty.
+    \return True if at least one field is dirty.
+ */
+bool displayDirty_pending (void);
+
+/**
+    \brief Take a field for redrawing: clear its dirty flag.
+    \param field Tracked field.
+    \return True if the field was dirty.
+ */
+bool displayDirty_take (uint8_t field);
+
+#endif /* DISPLAYDIRTY_H */
@@ -0,0 +1,77 @@
+/**
+    \file eventQueue.c
+    \brief Implementation file for the single-producer/single-consumer event
+           queue.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "memBarrier.h"
+#include "eventQueue.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Mask for wrapping free-running indices into the event storage. */
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1u)
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void eventQueue_init (EventQueue* queue) {
+    queue->head = 0;
+    queue->tail = 0;
+    queue->dropped = 0;
+}
+
+bool eventQueue_post (EventQueue* queue, uint8_t event) {
+    uint8_t head = queue->head;
+
+    /* Indices run freely; their difference is the fill level. */
+    if ((uint8_t)(head - queue->tail) >= EVENT_QUEUE_SIZE) {
+        queue->dropped++;
+        return false;
+    }
+
+    queue->events[head & EVENT_QUEUE_MASK] = event;
+
+    /* Event must be stored before it is made visible. */
+    MEM_BARRIER_RELEASE();
+    queue->head = head + 1u;
+
+    return true;
+}
+
+bool eventQueue_get (EventQueue* queue, uint8_t* event) {
+    uint8_t tail = queue->tail;
+
+    if (tail == queue->head) {
+        return false;
+    }
+
+    /* Event must be read after its slot was seen as filled. */
+    MEM_BARRIER_ACQUIRE();
+    *event = queue->events[tail & EVENT_QUEUE_MASK];
+
+    /* Slot must be read before it is handed back to the producer. */
+    MEM_BARRIER_RELEASE();
+    queue->tail = tail + 1u;
+
+    return true;
+}
+
+bool eventQueue_isEmpty (const EventQueue* queue) {
+    return (queue->tail == queue->head);
+}
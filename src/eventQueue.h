@@ -0,0 +1,85 @@
+/**
+    \file eventQueue.h
+    \brief Header file for the single-producer/single-consumer event queue.
+    \details Lock-free ring of one-byte events. Exactly one task (or ISR)
+             may post and exactly one task may get; neither side ever
+             blocks or disables interrupts.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Event queue capacity. Must be a power of two, up to 128. */
+#define EVENT_QUEUE_SIZE (16u)
+
+#if ((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1u)) != 0u) || \
+    (EVENT_QUEUE_SIZE > 128u)
+#error "EVENT_QUEUE_SIZE must be a power of two, up to 128."
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Event queue structure. */
+typedef struct EventQueue_struct {
+    volatile uint8_t head;              /**< Next slot to write (producer). */
+    volatile uint8_t tail;              /**< Next slot to read (consumer). */
+    uint8_t dropped;                    /**< Events dropped, queue full. */
+    uint8_t events[EVENT_QUEUE_SIZE];   /**< Event storage. */
+} EventQueue;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize an empty event queue.
+    \param queue Pointer to event queue.
+    \return None
+ */
+void eventQueue_init (EventQueue* queue);
+
+/**
+    \brief Post an event. Producer side only.
+    \param queue Pointer to event queue.
+    \param event Event to post.
+    \return True if posted, false if the queue was full.
+ */
+bool eventQueue_post (EventQueue* queue, uint8_t event);
+
+/**
+    \brief Get the oldest event. Consumer side only.
+    \param queue Pointer to event queue.
+    \param event Pointer to variable receiving the event.
+    \return True if an event was taken, false if the queue was empty.
+ */
+bool eventQueue_get (EventQueue* queue, uint8_t* event);
+
+/**
+    \brief Check whether there are no events to get. Consumer side only.
+    \param queue Pointer to event queue.
+    \return True if the queue is empty.
+ */
+bool eventQueue_isEmpty (const EventQueue* queue);
+
+#endif /* EVENTQUEUE_H */
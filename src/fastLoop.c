@@ -0,0 +1,237 @@
+/**
+    \file fastLoop.c
+    \brief Implementation file for the interrupt-context fast control loop
+           library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+#include "S12ADC.h"
+#include "DAC.h"
+#include "menu.h"
+#include "controllerSysControl.h"
+#include "controller.h"
+#include "myDebug.h"
+#include "fastLoop.h"
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern PIDControl pid;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Current and previous controller output values of the fast loop. */
+static int16_t fastOpArray[3] = {0, 0, 0};
+
+/** Current and previous error values of the fast loop. */
+static int16_t fastErArray[3] = {0, 0, 0};
+
+/** Snapshot being accumulated by the ISR. */
+static FastLoopSnapshot working = {0, 0, 0, 0, 0, 0, 0};
+
+/** Published snapshots; the ISR writes one while the task reads the other. */
+static FastLoopSnapshot published[2];
+
+/** Index of the most recently published snapshot. */
+static volatile uint8_t publishedIndex = 0;
+
+/** Number of snapshots published since start. */
+static volatile uint32_t publishedCount = 0;
+
+/** Number of snapshots already read by fastLoop_getSnapshot(). */
+static uint32_t readCount = 0;
+
+/** Samples left in the current decimation window. */
+static uint16_t decimationCounter = FAST_LOOP_DECIMATION;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Fast loop CMT1 compare match interrupt service routine.
+    \return None
+ */
+static void fastLoop_isr (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void fastLoop_init (void) {
+    FastLoopSnapshot empty = {0, 0, 0, 0, 0, 0, 0};
+    uint8_t i;
+
+    /* Start from an empty history and window: the execution time harness
+       may have run the step already. */
+    for (i = 0; i < 3u; i++) {
+        fastOpArray[i] = 0;
+        fastErArray[i] = 0;
+    }
+
+    working = empty;
+    publishedIndex = 0;
+    publishedCount = 0;
+    readCount = 0;
+    decimationCounter = FAST_LOOP_DECIMATION;
+
+    /* Take a blocking first sample so the pipelined ISR starts with a valid
+       conversion result. */
+    pvADC_start();
+
+    while (S12ADC_conversion_complete() == false) {
+    }
+
+    pvADC_start();
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up CMT1. */
+    MSTP(CMT1) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Stop CMT1 while it is configured. */
+    CMT.CMSTR0.BIT.STR1 = 0;
+
+    /* CMCR: Compare Match Timer Control Register
+    b6    CMIE  1  Compare match interrupt enabled.
+    b1:b0 CKS   0  Count source = PCLK/8.
+    */
+    CMT1.CMCR.WORD = 0x00C0;
+    CMT1.CMCNT = 0;
+    CMT1.CMCOR = FAST_LOOP_CMCOR;
+
+    /* Set interrupt priority above the kernel-aware boundary. */
+    IPR(CMT1,CMI1) = FAST_LOOP_IPL;
+
+    /* Clear any pending interrupt and enable it. */
+    IR(CMT1,CMI1) = 0;
+    IEN(CMT1,CMI1) = 1;
+
+    /* Start CMT1. */
+    CMT.CMSTR0.BIT.STR1 = 1;
+}
+
+int16_t fastLoop_step (int16_t pvCounts) {
+    working.pv = pvCounts;
+
+    if (pid.mode == PID_MAN) {
+        /* MANUAL MODE: SP follows PV, OP is set by the operator. */
+        working.sp = pvCounts;
+        working.er = 0;
+        working.op = pid.op;
+
+        insertArray(fastErArray, 0);
+    } else {
+        /* AUTOMATIC MODE */
+        working.sp = pid.sp;
+        working.er = working.sp - pvCounts;
+
+        insertArray(fastErArray, working.er);
+
+        working.op = getOP_PID(fastOpArray, fastErArray);
+    }
+
+    insertArray(fastOpArray, working.op);
+
+    /* Track PV extremes within the decimation window. */
+    if (decimationCounter == FAST_LOOP_DECIMATION) {
+        working.pvMin = pvCounts;
+        working.pvMax = pvCounts;
+    } else if (pvCounts < working.pvMin) {
+        working.pvMin = pvCounts;
+    } else if (pvCounts > working.pvMax) {
+        working.pvMax = pvCounts;
+    }
+
+    working.samples++;
+
+    /* Publish a snapshot at the end of each decimation window. */
+    if (--decimationCounter == 0) {
+        uint8_t index = publishedIndex ^ 1u;
+
+        published[index] = working;
+        publishedIndex = index;
+        publishedCount++;
+
+        decimationCounter = FAST_LOOP_DECIMATION;
+    }
+
+    return working.op;
+}
+
+bool fastLoop_getSnapshot (FastLoopSnapshot* snapshot) {
+    uint32_t count;
+
+    /* Retry if the ISR published twice while copying, which would mean the
+       buffer being read was overwritten. */
+    do {
+        count = publishedCount;
+        *snapshot = published[publishedIndex];
+    } while ((publishedCount - count) > 1u);
+
+    if (count == readCount) {
+        return false;
+    }
+
+    readCount = count;
+
+    return true;
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#pragma interrupt (fastLoop_isr (vect=VECT(CMT1,CMI1)))
+void fastLoop_isr (void) {
+    int16_t pvADC_counts;
+    int16_t opNew;
+
+#if (MY_DEBUG_ACTIVE)
+    /* Turn debug pin on. */
+    MY_DEBUG_1 = MY_DEBUG_ON;
+#endif
+
+    /* Conversion started on the previous interrupt has long completed; read
+       it and start the next one (one sample of latency, no busy wait). */
+    pvADC_counts = (int16_t)(pvADC_read() >> 2);
+    pvADC_start();
+
+    if (pid.active == PID_ON) {
+        opNew = fastLoop_step(pvADC_counts);
+
+        DAC_set(opNew);
+    }
+
+#if (MY_DEBUG_ACTIVE)
+    /* Turn debug pin off. */
+    MY_DEBUG_1 = MY_DEBUG_OFF;
+#endif
+}
@@ -0,0 +1,113 @@
+/**
+    \file fastLoop.h
+    \brief Header file for the interrupt-context fast control loop library.
+    \details When enabled, acquisition, PID computation and DAC update run
+             directly in the CMT1 compare match ISR at FAST_LOOP_RATE_HZ,
+             instead of in the 10 ms ControllerTask. Every
+             FAST_LOOP_DECIMATION samples the ISR publishes a snapshot that
+             ControllerTask copies into the PID control structure for the UI
+             and supervisory logic.
+             \par
+             The ISR runs above the kernel-aware interrupt priority boundary,
+             so it is never delayed by kernel critical sections and it must
+             never call uC/OS-III services.
+             \par
+             Cost: the execution time harness (wcet.h) times
+             fastLoop_step(), the body of the ISR, in CPU_TS counts, in
+             both controller modes and over whole decimation windows. Its
+             table header gives the budget next to the worst case: the
+             counts of one FAST_LOOP_RATE_HZ period. The ISR adds its entry
+             and exit, the ADC read and restart and the DAC write. Take the
+             figure on the board with WCET_ENABLED; tools/wcetHost.c runs
+             the same cases on the host to catch regressions only.
+             \par
+             The controller coefficients in controller.c were tuned for a
+             10 ms sample time and must be retuned for the fast loop rate.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef FASTLOOP_H
+#define FASTLOOP_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Fast loop enable flag. When disabled ControllerTask runs the loop. */
+#define FAST_LOOP_ENABLED (0)
+
+/** Fast loop sample rate in Hz (1000 - 10000). */
+#define FAST_LOOP_RATE_HZ (2000u)
+
+/** Rate in Hz of the snapshots handed to ControllerTask. */
+#define FAST_LOOP_SNAPSHOT_HZ (100u)
+
+/** Number of fast loop samples per published snapshot. */
+#define FAST_LOOP_DECIMATION (FAST_LOOP_RATE_HZ / FAST_LOOP_SNAPSHOT_HZ)
+
+/** Peripheral clock feeding CMT1, in Hz. */
+#define FAST_LOOP_PCLK_HZ (48000000u)
+
+/** CMT1 compare match value for PCLK/8 count source. */
+#define FAST_LOOP_CMCOR ((FAST_LOOP_PCLK_HZ / 8u) / FAST_LOOP_RATE_HZ - 1u)
+
+/** Fast loop interrupt priority level, above the kernel-aware boundary. */
+#define FAST_LOOP_IPL (0x0E)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Decimated fast loop snapshot. */
+typedef struct FastLoopSnapshot_struct {
+    int16_t sp;         /**< Setpoint raw value of the last sample. */
+    int16_t op;         /**< Controller output raw value of the last sample. */
+    int16_t pv;         /**< Process variable raw value of the last sample. */
+    int16_t er;         /**< Error raw value of the last sample. */
+    int16_t pvMin;      /**< Minimum PV within the decimation window. */
+    int16_t pvMax;      /**< Maximum PV within the decimation window. */
+    uint32_t samples;   /**< Total number of samples since start. */
+} FastLoopSnapshot;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize CMT1 and start the fast control loop.
+    \return None
+    \note S12ADC_init() and DAC_init() must have been called before.
+ */
+void fastLoop_init (void);
+
+/**
+    \brief Run one fast loop sample.
+    \details Body of the fast loop ISR, kept free of peripheral access so it
+             can be timed on its own.
+    \param pvCounts New process variable value, in DAC resolution.
+    \return New controller output value, to be written to the DAC.
+ */
+int16_t fastLoop_step (int16_t pvCounts);
+
+/**
+    \brief Get the most recent decimated snapshot.
+    \param snapshot Pointer to structure where the snapshot is copied.
+    \return True if a new snapshot was published since the previous call.
+ */
+bool fastLoop_getSnapshot (FastLoopSnapshot* snapshot);
+
+#endif /* FASTLOOP_H */
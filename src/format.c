@@ -0,0 +1,111 @@
+/**
+    \file format.c
+    \brief Implementation file for the integer formatting library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "format.h"
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Format a magnitude and sign right-aligned in a field.
+    \param out Buffer receiving the text.
+    \param magnitude Absolute value, scaled by 10^decimals.
+    \param negative Whether a minus sign precedes the digits.
+    \param decimals Number of decimals (0 - FORMAT_MAX_DECIMALS).
+    \param width Minimum field width.
+    \return Number of characters written, without the terminator.
+ */
+static uint8_t format_magnitude (char* out, uint32_t magnitude, bool negative,
+                                 uint8_t decimals, uint8_t width);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+uint8_t format_int (char* out, int32_t value, uint8_t width) {
+    return format_fixed(out, value, 0u, width);
+}
+
+uint8_t format_fixed (char* out, int32_t value, uint8_t decimals,
+                      uint8_t width) {
+    bool negative = (value < 0);
+
+    if (decimals > FORMAT_MAX_DECIMALS) {
+        decimals = FORMAT_MAX_DECIMALS;
+    }
+
+    /* Unsigned negation also covers INT32_MIN. */
+    return format_magnitude(out, negative ? (0u - (uint32_t)value) :
+                                            (uint32_t)value,
+                            negative, decimals, width);
+}
+
+char* format_append (char* out, const char* text) {
+    while (*text != '\0') {
+        *out++ = *text++;
+    }
+
+    *out = '\0';
+
+    return out;
+}
+
+char* format_appendUnsigned (char* out, uint32_t value, uint8_t width) {
+    return out + format_magnitude(out, value, false, 0u, width);
+}
+
+static uint8_t format_magnitude (char* out, uint32_t magnitude, bool negative,
+                                 uint8_t decimals, uint8_t width) {
+    char digits[FORMAT_INT32_SIZE];
+    uint8_t minimum;
+    uint8_t count = 0;
+    uint8_t length;
+
+    /* All decimals, the point and at least one integer digit. */
+    minimum = (decimals > 0u) ? (uint8_t)(decimals + 2u) : 1u;
+
+    /* Digits come out least significant first. */
+    do {
+        digits[count++] = (char)('0' + (magnitude % 10u));
+        magnitude /= 10u;
+
+        if (count == decimals) {
+            digits[count++] = '.';
+        }
+    } while ((magnitude != 0u) || (count < minimum));
+
+    length = (uint8_t)(count + (negative ? 1u : 0u));
+
+    /* Right-align in the field. */
+    while (length < width) {
+        *out++ = ' ';
+        length++;
+    }
+
+    if (negative) {
+        *out++ = '-';
+    }
+
+    while (count > 0u) {
+        *out++ = digits[--count];
+    }
+
+    *out = '\0';
+
+    return length;
+}
@@ -0,0 +1,86 @@
+/**
+    \file format.h
+    \brief Header file for the integer formatting library.
+    \details Small replacements for the sprintf() conversions used by the
+             display: right-aligned signed integers ("%*d") and fixed-point
+             decimals ("%*.*f" of an integer scaled by a power of ten). The
+             text is written straight into the caller's buffer, padded with
+             spaces on the left and null terminated; a value wider than the
+             field is written in full, as sprintf() does. The append
+             functions chain such fields and literal text into a report,
+             each returning the position after what it wrote. No stdio and
+             no allocation.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Buffer size that holds any int8_t in a field up to 4 characters. */
+#define FORMAT_INT8_SIZE (5u)
+
+/** Buffer size that holds any int32_t, sign and decimal point included,
+    in a field up to 12 characters. */
+#define FORMAT_INT32_SIZE (13u)
+
+/** Maximum number of decimals for format_fixed(). */
+#define FORMAT_MAX_DECIMALS (9u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Format a signed integer right-aligned in a field, like "%*d".
+    \param out Buffer receiving the text; see FORMAT_INT32_SIZE.
+    \param value Value to format.
+    \param width Minimum field width.
+    \return Number of characters written, without the terminator.
+ */
+uint8_t format_int (char* out, int32_t value, uint8_t width);
+
+/**
+    \brief Format a fixed-point value right-aligned in a field, like "%*.*f"
+           of value / 10^decimals; e.g. 453 with 1 decimal is "45.3".
+    \param out Buffer receiving the text; see FORMAT_INT32_SIZE.
+    \param value Value scaled by 10^decimals.
+    \param decimals Number of decimals (0 - FORMAT_MAX_DECIMALS).
+    \param width Minimum field width.
+    \return Number of characters written, without the terminator.
+ */
+uint8_t format_fixed (char* out, int32_t value, uint8_t decimals,
+                      uint8_t width);
+
+/**
+    \brief Append a string.
+    \param out Buffer position.
+    \param text String to append.
+    \return Buffer position after the string, where a terminator is written.
+ */
+char* format_append (char* out, const char* text);
+
+/**
+    \brief Append an unsigned integer right-aligned in a field, like "%*lu".
+    \param out Buffer position; room for FORMAT_INT32_SIZE at widths up to 12.
+    \param value Value to append.
+    \param width Minimum field width.
+    \return Buffer position after the number, where a terminator is written.
+ */
+char* format_appendUnsigned (char* out, uint32_t value, uint8_t width);
+
+#endif /* FORMAT_H */
@@ -0,0 +1,184 @@
+/**
+    \file frameBuffer.c
+    \brief Implementation file for the LCD shadow frame buffer library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lcd.h"
+#include "frameBuffer.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Cell attribute bit: character displayed inverted. */
+#define FB_INVERTED (0x80u)
+
+/** Cell character bits. */
+#define FB_CHAR_MASK (0x7Fu)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Cells drawn by the menu: character and attribute. */
+static uint8_t cells[FB_ROWS][FB_COLS];
+
+/** Cells currently shown by the LCD. */
+static uint8_t shown[FB_ROWS][FB_COLS];
+
+/** LCD must be cleared before the next flush. */
+static bool clearPending = true;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Draw text with an attribute into the frame buffer.
+    \param pos Position of the first character, see FB_XY().
+    \param text Null terminated text.
+    \param attr Cell attribute bits.
+    \return None
+ */
+static void frameBuffer_put (uint16_t pos, const char* text, uint8_t attr);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void frameBuffer_clear (void) {
+    memset(cells, ' ', sizeof(cells));
+
+    /* One LCD clear is cheaper than writing every cell. */
+    clearPending = true;
+}
+
+void frameBuffer_display (uint16_t pos, const char* text) {
+    frameBuffer_put(pos, text, 0u);
+}
+
+void frameBuffer_displayInverted (uint16_t pos, const char* text) {
+    frameBuffer_put(pos, text, FB_INVERTED);
+}
+
+uint8_t frameBuffer_flush (void) {
+    char run[FB_COLS + 1u];
+    uint8_t transfers = 0;
+    uint8_t row;
+    uint8_t col;
+    uint8_t start;
+    uint8_t end;
+    uint8_t next;
+    uint8_t attr;
+    uint8_t i;
+
+    if (clearPending) {
+        lcd_clear();
+        memset(shown, ' ', sizeof(shown));
+        clearPending = false;
+        transfers++;
+    }
+
+    for (row = 0; row < FB_ROWS; row++) {
+        col = 0;
+
+        while (col < FB_COLS) {
+            if (cells[row][col] == shown[row][col]) {
+                col++;
+                continue;
+            }
+
+            /* Start a run at the first changed cell. */
+            start = col;
+            attr = cells[row][col] & FB_INVERTED;
+            end = col + 1u;
+
+            /* Extend it over short gaps of unchanged cells with the same
+               attribute; 'end' stays one past the last changed cell. */
+            for (next = end; next < FB_COLS; next++) {
+                if (((uint8_t)(next - end) > FB_MERGE_GAP) ||
+                    ((cells[row][next] & FB_INVERTED) != attr)) {
+                    break;
+                }
+
+                if (cells[row][next] != shown[row][next]) {
+                    end = next + 1u;
+                }
+            }
+
+            for (i = start; i < end; i++) {
+                run[i - start] = (char)(cells[row][i] & FB_CHAR_MASK);
+                shown[row][i] = cells[row][i];
+            }
+
+            run[end - start] = '\0';
+
+            if (attr == FB_INVERTED) {
+                lcd_display_inverted(LCD_XY(start + 1u, row + 1u),
+                                     (const uint8_t*)run);
+            } else {
+                lcd_display(LCD_XY(start + 1u, row + 1u),
+                            (const uint8_t*)run);
+            }
+
+            transfers++;
+            col = end;
+        }
+    }
+
+    return transfers;
+}
+
+void frameBuffer_dump (char* out) {
+    uint8_t row;
+    uint8_t col;
+
+    for (row = 0; row < FB_ROWS; row++) {
+        for (col = 0; col < FB_COLS; col++) {
+            *out++ = (char)(cells[row][col] & FB_CHAR_MASK);
+        }
+
+        *out++ = ' ';
+
+        for (col = 0; col < FB_COLS; col++) {
+            *out++ = (cells[row][col] & FB_INVERTED) ? '#' : '.';
+        }
+
+        *out++ = '\n';
+    }
+
+    *out = '\0';
+}
+
+static void frameBuffer_put (uint16_t pos, const char* text, uint8_t attr) {
+    uint8_t x = (uint8_t)(pos & 0xFFu);
+    uint8_t y = (uint8_t)(pos >> 8);
+
+    if ((x < 1u) || (y < 1u) || (y > FB_ROWS)) {
+        return;
+    }
+
+    while ((*text != '\0') && (x <= FB_COLS)) {
+        cells[y - 1u][x - 1u] = (uint8_t)(((uint8_t)*text & FB_CHAR_MASK) |
+                                          attr);
+        text++;
+        x++;
+    }
+}
@@ -0,0 +1,97 @@
+/**
+    \file frameBuffer.h
+    \brief Header file for the LCD shadow frame buffer library.
+    \details The menu draws text into a RAM copy of the LCD character cells
+             instead of writing to the LCD directly. frameBuffer_flush()
+             compares the copy with what the LCD already shows and sends
+             only the changed cells, one LCD transfer per run of changed
+             cells with the same attribute; runs separated by a short gap
+             of unchanged cells are merged into one transfer.
+             \par
+             Cells are addressed by column and row, both starting at 1, as
+             with LCD_XY(). The frame buffer has no peripheral dependency
+             other than the lcd_display() calls made by the flush.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Number of character columns (96 pixels, 6 pixel wide font). */
+#define FB_COLS (16u)
+
+/** Number of character rows (64 pixels, 8 pixel high font). */
+#define FB_ROWS (8u)
+
+/** Longest run of unchanged cells merged into a transfer. */
+#define FB_MERGE_GAP (3u)
+
+/** Size of the text dump written by frameBuffer_dump(). */
+#define FB_DUMP_SIZE (FB_ROWS * (2u * FB_COLS + 2u) + 1u)
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Frame buffer position of a cell: column x, row y, both from 1. */
+#define FB_XY(x,y) ((uint16_t)(((uint16_t)(y) << 8) | (uint16_t)(x)))
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Clear the frame buffer. The next flush clears the LCD first.
+    \return None
+ */
+void frameBuffer_clear (void);
+
+/**
+    \brief Draw text into the frame buffer. Text beyond the row is clipped.
+    \param pos Position of the first character, see FB_XY().
+    \param text Null terminated text.
+    \return None
+ */
+void frameBuffer_display (uint16_t pos, const char* text);
+
+/**
+    \brief Draw inverted text into the frame buffer.
+    \param pos Position of the first character, see FB_XY().
+    \param text Null terminated text.
+    \return None
+ */
+void frameBuffer_displayInverted (uint16_t pos, const char* text);
+
+/**
+    \brief Send the cells changed since the last flush to the LCD.
+    \return Number of LCD transfers issued.
+ */
+uint8_t frameBuffer_flush (void);
+
+/**
+    \brief Write a text image of the frame buffer, for golden-image checks.
+    \details One line per row: the row text, a space and one attribute
+             character per cell ('#' inverted, '.' normal).
+    \param out Buffer of at least FB_DUMP_SIZE characters.
+    \return None
+ */
+void frameBuffer_dump (char* out);
+
+#endif /* FRAMEBUFFER_H */
@@ -25,11 +25,38 @@
 #include "lcd.h"
 #include "yrdkrx62n_rspi_api.h"
 #include "S12ADC.h"
+#include "debounce.h"
 #include "switches.h"
 #include "DAC.h"
+#include "format.h"
+#include "units.h"
+#include "frameBuffer.h"
+#include "trend.h"
+#include "stats.h"
+#include "loopTiming.h"
+#include "trace.h"
+#include "wcet.h"
+#include "deadline.h"
+#include "tickless.h"
+#include "telemetry.h"
+#include "netProto.h"
+#include "netService.h"
+#include "modbus.h"
+#include "modbusSlave.h"
+#include "console.h"
+#include "consoleSerial.h"
+#include "memBudget.h"
+#include "rta.h"
 #include "menu.h"
 #include "controllerSysControl.h"
+#include "pidSnapshot.h"
+#include "displayDirty.h"
+#include "eventQueue.h"
+#include "coroutine.h"
 #include "controller.h"
 #include "myDebug.h"
+#include "fastLoop.h"
+#include "blockFilter.h"
+#include "adcBlock.h"
 
 #endif /* __INCLUDES_H__ */
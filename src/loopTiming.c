@@ -0,0 +1,200 @@
+/**
+    \file loopTiming.c
+    \brief Implementation file for the control loop timing histogram library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "loopTiming.h"
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Bit mask of a point. */
+#define POINT_BIT(point) ((uint8_t)(1u << (point)))
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Timestamps of the current cycle; shared with LOOP_TIMING_MARK(). */
+LoopTimingControl loopTimingControl = {false, 0, {0}};
+
+/** Histograms; written only by the sampling task. */
+static LoopTimingHistogram histograms[LOOP_TIMING_HISTOGRAMS];
+
+/** Nominal cycle period, in timer counts. */
+static uint32_t period = 0;
+
+/** Wake-up timestamp of the previous cycle. */
+static uint32_t lastTick = 0;
+
+/** True if lastTick belongs to the cycle just before the current one. */
+static bool lastTickValid = false;
+
+/** Histogram clear requested by another task. */
+static volatile bool resetRequest = false;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Count a value in a histogram.
+    \param histogram Pointer to histogram.
+    \param value Value, in timer counts.
+    \return None
+ */
+static void loopTiming_count (LoopTimingHistogram* histogram, uint32_t value);
+
+/**
+    \brief Clear every histogram.
+    \return None
+ */
+static void loopTiming_clear (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void loopTiming_init (uint32_t periodCounts) {
+    loopTimingControl.enabled = false;
+    loopTimingControl.marked = 0;
+    period = periodCounts;
+    lastTickValid = false;
+    resetRequest = false;
+
+    loopTiming_clear();
+}
+
+void loopTiming_enable (bool enable) {
+    loopTimingControl.enabled = enable;
+}
+
+bool loopTiming_enabled (void) {
+    return loopTimingControl.enabled;
+}
+
+void loopTiming_fold (void) {
+    uint8_t marked = loopTimingControl.marked;
+    const uint32_t* stamp = loopTimingControl.stamp;
+    uint32_t elapsed;
+
+    loopTimingControl.marked = 0;
+
+    if (resetRequest) {
+        resetRequest = false;
+        loopTiming_clear();
+    }
+
+    if ((marked & POINT_BIT(LOOP_TIMING_TICK)) == 0u) {
+        /* Disabled, or no wake-up mark: the next period is unknown. */
+        lastTickValid = false;
+    } else {
+        if (lastTickValid) {
+            /* Unsigned differences stay right across a timer wrap. */
+            elapsed = stamp[LOOP_TIMING_TICK] - lastTick;
+            loopTiming_count(&histograms[LOOP_TIMING_JITTER],
+                             (elapsed >= period) ? (elapsed - period) :
+                                                   (period - elapsed));
+        }
+
+        lastTick = stamp[LOOP_TIMING_TICK];
+        lastTickValid = true;
+    }
+
+    if ((marked & POINT_BIT(LOOP_TIMING_ADC)) == 0u) {
+        return;
+    }
+
+    if (marked & POINT_BIT(LOOP_TIMING_PID)) {
+        loopTiming_count(&histograms[LOOP_TIMING_COMPUTE],
+                         stamp[LOOP_TIMING_PID] - stamp[LOOP_TIMING_ADC]);
+    }
+
+    if (marked & POINT_BIT(LOOP_TIMING_DAC)) {
+        loopTiming_count(&histograms[LOOP_TIMING_LATENCY],
+                         stamp[LOOP_TIMING_DAC] - stamp[LOOP_TIMING_ADC]);
+    }
+}
+
+void loopTiming_reset (void) {
+    resetRequest = true;
+}
+
+void loopTiming_get (uint8_t histogram, LoopTimingHistogram* copy) {
+    *copy = histograms[histogram];
+}
+
+uint8_t loopTiming_bucket (uint32_t value) {
+    uint8_t bits = 0;
+
+    /* Bit length of the value by binary search: five compares. */
+    if (value >= 0x10000ul) {
+        bits += 16u;
+        value >>= 16;
+    }
+
+    if (value >= 0x100u) {
+        bits += 8u;
+        value >>= 8;
+    }
+
+    if (value >= 0x10u) {
+        bits += 4u;
+        value >>= 4;
+    }
+
+    if (value >= 0x4u) {
+        bits += 2u;
+        value >>= 2;
+    }
+
+    if (value >= 0x2u) {
+        bits += 1u;
+        value >>= 1;
+    }
+
+    bits += (uint8_t)value;
+
+    return (bits < LOOP_TIMING_BUCKETS) ? bits :
+                                          (uint8_t)(LOOP_TIMING_BUCKETS - 1u);
+}
+
+static void loopTiming_count (LoopTimingHistogram* histogram, uint32_t value) {
+    histogram->bucket[loopTiming_bucket(value)]++;
+    histogram->samples++;
+
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+static void loopTiming_clear (void) {
+    uint8_t i;
+    uint8_t b;
+
+    for (i = 0; i < LOOP_TIMING_HISTOGRAMS; i++) {
+        histograms[i].samples = 0;
+        histograms[i].max = 0;
+
+        for (b = 0; b < LOOP_TIMING_BUCKETS; b++) {
+            histograms[i].bucket[b] = 0;
+        }
+    }
+}
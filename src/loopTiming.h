@@ -0,0 +1,188 @@
+/**
+    \file loopTiming.h
+    \brief Header file for the control loop timing histogram library.
+    \details ControllerTask timestamps four points of every cycle with
+             LOOP_TIMING_MARK(): task wake-up (tick start), ADC complete,
+             PID done and DAC written. At the end of the cycle
+             loopTiming_fold() turns the timestamps into three values and
+             counts each in a histogram of LOOP_TIMING_BUCKETS log2
+             buckets:
+             - period jitter: distance of the wake-up period from nominal;
+             - compute time: ADC complete to PID done;
+             - sample to actuate: ADC complete to DAC written.
+             \par
+             Timestamps come from LOOP_TIMING_NOW(), the free running uC/CPU
+             timestamp timer by default; a host test can define it to a
+             clock stand-in before including this file. A mark costs a flag
+             test, a timer read and two stores; a fold a few subtractions
+             and three bucket searches of five compares each.
+             \par
+             Instrumentation is switched at run time with
+             loopTiming_enable(), from the serial console "timing" command
+             as well. Histograms are written only by the
+             sampling task; other tasks read copies and ask for a reset
+             with loopTiming_reset(), carried out by the next fold.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef LOOPTIMING_H
+#define LOOPTIMING_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Loop timing instrumentation enable flag (compile time). */
+#define LOOP_TIMING_ENABLED (1)
+
+/** Buckets per histogram. Bucket 0 counts zero; bucket b > 0 counts values
+    from 2^(b-1) to 2^b - 1 timer counts; the last bucket also counts
+    everything above. */
+#define LOOP_TIMING_BUCKETS (24u)
+
+#if (LOOP_TIMING_BUCKETS < 2u) || (LOOP_TIMING_BUCKETS > 32u)
+#error "LOOP_TIMING_BUCKETS must be 2 - 32."
+#endif
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Timestamped points of a control cycle. */
+enum LoopTimingPointType {
+    LOOP_TIMING_TICK,       /**< Task woke up for the cycle. */
+    LOOP_TIMING_ADC,        /**< ADC sample available. */
+    LOOP_TIMING_PID,        /**< PID output computed. */
+    LOOP_TIMING_DAC,        /**< DAC written. */
+    LOOP_TIMING_POINTS      /**< Number of points. */
+};
+
+/** Histograms. */
+enum LoopTimingHistogramType {
+    LOOP_TIMING_JITTER,     /**< Period distance from nominal. */
+    LOOP_TIMING_COMPUTE,    /**< ADC complete to PID done. */
+    LOOP_TIMING_LATENCY,    /**< ADC complete to DAC written. */
+    LOOP_TIMING_HISTOGRAMS  /**< Number of histograms. */
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Timestamp source: free running timer counts. */
+#ifndef LOOP_TIMING_NOW
+#define LOOP_TIMING_NOW() ((uint32_t)CPU_TS_TmrRd())
+#endif
+
+/** Timestamp a point of the current cycle, if enabled. */
+#if (LOOP_TIMING_ENABLED)
+#define LOOP_TIMING_MARK(point)                                             \
+    do {                                                                    \
+        if (loopTimingControl.enabled) {                                    \
+            loopTimingControl.stamp[(point)] = LOOP_TIMING_NOW();           \
+            loopTimingControl.marked |= (uint8_t)(1u << (point));           \
+        }                                                                   \
+    } while (0)
+#else
+#define LOOP_TIMING_MARK(point) do { } while (0)
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Timestamps of the current cycle. */
+typedef struct LoopTimingControl_struct {
+    volatile bool enabled;                  /**< Run-time enable. */
+    uint8_t marked;                         /**< Points marked, one bit each. */
+    uint32_t stamp[LOOP_TIMING_POINTS];     /**< Timer count per point. */
+} LoopTimingControl;
+
+/** Histogram of one timing value, in timer counts. */
+typedef struct LoopTimingHistogram_struct {
+    uint32_t samples;                           /**< Values counted. */
+    uint32_t max;                               /**< Largest value. */
+    uint32_t bucket[LOOP_TIMING_BUCKETS];       /**< Count per bucket. */
+} LoopTimingHistogram;
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/** Timestamps of the current cycle; only used by LOOP_TIMING_MARK(). */
+extern LoopTimingControl loopTimingControl;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize loop timing, cleared and disabled.
+    \param periodCounts Nominal cycle period, in timer counts.
+    \return None
+ */
+void loopTiming_init (uint32_t periodCounts);
+
+/**
+    \brief Switch instrumentation on or off at run time.
+    \param enable True to timestamp and count cycles.
+    \return None
+ */
+void loopTiming_enable (bool enable);
+
+/**
+    \brief Check whether instrumentation is switched on.
+    \return True if cycles are timestamped and counted.
+ */
+bool loopTiming_enabled (void);
+
+/**
+    \brief Count the timing values of the cycle just marked and start the
+           next one. Only the sampling task may call this, once per cycle.
+    \return None
+ */
+void loopTiming_fold (void);
+
+/**
+    \brief Ask for the histograms to be cleared by the next fold.
+    \return None
+ */
+void loopTiming_reset (void);
+
+/**
+    \brief Copy a histogram. Counts of different buckets may be one cycle
+           apart when read outside the sampling task.
+    \param histogram Histogram type.
+    \param copy Pointer to structure where the histogram is copied.
+    \return None
+ */
+void loopTiming_get (uint8_t histogram, LoopTimingHistogram* copy);
+
+/**
+    \brief Get the histogram bucket of a value.
+    \param value Value, in timer counts.
+    \return Bucket (0 - LOOP_TIMING_BUCKETS-1).
+ */
+uint8_t loopTiming_bucket (uint32_t value);
+
+#endif /* LOOPTIMING_H */
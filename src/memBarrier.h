@@ -0,0 +1,34 @@
+/**
+    \file memBarrier.h
+    \brief Memory barrier macros for the lock-free data structures.
+    \details On the single-core RX target volatile accesses are neither
+             reordered by the compiler nor by the CPU, so the barriers are
+             empty. Host builds with GCC get C11 fences so
+             the same code can be exercised from several threads.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef MEMBARRIER_H
+#define MEMBARRIER_H
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+#if defined(__GNUC__)
+/** Orders preceding loads and stores before following stores. */
+#define MEM_BARRIER_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+/** Orders preceding loads before following loads and stores. */
+#define MEM_BARRIER_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+/** Orders preceding loads and stores before following loads and stores. */
+#define MEM_BARRIER_FULL() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define MEM_BARRIER_RELEASE()
+#define MEM_BARRIER_ACQUIRE()
+#define MEM_BARRIER_FULL()
+#endif
+
+#endif /* MEMBARRIER_H */
@@ -0,0 +1,280 @@
+/**
+    \file memBudget.c
+    \brief Implementation file for the static memory budget library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "format.h"
+#include "memBudget.h"
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (OS_CFG_MEM_EN == 0u)
+#error "The reclaimed memory pool needs OS_CFG_MEM_EN."
+#endif
+
+#if (MEM_BUDGET_ENABLED) && (OS_CFG_STAT_TASK_STK_CHK_EN == 0u)
+#error "Stack high-water marks need OS_CFG_STAT_TASK_STK_CHK_EN."
+#endif
+
+#if (MEM_BUDGET_BLK_SIZE % 4u)
+#error "MEM_BUDGET_BLK_SIZE must be a multiple of the pointer size."
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Budget entry of one task stack. */
+typedef struct MemBudgetTask_struct {
+    OS_TCB* tcb;            /**< Task control block. */
+    const char* macro;      /**< Stack size macro name, without suffix. */
+    uint32_t size;          /**< Stack size, in CPU_STK words. */
+    uint32_t peak;          /**< High-water mark, in CPU_STK words. */
+    bool retired;           /**< Deleted; no longer sampled. */
+} MemBudgetTask;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Registered task stacks. */
+static MemBudgetTask tasks[MEM_BUDGET_MAX_TASKS];
+
+/** Number of registered tasks. */
+static uint8_t taskCount = 0;
+
+/** Memory pool made of the reclaimed region. */
+static OS_MEM pool;
+
+/** Reclaimed region size, in bytes; zero before memBudget_reclaim(). */
+static uint32_t reclaimedSize = 0;
+
+/** Pool blocks. */
+static uint32_t poolBlocks = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+#if (MEM_BUDGET_ENABLED)
+/**
+    \brief Sample the high-water mark of one task.
+    \param entry Budget entry.
+    \return None
+ */
+static void memBudget_sampleTask (MemBudgetTask* entry);
+#endif
+
+/**
+    \brief Get the recommended size of a registered stack.
+    \param entry Budget entry.
+    \return Recommended size; the current size if never sampled.
+ */
+static uint32_t memBudget_recommendEntry (const MemBudgetTask* entry);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+bool memBudget_addTask (OS_TCB* tcb, const char* macro) {
+    MemBudgetTask* entry;
+
+    if (taskCount >= MEM_BUDGET_MAX_TASKS) {
+        return false;
+    }
+
+    entry = &tasks[taskCount];
+    entry->tcb = tcb;
+    entry->macro = macro;
+    entry->size = tcb->StkSize;
+    entry->peak = 0;
+    entry->retired = false;
+    taskCount++;
+
+    return true;
+}
+
+void memBudget_retire (OS_TCB* tcb) {
+#if (MEM_BUDGET_ENABLED)
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        if (tasks[i].tcb == tcb) {
+            memBudget_sampleTask(&tasks[i]);
+            tasks[i].retired = true;
+        }
+    }
+#else
+    (void)tcb;
+#endif
+}
+
+void memBudget_sample (void) {
+#if (MEM_BUDGET_ENABLED)
+    uint8_t i;
+
+    for (i = 0; i < taskCount; i++) {
+        if (!tasks[i].retired) {
+            memBudget_sampleTask(&tasks[i]);
+        }
+    }
+#endif
+}
+
+uint32_t memBudget_recommend (uint32_t peak) {
+    uint32_t size = ((peak * (100u + MEM_BUDGET_MARGIN_PCT)) + 99u) / 100u;
+
+    return ((size + MEM_BUDGET_ROUND - 1u) / MEM_BUDGET_ROUND) *
+           MEM_BUDGET_ROUND;
+}
+
+void memBudget_reclaim (void* region, uint32_t size) {
+    OS_ERR err;
+
+    poolBlocks = size / MEM_BUDGET_BLK_SIZE;
+
+    if (poolBlocks < 2u) {
+        /* The kernel needs two blocks or more. */
+        poolBlocks = 0;
+
+        return;
+    }
+
+    OSMemCreate(&pool, (CPU_CHAR*)"Reclaimed Pool", region,
+                (OS_MEM_QTY)poolBlocks, (OS_MEM_SIZE)MEM_BUDGET_BLK_SIZE,
+                &err);
+
+    if (err != OS_ERR_NONE) {
+        poolBlocks = 0;
+
+        return;
+    }
+
+    reclaimedSize = size;
+}
+
+OS_MEM* memBudget_pool (void) {
+    if (poolBlocks == 0u) {
+        return (OS_MEM*)0;
+    }
+
+    return &pool;
+}
+
+uint16_t memBudget_format (char* out) {
+    char* position = out;
+    const MemBudgetTask* entry;
+    uint32_t totalSize = 0;
+    uint32_t totalRecommended = 0;
+    uint32_t recommended;
+    uint8_t length;
+    uint8_t i;
+
+    position = format_append(position,
+                             "/* Memory budget, from memBudget_format()."
+                             "\n * Stack            size  peak   rec\n");
+
+    for (i = 0; i < taskCount; i++) {
+        entry = &tasks[i];
+        recommended = memBudget_recommendEntry(entry);
+        totalSize += entry->size;
+        totalRecommended += recommended;
+
+        position = format_append(position, " * ");
+
+        /* Name, padded to a fixed width. */
+        for (length = 0; entry->macro[length] != '\0'; length++) {
+            *position++ = entry->macro[length];
+        }
+
+        for (; length < 16u; length++) {
+            *position++ = ' ';
+        }
+
+        position = format_appendUnsigned(position, entry->size, 5u);
+        position = format_appendUnsigned(position, entry->peak, 6u);
+        position = format_appendUnsigned(position, recommended, 6u);
+        position = format_append(position, "\n");
+    }
+
+    /* Words and bytes of CPU_STK. */
+    position = format_append(position, " * Stacks ");
+    position = format_appendUnsigned(position, totalSize, 0u);
+    position = format_append(position, " -> ");
+    position = format_appendUnsigned(position, totalRecommended, 0u);
+    position = format_append(position, " words, ");
+    position = format_appendUnsigned(position,
+                                     (totalSize > totalRecommended) ?
+                                     ((totalSize - totalRecommended) *
+                                      sizeof(CPU_STK)) : 0u, 0u);
+    position = format_append(position, " B saved\n");
+
+    if (reclaimedSize > 0u) {
+        position = format_append(position, " * Start task ");
+        position = format_appendUnsigned(position, reclaimedSize, 0u);
+        position = format_append(position, " B reclaimed: pool ");
+        position = format_appendUnsigned(position, poolBlocks, 0u);
+        position = format_append(position, " x ");
+        position = format_appendUnsigned(position, MEM_BUDGET_BLK_SIZE, 0u);
+        position = format_append(position, " B\n");
+    }
+
+    position = format_append(position, " */\n");
+
+    for (i = 0; i < taskCount; i++) {
+        entry = &tasks[i];
+
+        position = format_append(position, "#define ");
+        position = format_append(position, entry->macro);
+        position = format_append(position, "_STK_SIZE ");
+        position = format_appendUnsigned(position,
+                                         memBudget_recommendEntry(entry), 0u);
+        position = format_append(position, "u\n");
+    }
+
+    *position = '\0';
+
+    return (uint16_t)(position - out);
+}
+
+#if (MEM_BUDGET_ENABLED)
+static void memBudget_sampleTask (MemBudgetTask* entry) {
+    CPU_STK_SIZE stackFree;
+    CPU_STK_SIZE stackUsed;
+    OS_ERR err;
+
+    /* Scans the painted, never used part of the stack. */
+    OSTaskStkChk(entry->tcb, &stackFree, &stackUsed, &err);
+
+    if ((err == OS_ERR_NONE) && (stackUsed > entry->peak)) {
+        entry->peak = stackUsed;
+    }
+}
+#endif
+
+static uint32_t memBudget_recommendEntry (const MemBudgetTask* entry) {
+    return (entry->peak > 0u) ? memBudget_recommend(entry->peak) :
+                                entry->size;
+}
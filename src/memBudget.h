@@ -0,0 +1,130 @@
+/**
+    \file memBudget.h
+    \brief Header file for the static memory budget library.
+    \details Task stacks are painted at creation (OS_OPT_TASK_STK_CLR) and
+             checked by the kernel, so the high-water mark of each stack
+             holds the deepest use since start. In a measurement build
+             (MEM_BUDGET_ENABLED) the registered tasks are sampled once per
+             statistics period while the board is put through its stress
+             scenarios: the execution time harness (start task), button
+             storms, every menu page, the controller in both modes.
+             memBudget_format() then writes a C header with the memory map
+             as a comment and a recommended size for each task stack: the
+             high-water mark plus MEM_BUDGET_MARGIN_PCT, rounded up to
+             MEM_BUDGET_ROUND words. Save it as src/app_stk_budget.h and
+             set APP_CFG_STK_BUDGET in app_cfg.h to build with it.
+             Interrupts run on the interrupt stack, so task stacks need no
+             room for interrupt frames.
+             \par
+             The start task deletes itself once the application tasks are
+             running. memBudget_reclaim() then turns its stack and control
+             block into a kernel memory partition of MEM_BUDGET_BLK_SIZE
+             byte blocks, memBudget_pool(); its size follows
+             APP_TASK_START_STK_SIZE. The serial console takes its line
+             buffers from it (consoleSerial.c).
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Record stack high-water marks (compile time); measurement builds. */
+#define MEM_BUDGET_ENABLED (0)
+
+/** Maximum number of registered tasks. */
+#define MEM_BUDGET_MAX_TASKS (4u)
+
+/** Margin over the high-water mark, in percent. */
+#define MEM_BUDGET_MARGIN_PCT (25u)
+
+/** Stack size granularity, in CPU_STK words. */
+#define MEM_BUDGET_ROUND (8u)
+
+/** Pool block size, in bytes; a multiple of the pointer size. */
+#define MEM_BUDGET_BLK_SIZE (64u)
+
+/** Characters of one text line, terminator included. */
+#define MEM_BUDGET_LINE_SIZE (56u)
+
+/** Buffer size that holds the whole generated header. */
+#define MEM_BUDGET_TEXT_SIZE \
+    (((2u * MEM_BUDGET_MAX_TASKS) + 6u) * MEM_BUDGET_LINE_SIZE)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Register a task stack for the budget.
+    \param tcb Pointer to the task control block; the task is created with
+           OS_OPT_TASK_STK_CHK and OS_OPT_TASK_STK_CLR.
+    \param macro Stack size macro name without the "_STK_SIZE" suffix, as
+           in app_cfg.h.
+    \return False if MEM_BUDGET_MAX_TASKS tasks are already registered.
+ */
+bool memBudget_addTask (OS_TCB* tcb, const char* macro);
+
+/**
+    \brief Take the last sample of a task about to delete itself; it is
+           not sampled again.
+    \param tcb Pointer to the task control block.
+    \return None
+ */
+void memBudget_retire (OS_TCB* tcb);
+
+/**
+    \brief Sample the high-water mark of every registered task.
+    \return None
+ */
+void memBudget_sample (void);
+
+/**
+    \brief Get the recommended size of a stack.
+    \param peak Stack high-water mark, in CPU_STK words.
+    \return The high-water mark plus the margin, rounded up to
+            MEM_BUDGET_ROUND words.
+ */
+uint32_t memBudget_recommend (uint32_t peak);
+
+/**
+    \brief Turn the memory of a deleted task into the memory pool. Call
+           once, from a task that runs after the deletion.
+    \param region Start of the region; aligned to a pointer.
+    \param size Region size, in bytes.
+    \return None
+ */
+void memBudget_reclaim (void* region, uint32_t size);
+
+/**
+    \brief Get the memory pool.
+    \return Pointer to the partition, for OSMemGet() and OSMemPut(); null
+            before memBudget_reclaim() or if the region was too small.
+ */
+OS_MEM* memBudget_pool (void);
+
+/**
+    \brief Write the generated header: the memory map as a comment, then
+           one "#define <macro>_STK_SIZE <words>u" line per task.
+    \param out Buffer receiving the text; see MEM_BUDGET_TEXT_SIZE.
+    \return Number of characters written, without the terminator.
+ */
+uint16_t memBudget_format (char* out);
+
+#endif /* MEM_BUDGET_H */
@@ -10,22 +10,186 @@
 ******************************************************************************/
 
 #include <stdint.h>
-#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "platform.h"
-#include "lcd.h"
+#include "format.h"
+#include "units.h"
 #include "controllerSysControl.h"
+#include "pidSnapshot.h"
+#include "trend.h"
+#include "stats.h"
+#include "trace.h"
 #include "menu.h"
 
 
 
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (TREND_COLUMNS > FB_COLS) || (TREND_PAGES > (FB_ROWS - 2u))
+#error "Trend chart does not fit the trend screen."
+#endif
+
+
+
 /******************************************************************************
 *                             EXTERNAL VARIABLES                              *
 ******************************************************************************/
 
-extern void* menuControl;
-extern CursorControl cursor;
+extern MenuControl menu;
 extern PIDControl pid;
-extern ControllerControl controller;
+extern const UnitsConfig signalUnitsConfig[SIGNALS];
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Menu state table: cursor row and transition for buttons 1, 2 and 3. */
+static const MenuStateEntry menuTable[MENU_STATES] = {
+    /* MENU_ON_OFF_VIEW */
+    {ON_OFF_SEL, {
+        {NULL,            GUARD_NONE, MENU_ON_OFF_VIEW,  0},
+        {onOffEditBegin,  GUARD_NONE, MENU_ON_OFF_EDIT,  REGION_CURSOR},
+        {NULL,            GUARD_NONE, MENU_MAN_AUT_VIEW, REGION_CURSOR}}},
+    /* MENU_ON_OFF_EDIT */
+    {ON_OFF_SEL, {
+        {onOffSelectOn,   GUARD_NONE, MENU_ON_OFF_EDIT,  REGION_ON_OFF},
+        {onOffCommit,     GUARD_NONE, MENU_ON_OFF_VIEW,  REGION_CURSOR},
+        {onOffSelectOff,  GUARD_NONE, MENU_ON_OFF_EDIT,  REGION_ON_OFF}}},
+    /* MENU_MAN_AUT_VIEW */
+    {MAN_AUT_SEL, {
+        {NULL,            GUARD_NONE, MENU_ON_OFF_VIEW,  REGION_CURSOR},
+        {manAutEditBegin, GUARD_NONE, MENU_MAN_AUT_EDIT, REGION_CURSOR},
+        {NULL,            GUARD_NONE, MENU_DIAG_VIEW,    REGION_CURSOR}}},
+    /* MENU_MAN_AUT_EDIT */
+    {MAN_AUT_SEL, {
+        {manAutSelectMan, GUARD_NONE, MENU_MAN_AUT_EDIT, REGION_MAN_AUT},
+        {manAutCommit,    GUARD_NONE, MENU_MAN_AUT_VIEW, REGION_CURSOR
+                                                       | REGION_SP
+                                                       | REGION_OP},
+        {manAutSelectAut, GUARD_NONE, MENU_MAN_AUT_EDIT, REGION_MAN_AUT}}},
+    /* MENU_SP_VIEW */
+    {SP_SEL, {
+        {NULL,            GUARD_NONE, MENU_DIAG_VIEW,    REGION_CURSOR},
+        {spEditBegin,     GUARD_AUTO, MENU_SP_EDIT,      REGION_CURSOR
+                                                       | REGION_SP},
+        {NULL,            GUARD_NONE, MENU_OP_VIEW,      REGION_CURSOR}}},
+    /* MENU_SP_EDIT */
+    {SP_SEL, {
+        {spIncrement,     GUARD_NONE, MENU_SP_EDIT,      REGION_SP},
+        {spCommit,        GUARD_NONE, MENU_SP_VIEW,      REGION_CURSOR
+                                                       | REGION_SP},
+        {spDecrement,     GUARD_NONE, MENU_SP_EDIT,      REGION_SP}}},
+    /* MENU_OP_VIEW */
+    {OP_SEL, {
+        {NULL,            GUARD_NONE, MENU_SP_VIEW,      REGION_CURSOR},
+        {opEditBegin,     GUARD_MAN,  MENU_OP_EDIT,      REGION_CURSOR
+                                                       | REGION_OP},
+        {NULL,            GUARD_NONE, MENU_TREND_VIEW,   REGION_CURSOR}}},
+    /* MENU_OP_EDIT */
+    {OP_SEL, {
+        {opIncrement,     GUARD_NONE, MENU_OP_EDIT,      REGION_OP},
+        {opCommit,        GUARD_NONE, MENU_OP_VIEW,      REGION_CURSOR
+                                                       | REGION_OP},
+        {opDecrement,     GUARD_NONE, MENU_OP_EDIT,      REGION_OP}}},
+    /* MENU_TREND_VIEW */
+    {TREND_SEL, {
+        {NULL,            GUARD_NONE, MENU_OP_VIEW,      REGION_CURSOR},
+        {NULL,            GUARD_NONE, MENU_TREND_EDIT,   REGION_SCREEN},
+        {NULL,            GUARD_NONE, MENU_TREND_VIEW,   0}}},
+    /* MENU_TREND_EDIT */
+    {TREND_SEL, {
+        {NULL,            GUARD_NONE, MENU_TREND_EDIT,   0},
+        {NULL,            GUARD_NONE, MENU_TREND_VIEW,   REGION_SCREEN},
+        {NULL,            GUARD_NONE, MENU_TREND_EDIT,   0}}},
+    /* MENU_DIAG_VIEW */
+    {DIAG_SEL, {
+        {NULL,            GUARD_NONE, MENU_MAN_AUT_VIEW, REGION_CURSOR},
+        {NULL,            GUARD_NONE, MENU_DIAG_EDIT,    REGION_SCREEN},
+        {NULL,            GUARD_NONE, MENU_SP_VIEW,      REGION_CURSOR}}},
+    /* MENU_DIAG_EDIT */
+    {DIAG_SEL, {
+        {diagPagePrev,    GUARD_NONE, MENU_DIAG_EDIT,    REGION_PAGE},
+        {NULL,            GUARD_NONE, MENU_DIAG_VIEW,    REGION_SCREEN},
+        {diagPageNext,    GUARD_NONE, MENU_DIAG_EDIT,    REGION_PAGE}}}
+};
+
+/** Row where the cursor is currently displayed. */
+static uint8_t cursorRow = ON_OFF_SEL;
+
+/** First task shown on the diagnostics screen. */
+static uint8_t diagFirst = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check a transition guard against the controller mode.
+    \param guard Transition guard.
+    \return True if the transition is allowed.
+ */
+static bool menuGuard (uint8_t guard);
+
+/**
+    \brief Display one of two options, the selected one inverted.
+    \param firstPos Position of first option in LCD.
+    \param first First option string.
+    \param secondPos Position of second option in LCD.
+    \param second Second option string.
+    \param firstSelected True if the first option is selected.
+    \return None
+ */
+static void printOption (uint16_t firstPos, const char* first,
+                         uint16_t secondPos, const char* second,
+                         bool firstSelected);
+
+/**
+    \brief Print the trend chart screen.
+    \return None
+ */
+static void printTrendScreen (void);
+
+/**
+    \brief Print the diagnostics screen.
+    \return None
+ */
+static void printDiagScreen (void);
+
+/**
+    \brief Print the diagnostics values: CPU usage, longest interrupt
+           disable time, context switches per period and, for each task on
+           the page, name, CPU usage and stack high-water mark in percent.
+    \return None
+ */
+static void printDiagValues (void);
+
+/**
+    \brief Copy a formatted value into a fixed width field of a line.
+    \param field Field position in the line.
+    \param text Formatted value; only the first width characters are used.
+    \param width Field width.
+    \return None
+ */
+static void printDiagField (char* field, const char* text, uint8_t width);
+
+/**
+    \brief Trend chart page writer: one character cell per page, '|' for
+           PV, '-' for SP and '+' for both.
+    \param x Chart column.
+    \param page Chart page, 0 on top.
+    \param pvBits PV pixels of the page.
+    \param spBits SP pixels of the page.
+    \return None
+ */
+static void printTrendCell (uint8_t x, uint8_t page, uint8_t pvBits,
+                            uint8_t spBits);
 
 
 
@@ -34,299 +198,317 @@ extern ControllerControl controller;
 ******************************************************************************/
 
 void printMainMenu (void) {
-    lcd_clear();
+    frameBuffer_clear();
+
+    frameBuffer_display(FB_XY(1,1), "PID CONTROL ");
+    frameBuffer_display(FB_XY(1,ON_OFF_SEL),  "> ON   OFF  ");
+    frameBuffer_display(FB_XY(1,MAN_AUT_SEL), "  MAN  AUT  ");
+    frameBuffer_display(FB_XY(1,DIAG_SEL), "   DIAG");
+
+    frameBuffer_display(FB_XY(1,SP_SEL), "   SP:");
+    frameBuffer_display(FB_XY(1,OP_SEL), "   OP:");
+    frameBuffer_display(FB_XY(1,PV_SEL), "   PV:");
+    frameBuffer_display(FB_XY(UNIT_COL,SP_SEL),
+                        signalUnitsConfig[SIGNAL_SP].unit);
+    frameBuffer_display(FB_XY(UNIT_COL,OP_SEL),
+                        signalUnitsConfig[SIGNAL_OP].unit);
+    frameBuffer_display(FB_XY(UNIT_COL,PV_SEL),
+                        signalUnitsConfig[SIGNAL_PV].unit);
+    frameBuffer_display(FB_XY(1,TREND_SEL), "   TREND");
+
+    frameBuffer_displayInverted(OFF_POS, "OFF");
+    frameBuffer_displayInverted(MAN_POS, "MAN");
+
+    cursorRow = ON_OFF_SEL;
+}
 
-    lcd_display(LCD_XY(1,1), "PID CONTROL ");
-    lcd_display(LCD_XY(1,ON_OFF_SEL),  "> ON   OFF  ");
-    lcd_display(LCD_XY(1,MAN_AUT_SEL), "  MAN  AUT  ");
+uint8_t menuDispatch (uint8_t action) {
+    const MenuTransition* transition;
 
-    lcd_display(LCD_XY(1,SP_SEL), "   SP:   0 %");
-    lcd_display(LCD_XY(1,OP_SEL), "   OP:   0 %");
-    lcd_display(LCD_XY(1,PV_SEL), "   PV:   0 %");
+    if ((action < 1u) || (action > MENU_BUTTONS)) {
+        return 0;
+    }
 
-    lcd_display_inverted(OFF_POS, "OFF");
-    lcd_display_inverted(MAN_POS, "MAN");
-}
+    transition = &menuTable[menu.state].button[action - 1u];
 
-void onOffSelectionMenu (uint8_t action) {
-    if (cursor.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Nothing happens. */
-            break;
-            case 2:
-                /* Change to edit mode. */
-                cursor.mode = EDIT;
-
-                /* Change cursor display. */
-                lcd_display_inverted(LCD_XY(1, ON_OFF_SEL), ">");
-            break;
-            case 3:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, ON_OFF_SEL), " ");
-
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, MAN_AUT_SEL), ">");
-
-                /* Update selection. */
-                cursor.selection = MAN_AUT_SEL;
-
-                /* Update menu control pointer. */
-                menuControl = manAutSelectionMenu;
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-                /* Display OFF non-inverted. */
-                lcd_display(OFF_POS, "OFF");
-
-                /* Display ON inverted. */
-                lcd_display_inverted(ON_POS, "ON");
-            break;
-            case 2:
-                /* Change to view mode. */
-                cursor.mode = VIEW;
-
-                /* Display non-inverted cursor. */
-                lcd_display(LCD_XY(1, ON_OFF_SEL), ">");
-            break;
-            case 3:
-                /* Display ON non-inverted. */
-                lcd_display(ON_POS, "ON");
-
-                /* Display OFF inverted. */
-                lcd_display_inverted(OFF_POS, "OFF");
-            break;
-        }
+    if (menuGuard(transition->guard) == false) {
+        return 0;
     }
+
+    if (transition->effect != NULL) {
+        (*transition->effect)();
+    }
+
+    TRACE_MENU(menu.state, transition->next);
+
+    menu.state = transition->next;
+
+    return transition->redraw;
 }
 
-void manAutSelectionMenu (uint8_t action) {
-    if (cursor.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, MAN_AUT_SEL), " ");
-
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, ON_OFF_SEL), ">");
-
-                /* Update selection. */
-                cursor.selection = ON_OFF_SEL;
-
-                /* Update menu control pointer. */
-                menuControl = onOffSelectionMenu;
-            break;
-            case 2:
-                /* Change to edit mode. */
-                cursor.mode = EDIT;
-
-                /* Change cursor display. */
-                lcd_display_inverted(LCD_XY(1, MAN_AUT_SEL), ">");
-            break;
-            case 3:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, MAN_AUT_SEL), " ");
-
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, SP_SEL), ">");
-
-                /* Update selection. */
-                cursor.selection = SP_SEL;
-
-                /* Update menu control pointer. */
-                menuControl = spSelectionMenu;
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-                /* Display AUT non-inverted. */
-                lcd_display(AUT_POS, "AUT");
-
-                /* Display MAN inverted. */
-                lcd_display_inverted(MAN_POS, "MAN");
-            break;
-            case 2:
-                /* Change to view mode. */
-                cursor.mode = VIEW;
-
-                /* Display non-inverted cursor. */
-                lcd_display(LCD_XY(1, MAN_AUT_SEL), ">");
-            break;
-            case 3:
-                /* Display MAN non-inverted. */
-                lcd_display(MAN_POS, "MAN");
-
-                /* Display AUT inverted. */
-                lcd_display_inverted(AUT_POS, "AUT");
-            break;
+uint8_t menuRender (uint8_t regions) {
+    uint8_t row;
+
+    if (menu.state == MENU_TREND_EDIT) {
+        if (regions & REGION_SCREEN) {
+            printTrendScreen();
+        } else if (regions & REGION_PAGE) {
+            trend_render(printTrendCell);
         }
+
+        return 0;
     }
-}
 
-void spSelectionMenu (uint8_t action) {
-    if (cursor.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, SP_SEL), " ");
-
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, MAN_AUT_SEL), ">");
-
-                /* Update selection. */
-                cursor.selection = MAN_AUT_SEL;
-
-                /* Update menu control pointer. */
-                menuControl = manAutSelectionMenu;
-            break;
-            case 2:
-                if (pid.mode == PID_AUTO) {
-                    /* Change to edit mode. */
-                    cursor.mode = EDIT;
-
-                    /* Change cursor display. */
-                    lcd_display_inverted(LCD_XY(1, SP_SEL),">");
-                }
-            break;
-            case 3:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, SP_SEL), " ");
+    if (menu.state == MENU_DIAG_EDIT) {
+        if (regions & REGION_SCREEN) {
+            printDiagScreen();
+        } else if (regions & REGION_PAGE) {
+            printDiagValues();
+        }
 
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, OP_SEL), ">");
+        return 0;
+    }
 
-                /* Update selection. */
-                cursor.selection = OP_SEL;
+    if (regions & REGION_SCREEN) {
+        /* Redraw every menu region over a fresh main menu. */
+        printMainMenu();
+        regions = 0xFF;
+    }
+
+    if (regions & REGION_CURSOR) {
+        row = menuTable[menu.state].row;
 
-                /* Update menu control pointer. */
-                menuControl = opSelectionMenu;
-            break;
+        /* Clear previous cursor. */
+        if (row != cursorRow) {
+            frameBuffer_display(FB_XY(1, cursorRow), " ");
+            cursorRow = row;
         }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-            case 3:
-                /* Nothing happens. */
-            break;
-            case 2:
-                /* Display non-inverted cursor. */
-                lcd_display(LCD_XY(1, SP_SEL), ">");
-
-                /* Change to view mode. */
-                cursor.mode = VIEW;
-            break;
+
+        /* Print new cursor, inverted while editing. */
+        if (MENU_MODE(menu.state) == EDIT) {
+            frameBuffer_displayInverted(FB_XY(1, row), ">");
+        } else {
+            frameBuffer_display(FB_XY(1, row), ">");
         }
     }
+
+    if (regions & REGION_ON_OFF) {
+        printOption(ON_POS, "ON", OFF_POS, "OFF",
+                    menu.activeTemp == PID_ON);
+    }
+
+    if (regions & REGION_MAN_AUT) {
+        printOption(MAN_POS, "MAN", AUT_POS, "AUT",
+                    menu.modeTemp == PID_MAN);
+    }
+
+    return (uint8_t)(regions & REGION_VALUES);
 }
 
-void opSelectionMenu (uint8_t action) {
-    if (cursor.mode == VIEW) { // VIEW mode
-        switch(action) {
-            case 1:
-                /* Clear current cursor. */
-                lcd_display(LCD_XY(1, OP_SEL), " ");
-
-                /* Print new cursor. */
-                lcd_display(LCD_XY(1, SP_SEL), ">");
-
-                /* Update selection. */
-                cursor.selection = SP_SEL;
-
-                /* Update menu control pointer. */
-                menuControl = spSelectionMenu;
-            break;
-            case 2:
-                if (pid.mode == PID_MAN) {
-                    /* Change to edit mode. */
-                    cursor.mode = EDIT;
-
-                    /* Change cursor display. */
-                    lcd_display_inverted(LCD_XY(1, OP_SEL),">");
-                }
-            break;
-            case 3:
-                /* Nothing happens. */
-            break;
-        }
-    } else { // EDIT mode
-        switch(action) {
-            case 1:
-            case 3:
-                /* Nothing happens. */
-            break;
-            case 2:
-                /* Display non-inverted cursor. */
-                lcd_display(LCD_XY(1, OP_SEL), ">");
-
-                /* Change to view mode. */
-                cursor.mode = VIEW;
-            break;
+void printSP (const PIDSnapshot* state) {
+    char spString[FORMAT_INT32_SIZE];
+    uint8_t decimals = signalUnitsConfig[SIGNAL_SP].decimals;
+    int32_t value;
+
+    if (state->mode == PID_AUTO) {
+        if (menu.state == MENU_SP_EDIT) {
+            format_fixed(spString, menu.spTemp, decimals, VALUE_WIDTH);
+            frameBuffer_displayInverted(SP_POS, spString);
+        } else {
+            format_fixed(spString, pid.spValue, decimals, VALUE_WIDTH);
+            frameBuffer_display(SP_POS, spString);
         }
+    } else {
+        /* Convert raw to engineering units. */
+        value = toValue(SIGNAL_SP, state->sp);
+
+        /* Format value. */
+        format_fixed(spString, value, decimals, VALUE_WIDTH);
+
+        frameBuffer_display(SP_POS, spString);
     }
 }
 
-void printSP (void) {
-    char spString[4];
-    int8_t percent;
-
-    if (pid.mode == PID_AUTO) {
-        sprintf(spString, "%3d", pid.spPercent);
+void printOP (const PIDSnapshot* state) {
+    char opString[FORMAT_INT32_SIZE];
+    uint8_t decimals = signalUnitsConfig[SIGNAL_OP].decimals;
+    int32_t value;
 
-        if ((controller.mode == EDIT) && (controller.selection == SP_SEL)) {
-            lcd_display_inverted(SP_POS, (const uint8_t*)spString);
+    if (state->mode == PID_MAN) {
+        if (menu.state == MENU_OP_EDIT) {
+            format_fixed(opString, menu.opTemp, decimals, VALUE_WIDTH);
+            frameBuffer_displayInverted(OP_POS, opString);
         } else {
-            lcd_display(SP_POS, (const uint8_t*)spString);
+            format_fixed(opString, pid.opValue, decimals, VALUE_WIDTH);
+            frameBuffer_display(OP_POS, opString);
         }
     } else {
-        /* Convert raw to percent. */
-        percent = toPercent(pid.sp);
-
-        pid.spPercent = percent;
+        /* Convert raw to engineering units. */
+        value = toValue(SIGNAL_OP, state->op);
 
         /* Format value. */
-        sprintf(spString, "%3d", percent);
+        format_fixed(opString, value, decimals, VALUE_WIDTH);
 
-        lcd_display(SP_POS, (const uint8_t*)spString);
+        frameBuffer_display(OP_POS, opString);
     }
 }
 
-void printOP (void) {
-    char opString[4];
-    int8_t percent;
+void printPV (const PIDSnapshot* state) {
+    char pvString[FORMAT_INT32_SIZE];
+    int32_t value;
+
+    /* Convert raw to engineering units. */
+    value = toValue(SIGNAL_PV, state->pv);
 
-    if (pid.mode == PID_MAN) {
-        sprintf(opString, "%3d", pid.opPercent);
+    /* Format value. */
+    format_fixed(pvString, value, signalUnitsConfig[SIGNAL_PV].decimals,
+                 VALUE_WIDTH);
 
-        if ((controller.mode == EDIT) && (controller.selection == OP_SEL))
-            lcd_display_inverted(OP_POS, (const uint8_t*)opString);
-        else
-            lcd_display(OP_POS, (const uint8_t*)opString);
+    frameBuffer_display(PV_POS, pvString);
+}
+
+void diagPageNext (void) {
+    if ((diagFirst + DIAG_TASK_ROWS) < stats_get()->taskCount) {
+        diagFirst += DIAG_TASK_ROWS;
     } else {
-        /* Convert raw to percent. */
-        percent = toPercent(pid.op);
+        diagFirst = 0;
+    }
+}
 
-        pid.opPercent = percent;
+void diagPagePrev (void) {
+    uint8_t count = stats_get()->taskCount;
 
-        /* Format value. */
-        sprintf(opString, "%3d", percent);
+    if (diagFirst >= DIAG_TASK_ROWS) {
+        diagFirst -= DIAG_TASK_ROWS;
+    } else if (count > 0u) {
+        /* Wrap to the last page. */
+        diagFirst = (uint8_t)(((count - 1u) / DIAG_TASK_ROWS) *
+                              DIAG_TASK_ROWS);
+    }
+}
 
-        lcd_display(OP_POS, (const uint8_t*)opString);
+static bool menuGuard (uint8_t guard) {
+    switch (guard) {
+        case GUARD_AUTO:
+            return (pid.mode == PID_AUTO);
+        case GUARD_MAN:
+            return (pid.mode == PID_MAN);
+        default:
+            return true;
     }
 }
 
-void printPV (void) {
-    char pvString[4];
-    int8_t percent;
+static void printOption (uint16_t firstPos, const char* first,
+                         uint16_t secondPos, const char* second,
+                         bool firstSelected) {
+    if (firstSelected) {
+        frameBuffer_display(secondPos, second);
+        frameBuffer_displayInverted(firstPos, first);
+    } else {
+        frameBuffer_display(firstPos, first);
+        frameBuffer_displayInverted(secondPos, second);
+    }
+}
 
-    /* Convert raw to percent. */
-    percent = toPercent(pid.pv);
-    pid.pvPercent = percent;
+static void printTrendScreen (void) {
+    frameBuffer_clear();
 
-    /* Format value. */
-    sprintf(pvString, "%3d", percent);
+    frameBuffer_display(FB_XY(1,1), "TREND   PV| SP-");
+    frameBuffer_display(FB_XY(1,FB_ROWS), "4 MIN    2: BACK");
 
-    lcd_display(PV_POS, (const uint8_t*)pvString);
+    trend_redraw(printTrendCell);
+}
+
+static void printTrendCell (uint8_t x, uint8_t page, uint8_t pvBits,
+                            uint8_t spBits) {
+    char cell[2] = {' ', '\0'};
+
+    if ((pvBits != 0u) && (spBits != 0u)) {
+        cell[0] = '+';
+    } else if (pvBits != 0u) {
+        cell[0] = '|';
+    } else if (spBits != 0u) {
+        cell[0] = '-';
+    }
+
+    /* Chart rows start below the title row. */
+    frameBuffer_display(FB_XY(x + 1u, page + 2u), cell);
+}
+
+static void printDiagScreen (void) {
+    frameBuffer_clear();
+
+    frameBuffer_display(FB_XY(1,1), "DIAG  CPU      %");
+    frameBuffer_display(FB_XY(1,2), "IRQ OFF       us");
+    frameBuffer_display(FB_XY(1,3), "CSW       WK");
+    frameBuffer_display(FB_XY(1,FB_ROWS), "1/3: MORE 2:BACK");
+
+    printDiagValues();
+}
+
+static void printDiagValues (void) {
+    const Stats* stats = stats_get();
+    const StatsTask* task;
+    char line[FB_COLS + 1u];
+    char number[FORMAT_INT32_SIZE];
+    uint8_t row;
+    uint8_t i;
+
+    format_fixed(number, stats->cpuUsage, 2u, 6u);
+    frameBuffer_display(FB_XY(10,1), number);
+
+    format_int(number, stats->intDisMaxUs, 5u);
+    frameBuffer_display(FB_XY(9,2), number);
+
+    format_int(number, stats->switches, 5u);
+    frameBuffer_display(FB_XY(4,3), number);
+
+    /* Idle wake-ups per second. */
+    format_int(number, stats->wakeups, 5u);
+    frameBuffer_display(FB_XY(12,3), number);
+
+    for (row = 0; row < DIAG_TASK_ROWS; row++) {
+        for (i = 0; i < FB_COLS; i++) {
+            line[i] = ' ';
+        }
+
+        line[FB_COLS] = '\0';
+
+        if ((diagFirst + row) < stats->taskCount) {
+            task = &stats->task[diagFirst + row];
+
+            /* Name, first 5 characters. */
+            for (i = 0; i < 5u; i++) {
+                if ((task->name == NULL) || (task->name[i] == '\0')) {
+                    break;
+                }
+
+                line[i] = task->name[i];
+            }
+
+            /* CPU usage with one decimal. */
+            format_fixed(number, (task->cpuUsage + 5) / 10, 1u, 5u);
+            printDiagField(&line[5], number, 5u);
+            line[10] = '%';
+
+            /* Stack high-water mark, percent of its size. */
+            if (task->stackSize > 0u) {
+                format_int(number, (((uint32_t)task->stackUsed * 100u) +
+                                    (task->stackSize / 2u)) /
+                                   task->stackSize, 4u);
+                printDiagField(&line[11], number, 4u);
+                line[15] = '%';
+            }
+        }
+
+        frameBuffer_display(FB_XY(1, row + 4u), line);
+    }
+}
+
+static void printDiagField (char* field, const char* text, uint8_t width) {
+    uint8_t i;
+
+    for (i = 0; (i < width) && (text[i] != '\0'); i++) {
+        field[i] = text[i];
+    }
 }
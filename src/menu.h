@@ -8,30 +8,81 @@
 #ifndef MENU_H_
 #define MENU_H_
 
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include "frameBuffer.h"
+#include "pidSnapshot.h"
+
+
+
 /******************************************************************************
 *                                  CONSTANTS                                  *
 ******************************************************************************/
 
 /** Setpoint value position in LCD. */
-#define SP_POS (LCD_XY(8,5))
+#define SP_POS (FB_XY(7,5))
 
 /** Controller output value position in LCD. */
-#define OP_POS (LCD_XY(8,6))
+#define OP_POS (FB_XY(7,6))
 
 /** Process variable value position in LCD. */
-#define PV_POS (LCD_XY(8,7))
+#define PV_POS (FB_XY(7,7))
+
+/** Width of the value fields in LCD. */
+#define VALUE_WIDTH (6u)
+
+/** Column of the unit text after each value field in LCD. */
+#define UNIT_COL (14)
 
 /** ON option position in LCD. */
-#define ON_POS (LCD_XY(3,2))
+#define ON_POS (FB_XY(3,2))
 
 /** OFF option position in LCD. */
-#define OFF_POS (LCD_XY(8,2))
+#define OFF_POS (FB_XY(8,2))
 
 /** Manual option position in LCD. */
-#define MAN_POS (LCD_XY(3,3))
+#define MAN_POS (FB_XY(3,3))
 
 /** Automatic option position in LCD. */
-#define AUT_POS (LCD_XY(8,3))
+#define AUT_POS (FB_XY(8,3))
+
+
+/** Number of buttons driving the menu. */
+#define MENU_BUTTONS (3)
+
+/** Task rows per diagnostics page. */
+#define DIAG_TASK_ROWS (4u)
+
+
+/** Screen region: selection cursor. */
+#define REGION_CURSOR  (0x01)
+
+/** Screen region: on/off option. */
+#define REGION_ON_OFF  (0x02)
+
+/** Screen region: manual/automatic option. */
+#define REGION_MAN_AUT (0x04)
+
+/** Screen region: setpoint value. */
+#define REGION_SP      (0x08)
+
+/** Screen region: controller output value. */
+#define REGION_OP      (0x10)
+
+/** Screen region: process variable value. */
+#define REGION_PV      (0x20)
+
+/** Screen region: contents of the page shown; trend chart columns completed
+    since the last draw or diagnostics values. */
+#define REGION_PAGE    (0x40)
+
+/** Screen region: whole screen. */
+#define REGION_SCREEN  (0x80)
+
+/** Screen regions holding controller values. */
+#define REGION_VALUES  (REGION_SP | REGION_OP | REGION_PV)
 
 
 
@@ -43,9 +94,11 @@
 enum SelectionType {
     ON_OFF_SEL = 2,     /**< On/off option. */
     MAN_AUT_SEL = 3,    /**< Manual/automatic option. */
+    DIAG_SEL = 4,       /**< Diagnostics screen. */
     SP_SEL = 5,         /**< Setpoint value. */
     OP_SEL = 6,         /**< Controller output value. */
-    PV_SEL = 7          /**< Process variable value. */
+    PV_SEL = 7,         /**< Process variable value. */
+    TREND_SEL = 8       /**< Trend chart screen. */
 };
 
 /** Menu mode: view or edit. */
@@ -54,17 +107,67 @@ enum MenuModeType {
     EDIT    /**< Edit mode.. */
 };
 
+/** Menu states: one view and one edit state per selectable option.
+    View and edit states alternate so MENU_MODE() can tell them apart. */
+enum MenuStateType {
+    MENU_ON_OFF_VIEW,   /**< On/off option selected. */
+    MENU_ON_OFF_EDIT,   /**< On/off option being edited. */
+    MENU_MAN_AUT_VIEW,  /**< Manual/automatic option selected. */
+    MENU_MAN_AUT_EDIT,  /**< Manual/automatic option being edited. */
+    MENU_SP_VIEW,       /**< Setpoint selected. */
+    MENU_SP_EDIT,       /**< Setpoint being edited. */
+    MENU_OP_VIEW,       /**< Controller output selected. */
+    MENU_OP_EDIT,       /**< Controller output being edited. */
+    MENU_TREND_VIEW,    /**< Trend chart option selected. */
+    MENU_TREND_EDIT,    /**< Trend chart screen shown. */
+    MENU_DIAG_VIEW,     /**< Diagnostics option selected. */
+    MENU_DIAG_EDIT,     /**< Diagnostics screen shown. */
+    MENU_STATES         /**< Number of menu states. */
+};
+
+/** Transition guards: conditions that must hold for a transition. */
+enum MenuGuardType {
+    GUARD_NONE,    /**< Always allowed. */
+    GUARD_AUTO,    /**< Only allowed in automatic mode. */
+    GUARD_MAN      /**< Only allowed in manual mode. */
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Get menu mode (VIEW or EDIT) of a menu state. */
+#define MENU_MODE(state) ((uint8_t)((state) & 0x01))
 
 
 /******************************************************************************
 *                              TYPE DEFINITIONS                               *
 ******************************************************************************/
 
-/** Cursor control structure. */
-typedef struct CursorControl_struct {
-    uint8_t selection;      /**< Current selection. */
-    uint8_t mode;           /**< Cursor mode: view or edit. */
-} CursorControl;
+/** Menu control structure. */
+typedef struct MenuControl_struct {
+    uint8_t state;          /**< Current menu state. */
+    uint8_t activeTemp;     /**< On/off value while being edited. */
+    uint8_t modeTemp;       /**< Manual/automatic value while being edited. */
+    int32_t spTemp;         /**< Setpoint value while being edited. */
+    int32_t opTemp;         /**< Controller output value while being edited. */
+} MenuControl;
+
+/** Menu transition taken when a button is pressed. */
+typedef struct MenuTransition_struct {
+    void (*effect)(void);   /**< Action performed, null for none. */
+    uint8_t guard;          /**< Condition for the transition to happen. */
+    uint8_t next;           /**< Next menu state. */
+    uint8_t redraw;         /**< Screen regions to redraw. */
+} MenuTransition;
+
+/** Menu state table entry. */
+typedef struct MenuStateEntry_struct {
+    uint8_t row;                                /**< Cursor row in LCD. */
+    MenuTransition button[MENU_BUTTONS];        /**< Transition per button. */
+} MenuStateEntry;
 
 
 
@@ -79,49 +182,52 @@ typedef struct CursorControl_struct {
 void printMainMenu (void);
 
 /**
-    \brief Displayed menu actions when on/off option is selected.
+    \brief Perform the menu transition for a button press.
     \param action Value for action to be taken, indicated by button press.
-    \return None
+    \return Screen regions to redraw.
  */
-void onOffSelectionMenu (uint8_t action);
+uint8_t menuDispatch (uint8_t action);
 
 /**
-    \brief Displayed menu actions when manual/automatic option is selected.
-    \param action Value for action to be taken, indicated by button press.
-    \return None
+    \brief Redraw menu regions from the current menu state.
+    \param regions Screen regions to redraw.
+    \return Value regions left to redraw with printSP(), printOP() and
+            printPV(); none while the trend chart or the diagnostics
+            screen is shown.
  */
-void manAutSelectionMenu (uint8_t action);
+uint8_t menuRender (uint8_t regions);
 
 /**
-    \brief Displayed menu actions when setpoint option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Show the next tasks on the diagnostics screen.
     \return None
  */
-void spSelectionMenu (uint8_t action);
+void diagPageNext (void);
 
 /**
-    \brief Displayed menu actions when controller output option is selected.
-    \param action Value for action to be taken, indicated by button press.
+    \brief Show the previous tasks on the diagnostics screen.
     \return None
  */
-void opSelectionMenu (uint8_t action);
+void diagPagePrev (void);
 
 /**
     \brief Print setpoint value.
+    \param state Pointer to published PID loop state.
     \return None
  */
-void printSP (void);
+void printSP (const PIDSnapshot* state);
 
 /**
     \brief Print controller output value.
+    \param state Pointer to published PID loop state.
     \return None
  */
-void printOP (void);
+void printOP (const PIDSnapshot* state);
 
 /**
     \brief Print process variable value.
+    \param state Pointer to published PID loop state.
     \return None
  */
-void printPV (void);
+void printPV (const PIDSnapshot* state);
 
 #endif /* MENU_H_ */
@@ -0,0 +1,529 @@
+/**
+    \file modbus.c
+    \brief Implementation file for the Modbus RTU slave protocol library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "modbus.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Write multiple registers request size before the values. */
+#define MODBUS_WRITE_HEADER (7u)
+
+/** Write reply size before the CRC: the request echo. */
+#define MODBUS_WRITE_REPLY (6u)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/**
+    \brief Function handler.
+    \param map Register map.
+    \param request Request frame, checked for its CRC and fixed length.
+    \param length Request length, CRC included.
+    \param reply Reply buffer.
+    \param replyLength Reply length before the CRC, set on success.
+    \return ModbusException.
+ */
+typedef uint8_t (*ModbusHandler)(const ModbusMap* map,
+                                 const uint8_t* request, uint16_t length,
+                                 uint8_t* reply, uint16_t* replyLength);
+
+/** Function table entry. */
+typedef struct ModbusFunctionEntry_struct {
+    uint8_t code;           /**< Function code. */
+    uint8_t length;         /**< Request length with the CRC; zero if it
+                                 depends on the request. */
+    bool broadcast;         /**< Allowed as a broadcast. */
+    ModbusHandler handler;  /**< Handler. */
+} ModbusFunctionEntry;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Read holding or input registers.
+    \return ModbusException.
+ */
+static uint8_t modbus_read (const ModbusMap* map, const uint8_t* request,
+                            uint16_t length, uint8_t* reply,
+                            uint16_t* replyLength);
+
+/**
+    \brief Write a single holding register.
+    \return ModbusException.
+ */
+static uint8_t modbus_writeSingle (const ModbusMap* map,
+                                   const uint8_t* request, uint16_t length,
+                                   uint8_t* reply, uint16_t* replyLength);
+
+/**
+    \brief Write consecutive holding registers.
+    \return ModbusException.
+ */
+static uint8_t modbus_writeMultiple (const ModbusMap* map,
+                                     const uint8_t* request,
+                                     uint16_t length, uint8_t* reply,
+                                     uint16_t* replyLength);
+
+/**
+    \brief Check or apply the values of a write multiple request.
+    \param map Register map.
+    \param first First register, the start of a value.
+    \param end Register after the last one; the registers in between are
+           checked to be writable whole values.
+    \param in First value.
+    \param apply Apply the values; otherwise only check them.
+    \return ModbusException of the first value rejected.
+ */
+static uint8_t modbus_setValues (const ModbusMap* map, uint16_t first,
+                                 uint32_t end, const uint8_t* in,
+                                 bool apply);
+
+/**
+    \brief Find the descriptor covering a register.
+    \param table Descriptors, sorted by address.
+    \param count Number of descriptors.
+    \param address Register address.
+    \return Descriptor, or null if the register is not in the map.
+ */
+static const ModbusRegister* modbus_find (const ModbusRegister* table,
+                                          uint16_t count, uint16_t address);
+
+/**
+    \brief Get the number of registers of a value type.
+    \param type Value type.
+    \return One or two.
+ */
+static uint16_t modbus_size (uint8_t type);
+
+/**
+    \brief Load a written value.
+    \param reg Descriptor.
+    \param in Value in the request.
+    \return Value bits, as the set function of the descriptor takes them.
+ */
+static uint32_t modbus_decode (const ModbusRegister* reg, const uint8_t* in);
+
+/**
+    \brief Read a live value.
+    \param reg Descriptor.
+    \return Value bits: integers sign or zero extended, floats as bits.
+ */
+static uint32_t modbus_get (const ModbusRegister* reg);
+
+/**
+    \brief Load a big-endian 16-bit value.
+    \param in Buffer position.
+    \return Value.
+ */
+static uint16_t modbus_get16 (const uint8_t* in);
+
+/**
+    \brief Store a big-endian 16-bit value.
+    \param out Buffer position.
+    \param value Value to store.
+    \return Buffer position after the value.
+ */
+static uint8_t* modbus_put16 (uint8_t* out, uint16_t value);
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** CRC-16/MODBUS of every byte value, for one lookup per byte. */
+static const uint16_t crcTable[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
+};
+
+/** Supported functions. */
+static const ModbusFunctionEntry functions[] = {
+    { MODBUS_READ_HOLDING, 8u, false, modbus_read },
+    { MODBUS_READ_INPUT, 8u, false, modbus_read },
+    { MODBUS_WRITE_SINGLE, 8u, true, modbus_writeSingle },
+    { MODBUS_WRITE_MULTIPLE, 0u, true, modbus_writeMultiple }
+};
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+uint16_t modbus_crc (const uint8_t* data, uint16_t size) {
+    uint16_t crc = 0xFFFF;
+
+    while (size-- > 0u) {
+        crc = (uint16_t)((crc >> 8) ^ crcTable[(crc ^ *data++) & 0xFFu]);
+    }
+
+    return crc;
+}
+
+uint16_t modbus_process (const ModbusMap* map, uint8_t address,
+                         const uint8_t* request, uint16_t length,
+                         uint8_t* reply) {
+    const ModbusFunctionEntry* entry = (const ModbusFunctionEntry*)0;
+    uint16_t replyLength = 0;
+    uint16_t crc;
+    uint8_t exception;
+    uint8_t i;
+    bool broadcast;
+
+    /* Noise and frames for other slaves get no answer. */
+    if ((length < MODBUS_FRAME_MIN) || (length > MODBUS_FRAME_MAX) ||
+        (modbus_crc(request, length) != 0u)) {
+        return 0;
+    }
+
+    broadcast = (request[0] == MODBUS_BROADCAST);
+
+    if (!broadcast && (request[0] != address)) {
+        return 0;
+    }
+
+    for (i = 0; i < (sizeof(functions) / sizeof(functions[0])); i++) {
+        if (functions[i].code == request[1]) {
+            entry = &functions[i];
+            break;
+        }
+    }
+
+    if (entry == (const ModbusFunctionEntry*)0) {
+        exception = MODBUS_EX_ILLEGAL_FUNCTION;
+    } else if (broadcast && !entry->broadcast) {
+        return 0;
+    } else if ((entry->length != 0u) && (length != entry->length)) {
+        exception = MODBUS_EX_ILLEGAL_VALUE;
+    } else {
+        exception = entry->handler(map, request, length, reply,
+                                   &replyLength);
+    }
+
+    if (broadcast) {
+        return 0;
+    }
+
+    reply[0] = address;
+
+    if (exception != MODBUS_EX_NONE) {
+        reply[1] = (uint8_t)(request[1] | MODBUS_EXCEPTION_FLAG);
+        reply[2] = exception;
+        replyLength = 3;
+    } else {
+        reply[1] = request[1];
+    }
+
+    /* The CRC goes low byte first, unlike the values. */
+    crc = modbus_crc(reply, replyLength);
+    reply[replyLength] = (uint8_t)crc;
+    reply[replyLength + 1u] = (uint8_t)(crc >> 8);
+
+    return replyLength + 2u;
+}
+
+static uint8_t modbus_read (const ModbusMap* map, const uint8_t* request,
+                            uint16_t length, uint8_t* reply,
+                            uint16_t* replyLength) {
+    const ModbusRegister* table;
+    const ModbusRegister* reg;
+    uint16_t tableCount;
+    uint16_t address = modbus_get16(&request[2]);
+    uint16_t count = modbus_get16(&request[4]);
+    uint32_t end = (uint32_t)address + count;
+    uint32_t bits;
+    uint16_t words;
+    uint16_t word;
+    uint16_t shift;
+    uint8_t* out = &reply[3];
+
+    (void)length;
+
+    if ((count == 0u) || (count > MODBUS_READ_MAX)) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    if (request[1] == MODBUS_READ_HOLDING) {
+        table = map->holding;
+        tableCount = map->holdingCount;
+    } else {
+        table = map->input;
+        tableCount = map->inputCount;
+    }
+
+    while (address < end) {
+        reg = modbus_find(table, tableCount, address);
+
+        if (reg == (const ModbusRegister*)0) {
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+        }
+
+        /* One access per value: both words of a 32-bit value belong
+           together. A read may start or end in the middle of one. */
+        bits = modbus_get(reg);
+        words = modbus_size(reg->type);
+
+        for (word = (uint16_t)(address - reg->address);
+             (word < words) && (address < end); word++) {
+            shift = 16u * (words - 1u - word);
+            out = modbus_put16(out, (uint16_t)(bits >> shift));
+            address++;
+        }
+    }
+
+    reply[2] = (uint8_t)(count * 2u);
+    *replyLength = 3u + (count * 2u);
+
+    return MODBUS_EX_NONE;
+}
+
+static uint8_t modbus_writeSingle (const ModbusMap* map,
+                                   const uint8_t* request, uint16_t length,
+                                   uint8_t* reply, uint16_t* replyLength) {
+    const ModbusRegister* reg;
+    uint8_t exception;
+
+    (void)length;
+
+    reg = modbus_find(map->holding, map->holdingCount,
+                      modbus_get16(&request[2]));
+
+    /* A 32-bit value cannot be written one half at a time. */
+    if ((reg == (const ModbusRegister*)0) ||
+        (reg->set == (uint8_t (*)(uint32_t, bool))0) ||
+        (modbus_size(reg->type) != 1u)) {
+        return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+
+    exception = reg->set(modbus_decode(reg, &request[4]), true);
+
+    if (exception != MODBUS_EX_NONE) {
+        return exception;
+    }
+
+    /* The reply echoes the request. */
+    (void)memcpy(reply, request, MODBUS_WRITE_REPLY);
+    *replyLength = MODBUS_WRITE_REPLY;
+
+    return MODBUS_EX_NONE;
+}
+
+static uint8_t modbus_writeMultiple (const ModbusMap* map,
+                                     const uint8_t* request,
+                                     uint16_t length, uint8_t* reply,
+                                     uint16_t* replyLength) {
+    const ModbusRegister* reg;
+    uint16_t first;
+    uint16_t count;
+    uint16_t address;
+    uint16_t words;
+    uint32_t end;
+    uint8_t exception;
+
+    if (length < (MODBUS_WRITE_HEADER + 4u)) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    first = modbus_get16(&request[2]);
+    count = modbus_get16(&request[4]);
+    end = (uint32_t)first + count;
+
+    if ((count == 0u) || (count > MODBUS_WRITE_MAX) ||
+        (request[6] != (count * 2u)) ||
+        (length != (MODBUS_WRITE_HEADER + 2u + (count * 2u)))) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    /* Check every register first: a bad address changes nothing. */
+    for (address = first; address < end; address += words) {
+        reg = modbus_find(map->holding, map->holdingCount, address);
+
+        if ((reg == (const ModbusRegister*)0) ||
+            (reg->set == (uint8_t (*)(uint32_t, bool))0) ||
+            (reg->address != address)) {
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+        }
+
+        words = modbus_size(reg->type);
+
+        if (((uint32_t)address + words) > end) {
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+        }
+    }
+
+    /* Then every value: a rejected one changes nothing either. */
+    exception = modbus_setValues(map, first, end,
+                                 &request[MODBUS_WRITE_HEADER], false);
+
+    if (exception == MODBUS_EX_NONE) {
+        exception = modbus_setValues(map, first, end,
+                                     &request[MODBUS_WRITE_HEADER], true);
+    }
+
+    if (exception != MODBUS_EX_NONE) {
+        return exception;
+    }
+
+    /* The reply echoes the address and count. */
+    (void)memcpy(reply, request, MODBUS_WRITE_REPLY);
+    *replyLength = MODBUS_WRITE_REPLY;
+
+    return MODBUS_EX_NONE;
+}
+
+static uint8_t modbus_setValues (const ModbusMap* map, uint16_t first,
+                                 uint32_t end, const uint8_t* in,
+                                 bool apply) {
+    const ModbusRegister* reg;
+    uint16_t address;
+    uint16_t words;
+    uint8_t exception;
+
+    for (address = first; address < end; address += words) {
+        reg = modbus_find(map->holding, map->holdingCount, address);
+        words = modbus_size(reg->type);
+        exception = reg->set(modbus_decode(reg, in), apply);
+
+        if (exception != MODBUS_EX_NONE) {
+            return exception;
+        }
+
+        in += words * 2u;
+    }
+
+    return MODBUS_EX_NONE;
+}
+
+static const ModbusRegister* modbus_find (const ModbusRegister* table,
+                                          uint16_t count, uint16_t address) {
+    const ModbusRegister* reg;
+    uint16_t low = 0;
+    uint16_t high = count;
+    uint16_t middle;
+
+    /* Binary search over the address ranges of the descriptors. */
+    while (low < high) {
+        middle = (uint16_t)((low + high) / 2u);
+        reg = &table[middle];
+
+        if (address < reg->address) {
+            high = middle;
+        } else if (address >=
+                   ((uint32_t)reg->address + modbus_size(reg->type))) {
+            low = (uint16_t)(middle + 1u);
+        } else {
+            return reg;
+        }
+    }
+
+    return (const ModbusRegister*)0;
+}
+
+static uint16_t modbus_size (uint8_t type) {
+    return (type >= MODBUS_I32) ? 2u : 1u;
+}
+
+static uint32_t modbus_decode (const ModbusRegister* reg, const uint8_t* in) {
+    if (modbus_size(reg->type) == 2u) {
+        return ((uint32_t)modbus_get16(in) << 16) | modbus_get16(in + 2);
+    }
+
+    if (reg->type == MODBUS_I16) {
+        return (uint32_t)(int32_t)(int16_t)modbus_get16(in);
+    }
+
+    return modbus_get16(in);
+}
+
+static uint32_t modbus_get (const ModbusRegister* reg) {
+    uint32_t bits;
+    float value;
+
+    if (reg->value == (const volatile void*)0) {
+        return reg->get();
+    }
+
+    switch (reg->type) {
+        case MODBUS_U8:
+            bits = *(const volatile uint8_t*)reg->value;
+        break;
+        case MODBUS_I16:
+            bits = (uint32_t)(int32_t)*(const volatile int16_t*)reg->value;
+        break;
+        case MODBUS_U16:
+            bits = *(const volatile uint16_t*)reg->value;
+        break;
+        case MODBUS_F32:
+            value = *(const volatile float*)reg->value;
+            (void)memcpy(&bits, &value, sizeof(bits));
+        break;
+        default:
+            bits = *(const volatile uint32_t*)reg->value;
+        break;
+    }
+
+    return bits;
+}
+
+static uint16_t modbus_get16 (const uint8_t* in) {
+    return (uint16_t)(((uint16_t)in[0] << 8) | in[1]);
+}
+
+static uint8_t* modbus_put16 (uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+
+    return out + 2;
+}
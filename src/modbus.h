@@ -0,0 +1,166 @@
+/**
+    \file modbus.h
+    \brief Header file for the Modbus RTU slave protocol library.
+    \details Frame checking, register access and reply building of a
+             Modbus RTU slave, in portable C with no kernel or board
+             dependency, so that the same code runs on the host (see
+             tools/modbusMaster.c). The serial side, frame timing and the
+             register map of this controller are in modbusSlave.c.
+             \par
+             Supported functions: read holding registers (0x03), read input
+             registers (0x04), write single register (0x06) and write
+             multiple registers (0x10). A frame is the slave address, the
+             function code, the data and the CRC-16/MODBUS, low byte first;
+             register values are big-endian. Broadcast writes (address 0)
+             are applied and not answered.
+             \par
+             The registers are described by a static table of ModbusRegister
+             descriptors sorted by address, each pointing at the live value
+             it exposes, so a read goes from the variable to the reply with
+             no shadow copy in between. A value behind an accessor is read
+             through its get function instead. 32-bit values take two
+             registers, high word first, and are read in one access, so the
+             two words always belong together; a read of several values is
+             not a snapshot across them. A write goes through the set
+             function of its descriptor, which checks the value. A write
+             of several values checks them all before it applies any, so a
+             rejected value leaves every register as it was.
+             \par
+             Both the CRC and the request decoding are table-driven: one
+             table lookup per byte for the CRC, and a table of function
+             codes with their fixed request lengths and handlers.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Largest RTU frame, in bytes. */
+#define MODBUS_FRAME_MAX (256u)
+
+/** Smallest RTU frame: address, function and CRC. */
+#define MODBUS_FRAME_MIN (4u)
+
+/** Broadcast slave address. */
+#define MODBUS_BROADCAST (0u)
+
+/** Most registers in one read. */
+#define MODBUS_READ_MAX (125u)
+
+/** Most registers in one write. */
+#define MODBUS_WRITE_MAX (123u)
+
+/** Exception reply flag of the function code. */
+#define MODBUS_EXCEPTION_FLAG (0x80u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Supported function codes. */
+enum ModbusFunction {
+    MODBUS_READ_HOLDING = 0x03,     /**< Read holding registers. */
+    MODBUS_READ_INPUT = 0x04,       /**< Read input registers. */
+    MODBUS_WRITE_SINGLE = 0x06,     /**< Write single register. */
+    MODBUS_WRITE_MULTIPLE = 0x10    /**< Write multiple registers. */
+};
+
+/** Exception codes; MODBUS_EX_NONE for success. */
+enum ModbusException {
+    MODBUS_EX_NONE,                 /**< No exception. */
+    MODBUS_EX_ILLEGAL_FUNCTION,     /**< Function not supported. */
+    MODBUS_EX_ILLEGAL_ADDRESS,      /**< Register not in the map, not
+                                         writable, or a 32-bit value only
+                                         partly written. */
+    MODBUS_EX_ILLEGAL_VALUE,        /**< Bad count or value out of range. */
+    MODBUS_EX_DEVICE_FAILURE        /**< Not allowed in the current
+                                         state. */
+};
+
+/** Register value types. */
+enum ModbusType {
+    MODBUS_U8,      /**< uint8_t, one register. */
+    MODBUS_I16,     /**< int16_t, one register. */
+    MODBUS_U16,     /**< uint16_t, one register. */
+    MODBUS_I32,     /**< int32_t, two registers. */
+    MODBUS_U32,     /**< uint32_t, two registers. */
+    MODBUS_F32      /**< IEEE 754 float, two registers. */
+};
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Register descriptor. */
+typedef struct ModbusRegister_struct {
+    uint16_t address;               /**< First register address. */
+    uint8_t type;                   /**< Value type (ModbusType). */
+    const volatile void* value;     /**< Live value; null to use get. */
+    uint32_t (*get)(void);          /**< Value bits, as set takes them;
+                                         used if value is null. */
+    uint8_t (*set)(uint32_t bits, bool apply);
+                                    /**< Check a written value and, if
+                                         apply, apply it: integers sign or
+                                         zero extended, floats as their
+                                         bits; returns a ModbusException.
+                                         A value that passes the check
+                                         must apply. Null if read only. */
+} ModbusRegister;
+
+/** Register map. */
+typedef struct ModbusMap_struct {
+    const ModbusRegister* holding;  /**< Holding registers, by address. */
+    uint16_t holdingCount;          /**< Holding register descriptors. */
+    const ModbusRegister* input;    /**< Input registers, by address. */
+    uint16_t inputCount;            /**< Input register descriptors. */
+} ModbusMap;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Compute the CRC-16/MODBUS of a buffer: polynomial 0x8005
+           reflected, initial value 0xFFFF, no final XOR.
+    \param data Buffer.
+    \param size Buffer size, in bytes.
+    \return CRC value; zero over a frame with its CRC means a good frame.
+ */
+uint16_t modbus_crc (const uint8_t* data, uint16_t size);
+
+/**
+    \brief Check a request frame, apply it and build the reply.
+    \param map Register map.
+    \param address Slave address.
+    \param request Request frame, CRC included.
+    \param length Request length, in bytes.
+    \param reply Reply buffer, MODBUS_FRAME_MAX bytes; may not overlap the
+           request.
+    \return Reply length, CRC included; zero if there is no reply: bad CRC,
+            another slave, or a broadcast.
+ */
+uint16_t modbus_process (const ModbusMap* map, uint8_t address,
+                         const uint8_t* request, uint16_t length,
+                         uint8_t* reply);
+
+#endif /* MODBUS_H */
@@ -0,0 +1,719 @@
+/**
+    \file modbusSlave.c
+    \brief Implementation file for the Modbus RTU slave library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <machine.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "platform.h"
+#include "controller.h"
+#include "controllerSysControl.h"
+#include "displayDirty.h"
+#include "stats.h"
+#include "trace.h"
+#include "modbus.h"
+#include "modbusSlave.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Busy loop iterations covering one bit time after setting the bit rate. */
+#define MODBUS_SLAVE_BIT_WAIT (5000u)
+
+/** SCR: receiver and its interrupt on, transmitter off. */
+#define MODBUS_SLAVE_SCR_RECEIVE (0x50u)
+
+/** SCR: TIE and TE set together, which raises the first TXI. */
+#define MODBUS_SLAVE_SCR_SEND (0xF0u)
+
+/** SCR transmit end interrupt enable bit. */
+#define MODBUS_SLAVE_SCR_TEIE (0x04u)
+
+/** SSR overrun, framing and parity error flags. */
+#define MODBUS_SLAVE_SSR_ERRORS (0x38u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Line states. */
+enum ModbusSlaveState {
+    MODBUS_SLAVE_RECEIVING, /**< Taking the bytes of a request. */
+    MODBUS_SLAVE_READY,     /**< Request complete, waiting for the task. */
+    MODBUS_SLAVE_SENDING    /**< Reply going out; received bytes ignored. */
+};
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern PIDControl pid;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Write the setpoint register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setSp (uint32_t bits, bool apply);
+
+/**
+    \brief Write the controller output register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setOp (uint32_t bits, bool apply);
+
+/**
+    \brief Write the mode register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setMode (uint32_t bits, bool apply);
+
+/**
+    \brief Write the power register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setActive (uint32_t bits, bool apply);
+
+/**
+    \brief Read the b1 coefficient register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getB1 (void);
+
+/**
+    \brief Read the b2 coefficient register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getB2 (void);
+
+/**
+    \brief Read the b3 coefficient register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getB3 (void);
+
+/**
+    \brief Write the b1 coefficient register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setB1 (uint32_t bits, bool apply);
+
+/**
+    \brief Write the b2 coefficient register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setB2 (uint32_t bits, bool apply);
+
+/**
+    \brief Write the b3 coefficient register.
+    \param bits Value bits.
+    \param apply Apply the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setB3 (uint32_t bits, bool apply);
+
+/**
+    \brief Read the setpoint register, in engineering units.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getSpValue (void);
+
+/**
+    \brief Read the process variable register, in engineering units.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getPvValue (void);
+
+/**
+    \brief Read the controller output register, in engineering units.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getOpValue (void);
+
+/**
+    \brief Read the CPU usage register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getCpuUsage (void);
+
+/**
+    \brief Read the context switch register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getSwitches (void);
+
+/**
+    \brief Read the idle wake-up register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getWakeups (void);
+
+/**
+    \brief Read the interrupt disable time register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getIntDisMax (void);
+
+/**
+    \brief Read the deadline miss register.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getMisses (void);
+
+/**
+    \brief Stage a coefficient written by the current request.
+    \param index Coefficient: 0 for b1, 1 for b2, 2 for b3.
+    \param bits Value bits.
+    \param apply Stage the value; otherwise only check it.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_setCoefficient (uint8_t index, uint32_t bits,
+                                           bool apply);
+
+/**
+    \brief Map the result of a controller setting to its exception.
+    \param result PIDSettingResult.
+    \return ModbusException.
+ */
+static uint8_t modbusSlave_exception (uint8_t result);
+
+/**
+    \brief Get a coefficient, as written or in use.
+    \param index Coefficient: 0 for b1, 1 for b2, 2 for b3.
+    \return Value bits.
+ */
+static uint32_t modbusSlave_getCoefficient (uint8_t index);
+
+/**
+    \brief Drop the received bytes and take a new request.
+    \return None
+ */
+static void modbusSlave_receive (void);
+
+#if (MODBUS_SLAVE_ENABLED)
+/**
+    \brief SCI6 receive interrupt service routine.
+    \return None
+ */
+static void modbusSlave_rxIsr (void);
+
+/**
+    \brief SCI6 transmit data empty interrupt service routine.
+    \return None
+ */
+static void modbusSlave_txIsr (void);
+
+/**
+    \brief SCI6 transmit end interrupt service routine.
+    \return None
+ */
+static void modbusSlave_txEndIsr (void);
+
+/**
+    \brief CMT3 frame end interrupt service routine.
+    \return None
+ */
+static void modbusSlave_frameIsr (void);
+#endif
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Line state. */
+static volatile uint8_t state = MODBUS_SLAVE_RECEIVING;
+
+/** Request being received. */
+static uint8_t rxBuffer[MODBUS_FRAME_MAX];
+
+/** Request bytes received. */
+static volatile uint16_t rxLength = 0;
+
+/** The request did not fit the buffer; it is dropped at its end. */
+static volatile bool rxOverflow = false;
+
+/** Reply being sent. */
+static uint8_t txBuffer[MODBUS_FRAME_MAX];
+
+/** Reply length, in bytes. */
+static uint16_t txLength = 0;
+
+/** Next reply byte to send. */
+static volatile uint16_t txIndex = 0;
+
+/** Task posted at each frame end. */
+static OS_TCB* notify = (OS_TCB*)0;
+
+/** Control cycle deadline monitor; may be null. */
+static const DeadlineMonitor* deadlineMonitor = (const DeadlineMonitor*)0;
+
+/** Coefficients written by the current request. */
+static PIDCoefficients pendingCoefficients;
+
+/** A coefficient was written by the current request. */
+static bool coefficientsPending = false;
+
+/** Holding registers, by address. The setpoint and output are checked
+    against the mode before a write of several registers changes it. */
+static const ModbusRegister holdingRegisters[] = {
+    { 0u, MODBUS_I32, 0, modbusSlave_getSpValue, modbusSlave_setSp },
+    { 2u, MODBUS_I32, 0, modbusSlave_getOpValue, modbusSlave_setOp },
+    { 4u, MODBUS_U8, &pid.mode, 0, modbusSlave_setMode },
+    { 5u, MODBUS_U8, &pid.active, 0, modbusSlave_setActive },
+    { 6u, MODBUS_F32, 0, modbusSlave_getB1, modbusSlave_setB1 },
+    { 8u, MODBUS_F32, 0, modbusSlave_getB2, modbusSlave_setB2 },
+    { 10u, MODBUS_F32, 0, modbusSlave_getB3, modbusSlave_setB3 }
+};
+
+/** Input registers, by address. */
+static const ModbusRegister inputRegisters[] = {
+    { 0u, MODBUS_I16, &pid.sp, 0, 0 },
+    { 1u, MODBUS_I16, &pid.pv, 0, 0 },
+    { 2u, MODBUS_I16, &pid.op, 0, 0 },
+    { 3u, MODBUS_I16, &pid.er, 0, 0 },
+    { 4u, MODBUS_I32, 0, modbusSlave_getSpValue, 0 },
+    { 6u, MODBUS_I32, 0, modbusSlave_getPvValue, 0 },
+    { 8u, MODBUS_I32, 0, modbusSlave_getOpValue, 0 },
+    { 10u, MODBUS_U16, 0, modbusSlave_getCpuUsage, 0 },
+    { 11u, MODBUS_U16, 0, modbusSlave_getSwitches, 0 },
+    { 12u, MODBUS_U16, 0, modbusSlave_getWakeups, 0 },
+    { 13u, MODBUS_U16, 0, modbusSlave_getIntDisMax, 0 },
+    { 14u, MODBUS_U32, 0, modbusSlave_getMisses, 0 }
+};
+
+/** Register map. */
+static const ModbusMap map = {
+    holdingRegisters,
+    (uint16_t)(sizeof(holdingRegisters) / sizeof(holdingRegisters[0])),
+    inputRegisters,
+    (uint16_t)(sizeof(inputRegisters) / sizeof(inputRegisters[0]))
+};
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void modbusSlave_init (OS_TCB* notifyTCB, const DeadlineMonitor* deadline) {
+    uint16_t i;
+
+    notify = notifyTCB;
+    deadlineMonitor = deadline;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up SCI6 and CMT unit 1 (CMT2 and CMT3). */
+    MSTP(SCI6) = 0;
+    MSTP(CMT3) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Set up port 00 (TXD6) and port 01 (RXD6) for SCI6. */
+    PORT0.PODR.BIT.B0 = 1;      /* Idle line level while still GPIO. */
+    PORT0.PDR.BIT.B0  = 1;      /* Set I/O pin direction to output. */
+    PORT0.PDR.BIT.B1  = 0;      /* Set I/O pin direction to input. */
+    PORT0.PMR.BIT.B0  = 0;      /* First set I/O pins to GPIO mode. */
+    PORT0.PMR.BIT.B1  = 0;
+    MPC.P00PFS.BYTE = 0x0A;     /* P00 is used as TXD6. */
+    MPC.P01PFS.BYTE = 0x0A;     /* P01 is used as RXD6. */
+    PORT0.PMR.BIT.B0  = 1;      /* Hand the pins over to SCI6. */
+    PORT0.PMR.BIT.B1  = 1;
+
+    /* Asynchronous 8E1, PCLK/1 count source; receiver still off. */
+    SCI6.SCR.BYTE = 0x00;
+    SCI6.SMR.BYTE = 0x20;
+    SCI6.SCMR.BYTE = 0xF2;      /* Serial mode, LSB first. */
+    SCI6.SEMR.BYTE = 0x00;
+    SCI6.BRR = MODBUS_SLAVE_BRR;
+
+    /* The bit rate settles within one bit time. */
+    for (i = 0; i < MODBUS_SLAVE_BIT_WAIT; i++) {
+        nop();
+    }
+
+    /* CMT3: PCLK/32, compare match interrupt; started by each byte. */
+    CMT.CMSTR1.BIT.STR3 = 0;
+    CMT3.CMCR.WORD = 0x00C1;
+    CMT3.CMCNT = 0;
+    CMT3.CMCOR = (uint16_t)(MODBUS_SLAVE_T35_COUNTS - 1u);
+
+    IPR(SCI6,RXI6) = MODBUS_SLAVE_IPL;
+    IR(SCI6,RXI6) = 0;
+    IR(SCI6,TXI6) = 0;
+    IR(SCI6,TEI6) = 0;
+    IEN(SCI6,RXI6) = 1;
+    IEN(SCI6,TXI6) = 1;
+    IEN(SCI6,TEI6) = 1;
+
+    IPR(CMT3,CMI3) = MODBUS_SLAVE_IPL;
+    IR(CMT3,CMI3) = 0;
+    IEN(CMT3,CMI3) = 1;
+
+    SCI6.SCR.BYTE = MODBUS_SLAVE_SCR_RECEIVE;
+}
+
+bool modbusSlave_ready (void) {
+    return (state == MODBUS_SLAVE_READY);
+}
+
+void modbusSlave_serve (void) {
+    bool lineError = ((SCI6.SSR.BYTE & MODBUS_SLAVE_SSR_ERRORS) != 0u);
+
+    /* A line error stops the receiver until its flag is cleared. */
+    if (lineError) {
+        SCI6.SSR.BYTE = (uint8_t)(SCI6.SSR.BYTE & ~MODBUS_SLAVE_SSR_ERRORS);
+    }
+
+    if (state != MODBUS_SLAVE_READY) {
+        return;
+    }
+
+    /* Bytes were lost: the request cannot be trusted. */
+    if (lineError) {
+        modbusSlave_receive();
+        return;
+    }
+
+    coefficientsPending = false;
+    txLength = modbus_process(&map, MODBUS_SLAVE_ADDRESS, rxBuffer,
+                              rxLength, txBuffer);
+
+    /* All the coefficients of one request take effect together, and only
+       if the request was taken: broadcasts have no reply to check. */
+    if (coefficientsPending &&
+        ((txLength == 0u) ||
+         ((txBuffer[1] & MODBUS_EXCEPTION_FLAG) == 0u))) {
+        (void)setCoefficients_PID(&pendingCoefficients);
+    }
+
+    coefficientsPending = false;
+
+    if (txLength == 0u) {
+        modbusSlave_receive();
+        return;
+    }
+
+    txIndex = 0;
+    state = MODBUS_SLAVE_SENDING;
+    SCI6.SCR.BYTE = MODBUS_SLAVE_SCR_SEND;
+}
+
+static uint8_t modbusSlave_setSp (uint32_t bits, bool apply) {
+    uint8_t result;
+
+    if (!apply) {
+        return modbusSlave_exception(checkSetpoint((int32_t)bits));
+    }
+
+    result = setSetpoint((int32_t)bits);
+
+    if (result == PID_SETTING_OK) {
+        displayDirty_set(DISPLAY_SP);
+    }
+
+    return modbusSlave_exception(result);
+}
+
+static uint8_t modbusSlave_setOp (uint32_t bits, bool apply) {
+    uint8_t result;
+
+    if (!apply) {
+        return modbusSlave_exception(checkOutput((int32_t)bits));
+    }
+
+    result = setOutput((int32_t)bits);
+
+    if (result == PID_SETTING_OK) {
+        displayDirty_set(DISPLAY_OP);
+    }
+
+    return modbusSlave_exception(result);
+}
+
+static uint8_t modbusSlave_setMode (uint32_t bits, bool apply) {
+    if ((bits != PID_MAN) && (bits != PID_AUTO)) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    if (!apply) {
+        return MODBUS_EX_NONE;
+    }
+
+    setMode((uint8_t)bits);
+    displayDirty_set(DISPLAY_MODE);
+
+    return MODBUS_EX_NONE;
+}
+
+static uint8_t modbusSlave_setActive (uint32_t bits, bool apply) {
+    if ((bits != PID_ON) && (bits != PID_OFF)) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    if (!apply) {
+        return MODBUS_EX_NONE;
+    }
+
+    setActive((uint8_t)bits);
+    displayDirty_set(DISPLAY_MODE);
+
+    return MODBUS_EX_NONE;
+}
+
+static uint32_t modbusSlave_getB1 (void) {
+    return modbusSlave_getCoefficient(0);
+}
+
+static uint32_t modbusSlave_getB2 (void) {
+    return modbusSlave_getCoefficient(1);
+}
+
+static uint32_t modbusSlave_getB3 (void) {
+    return modbusSlave_getCoefficient(2);
+}
+
+static uint8_t modbusSlave_setB1 (uint32_t bits, bool apply) {
+    return modbusSlave_setCoefficient(0, bits, apply);
+}
+
+static uint8_t modbusSlave_setB2 (uint32_t bits, bool apply) {
+    return modbusSlave_setCoefficient(1, bits, apply);
+}
+
+static uint8_t modbusSlave_setB3 (uint32_t bits, bool apply) {
+    return modbusSlave_setCoefficient(2, bits, apply);
+}
+
+static uint32_t modbusSlave_getSpValue (void) {
+    return (uint32_t)toValue(SIGNAL_SP, pid.sp);
+}
+
+static uint32_t modbusSlave_getPvValue (void) {
+    return (uint32_t)toValue(SIGNAL_PV, pid.pv);
+}
+
+static uint32_t modbusSlave_getOpValue (void) {
+    return (uint32_t)toValue(SIGNAL_OP, pid.op);
+}
+
+static uint32_t modbusSlave_getCpuUsage (void) {
+#if (STATS_ENABLED)
+    return stats_get()->cpuUsage;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t modbusSlave_getSwitches (void) {
+#if (STATS_ENABLED)
+    return stats_get()->switches;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t modbusSlave_getWakeups (void) {
+#if (STATS_ENABLED)
+    return stats_get()->wakeups;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t modbusSlave_getIntDisMax (void) {
+#if (STATS_ENABLED)
+    return stats_get()->intDisMaxUs;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t modbusSlave_getMisses (void) {
+    return (deadlineMonitor != (const DeadlineMonitor*)0) ?
+           deadlineMonitor->misses : 0u;
+}
+
+static uint8_t modbusSlave_setCoefficient (uint8_t index, uint32_t bits,
+                                           bool apply) {
+    float value;
+
+    (void)memcpy(&value, &bits, sizeof(value));
+
+    if (!checkCoefficient_PID(value)) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    if (!apply) {
+        return MODBUS_EX_NONE;
+    }
+
+    if (!coefficientsPending) {
+        getCoefficients_PID(&pendingCoefficients);
+        coefficientsPending = true;
+    }
+
+    if (index == 0u) {
+        pendingCoefficients.b1 = value;
+    } else if (index == 1u) {
+        pendingCoefficients.b2 = value;
+    } else {
+        pendingCoefficients.b3 = value;
+    }
+
+    return MODBUS_EX_NONE;
+}
+
+static uint8_t modbusSlave_exception (uint8_t result) {
+    if (result == PID_SETTING_REFUSED) {
+        return MODBUS_EX_DEVICE_FAILURE;
+    }
+
+    if (result == PID_SETTING_BAD_VALUE) {
+        return MODBUS_EX_ILLEGAL_VALUE;
+    }
+
+    return MODBUS_EX_NONE;
+}
+
+static uint32_t modbusSlave_getCoefficient (uint8_t index) {
+    PIDCoefficients coefficients;
+    uint32_t bits;
+
+    getCoefficients_PID(&coefficients);
+
+    if (index == 0u) {
+        (void)memcpy(&bits, &coefficients.b1, sizeof(bits));
+    } else if (index == 1u) {
+        (void)memcpy(&bits, &coefficients.b2, sizeof(bits));
+    } else {
+        (void)memcpy(&bits, &coefficients.b3, sizeof(bits));
+    }
+
+    return bits;
+}
+
+static void modbusSlave_receive (void) {
+    CPU_SR_ALLOC();
+
+    CPU_CRITICAL_ENTER();
+    rxLength = 0;
+    rxOverflow = false;
+    state = MODBUS_SLAVE_RECEIVING;
+    CPU_CRITICAL_EXIT();
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#if (MODBUS_SLAVE_ENABLED)
+#pragma interrupt (modbusSlave_rxIsr (vect=VECT(SCI6,RXI6)))
+void modbusSlave_rxIsr (void) {
+    uint8_t data = SCI6.RDR;
+
+    /* A reply is pending or going out: not a request for this slave. */
+    if (state != MODBUS_SLAVE_RECEIVING) {
+        return;
+    }
+
+    if (rxLength < MODBUS_FRAME_MAX) {
+        rxBuffer[rxLength] = data;
+        rxLength = rxLength + 1u;
+    } else {
+        rxOverflow = true;
+    }
+
+    /* The frame ends after 3.5 characters of silence. */
+    CMT3.CMCNT = 0;
+    CMT.CMSTR1.BIT.STR3 = 1;
+}
+
+#pragma interrupt (modbusSlave_txIsr (vect=VECT(SCI6,TXI6)))
+void modbusSlave_txIsr (void) {
+    SCI6.TDR = txBuffer[txIndex];
+    txIndex = txIndex + 1u;
+
+    /* Last byte loaded: wait for it to leave the shift register. */
+    if (txIndex >= txLength) {
+        SCI6.SCR.BYTE = (uint8_t)((SCI6.SCR.BYTE & ~0x80u) |
+                                  MODBUS_SLAVE_SCR_TEIE);
+    }
+}
+
+#pragma interrupt (modbusSlave_txEndIsr (vect=VECT(SCI6,TEI6)))
+void modbusSlave_txEndIsr (void) {
+    /* Transmitter off; bytes echoed by a half-duplex line are dropped. */
+    SCI6.SCR.BYTE = MODBUS_SLAVE_SCR_RECEIVE;
+    rxLength = 0;
+    rxOverflow = false;
+    state = MODBUS_SLAVE_RECEIVING;
+}
+
+#pragma interrupt (modbusSlave_frameIsr (vect=VECT(CMT3,CMI3)))
+void modbusSlave_frameIsr (void) {
+    OS_ERR err;
+
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_MODBUS);
+
+    CMT.CMSTR1.BIT.STR3 = 0;
+
+    if (rxOverflow) {
+        /* Too long for any request; start over. */
+        rxLength = 0;
+        rxOverflow = false;
+    } else if ((state == MODBUS_SLAVE_RECEIVING) && (rxLength > 0u)) {
+        state = MODBUS_SLAVE_READY;
+
+        if (notify != (OS_TCB*)0) {
+            OSTaskSemPost(notify, OS_OPT_POST_NONE, &err);
+        }
+    }
+
+    TRACE_ISR_EXIT(TRACE_ISR_MODBUS);
+    OSIntExit();
+}
+#endif
@@ -0,0 +1,149 @@
+/**
+    \file modbusSlave.h
+    \brief Header file for the Modbus RTU slave library.
+    \details Modbus RTU slave on SCI6 (TXD6 on P00, RXD6 on P01), for an
+             RS-485 transceiver with automatic direction control or a
+             point-to-point RS-232 link; 8 data bits, even parity, one stop
+             bit, as the Modbus default.
+             \par
+             The receive interrupt stores each byte in the frame buffer and
+             restarts CMT3, which expires after 3.5 character times of
+             silence: the frame end. Its interrupt posts the UI task, where
+             modbusSlave_serve() checks and applies the request through
+             modbus.c and starts the reply, sent by the transmit interrupt.
+             Requests are so applied from the UI task, the single writer of
+             the settings, as the menu applies its edits.
+             \par
+             Register map (addresses from zero; I32 and F32 take two
+             registers, high word first):
+             \code
+             holding  0  I32  setpoint, in engineering units (automatic
+                              mode only)
+                      2  I32  controller output, in engineering units
+                              (manual mode only)
+                      4  U8   mode: 0 manual, 1 automatic
+                      5  U8   power: 0 on, 1 off
+                      6  F32  PID coefficient b1
+                      8  F32  PID coefficient b2
+                     10  F32  PID coefficient b3
+             input    0  I16  setpoint, raw
+                      1  I16  process variable, raw
+                      2  I16  controller output, raw
+                      3  I16  error, raw
+                      4  I32  setpoint, in engineering units
+                      6  I32  process variable, in engineering units
+                      8  I32  controller output, in engineering units
+                     10  U16  CPU usage, in hundredths of a percent
+                     11  U16  context switches in the last period
+                     12  U16  idle wake-ups per second
+                     13  U16  longest interrupt disable time, in us
+                     14  U32  control cycles past their deadline
+             \endcode
+             The raw values and the mode and power registers point straight
+             at the controller state; the engineering unit values of the
+             settings and live signals, the coefficients and the statistics
+             are read through their accessors, from the values in use. A
+             setpoint or output written in the wrong mode is refused with
+             the device failure exception, as the menu would not offer it.
+             All the values of a request are checked before any is
+             applied, and the coefficients written in one request are
+             applied together.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef MODBUS_SLAVE_H
+#define MODBUS_SLAVE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+#include "deadline.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Modbus RTU slave enable flag (compile time). */
+#define MODBUS_SLAVE_ENABLED (1)
+
+/** Slave address, 1 to 247. */
+#define MODBUS_SLAVE_ADDRESS (1u)
+
+#if (MODBUS_SLAVE_ADDRESS < 1u) || (MODBUS_SLAVE_ADDRESS > 247u)
+#error "MODBUS_SLAVE_ADDRESS must be from 1 to 247."
+#endif
+
+/** SCI6 bit rate, in bits per second. */
+#define MODBUS_SLAVE_BAUD (19200ul)
+
+/** Peripheral clock feeding SCI6 and CMT3, in Hz. */
+#define MODBUS_SLAVE_PCLK_HZ (48000000ul)
+
+/** SCI6 bit rate register value for the PCLK/1 count source, rounded. */
+#define MODBUS_SLAVE_BRR                                                    \
+    (((MODBUS_SLAVE_PCLK_HZ + (16u * MODBUS_SLAVE_BAUD)) /                  \
+      (32u * MODBUS_SLAVE_BAUD)) - 1u)
+
+#if (MODBUS_SLAVE_BRR > 255u)
+#error "MODBUS_SLAVE_BAUD too low for the PCLK/1 count source."
+#endif
+
+/** Frame end silence, in microseconds: 3.5 characters of 11 bits, and a
+    fixed 1750 us above 19200 bit/s, as the Modbus serial line spec says. */
+#define MODBUS_SLAVE_T35_US                                                 \
+    ((MODBUS_SLAVE_BAUD > 19200u) ? 1750ul :                                \
+     ((38500000ul + MODBUS_SLAVE_BAUD - 1u) / MODBUS_SLAVE_BAUD))
+
+/** Frame end silence, in CMT3 counts of PCLK/32. */
+#define MODBUS_SLAVE_T35_COUNTS                                             \
+    (((MODBUS_SLAVE_PCLK_HZ / 32000u) * MODBUS_SLAVE_T35_US) / 1000u)
+
+#if (MODBUS_SLAVE_T35_COUNTS > 65535u)
+#error "MODBUS_SLAVE_BAUD too low for the CMT3 frame timer."
+#endif
+
+/** Line error check period while no frame comes, in milliseconds. */
+#define MODBUS_SLAVE_POLL_MS (100u)
+
+/** Interrupt priority of SCI6 and the frame timer; kernel-aware. */
+#define MODBUS_SLAVE_IPL (3u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Set up SCI6, its pins and the CMT3 frame timer, and start
+           receiving.
+    \param notifyTCB Task posted at each frame end; it must call
+           modbusSlave_serve().
+    \param deadline Control cycle deadline monitor, for its register; null
+           if the deadlines are not monitored.
+    \return None
+ */
+void modbusSlave_init (OS_TCB* notifyTCB, const DeadlineMonitor* deadline);
+
+/**
+    \brief Check for a received frame.
+    \return True if a frame waits for modbusSlave_serve().
+ */
+bool modbusSlave_ready (void);
+
+/**
+    \brief Apply the received frame and start the reply, if any; clear the
+           line errors. Call from the task given to modbusSlave_init(),
+           when a frame is ready and every MODBUS_SLAVE_POLL_MS.
+    \return None
+ */
+void modbusSlave_serve (void);
+
+#endif /* MODBUS_SLAVE_H */
@@ -0,0 +1,443 @@
+/**
+    \file netProto.c
+    \brief Implementation file for the UDP monitoring protocol library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "netProto.h"
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (NET_PROTO_BATCH_MAX > 255u)
+#error "NET_PROTO_BATCH_MAX must fit the batch sample counter."
+#endif
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Offset of the first sample in a sample datagram. */
+#define NET_PROTO_SAMPLES_OFFSET (NET_PROTO_HEADER_SIZE + 4u)
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Write a datagram header.
+    \param out Datagram.
+    \param type Datagram type.
+    \param sequence Sequence number.
+    \param length Payload length, in bytes.
+    \return Datagram length, in bytes.
+ */
+static uint16_t netProto_header (uint8_t* out, uint8_t type,
+                                 uint16_t sequence, uint16_t length);
+
+/**
+    \brief Store a 16-bit value, little-endian.
+    \param out Buffer position.
+    \param value Value to store.
+    \return Buffer position after the value.
+ */
+static uint8_t* netProto_put16 (uint8_t* out, uint16_t value);
+
+/**
+    \brief Store a 32-bit value, little-endian.
+    \param out Buffer position.
+    \param value Value to store.
+    \return Buffer position after the value.
+ */
+static uint8_t* netProto_put32 (uint8_t* out, uint32_t value);
+
+/**
+    \brief Store a float, little-endian.
+    \param out Buffer position.
+    \param value Value to store.
+    \return Buffer position after the value.
+ */
+static uint8_t* netProto_putFloat (uint8_t* out, float value);
+
+/**
+    \brief Load a 16-bit value, little-endian.
+    \param in Buffer position.
+    \return Value.
+ */
+static uint16_t netProto_get16 (const uint8_t* in);
+
+/**
+    \brief Load a 32-bit value, little-endian.
+    \param in Buffer position.
+    \return Value.
+ */
+static uint32_t netProto_get32 (const uint8_t* in);
+
+/**
+    \brief Load a float, little-endian.
+    \param in Buffer position.
+    \return Value.
+ */
+static float netProto_getFloat (const uint8_t* in);
+
+/**
+    \brief Decode the header of a datagram of an expected type.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param type Expected type.
+    \param size Expected payload length, in bytes.
+    \return NetProtoResult.
+ */
+static uint8_t netProto_expect (const uint8_t* in, uint16_t length,
+                                uint8_t type, uint16_t size);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void netProto_batchBegin (NetBatch* batch, uint16_t sequence, uint32_t first) {
+    (void)netProto_header(batch->data, NET_PROTO_SAMPLES, sequence, 0);
+    (void)netProto_put32(&batch->data[NET_PROTO_HEADER_SIZE], first);
+    batch->count = 0;
+}
+
+bool netProto_batchAdd (NetBatch* batch, const NetSample* sample) {
+    uint8_t* position;
+
+    if (batch->count >= NET_PROTO_BATCH_MAX) {
+        return false;
+    }
+
+    position = &batch->data[NET_PROTO_SAMPLES_OFFSET +
+                            ((uint16_t)batch->count * NET_PROTO_SAMPLE_SIZE)];
+    position = netProto_put16(position, (uint16_t)sample->sp);
+    position = netProto_put16(position, (uint16_t)sample->pv);
+    position = netProto_put16(position, (uint16_t)sample->op);
+    (void)netProto_put16(position, (uint16_t)sample->er);
+    batch->count++;
+
+    return true;
+}
+
+uint16_t netProto_batchEnd (NetBatch* batch) {
+    uint16_t length = 4u + ((uint16_t)batch->count * NET_PROTO_SAMPLE_SIZE);
+
+    /* Only the payload length was left open. */
+    (void)netProto_put16(&batch->data[6], length);
+
+    return NET_PROTO_HEADER_SIZE + length;
+}
+
+uint16_t netProto_encodeStatus (uint8_t* out, uint16_t sequence,
+                                const NetStatus* status) {
+    uint8_t* position = out + NET_PROTO_HEADER_SIZE;
+    uint8_t i;
+
+    position = netProto_put16(position, status->alarms);
+    *position++ = status->active;
+    *position++ = status->mode;
+    position = netProto_put32(position, (uint32_t)status->spValue);
+    position = netProto_put32(position, (uint32_t)status->pvValue);
+    position = netProto_put32(position, (uint32_t)status->opValue);
+    position = netProto_put16(position, status->cpuUsage);
+    position = netProto_put32(position, status->deadlineMisses);
+    position = netProto_put32(position, status->samplesLost);
+
+    for (i = 0; i < 3u; i++) {
+        position = netProto_putFloat(position, status->coefficients[i]);
+    }
+
+    return netProto_header(out, NET_PROTO_STATUS, sequence,
+                           NET_PROTO_STATUS_SIZE);
+}
+
+uint16_t netProto_encodeAck (uint8_t* out, uint16_t sequence, uint8_t type,
+                             uint8_t result) {
+    out[NET_PROTO_HEADER_SIZE] = type;
+    out[NET_PROTO_HEADER_SIZE + 1u] = result;
+
+    return netProto_header(out, NET_PROTO_ACK, sequence, 2u);
+}
+
+uint16_t netProto_encodeCommand (uint8_t* out, const NetCommand* command) {
+    uint8_t* position = out + NET_PROTO_HEADER_SIZE;
+    uint8_t i;
+
+    switch (command->type) {
+        case NET_PROTO_SUBSCRIBE:
+        break;
+        case NET_PROTO_SET_SP:
+            position = netProto_put32(position, (uint32_t)command->setpoint);
+        break;
+        case NET_PROTO_SET_MODE:
+            *position++ = command->mode;
+        break;
+        case NET_PROTO_SET_COEF:
+            for (i = 0; i < 3u; i++) {
+                position = netProto_putFloat(position,
+                                             command->coefficients[i]);
+            }
+        break;
+        default:
+            return 0;
+    }
+
+    return netProto_header(out, command->type, command->sequence,
+                           (uint16_t)(position - out) -
+                           NET_PROTO_HEADER_SIZE);
+}
+
+uint8_t netProto_decodeHeader (const uint8_t* in, uint16_t length,
+                               NetProtoHeader* header) {
+    if ((length < NET_PROTO_HEADER_SIZE) ||
+        (netProto_get16(in) != NET_PROTO_MAGIC) ||
+        (in[2] != NET_PROTO_VERSION)) {
+        return NET_PROTO_BAD_HEADER;
+    }
+
+    header->type = in[3];
+    header->sequence = netProto_get16(in + 4);
+    header->length = netProto_get16(in + 6);
+
+    if (header->length != (length - NET_PROTO_HEADER_SIZE)) {
+        return NET_PROTO_BAD_LENGTH;
+    }
+
+    return NET_PROTO_OK;
+}
+
+uint8_t netProto_decodeCommand (const uint8_t* in, uint16_t length,
+                                NetCommand* command) {
+    NetProtoHeader header;
+    const uint8_t* payload = in + NET_PROTO_HEADER_SIZE;
+    uint16_t size;
+    uint8_t result;
+    uint8_t i;
+
+    result = netProto_decodeHeader(in, length, &header);
+
+    if (result == NET_PROTO_BAD_HEADER) {
+        return result;
+    }
+
+    command->type = header.type;
+    command->sequence = header.sequence;
+
+    if (result != NET_PROTO_OK) {
+        return result;
+    }
+
+    switch (header.type) {
+        case NET_PROTO_SUBSCRIBE:
+            size = 0;
+        break;
+        case NET_PROTO_SET_SP:
+            size = 4u;
+        break;
+        case NET_PROTO_SET_MODE:
+            size = 1u;
+        break;
+        case NET_PROTO_SET_COEF:
+            size = 12u;
+        break;
+        default:
+            return NET_PROTO_BAD_TYPE;
+    }
+
+    if (header.length != size) {
+        return NET_PROTO_BAD_LENGTH;
+    }
+
+    switch (header.type) {
+        case NET_PROTO_SET_SP:
+            command->setpoint = (int32_t)netProto_get32(payload);
+        break;
+        case NET_PROTO_SET_MODE:
+            command->mode = payload[0];
+        break;
+        case NET_PROTO_SET_COEF:
+            for (i = 0; i < 3u; i++) {
+                command->coefficients[i] =
+                    netProto_getFloat(payload + (4u * i));
+            }
+        break;
+        default:
+        break;
+    }
+
+    return NET_PROTO_OK;
+}
+
+uint8_t netProto_decodeSamples (const uint8_t* in, uint16_t length,
+                                uint32_t* first, uint16_t* count) {
+    NetProtoHeader header;
+    uint8_t result;
+
+    result = netProto_decodeHeader(in, length, &header);
+
+    if (result != NET_PROTO_OK) {
+        return result;
+    }
+
+    if (header.type != NET_PROTO_SAMPLES) {
+        return NET_PROTO_BAD_TYPE;
+    }
+
+    if ((header.length < 4u) ||
+        (((header.length - 4u) % NET_PROTO_SAMPLE_SIZE) != 0u)) {
+        return NET_PROTO_BAD_LENGTH;
+    }
+
+    *first = netProto_get32(in + NET_PROTO_HEADER_SIZE);
+    *count = (header.length - 4u) / NET_PROTO_SAMPLE_SIZE;
+
+    return NET_PROTO_OK;
+}
+
+void netProto_getSample (const uint8_t* in, uint16_t index,
+                         NetSample* sample) {
+    const uint8_t* position = in + NET_PROTO_SAMPLES_OFFSET +
+                              ((uint32_t)index * NET_PROTO_SAMPLE_SIZE);
+
+    sample->sp = (int16_t)netProto_get16(position);
+    sample->pv = (int16_t)netProto_get16(position + 2);
+    sample->op = (int16_t)netProto_get16(position + 4);
+    sample->er = (int16_t)netProto_get16(position + 6);
+}
+
+uint8_t netProto_decodeStatus (const uint8_t* in, uint16_t length,
+                               NetStatus* status) {
+    const uint8_t* position = in + NET_PROTO_HEADER_SIZE;
+    uint8_t result;
+    uint8_t i;
+
+    result = netProto_expect(in, length, NET_PROTO_STATUS,
+                             NET_PROTO_STATUS_SIZE);
+
+    if (result != NET_PROTO_OK) {
+        return result;
+    }
+
+    status->alarms = netProto_get16(position);
+    status->active = position[2];
+    status->mode = position[3];
+    status->spValue = (int32_t)netProto_get32(position + 4);
+    status->pvValue = (int32_t)netProto_get32(position + 8);
+    status->opValue = (int32_t)netProto_get32(position + 12);
+    status->cpuUsage = netProto_get16(position + 16);
+    status->deadlineMisses = netProto_get32(position + 18);
+    status->samplesLost = netProto_get32(position + 22);
+
+    for (i = 0; i < 3u; i++) {
+        status->coefficients[i] = netProto_getFloat(position + 26 + (4u * i));
+    }
+
+    return NET_PROTO_OK;
+}
+
+uint8_t netProto_decodeAck (const uint8_t* in, uint16_t length,
+                            uint8_t* type, uint8_t* result) {
+    uint8_t check;
+
+    check = netProto_expect(in, length, NET_PROTO_ACK, 2u);
+
+    if (check != NET_PROTO_OK) {
+        return check;
+    }
+
+    *type = in[NET_PROTO_HEADER_SIZE];
+    *result = in[NET_PROTO_HEADER_SIZE + 1u];
+
+    return NET_PROTO_OK;
+}
+
+static uint16_t netProto_header (uint8_t* out, uint8_t type,
+                                 uint16_t sequence, uint16_t length) {
+    uint8_t* position;
+
+    position = netProto_put16(out, NET_PROTO_MAGIC);
+    *position++ = NET_PROTO_VERSION;
+    *position++ = type;
+    position = netProto_put16(position, sequence);
+    (void)netProto_put16(position, length);
+
+    return NET_PROTO_HEADER_SIZE + length;
+}
+
+static uint8_t* netProto_put16 (uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+
+    return out + 2;
+}
+
+static uint8_t* netProto_put32 (uint8_t* out, uint32_t value) {
+    out = netProto_put16(out, (uint16_t)value);
+
+    return netProto_put16(out, (uint16_t)(value >> 16));
+}
+
+static uint8_t* netProto_putFloat (uint8_t* out, float value) {
+    uint32_t bits;
+
+    /* Bit pattern; both ends use IEEE 754 single precision. */
+    memcpy(&bits, &value, sizeof(bits));
+
+    return netProto_put32(out, bits);
+}
+
+static uint16_t netProto_get16 (const uint8_t* in) {
+    return (uint16_t)(in[0] | ((uint16_t)in[1] << 8));
+}
+
+static uint32_t netProto_get32 (const uint8_t* in) {
+    return netProto_get16(in) | ((uint32_t)netProto_get16(in + 2) << 16);
+}
+
+static float netProto_getFloat (const uint8_t* in) {
+    uint32_t bits = netProto_get32(in);
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static uint8_t netProto_expect (const uint8_t* in, uint16_t length,
+                                uint8_t type, uint16_t size) {
+    NetProtoHeader header;
+    uint8_t result;
+
+    result = netProto_decodeHeader(in, length, &header);
+
+    if (result != NET_PROTO_OK) {
+        return result;
+    }
+
+    if (header.type != type) {
+        return NET_PROTO_BAD_TYPE;
+    }
+
+    if (header.length != size) {
+        return NET_PROTO_BAD_LENGTH;
+    }
+
+    return NET_PROTO_OK;
+}
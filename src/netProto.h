@@ -0,0 +1,292 @@
+/**
+    \file netProto.h
+    \brief Header file for the UDP monitoring protocol library.
+    \details Encoding and decoding of the datagrams between the board and a
+             monitoring client, in portable C with no kernel, network stack
+             or board dependency, so that the same code runs on the host
+             (see tools/netClient.c). Every field is little-endian and
+             floats are IEEE 754 single precision. A datagram starts with a
+             header:
+             \code
+             offset  0  uint16  NET_PROTO_MAGIC
+                     2  uint8   NET_PROTO_VERSION
+                     3  uint8   type (NetProtoType)
+                     4  uint16  sequence number of the sender
+                     6  uint16  payload length, in bytes
+             \endcode
+             followed by the payload of its type:
+             - NET_PROTO_SAMPLES, board to client: uint32 index of the first
+               sample since start, then up to NET_PROTO_BATCH_MAX samples
+               of int16 sp, pv, op and er, raw; a jump in the index is a
+               loss;
+             - NET_PROTO_STATUS, board to client: the NetStatus fields, in
+               order;
+             - NET_PROTO_ACK, board to client: uint8 type and uint8 result
+               (NetProtoResult) of the command of the same sequence number;
+             - NET_PROTO_SUBSCRIBE, client to board: no payload; samples and
+               status go to the last client that subscribed;
+             - NET_PROTO_SET_SP: int32 setpoint, in engineering units;
+             - NET_PROTO_SET_MODE: uint8 mode, PID_MAN or PID_AUTO;
+             - NET_PROTO_SET_COEF: float b1, b2 and b3.
+             \par
+             Many samples share one datagram, and so one trip through the
+             network stack: NetBatch builds the datagram in place as the
+             samples are added.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef NET_PROTO_H
+#define NET_PROTO_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Header magic: "PN" when read as bytes. */
+#define NET_PROTO_MAGIC (0x4E50u)
+
+/** Protocol version. */
+#define NET_PROTO_VERSION (1u)
+
+/** UDP port of the board. */
+#define NET_PROTO_PORT (5020u)
+
+/** Header size, in bytes. */
+#define NET_PROTO_HEADER_SIZE (8u)
+
+/** Encoded sample size, in bytes. */
+#define NET_PROTO_SAMPLE_SIZE (8u)
+
+/** Samples per datagram; the datagram fits a 1500-byte Ethernet frame
+    with its IP and UDP headers. */
+#define NET_PROTO_BATCH_MAX (180u)
+
+/** Largest datagram, in bytes. */
+#define NET_PROTO_DATAGRAM_MAX                                              \
+    (NET_PROTO_HEADER_SIZE + 4u +                                           \
+     (NET_PROTO_BATCH_MAX * NET_PROTO_SAMPLE_SIZE))
+
+/** Status payload size, in bytes. */
+#define NET_PROTO_STATUS_SIZE (38u)
+
+/** Status alarm: the control cycle deadline alarm is latched. */
+#define NET_ALARM_DEADLINE (0x0001u)
+
+/** Status alarm: samples were lost on the board since the last status. */
+#define NET_ALARM_SAMPLES_LOST (0x0002u)
+
+/** Status alarm: the controller is off. */
+#define NET_ALARM_CONTROLLER_OFF (0x0004u)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Datagram types. */
+enum NetProtoType {
+    NET_PROTO_SAMPLES = 0x01,   /**< Sample batch. */
+    NET_PROTO_STATUS = 0x02,    /**< Alarm and KPI state. */
+    NET_PROTO_ACK = 0x03,       /**< Command result. */
+    NET_PROTO_SUBSCRIBE = 0x10, /**< Send samples and status here. */
+    NET_PROTO_SET_SP = 0x11,    /**< Set the setpoint. */
+    NET_PROTO_SET_MODE = 0x12,  /**< Set the controller mode. */
+    NET_PROTO_SET_COEF = 0x13   /**< Set the PID coefficients. */
+};
+
+/** Decoding and command results. */
+enum NetProtoResult {
+    NET_PROTO_OK,               /**< Accepted. */
+    NET_PROTO_BAD_HEADER,       /**< Not this protocol or version. */
+    NET_PROTO_BAD_LENGTH,       /**< Wrong length for the type. */
+    NET_PROTO_BAD_TYPE,         /**< Unexpected type. */
+    NET_PROTO_BAD_VALUE,        /**< Value out of range; nothing changed. */
+    NET_PROTO_REFUSED           /**< Not in the current mode; nothing
+                                     changed. */
+};
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Datagram header. */
+typedef struct NetProtoHeader_struct {
+    uint8_t type;           /**< Datagram type. */
+    uint16_t sequence;      /**< Sequence number of the sender. */
+    uint16_t length;        /**< Payload length, in bytes. */
+} NetProtoHeader;
+
+/** Control sample, raw values. */
+typedef struct NetSample_struct {
+    int16_t sp;             /**< Setpoint. */
+    int16_t pv;             /**< Process variable. */
+    int16_t op;             /**< Controller output. */
+    int16_t er;             /**< Error. */
+} NetSample;
+
+/** Alarm and KPI state. */
+typedef struct NetStatus_struct {
+    uint16_t alarms;        /**< NET_ALARM_* flags. */
+    uint8_t active;         /**< Controller power mode. */
+    uint8_t mode;           /**< Controller mode. */
+    int32_t spValue;        /**< Setpoint, in engineering units. */
+    int32_t pvValue;        /**< Process variable, in engineering units. */
+    int32_t opValue;        /**< Controller output, in engineering units. */
+    uint16_t cpuUsage;      /**< CPU usage, in hundredths of a percent. */
+    uint32_t deadlineMisses;    /**< Control cycles past their deadline. */
+    uint32_t samplesLost;   /**< Samples lost on the board since start. */
+    float coefficients[3];  /**< PID coefficients b1, b2 and b3. */
+} NetStatus;
+
+/** Decoded command. */
+typedef struct NetCommand_struct {
+    uint8_t type;           /**< Command type. */
+    uint16_t sequence;      /**< Sequence number, echoed by the ACK. */
+    int32_t setpoint;       /**< NET_PROTO_SET_SP value. */
+    uint8_t mode;           /**< NET_PROTO_SET_MODE value. */
+    float coefficients[3];  /**< NET_PROTO_SET_COEF values. */
+} NetCommand;
+
+/** Sample datagram under construction. */
+typedef struct NetBatch_struct {
+    uint8_t data[NET_PROTO_DATAGRAM_MAX];   /**< Datagram. */
+    uint8_t count;          /**< Samples added. */
+} NetBatch;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Start a sample datagram.
+    \param batch Batch to start.
+    \param sequence Sequence number of the datagram.
+    \param first Index of the first sample since start.
+    \return None
+ */
+void netProto_batchBegin (NetBatch* batch, uint16_t sequence, uint32_t first);
+
+/**
+    \brief Add a sample to a datagram.
+    \param batch Batch.
+    \param sample Sample to add.
+    \return False, and nothing added, if the batch is full.
+ */
+bool netProto_batchAdd (NetBatch* batch, const NetSample* sample);
+
+/**
+    \brief Complete a sample datagram.
+    \param batch Batch.
+    \return Datagram length, in bytes; batch->data holds the datagram.
+ */
+uint16_t netProto_batchEnd (NetBatch* batch);
+
+/**
+    \brief Encode a status datagram.
+    \param out Buffer, NET_PROTO_HEADER_SIZE + NET_PROTO_STATUS_SIZE bytes.
+    \param sequence Sequence number.
+    \param status State to encode.
+    \return Datagram length, in bytes.
+ */
+uint16_t netProto_encodeStatus (uint8_t* out, uint16_t sequence,
+                                const NetStatus* status);
+
+/**
+    \brief Encode a command result datagram.
+    \param out Buffer, NET_PROTO_HEADER_SIZE + 2 bytes.
+    \param sequence Sequence number of the command.
+    \param type Command type.
+    \param result Command result.
+    \return Datagram length, in bytes.
+ */
+uint16_t netProto_encodeAck (uint8_t* out, uint16_t sequence, uint8_t type,
+                             uint8_t result);
+
+/**
+    \brief Encode a command datagram.
+    \param out Buffer, NET_PROTO_HEADER_SIZE + 12 bytes.
+    \param command Command to encode.
+    \return Datagram length, in bytes; zero if the type is not a command.
+ */
+uint16_t netProto_encodeCommand (uint8_t* out, const NetCommand* command);
+
+/**
+    \brief Decode and check a datagram header.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param header Decoded header.
+    \return NET_PROTO_OK, NET_PROTO_BAD_HEADER or NET_PROTO_BAD_LENGTH.
+ */
+uint8_t netProto_decodeHeader (const uint8_t* in, uint16_t length,
+                               NetProtoHeader* header);
+
+/**
+    \brief Decode a command datagram.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param command Decoded command; the type and sequence number are set
+           whenever the header is valid, for the ACK.
+    \return NetProtoResult; the values are checked where they are
+            applied.
+ */
+uint8_t netProto_decodeCommand (const uint8_t* in, uint16_t length,
+                                NetCommand* command);
+
+/**
+    \brief Decode a sample datagram.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param first Index of the first sample.
+    \param count Number of samples.
+    \return NetProtoResult.
+ */
+uint8_t netProto_decodeSamples (const uint8_t* in, uint16_t length,
+                                uint32_t* first, uint16_t* count);
+
+/**
+    \brief Get a sample of a checked sample datagram.
+    \param in Datagram.
+    \param index Sample index in the datagram.
+    \param sample Decoded sample.
+    \return None
+ */
+void netProto_getSample (const uint8_t* in, uint16_t index,
+                         NetSample* sample);
+
+/**
+    \brief Decode a status datagram.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param status Decoded state.
+    \return NetProtoResult.
+ */
+uint8_t netProto_decodeStatus (const uint8_t* in, uint16_t length,
+                               NetStatus* status);
+
+/**
+    \brief Decode a command result datagram.
+    \param in Datagram.
+    \param length Datagram length, in bytes.
+    \param type Command type.
+    \param result Command result.
+    \return NetProtoResult.
+ */
+uint8_t netProto_decodeAck (const uint8_t* in, uint16_t length,
+                            uint8_t* type, uint8_t* result);
+
+#endif /* NET_PROTO_H */
@@ -0,0 +1,459 @@
+/**
+    \file netService.c
+    \brief Implementation file for the UDP monitoring service library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+#include "memBarrier.h"
+#include "controller.h"
+#include "controllerSysControl.h"
+#include "pidSnapshot.h"
+#include "displayDirty.h"
+#include "stats.h"
+#include "netProto.h"
+#include "netService.h"
+
+#if (NET_SERVICE_ENABLED)
+#include <net.h>
+#endif
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (NET_SERVICE_ENABLED) && (NET_BSD_CFG_API_EN != DEF_ENABLED)
+#error "The network service needs the uC/TCP-IP BSD API (NET_BSD_CFG_API_EN)."
+#endif
+
+#if (NET_SERVICE_BATCH == 0u) || (NET_SERVICE_BATCH > NET_PROTO_BATCH_MAX)
+#error "NET_SERVICE_BATCH must be from 1 to NET_PROTO_BATCH_MAX."
+#endif
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Mask for wrapping free-running indices into the ring. */
+#define NET_SERVICE_MASK (NET_SERVICE_RING - 1u)
+
+/** Longest wait of a sample for its datagram, in kernel ticks. */
+#define NET_SERVICE_FLUSH_TICKS \
+    (((NET_SERVICE_FLUSH_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Status period, in kernel ticks. */
+#define NET_SERVICE_STATUS_TICKS \
+    (((NET_SERVICE_STATUS_MS * OS_CFG_TICK_RATE_HZ) + 999u) / 1000u)
+
+/** Largest command datagram received, in bytes. */
+#define NET_SERVICE_RX_SIZE (NET_PROTO_HEADER_SIZE + 16u)
+
+/** Largest reply datagram, in bytes. */
+#define NET_SERVICE_TX_SIZE (NET_PROTO_HEADER_SIZE + NET_PROTO_STATUS_SIZE)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Ring slot: a sample and its index since start. */
+typedef struct NetServiceSlot_struct {
+    uint32_t index;         /**< Sample index; dropped samples count too. */
+    NetSample sample;       /**< Sample. */
+} NetServiceSlot;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Sample ring. */
+static NetServiceSlot ring[NET_SERVICE_RING];
+
+/** Next slot to write (control task). */
+static volatile uint16_t ringHead = 0;
+
+/** Next slot to read (UI task). */
+static volatile uint16_t ringTail = 0;
+
+/** Index of the next sample; written by the control task only. */
+static uint32_t produced = 0;
+
+/** Samples dropped on a full ring. */
+static volatile uint32_t lost = 0;
+
+/** Dropped samples already flagged in a status. */
+static uint32_t lostReported = 0;
+
+/** Sample datagram being filled. */
+static NetBatch batch;
+
+/** A sample datagram is being filled. */
+static bool batchOpen = false;
+
+/** Index the next sample of the open datagram must have. */
+static uint32_t batchNext;
+
+/** Time the open datagram got its first sample, in kernel ticks. */
+static uint32_t batchStart;
+
+/** Sequence number of the next datagram sent. */
+static uint16_t txSequence = 0;
+
+/** Time of the last status, in kernel ticks. */
+static uint32_t lastStatus = 0;
+
+#if (NET_SERVICE_ENABLED)
+/** Service socket; negative until open. */
+static int sock = -1;
+
+/** Address of the subscribed client. */
+static struct sockaddr_in client;
+
+/** A client has subscribed. */
+static bool subscribed = false;
+
+/** Received command. */
+static uint8_t rxBuffer[NET_SERVICE_RX_SIZE];
+
+/** ACK or status being sent. */
+static uint8_t txBuffer[NET_SERVICE_TX_SIZE];
+#endif
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+#if (NET_SERVICE_ENABLED)
+/**
+    \brief Apply every received command and answer it.
+    \return None
+ */
+static void netService_receive (void);
+
+/**
+    \brief Apply a command.
+    \param command Decoded command.
+    \param from Address of the sender.
+    \return NetProtoResult for the ACK.
+ */
+static uint8_t netService_apply (const NetCommand* command,
+                                 const struct sockaddr_in* from);
+
+/**
+    \brief Send a datagram to the subscribed client.
+    \param data Datagram.
+    \param length Datagram length, in bytes.
+    \return None
+ */
+static void netService_send (const uint8_t* data, uint16_t length);
+#endif
+
+/**
+    \brief Move the queued samples into datagrams; send the full ones and
+           the one that waited too long.
+    \param now Current time, in kernel ticks.
+    \return None
+ */
+static void netService_drain (uint32_t now);
+
+/**
+    \brief Send the open sample datagram.
+    \return None
+ */
+static void netService_flush (void);
+
+/**
+    \brief Send the alarm and KPI state.
+    \param deadline Control cycle deadline monitor; may be null.
+    \return None
+ */
+static void netService_status (const DeadlineMonitor* deadline);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void netService_init (void) {
+#if (NET_SERVICE_ENABLED)
+    struct sockaddr_in local;
+    int i;
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (sock < 0) {
+        return;
+    }
+
+    for (i = 0; i < (int)sizeof(local); i++) {
+        ((uint8_t*)&local)[i] = 0;
+    }
+
+    local.sin_family = AF_INET;
+    local.sin_port = htons(NET_PROTO_PORT);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) != 0) {
+        close(sock);
+        sock = -1;
+    }
+#endif
+}
+
+void netService_put (int16_t sp, int16_t pv, int16_t op, int16_t er) {
+    uint16_t head = ringHead;
+    NetServiceSlot* slot;
+
+    /* Indices run freely; their difference is the fill level. */
+    if ((uint16_t)(head - ringTail) >= NET_SERVICE_RING) {
+        /* Indexed anyway: the client sees the gap. */
+        produced++;
+        lost++;
+
+        return;
+    }
+
+    slot = &ring[head & NET_SERVICE_MASK];
+    slot->index = produced++;
+    slot->sample.sp = sp;
+    slot->sample.pv = pv;
+    slot->sample.op = op;
+    slot->sample.er = er;
+
+    /* Sample must be stored before it is made visible. */
+    MEM_BARRIER_RELEASE();
+    ringHead = head + 1u;
+}
+
+void netService_poll (uint32_t now, const DeadlineMonitor* deadline) {
+#if (NET_SERVICE_ENABLED)
+    if (sock < 0) {
+        return;
+    }
+
+    netService_receive();
+#endif
+
+    netService_drain(now);
+
+    if ((uint32_t)(now - lastStatus) >= NET_SERVICE_STATUS_TICKS) {
+        lastStatus = now;
+        netService_status(deadline);
+    }
+}
+
+uint32_t netService_lost (void) {
+    return lost;
+}
+
+#if (NET_SERVICE_ENABLED)
+static void netService_receive (void) {
+    struct sockaddr_in from;
+    NetCommand command;
+    socklen_t fromLength;
+    int received;
+    uint16_t length;
+    uint8_t result;
+
+    while (DEF_ON) {
+        fromLength = sizeof(from);
+        received = recvfrom(sock, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT,
+                            (struct sockaddr*)&from, &fromLength);
+
+        if (received <= 0) {
+            /* Nothing more this poll. */
+            return;
+        }
+
+        result = netProto_decodeCommand(rxBuffer, (uint16_t)received,
+                                        &command);
+
+        if (result == NET_PROTO_BAD_HEADER) {
+            /* Not for this service; no answer. */
+            continue;
+        }
+
+        if (result == NET_PROTO_OK) {
+            result = netService_apply(&command, &from);
+        }
+
+        length = netProto_encodeAck(txBuffer, command.sequence, command.type,
+                                    result);
+        (void)sendto(sock, txBuffer, length, 0, (struct sockaddr*)&from,
+                     fromLength);
+    }
+}
+
+static uint8_t netService_apply (const NetCommand* command,
+                                 const struct sockaddr_in* from) {
+    PIDCoefficients coefficients;
+    uint8_t result;
+
+    switch (command->type) {
+        case NET_PROTO_SUBSCRIBE:
+            client = *from;
+            subscribed = true;
+        break;
+        case NET_PROTO_SET_SP:
+            result = setSetpoint(command->setpoint);
+
+            if (result == PID_SETTING_REFUSED) {
+                return NET_PROTO_REFUSED;
+            }
+
+            if (result == PID_SETTING_BAD_VALUE) {
+                return NET_PROTO_BAD_VALUE;
+            }
+
+            displayDirty_set(DISPLAY_SP);
+        break;
+        case NET_PROTO_SET_MODE:
+            if ((command->mode != PID_MAN) && (command->mode != PID_AUTO)) {
+                return NET_PROTO_BAD_VALUE;
+            }
+
+            setMode(command->mode);
+            displayDirty_set(DISPLAY_MODE);
+        break;
+        case NET_PROTO_SET_COEF:
+            coefficients.b1 = command->coefficients[0];
+            coefficients.b2 = command->coefficients[1];
+            coefficients.b3 = command->coefficients[2];
+
+            if (!setCoefficients_PID(&coefficients)) {
+                return NET_PROTO_BAD_VALUE;
+            }
+        break;
+        default:
+            return NET_PROTO_BAD_TYPE;
+    }
+
+    return NET_PROTO_OK;
+}
+
+static void netService_send (const uint8_t* data, uint16_t length) {
+    if (subscribed) {
+        (void)sendto(sock, (void*)data, length, 0,
+                     (struct sockaddr*)&client, sizeof(client));
+    }
+}
+#endif
+
+static void netService_drain (uint32_t now) {
+    uint16_t tail = ringTail;
+    const NetServiceSlot* slot;
+
+    while (tail != ringHead) {
+        /* Sample must be read after its slot was seen as filled. */
+        MEM_BARRIER_ACQUIRE();
+        slot = &ring[tail & NET_SERVICE_MASK];
+
+        /* A datagram holds consecutive samples only. */
+        if (batchOpen && ((slot->index != batchNext) ||
+                          (batch.count >= NET_SERVICE_BATCH))) {
+            netService_flush();
+        }
+
+        if (!batchOpen) {
+            netProto_batchBegin(&batch, txSequence, slot->index);
+            batchOpen = true;
+            batchStart = now;
+        }
+
+        (void)netProto_batchAdd(&batch, &slot->sample);
+        batchNext = slot->index + 1u;
+
+        /* Slot must be read before it is handed back to the producer. */
+        MEM_BARRIER_RELEASE();
+        tail++;
+        ringTail = tail;
+    }
+
+    if (batchOpen && ((batch.count >= NET_SERVICE_BATCH) ||
+                      ((uint32_t)(now - batchStart) >=
+                       NET_SERVICE_FLUSH_TICKS))) {
+        netService_flush();
+    }
+}
+
+static void netService_flush (void) {
+    uint16_t length = netProto_batchEnd(&batch);
+
+#if (NET_SERVICE_ENABLED)
+    netService_send(batch.data, length);
+#else
+    (void)length;
+#endif
+
+    txSequence++;
+    batchOpen = false;
+}
+
+static void netService_status (const DeadlineMonitor* deadline) {
+#if (NET_SERVICE_ENABLED)
+    PIDSnapshot state;
+    PIDCoefficients coefficients;
+    NetStatus status;
+    uint32_t lostNow = lost;
+    uint16_t length;
+
+    pidSnapshot_read(&state);
+    getCoefficients_PID(&coefficients);
+
+    status.alarms = 0;
+
+    if ((deadline != (DeadlineMonitor*)0) && deadline_alarm(deadline)) {
+        status.alarms |= NET_ALARM_DEADLINE;
+    }
+
+    if (lostNow != lostReported) {
+        status.alarms |= NET_ALARM_SAMPLES_LOST;
+        lostReported = lostNow;
+    }
+
+    if (state.active == PID_OFF) {
+        status.alarms |= NET_ALARM_CONTROLLER_OFF;
+    }
+
+    status.active = state.active;
+    status.mode = state.mode;
+    status.spValue = toValue(SIGNAL_SP, state.sp);
+    status.pvValue = toValue(SIGNAL_PV, state.pv);
+    status.opValue = toValue(SIGNAL_OP, state.op);
+#if (STATS_ENABLED)
+    status.cpuUsage = stats_get()->cpuUsage;
+#else
+    status.cpuUsage = 0;
+#endif
+    status.deadlineMisses = (deadline != (DeadlineMonitor*)0) ?
+                            deadline->misses : 0u;
+    status.samplesLost = lostNow;
+    status.coefficients[0] = coefficients.b1;
+    status.coefficients[1] = coefficients.b2;
+    status.coefficients[2] = coefficients.b3;
+
+    length = netProto_encodeStatus(txBuffer, txSequence, &status);
+    txSequence++;
+    netService_send(txBuffer, length);
+#else
+    (void)deadline;
+    (void)lostReported;
+#endif
+}
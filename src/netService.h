@@ -0,0 +1,112 @@
+/**
+    \file netService.h
+    \brief Header file for the UDP monitoring service library.
+    \details Remote monitoring and control over Ethernet, on UDP port
+             NET_PROTO_PORT, with the datagrams of netProto.h:
+             \par
+             - the control task queues each cycle as a sample in a
+               single-producer/single-consumer ring (netService_put());
+             - the UI task polls the service (netService_poll()), which
+               packs the queued samples into datagrams of up to
+               NET_SERVICE_BATCH samples, so the network stack is entered
+               once per batch rather than once per sample; a batch that is
+               not full is sent once its first sample is NET_SERVICE_FLUSH_MS
+               old;
+             - commands from a client are taken in the same poll and applied
+               from the UI task, as the menu applies its edits: setpoint
+               (automatic mode only, as in the menu), mode and PID
+               coefficients; each one is answered with an ACK;
+             - the alarm and KPI state goes out every NET_SERVICE_STATUS_MS.
+             \par
+             Samples and status go to the last client that subscribed; with
+             no client the ring is emptied and its samples discarded. A full
+             ring drops the new sample, which shows as a jump in the sample
+             index of the batches and in the status alarms.
+             \par
+             The service uses the BSD socket API of uC/TCP-IP, which is not
+             part of this project: with NET_SERVICE_ENABLED set, the stack
+             must be in the build and up, with the interface address set,
+             before the UI task starts. The protocol itself, netProto.c, has
+             no such dependency.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef NET_SERVICE_H
+#define NET_SERVICE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include "deadline.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** UDP monitoring service enable flag (compile time); needs uC/TCP-IP. */
+#define NET_SERVICE_ENABLED (0)
+
+/** Samples kept in the ring; a power of two, up to 32768. */
+#define NET_SERVICE_RING (128u)
+
+#if (NET_SERVICE_RING & (NET_SERVICE_RING - 1u)) || (NET_SERVICE_RING > 32768u)
+#error "NET_SERVICE_RING must be a power of two, up to 32768."
+#endif
+
+/** Samples per datagram; up to NET_PROTO_BATCH_MAX. */
+#define NET_SERVICE_BATCH (50u)
+
+/** Longest wait of a sample for its datagram, in milliseconds. */
+#define NET_SERVICE_FLUSH_MS (500u)
+
+/** Status period, in milliseconds. */
+#define NET_SERVICE_STATUS_MS (1000u)
+
+/** Poll period of the UI task, in milliseconds. */
+#define NET_SERVICE_POLL_MS (20u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Open and bind the service socket. Call from the UI task, once
+           the network stack is up.
+    \return None
+ */
+void netService_init (void);
+
+/**
+    \brief Queue a control sample. Call from the control task only.
+    \param sp Setpoint raw value.
+    \param pv Process variable raw value.
+    \param op Controller output raw value.
+    \param er Error raw value.
+    \return None
+ */
+void netService_put (int16_t sp, int16_t pv, int16_t op, int16_t er);
+
+/**
+    \brief Apply the received commands, send the due sample batches and
+           the due status. Call from the UI task every NET_SERVICE_POLL_MS.
+    \param now Current time, in kernel ticks.
+    \param deadline Control cycle deadline monitor, for the status; null
+           if the deadlines are not monitored.
+    \return None
+ */
+void netService_poll (uint32_t now, const DeadlineMonitor* deadline);
+
+/**
+    \brief Get the number of samples dropped on a full ring since start.
+    \return Dropped sample count.
+ */
+uint32_t netService_lost (void);
+
+#endif /* NET_SERVICE_H */
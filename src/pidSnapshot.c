@@ -0,0 +1,80 @@
+/**
+    \file pidSnapshot.c
+    \brief Implementation file for the published PID state snapshot library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "controllerSysControl.h"
+#include "memBarrier.h"
+#include "pidSnapshot.h"
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Sequence counter; odd while a publish is in progress. */
+static volatile uint32_t sequence = 0;
+
+/** Published loop state. */
+static volatile PIDSnapshot shared = {PID_OFF, PID_MAN, 0, 0, 0, 0};
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void pidSnapshot_publish (const PIDControl* source) {
+    /* Mark publish in progress. */
+    sequence = sequence + 1u;
+    MEM_BARRIER_RELEASE();
+
+    shared.active = source->active;
+    shared.mode   = source->mode;
+    shared.sp     = source->sp;
+    shared.op     = source->op;
+    shared.pv     = source->pv;
+    shared.er     = source->er;
+
+    /* Mark publish complete. */
+    MEM_BARRIER_RELEASE();
+    sequence = sequence + 1u;
+}
+
+uint8_t pidSnapshot_read (PIDSnapshot* snapshot) {
+    uint32_t start;
+    uint8_t retries = 0;
+    bool consistent;
+
+    do {
+        start = sequence;
+        MEM_BARRIER_ACQUIRE();
+
+        snapshot->active = shared.active;
+        snapshot->mode   = shared.mode;
+        snapshot->sp     = shared.sp;
+        snapshot->op     = shared.op;
+        snapshot->pv     = shared.pv;
+        snapshot->er     = shared.er;
+
+        MEM_BARRIER_ACQUIRE();
+
+        /* Copy is consistent if no publish was in progress or started. */
+        consistent = ((start & 1u) == 0u) && (sequence == start);
+
+        if ((consistent == false) && (retries < UINT8_MAX)) {
+            retries++;
+        }
+    } while (consistent == false);
+
+    return retries;
+}
@@ -0,0 +1,61 @@
+/**
+    \file pidSnapshot.h
+    \brief Header file for the published PID state snapshot library.
+    \details ControllerTask is the single writer: it publishes the loop
+             state once per control cycle. Other tasks read a consistent
+             copy through a sequence lock; the writer never blocks and a
+             reader that overlapped a publish simply copies again.
+             \par
+             Readers must not run at a higher priority than the writer, or a
+             reader preempting a publish would retry forever.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef PIDSNAPSHOT_H
+#define PIDSNAPSHOT_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include "controllerSysControl.h"
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Published PID loop state. */
+typedef struct PIDSnapshot_struct {
+    uint8_t active;     /**< Controller active flag. */
+    uint8_t mode;       /**< Controller mode. */
+    int16_t sp;         /**< Setpoint raw value. (0 - 1023) */
+    int16_t op;         /**< Controller output raw value. (0 - 1023) */
+    int16_t pv;         /**< Process variable raw value. (0 - 1023) */
+    int16_t er;         /**< Error raw value. */
+} PIDSnapshot;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Publish the loop state. Only ControllerTask may call this.
+    \param source Pointer to the PID control structure to publish.
+    \return None
+ */
+void pidSnapshot_publish (const PIDControl* source);
+
+/**
+    \brief Read a consistent copy of the last published loop state.
+    \param snapshot Pointer to structure where the state is copied.
+    \return Number of retries needed because of a concurrent publish.
+ */
+uint8_t pidSnapshot_read (PIDSnapshot* snapshot);
+
+#endif /* PIDSNAPSHOT_H */
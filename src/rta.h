@@ -0,0 +1,129 @@
+/**
+    \file rta.h
+    \brief Header file for the compile time response time analysis.
+    \details RTA_CHECK() runs the rate monotonic response time analysis of
+             a fixed priority task set at build time. For each task i, with
+             budget C(i) and period T(i), both in microseconds, the worst
+             case response time is the fixed point of
+             \code
+             R = C(i) + ceil(R / Ttick) * Ctick
+                      + sum over tasks j of higher priority:
+                        ceil(R / T(j)) * C(j)
+             \endcode
+             where the tick term is the kernel tick interrupt and tick task.
+             Each task must meet R <= T(i), the next release of the task.
+             The iteration is unrolled eight times into enumeration
+             constants; a task that misses its deadline, or whose response
+             time does not settle by then, or that shares its priority,
+             fails the build with a negative array size error on a typedef
+             named after the task:
+             \code
+             rtaDeadlineMissed_<task>
+             rtaSharedPriority_<task>
+             \endcode
+             \par
+             The task set is an X-macro table:
+             \code
+             #define TASK_TABLE(X, ...) \
+                 X(__VA_ARGS__, task, name, prio, periodMs, budgetUs, stk) \
+                 ...
+             #define TASK_TABLE_INDIRECT() TASK_TABLE
+             \endcode
+             Lower priority numbers are more urgent, as in the kernel. The
+             indirect macro lets the analysis walk the table once for each
+             task: the inner walk is deferred until the outer one is done.
+             Nothing is emitted but enumeration constants and typedefs.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef RTA_H
+#define RTA_H
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Ceiling of a / b, for positive integers. */
+#define RTA_CEIL_DIV(a, b) (((a) + (b) - 1) / (b))
+
+/** Static assertion: a negative array size when the condition fails. */
+#define RTA_ASSERT(condition, name) typedef char name[(condition) ? 1 : -1]
+
+/** Token pasting, with the arguments expanded first. */
+#define RTA_CAT(a, b) RTA_CAT_(a, b)
+#define RTA_CAT_(a, b) a##b
+
+/** Response time constant of a task at an iteration, and its uncapped
+    value. */
+#define RTA_R(step, task) RTA_CAT(RTA_CAT(RTA_R, step), _##task)
+#define RTA_W(step, task) RTA_CAT(RTA_CAT(RTA_W, step), _##task)
+
+/** Deferred expansion: the macro is called on the next scan only. */
+#define RTA_EMPTY()
+#define RTA_DEFER(macro) macro RTA_EMPTY()
+#define RTA_EXPAND(...) __VA_ARGS__
+
+/** Interference of task j on a task of priority prioI over a window. */
+#define RTA_TERM(window, prioI, task, name, prio, periodMs, budgetUs, stk) \
+    + (((prio) < (prioI)) ?                                                 \
+       (RTA_CEIL_DIV((window), (periodMs) * 1000) * (budgetUs)) : 0)
+
+/** One when task j shares priority prioI. */
+#define RTA_SAME(prioI, task, name, prio, periodMs, budgetUs, stk) \
+    + (((prio) == (prioI)) ? 1 : 0)
+
+/** Response time of a task before the first iteration: its budget. */
+#define RTA_START(table, tick, task, name, prio, periodMs, budgetUs, stk) \
+    RTA_R(0, task) = (budgetUs),
+
+/** Next iteration, capped just past the deadline where it has failed. The
+    deferred table walk must not sit in a macro argument: each argument
+    scan would bring it forward into the outer walk. */
+#define RTA_STEP(table, tick, step, next,                                 \
+                 task, name, prio, periodMs, budgetUs, stk)               \
+    RTA_W(next, task) = (budgetUs) + RTA_TICK(RTA_R(step, task), tick)    \
+        RTA_DEFER(table)()(RTA_TERM, RTA_R(step, task), (prio)),          \
+    RTA_R(next, task) = RTA_MIN(RTA_W(next, task),                        \
+                                ((periodMs) * 1000) + 1),
+
+/** Final checks of one task: settled by the last iteration, on time, and
+    alone at its priority. */
+#define RTA_VERDICT(table, tick, task, name, prio, periodMs, budgetUs, stk) \
+    enum { rtaPriorityUsers_##task =                                        \
+           0 RTA_DEFER(table)()(RTA_SAME, (prio)) };                        \
+    RTA_ASSERT((RTA_R(8, task) <= ((periodMs) * 1000)) &&                   \
+               ((int)RTA_R(8, task) == (int)RTA_R(7, task)),                \
+               rtaDeadlineMissed_##task);                                   \
+    RTA_ASSERT(rtaPriorityUsers_##task == 1, rtaSharedPriority_##task);
+
+/** Tick interference over a window; tick is (periodUs, budgetUs). */
+#define RTA_TICK(window, tick) RTA_TICK_(window, RTA_EXPAND tick)
+#define RTA_TICK_(window, ...) RTA_TICK__(window, __VA_ARGS__)
+#define RTA_TICK__(window, periodUs, budgetUs) \
+    (RTA_CEIL_DIV((window), (periodUs)) * (budgetUs))
+
+/** Smaller of two values. */
+#define RTA_MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+/**
+    \brief Check the task set at build time.
+    \param table Indirect macro of the task table.
+    \param tick Kernel tick load: (period, budget), in microseconds.
+    \details Use once per translation unit, at file scope, followed by a
+             semicolon.
+ */
+#define RTA_CHECK(table, tick)                                            \
+    enum { RTA_EXPAND(table()(RTA_START, table, tick)) };                 \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 0, 1)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 1, 2)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 2, 3)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 3, 4)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 4, 5)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 5, 6)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 6, 7)) };            \
+    enum { RTA_EXPAND(table()(RTA_STEP, table, tick, 7, 8)) };            \
+    RTA_EXPAND(table()(RTA_VERDICT, table, tick))                         \
+    RTA_ASSERT(1, rtaChecked)
+
+#endif /* RTA_H */
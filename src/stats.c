@@ -0,0 +1,246 @@
+/**
+    \file stats.c
+    \brief Implementation file for the task statistics library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "format.h"
+#include "tickless.h"
+#include "stats.h"
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (STATS_ENABLED)
+#if (OS_CFG_STAT_TASK_EN == 0u) || (OS_CFG_TASK_PROFILE_EN == 0u)
+#error "Task statistics need OS_CFG_STAT_TASK_EN and OS_CFG_TASK_PROFILE_EN."
+#endif
+#endif
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Convert an OS_CPU_USAGE value to hundredths of a percent. */
+#define STATS_HUNDREDTHS(usage) \
+    ((uint16_t)(((uint32_t)(usage) * 10000u) / STATS_CPU_USAGE_FULL))
+
+/** Saturate a 32-bit count to 16 bits. */
+#define STATS_SATURATE(count) \
+    ((uint16_t)(((count) > UINT16_MAX) ? UINT16_MAX : (count)))
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Registered task control blocks. */
+static OS_TCB* tasks[STATS_MAX_TASKS];
+
+/** Short names of the registered tasks; null for the kernel name. */
+static const char* taskNames[STATS_MAX_TASKS];
+
+/** Context switch counter of each task at the previous collection. */
+static OS_CTX_SW_CTR lastTaskSwitches[STATS_MAX_TASKS];
+
+/** Total context switch counter at the previous collection. */
+static OS_CTX_SW_CTR lastSwitches = 0;
+
+/** Idle wake-up counter at the previous collection. */
+static uint32_t lastWakeups = 0;
+
+/** Number of registered tasks. */
+static uint8_t taskCount = 0;
+
+/** Last collected statistics. */
+static Stats stats;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Convert a timestamp timer count to microseconds, saturated.
+    \param count Timestamp timer count.
+    \return Time in microseconds.
+ */
+static uint16_t stats_toMicros (uint32_t count);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+bool stats_addTask (OS_TCB* tcb, const char* name) {
+    if (taskCount >= STATS_MAX_TASKS) {
+        return false;
+    }
+
+    tasks[taskCount] = tcb;
+    taskNames[taskCount] = name;
+#if (STATS_ENABLED)
+    lastTaskSwitches[taskCount] = tcb->CtxSwCtr;
+#endif
+    taskCount++;
+
+    return true;
+}
+
+void stats_collect (void) {
+#if (STATS_ENABLED)
+    CPU_TS_TMR start = CPU_TS_TmrRd();
+    OS_CTX_SW_CTR switches;
+    uint32_t wakeups;
+    StatsTask* entry;
+    OS_TCB* tcb;
+    uint8_t i;
+
+#if (OS_CFG_STAT_TASK_STK_CHK_EN == 0u)
+    CPU_STK_SIZE stackFree;
+    CPU_STK_SIZE stackUsed;
+    OS_ERR err;
+#endif
+
+    for (i = 0; i < taskCount; i++) {
+        tcb = tasks[i];
+        entry = &stats.task[i];
+
+        entry->name = (taskNames[i] != NULL) ? taskNames[i] :
+                                               (const char*)tcb->NamePtr;
+        entry->prio = (uint8_t)tcb->Prio;
+        entry->cpuUsage = STATS_HUNDREDTHS(tcb->CPUUsage);
+
+        switches = tcb->CtxSwCtr;
+        entry->switches = STATS_SATURATE(switches - lastTaskSwitches[i]);
+        lastTaskSwitches[i] = switches;
+
+#if (OS_CFG_STAT_TASK_STK_CHK_EN > 0u)
+        /* Kept up to date by the statistic task. */
+        entry->stackUsed = STATS_SATURATE(tcb->StkUsed);
+#else
+        /* Scans the unused part of the stack. */
+        OSTaskStkChk(tcb, &stackFree, &stackUsed, &err);
+        entry->stackUsed = STATS_SATURATE(stackUsed);
+#endif
+        entry->stackSize = STATS_SATURATE(tcb->StkSize);
+    }
+
+    stats.taskCount = taskCount;
+    /* The idle task sleeps, so its loop count no longer measures the idle
+       time behind OSStatTaskCPUUsage; its own time share still does. */
+    stats.cpuUsage = STATS_HUNDREDTHS(STATS_CPU_USAGE_FULL -
+                                      OSIdleTaskTCB.CPUUsage);
+
+    switches = OSTaskCtxSwCtr;
+    stats.switches = STATS_SATURATE(switches - lastSwitches);
+    lastSwitches = switches;
+
+    wakeups = tickless_wakeups();
+    stats.wakeups = STATS_SATURATE(((wakeups - lastWakeups) * 1000u) /
+                                   STATS_PERIOD_MS);
+    lastWakeups = wakeups;
+
+#ifdef CPU_CFG_INT_DIS_MEAS_EN
+    stats.intDisMaxUs = stats_toMicros(CPU_IntDisMeasMaxGet());
+#endif
+
+    stats.collections++;
+    stats.collectUs = stats_toMicros((CPU_TS_TMR)(CPU_TS_TmrRd() - start));
+#endif
+}
+
+const Stats* stats_get (void) {
+    return &stats;
+}
+
+uint16_t stats_format (char* out) {
+    char number[FORMAT_INT32_SIZE];
+    char* position = out;
+    const StatsTask* entry;
+    uint8_t length;
+    uint8_t i;
+
+    format_fixed(number, stats.cpuUsage, 2u, 6u);
+    position = format_append(position, "CPU ");
+    position = format_append(position, number);
+    format_int(number, stats.switches, 5u);
+    position = format_append(position, "% CSW ");
+    position = format_append(position, number);
+    format_int(number, stats.wakeups, 5u);
+    position = format_append(position, " WAKE_PER_S ");
+    position = format_append(position, number);
+    format_int(number, stats.intDisMaxUs, 5u);
+    position = format_append(position, " IRQ_OFF_US ");
+    position = format_append(position, number);
+    format_int(number, stats.collectUs, 5u);
+    position = format_append(position, " COLLECT_US ");
+    position = format_append(position, number);
+    position = format_append(position, "\n");
+
+    for (i = 0; i < stats.taskCount; i++) {
+        entry = &stats.task[i];
+
+        format_int(number, entry->prio, 3u);
+        position = format_append(position, number);
+        position = format_append(position, " ");
+
+        /* Name, truncated and padded to a fixed width. */
+        for (length = 0; length < STATS_NAME_CHARS; length++) {
+            if ((entry->name == NULL) || (entry->name[length] == '\0')) {
+                break;
+            }
+
+            *position++ = entry->name[length];
+        }
+
+        for (; length < STATS_NAME_CHARS; length++) {
+            *position++ = ' ';
+        }
+
+        format_fixed(number, entry->cpuUsage, 2u, 7u);
+        position = format_append(position, number);
+        format_int(number, entry->switches, 6u);
+        position = format_append(position, "%");
+        position = format_append(position, number);
+        format_int(number, entry->stackUsed, 6u);
+        position = format_append(position, number);
+        format_int(number, entry->stackSize, 0u);
+        position = format_append(position, "/");
+        position = format_append(position, number);
+        position = format_append(position, "\n");
+    }
+
+    *position = '\0';
+
+    return (uint16_t)(position - out);
+}
+
+static uint16_t stats_toMicros (uint32_t count) {
+    CPU_ERR err;
+    CPU_TS_TMR_FREQ frequency = CPU_TS_TmrFreqGet(&err);
+
+    if ((err != CPU_ERR_NONE) || (frequency == 0u)) {
+        return 0;
+    }
+
+    return STATS_SATURATE(((uint64_t)count * 1000000u) / frequency);
+}
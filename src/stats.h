@@ -0,0 +1,138 @@
+/**
+    \file stats.h
+    \brief Header file for the task statistics library.
+    \details Once every STATS_PERIOD_MS the UI task collects, from the
+             registered task control blocks, the CPU usage and stack
+             high-water mark that the kernel statistic task keeps for each
+             task, plus the context switches and idle wake-ups in the last
+             period, the total CPU usage and the longest interrupt disable
+             time. The result
+             is a compact Stats structure that the LCD diagnostics page
+             shows and stats_format() exports as text.
+             \par
+             Collector overhead: the collector only reads counters the
+             kernel already maintains. Per registered task that is a
+             handful of loads and stores, plus one stack scan per task when
+             OS_CFG_STAT_TASK_STK_CHK_EN is disabled; two timestamp to time
+             conversions complete a collection. It runs at UI task priority
+             with interrupts and scheduling enabled, at most STATS_MAX_TASKS
+             tasks once per period, and times itself: Stats.collectUs.
+             \par
+             No lock is taken. The usage and stack fields are only written
+             by the kernel statistic task, which has a lower priority than
+             the UI task and so never runs in the middle of a collection;
+             the context switch counters are single aligned words.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Task statistics enable flag. */
+#define STATS_ENABLED (1)
+
+/** Maximum number of registered tasks. */
+#define STATS_MAX_TASKS (8u)
+
+/** Collection period, in milliseconds. */
+#define STATS_PERIOD_MS (1000u)
+
+/** OS_CPU_USAGE full scale (100 %): 10000 since uC/OS-III V3.03, 100
+    before. */
+#ifndef STATS_CPU_USAGE_FULL
+#define STATS_CPU_USAGE_FULL (10000u)
+#endif
+
+/** Task name characters kept in the text export. */
+#define STATS_NAME_CHARS (12u)
+
+/** Characters of the general text export line, terminator included. */
+#define STATS_TEXT_HEADER_SIZE (80u)
+
+/** Characters of one task text export line. */
+#define STATS_TEXT_TASK_SIZE (STATS_NAME_CHARS + 40u)
+
+/** Buffer size that holds the whole text export. */
+#define STATS_TEXT_SIZE \
+    (STATS_TEXT_HEADER_SIZE + (STATS_MAX_TASKS * STATS_TEXT_TASK_SIZE))
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Statistics of one task. */
+typedef struct StatsTask_struct {
+    const char* name;       /**< Task name. */
+    uint8_t prio;           /**< Task priority. */
+    uint16_t cpuUsage;      /**< CPU usage, in hundredths of a percent. */
+    uint16_t switches;      /**< Switches to the task in the last period. */
+    uint16_t stackUsed;     /**< Stack high-water mark, in CPU_STK words. */
+    uint16_t stackSize;     /**< Stack size, in CPU_STK words. */
+} StatsTask;
+
+/** System statistics. */
+typedef struct Stats_struct {
+    uint32_t collections;   /**< Number of collections since start. */
+    uint16_t cpuUsage;      /**< CPU usage, in hundredths of a percent. */
+    uint16_t switches;      /**< Context switches in the last period. */
+    uint16_t wakeups;       /**< Idle wake-ups per second, last period. */
+    uint16_t intDisMaxUs;   /**< Longest interrupt disable time, in us. */
+    uint16_t collectUs;     /**< Duration of the last collection, in us. */
+    uint8_t taskCount;      /**< Number of valid task entries. */
+    StatsTask task[STATS_MAX_TASKS];    /**< Per task statistics. */
+} Stats;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Register a task for statistics. Call before the first collection.
+    \param tcb Pointer to the task control block.
+    \param name Short task name for the LCD (5 characters shown) and the
+           text export; null to use the kernel task name.
+    \return False if STATS_MAX_TASKS tasks are already registered.
+ */
+bool stats_addTask (OS_TCB* tcb, const char* name);
+
+/**
+    \brief Collect the statistics of the last period. Only the UI task may
+           call this, once per STATS_PERIOD_MS.
+    \return None
+ */
+void stats_collect (void);
+
+/**
+    \brief Get the last collected statistics. UI task only.
+    \return Pointer to the statistics.
+ */
+const Stats* stats_get (void);
+
+/**
+    \brief Export the last collected statistics as text: one general line,
+           then one line per task. UI task only.
+    \param out Buffer receiving the text; see STATS_TEXT_SIZE.
+    \return Number of characters written, without the terminator.
+ */
+uint16_t stats_format (char* out);
+
+#endif /* STATS_H */
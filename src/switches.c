@@ -14,10 +14,25 @@
 #include <includes.h>
 #include <stdio.h>
 #include "platform.h"
+#include "trace.h"
 #include "switches.h"
 
 
 
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+#if (SWITCH_IRQ_ENABLED)
+/** Task signaled on the next switch press. */
+static OS_TCB* irqNotifyTCB = (OS_TCB*)0;
+
+/** Switch interrupt received since the last arm. */
+static volatile bool irqFired = false;
+#endif
+
+
+
 /******************************************************************************
 *                          LOCAL FUNCTION PROTOTYPES                          *
 ******************************************************************************/
@@ -40,6 +55,14 @@ static void sw2_isr (void);
  */
 static void sw3_isr (void);
 
+#if (SWITCH_IRQ_ENABLED)
+/**
+    \brief Disable switch interrupts and signal the task waiting for a press.
+    \return None
+ */
+static void switches_irqNotify (void);
+#endif
+
 
 
 /******************************************************************************
@@ -82,7 +105,38 @@ void switches_initialize (void) {
     IPR(ICU,IRQ9) = 0x03;
     IPR(ICU,IRQ12) = 0x03;
 
-    /* Clear any pending interrupts. */
+    /* Interrupts are enabled by switches_irqArm(), once the task that
+       handles them is running. */
+#endif
+}
+
+uint8_t read_switches (void) {
+    uint8_t switches_read;
+
+    /* Read switches port, disable additional bits. */
+    switches_read = (SWITCH_IN_PORT | SWITCHES_ON);
+
+    return switches_read;
+}
+
+uint8_t read_keys (void) {
+    uint8_t pressed;
+
+    /* Switches are active low. */
+    pressed = (uint8_t)~read_switches();
+
+    return (uint8_t)((((pressed >> SWITCH_1_PORT_BIT) & 0x01) << 0) |
+                     (((pressed >> SWITCH_2_PORT_BIT) & 0x01) << 1) |
+                     (((pressed >> SWITCH_3_PORT_BIT) & 0x01) << 2));
+}
+
+#if (SWITCH_IRQ_ENABLED)
+void switches_irqArm (OS_TCB* notify) {
+    irqNotifyTCB = notify;
+    irqFired = false;
+
+    /* Clear any pending interrupts: edges latched while they were disabled
+       are bounce of the press just debounced. */
     IR(ICU,IRQ8) = 0;
     IR(ICU,IRQ9) = 0;
     IR(ICU,IRQ12) = 0;
@@ -91,17 +145,36 @@ void switches_initialize (void) {
     IEN(ICU,IRQ8) = 1;
     IEN(ICU,IRQ9) = 1;
     IEN(ICU,IRQ12) = 1;
-#endif
+
+    /* A key held down makes no new edge: do not wait for one. */
+    if (read_keys() != 0u) {
+        IEN(ICU,IRQ8) = 0;
+        IEN(ICU,IRQ9) = 0;
+        IEN(ICU,IRQ12) = 0;
+
+        irqFired = true;
+    }
 }
 
-uint8_t read_switches (void) {
-    uint8_t switches_read;
+bool switches_irqFired (void) {
+    return irqFired;
+}
 
-    /* Read switches port, disable additional bits. */
-    switches_read = (SWITCH_IN_PORT | SWITCHES_ON);
+static void switches_irqNotify (void) {
+    OS_ERR err;
 
-    return switches_read;
+    /* Ignore further edges (contact bounce) until re-armed. */
+    IEN(ICU,IRQ8) = 0;
+    IEN(ICU,IRQ9) = 0;
+    IEN(ICU,IRQ12) = 0;
+
+    irqFired = true;
+
+    if (irqNotifyTCB != (OS_TCB*)0) {
+        OSTaskSemPost(irqNotifyTCB, OS_OPT_POST_NONE, &err);
+    }
 }
+#endif
 
 
 
@@ -111,18 +184,48 @@ uint8_t read_switches (void) {
 
 #pragma interrupt (sw1_isr (vect=VECT(ICU,IRQ8)))
 void sw1_isr (void) {
+#if (SWITCH_IRQ_ENABLED)
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_SW1);
+
+    /* Start debouncing in the UI task. */
+    switches_irqNotify();
+
+    TRACE_ISR_EXIT(TRACE_ISR_SW1);
+    OSIntExit();
+#else
     nop();
-    /* TODO: Add some debouncing! */
+#endif
 }
 
 #pragma interrupt (sw2_isr (vect=VECT(ICU,IRQ9)))
 void sw2_isr (void) {
+#if (SWITCH_IRQ_ENABLED)
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_SW2);
+
+    /* Start debouncing in the UI task. */
+    switches_irqNotify();
+
+    TRACE_ISR_EXIT(TRACE_ISR_SW2);
+    OSIntExit();
+#else
     nop();
-    /* TODO: Add some debouncing! */
+#endif
 }
 
 #pragma interrupt (sw3_isr (vect=VECT(ICU,IRQ12)))
 void sw3_isr (void) {
+#if (SWITCH_IRQ_ENABLED)
+    OSIntEnter();
+    TRACE_ISR_ENTER(TRACE_ISR_SW3);
+
+    /* Start debouncing in the UI task. */
+    switches_irqNotify();
+
+    TRACE_ISR_EXIT(TRACE_ISR_SW3);
+    OSIntExit();
+#else
     nop();
-    /* TODO: Add some debouncing! */
+#endif
 }
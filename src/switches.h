@@ -14,6 +14,7 @@
 
 #include <os.h>
 #include "iodefine.h"
+#include "debounce.h"
 
 
 
@@ -22,7 +23,7 @@
 ******************************************************************************/
 
 /** Swith interrupt request enable flag.*/
-#define SWITCH_IRQ_ENABLED (0)
+#define SWITCH_IRQ_ENABLED (1)
 
 
 /** Switch 1 port bit number. */
@@ -50,37 +51,31 @@
 
 
 /** Switch-1-on port value. */
-#define SWITCH_1_ON (~(0x01<<SWITCH_1_PORT_BIT)) // 254           1111_1110
+#define SWITCH_1_ON ((uint8_t)~(0x01<<SWITCH_1_PORT_BIT)) // 254           1111_1110
 
 /** Switch-2-on port value. */
-#define SWITCH_2_ON (~(0x01<<SWITCH_2_PORT_BIT)) // 253           1111_1101
+#define SWITCH_2_ON ((uint8_t)~(0x01<<SWITCH_2_PORT_BIT)) // 253           1111_1101
 
 /** Switch-3-on port value. */
-#define SWITCH_3_ON (~(0x01<<SWITCH_3_PORT_BIT)) // 239           1110_1111
+#define SWITCH_3_ON ((uint8_t)~(0x01<<SWITCH_3_PORT_BIT)) // 239           1110_1111
 
 /** All-switches-on port value. */
-#define SWITCHES_ON (SWITCH_1_ON & SWITCH_2_ON & SWITCH_3_ON)  // 1110_1100
+#define SWITCHES_ON ((uint8_t)(SWITCH_1_ON & SWITCH_2_ON & SWITCH_3_ON))  // 1110_1100
 
 /** All-switches-off port value. */
 #define SWITCHES_OFF (0xFF)
 
 
-/** Maximum debounce count. */
-#define DEBOUNCE_MAX (3)
+/** Debounce sampling period in milliseconds. With interrupts the task only
+    samples while a switch is active, so it can sample faster. */
+#if (SWITCH_IRQ_ENABLED)
+#define DEBOUNCE_PERIOD_MS (5u)
+#else
+#define DEBOUNCE_PERIOD_MS (50u)
+#endif
 
-
-
-/******************************************************************************
-*                              TYPE DEFINITIONS                               *
-******************************************************************************/
-
-/** Debounce control structure. */
-typedef struct DebounceControlType_struct {
-    uint8_t counter;    /**< Debounce counter. */
-    uint8_t current;    /**< Current switch state. */
-    uint8_t previous;   /**< Previous switch state. */
-    uint8_t debounce;   /**< Debouncing active. */
-} DebounceControlType;
+/** Keys that auto-repeat when held: switch 1 (up) and switch 3 (down). */
+#define SWITCH_REPEAT_KEYS (0x05)
 
 
 
@@ -100,4 +95,30 @@ void switches_initialize (void);
  */
 uint8_t read_switches(void);
 
+/**
+    \brief Read switches as key bits for the debouncer.
+    \return Key states, bit set = pressed (bit 0 = switch 1, bit 1 = switch
+            2, bit 2 = switch 3).
+ */
+uint8_t read_keys (void);
+
+#if (SWITCH_IRQ_ENABLED)
+/**
+    \brief Clear pending switch interrupts and enable them.
+    \details The first switch interrupt disables all three again and posts
+             the task semaphore of 'notify', so each arm wakes the task at
+             most once regardless of contact bounce. A key already down,
+             which makes no new edge, counts as fired.
+    \param notify Task to be signaled on the next switch press.
+    \return None
+ */
+void switches_irqArm (OS_TCB* notify);
+
+/**
+    \brief Check for a switch interrupt since the last switches_irqArm().
+    \return True if a switch interrupt was received.
+ */
+bool switches_irqFired (void);
+#endif
+
 #endif /* _SWITCHES_H_ */
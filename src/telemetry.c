@@ -0,0 +1,305 @@
+/**
+    \file telemetry.c
+    \brief Implementation file for the binary UART telemetry library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <machine.h>
+#include <cpu_core.h>
+#include "platform.h"
+#include "memBarrier.h"
+#include "telemetry.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Mask for wrapping free-running indices into the ring. */
+#define TELEMETRY_MASK (TELEMETRY_FRAMES - 1u)
+
+/** Bytes of a record covered by its CRC. */
+#define TELEMETRY_CRC_SIZE (TELEMETRY_RECORD_SIZE - 2u)
+
+/** Busy loop iterations covering one bit time after setting the bit rate. */
+#define TELEMETRY_BIT_WAIT (1000u)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Frame ring; read by DMAC channel 0. */
+static uint8_t ring[TELEMETRY_FRAMES][TELEMETRY_FRAME_SIZE];
+
+/** Next frame to write (control task). */
+static volatile uint8_t ringHead = 0;
+
+/** Next frame to send (transfer end interrupt). */
+static volatile uint8_t ringTail = 0;
+
+/** Frames of the transfer in progress; zero when DMAC channel 0 is idle. */
+static volatile uint8_t framesInFlight = 0;
+
+/** Control cycles since the last record. */
+static uint8_t decimationCount = 0;
+
+/** Sequence number of the next record. */
+static uint16_t sequence = 0;
+
+/** Records dropped on a full ring. */
+static volatile uint32_t dropped = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Start a transfer of the ready frames, up to the end of the ring
+           storage. Call with DMAC channel 0 idle and its interrupt masked.
+    \return None
+ */
+static void telemetry_start (void);
+
+/**
+    \brief Store a 16-bit value, little-endian.
+    \param out Buffer position.
+    \param value Value to store.
+    \return Buffer position after the value.
+ */
+static uint8_t* telemetry_put16 (uint8_t* out, uint16_t value);
+
+#if (TELEMETRY_ENABLED)
+/**
+    \brief DMAC channel 0 transfer end interrupt service routine.
+    \return None
+ */
+static void telemetry_isr (void);
+#endif
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void telemetry_init (void) {
+    uint16_t i;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up the DMAC and SCI2. */
+    MSTP(DMAC) = 0;
+    MSTP(SCI2) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Set up port 50 (TXD2) as SCI2 output. */
+    PORT5.PODR.BIT.B0 = 1;      /* Idle line level while still GPIO. */
+    PORT5.PDR.BIT.B0  = 1;      /* Set I/O pin direction to output. */
+    PORT5.PMR.BIT.B0  = 0;      /* First set I/O pin to GPIO mode. */
+    MPC.P50PFS.BYTE = 0x0A;     /* P50 is used as TXD2. */
+    PORT5.PMR.BIT.B0  = 1;      /* Hand the pin over to SCI2. */
+
+    /* Asynchronous 8N1, PCLK/1 count source; transmitter still off. */
+    SCI2.SCR.BYTE = 0x00;
+    SCI2.SMR.BYTE = 0x00;
+    SCI2.SCMR.BYTE = 0xF2;      /* Serial mode, LSB first. */
+    SCI2.SEMR.BYTE = 0x00;
+    SCI2.BRR = TELEMETRY_BRR;
+
+    /* The bit rate settles within one bit time. */
+    for (i = 0; i < TELEMETRY_BIT_WAIT; i++) {
+        nop();
+    }
+
+    /* Channel 0 stays off until the first frame is ready. */
+    DMAC0.DMCNT.BIT.DTE = 0;
+
+    /* DMTMD: DMA Transfer Mode Register
+    b15:b14 MD    00  Normal transfer.
+    b13:b12 DTS   10  No repeat or block area.
+    b9:b8   SZ    00  8-bit transfers.
+    b1:b0   DCTG  01  Started by an interrupt request (DMRSR0).
+    */
+    DMAC0.DMTMD.WORD = 0x2001;
+
+    /* DMAMD: DMA Address Mode Register
+    b15:b14 SM    10  Source incremented: the ring.
+    b7:b6   DM    00  Destination fixed: the transmit data register.
+    */
+    DMAC0.DMAMD.WORD = 0x8000;
+    DMAC0.DMDAR = (uint32_t)&SCI2.TDR;
+    DMAC0.DMCSL.BYTE = 0x00;    /* Interrupt at the transfer end only. */
+    DMAC0.DMINT.BYTE = 0x10;    /* DTIE = 1: transfer end interrupt. */
+
+    /* SCI2 TXI requests start channel 0, not the CPU. */
+    ICU.DMRSR0 = VECT(SCI2,TXI2);
+    IR(SCI2,TXI2) = 0;
+    IEN(SCI2,TXI2) = 1;
+
+    IPR(DMAC,DMAC0I) = TELEMETRY_IPL;
+    IR(DMAC,DMAC0I) = 0;
+    IEN(DMAC,DMAC0I) = 1;
+
+    DMAC.DMAST.BIT.DMST = 1;
+
+    /* TIE and TE set together raise the first TXI: the transmit data
+       register is empty. A TXI raised while channel 0 is off stays pending
+       and starts the next transfer as soon as it is enabled. */
+    SCI2.SCR.BYTE = 0xA0;
+}
+
+void telemetry_put (int16_t sp, int16_t pv, int16_t op, int16_t er) {
+    uint8_t head = ringHead;
+    uint8_t* record;
+    uint8_t* position;
+    CPU_SR_ALLOC();
+
+    if (++decimationCount < TELEMETRY_DECIMATION) {
+        return;
+    }
+
+    decimationCount = 0;
+
+    /* Indices run freely; their difference is the fill level. */
+    if ((uint8_t)(head - ringTail) >= TELEMETRY_FRAMES) {
+        /* Numbered anyway: the receiver sees the gap. */
+        sequence++;
+        dropped++;
+
+        return;
+    }
+
+    /* Build the record where it is sent from. */
+    record = &ring[head & TELEMETRY_MASK][1];
+    position = telemetry_put16(record, sequence);
+    position = telemetry_put16(position, (uint16_t)sp);
+    position = telemetry_put16(position, (uint16_t)pv);
+    position = telemetry_put16(position, (uint16_t)op);
+    position = telemetry_put16(position, (uint16_t)er);
+    (void)telemetry_put16(position,
+                          telemetry_crc(record, TELEMETRY_CRC_SIZE));
+    telemetry_encode(record - 1);
+    sequence++;
+
+    /* Frame must be stored before it is made visible. */
+    MEM_BARRIER_RELEASE();
+    ringHead = head + 1u;
+
+    CPU_CRITICAL_ENTER();
+
+    if (framesInFlight == 0u) {
+        telemetry_start();
+    }
+
+    CPU_CRITICAL_EXIT();
+}
+
+uint32_t telemetry_dropped (void) {
+    return dropped;
+}
+
+uint16_t telemetry_crc (const uint8_t* data, uint8_t size) {
+    uint16_t crc = 0xFFFF;
+    uint8_t bit;
+
+    while (size-- > 0u) {
+        crc ^= (uint16_t)((uint16_t)*data++ << 8);
+
+        for (bit = 0; bit < 8u; bit++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) :
+                                    (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+void telemetry_encode (uint8_t* frame) {
+    uint8_t code = 1;
+    uint8_t last = 0;
+    uint8_t i;
+
+    /* Each zero of the record becomes the distance to the next zero, or
+       to the delimiter; the code byte holds the distance to the first. */
+    for (i = 1; i <= TELEMETRY_RECORD_SIZE; i++) {
+        if (frame[i] == 0u) {
+            frame[last] = code;
+            last = i;
+            code = 1;
+        } else {
+            code++;
+        }
+    }
+
+    frame[last] = code;
+    frame[TELEMETRY_FRAME_SIZE - 1u] = 0;
+}
+
+static void telemetry_start (void) {
+    uint8_t tail = ringTail;
+    uint8_t index = tail & TELEMETRY_MASK;
+    uint8_t count = (uint8_t)(ringHead - tail);
+
+    if (count == 0u) {
+        return;
+    }
+
+    /* Frames must be read after they were seen as filled. */
+    MEM_BARRIER_ACQUIRE();
+
+    /* Contiguous frames only; the rest go with the next transfer. */
+    if (count > (TELEMETRY_FRAMES - index)) {
+        count = TELEMETRY_FRAMES - index;
+    }
+
+    framesInFlight = count;
+
+    DMAC0.DMSAR = (uint32_t)&ring[index][0];
+    DMAC0.DMCRA = (uint32_t)count * TELEMETRY_FRAME_SIZE;
+    DMAC0.DMCNT.BIT.DTE = 1;
+}
+
+static uint8_t* telemetry_put16 (uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+
+    return out + 2;
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#if (TELEMETRY_ENABLED)
+#pragma interrupt (telemetry_isr (vect=VECT(DMAC,DMAC0I)))
+void telemetry_isr (void) {
+    /* DTE was cleared by the hardware at the transfer end. */
+    DMAC0.DMSTS.BIT.DTIF = 0;
+
+    /* Frames must be sent before they are handed back to the producer. */
+    MEM_BARRIER_RELEASE();
+    ringTail = ringTail + framesInFlight;
+    framesInFlight = 0;
+
+    telemetry_start();
+}
+#endif
@@ -0,0 +1,137 @@
+/**
+    \file telemetry.h
+    \brief Header file for the binary UART telemetry library.
+    \details Streams the loop state (SP, PV, OP and error) off the board
+             on SCI2, one record every TELEMETRY_DECIMATION control cycles.
+             A record is TELEMETRY_RECORD_SIZE bytes, little-endian:
+             \code
+             offset  0  uint16  sequence number
+                     2  int16   sp
+                     4  int16   pv
+                     6  int16   op
+                     8  int16   er
+                    10  uint16  CRC-16/CCITT-FALSE of bytes 0 to 9
+             \endcode
+             Each record is COBS encoded (consistent overhead byte
+             stuffing) and followed by a zero byte, so a receiver finds the
+             frame boundaries in the byte stream by the zeros alone and
+             picks the stream up at any frame. A record always takes one
+             code byte, so every frame is TELEMETRY_FRAME_SIZE bytes.
+             \par
+             The control task writes each frame in place into a
+             single-producer/single-consumer ring of frames; DMAC channel 0
+             is the consumer and moves the frames straight from the ring
+             into the SCI2 transmit data register, one byte per TXI request,
+             with no copy in between. A transfer covers all the frames
+             ready up to the end of the ring storage; its end interrupt
+             hands them back and starts the next transfer. A full ring
+             drops the new record; the sequence number still advances, so
+             the receiver sees the gap.
+             \par
+             The host decoder, tools/telemetryDecode.c, checks the frames
+             and writes CSV and column files.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Telemetry stream enable flag (compile time). */
+#define TELEMETRY_ENABLED (1)
+
+/** Control cycles per record. */
+#define TELEMETRY_DECIMATION (1u)
+
+/** Frames kept in the ring; a power of two, up to 128. */
+#define TELEMETRY_FRAMES (32u)
+
+#if (TELEMETRY_FRAMES & (TELEMETRY_FRAMES - 1u)) || (TELEMETRY_FRAMES > 128u)
+#error "TELEMETRY_FRAMES must be a power of two, up to 128."
+#endif
+
+/** Record size, in bytes, CRC included. */
+#define TELEMETRY_RECORD_SIZE (12u)
+
+/** Frame size, in bytes: code byte, encoded record and delimiter. */
+#define TELEMETRY_FRAME_SIZE (TELEMETRY_RECORD_SIZE + 2u)
+
+/** SCI2 bit rate, in bits per second. */
+#define TELEMETRY_BAUD (115200ul)
+
+/** Peripheral clock feeding SCI2, in Hz. */
+#define TELEMETRY_PCLK_HZ (48000000ul)
+
+/** SCI2 bit rate register value for the PCLK/1 count source, rounded. */
+#define TELEMETRY_BRR                                                       \
+    (((TELEMETRY_PCLK_HZ + (16u * TELEMETRY_BAUD)) / (32u * TELEMETRY_BAUD)) \
+     - 1u)
+
+#if (TELEMETRY_BRR > 255u)
+#error "TELEMETRY_BAUD too low for the PCLK/1 count source."
+#endif
+
+/** Interrupt priority of the transfer end; kernel-aware. */
+#define TELEMETRY_IPL (2u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Set up SCI2, its TXD2 pin and DMAC channel 0. Call once, before
+           the first telemetry_put().
+    \return None
+ */
+void telemetry_init (void);
+
+/**
+    \brief Count a control cycle and queue a record every
+           TELEMETRY_DECIMATION cycles. Call from the control task only.
+    \param sp Setpoint raw value.
+    \param pv Process variable raw value.
+    \param op Controller output raw value.
+    \param er Error raw value.
+    \return None
+ */
+void telemetry_put (int16_t sp, int16_t pv, int16_t op, int16_t er);
+
+/**
+    \brief Get the number of records dropped on a full ring since start.
+    \return Dropped record count.
+ */
+uint32_t telemetry_dropped (void);
+
+/**
+    \brief Compute the CRC-16/CCITT-FALSE of a buffer: polynomial 0x1021,
+           initial value 0xFFFF, no reflection, no final XOR.
+    \param data Buffer.
+    \param size Buffer size, in bytes.
+    \return CRC value.
+ */
+uint16_t telemetry_crc (const uint8_t* data, uint8_t size);
+
+/**
+    \brief COBS encode a frame in place.
+    \param frame Frame buffer, TELEMETRY_FRAME_SIZE bytes, holding the
+           record from its second byte on; the first and last bytes are
+           written.
+    \return None
+ */
+void telemetry_encode (uint8_t* frame);
+
+#endif /* TELEMETRY_H */
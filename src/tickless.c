@@ -0,0 +1,265 @@
+/**
+    \file tickless.c
+    \brief Implementation file for the tickless idle library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <machine.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "platform.h"
+#include "tickless.h"
+
+
+
+/******************************************************************************
+*                            CONFIGURATION CHECKS                             *
+******************************************************************************/
+
+#if (OS_CFG_APP_HOOKS_EN == 0u)
+#error "Idle sleep needs OS_CFG_APP_HOOKS_EN for the idle task hook."
+#endif
+
+#if (TICKLESS_ENABLED) && (OS_CFG_TMR_EN > 0u)
+#error "Tickless idle skips OSTimeTick(), which also drives the timer task."
+#endif
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Wake-ups from idle sleep; written by the idle task only. */
+static volatile uint32_t wakeups = 0;
+
+#if (TICKLESS_ENABLED)
+/** CMT2 matched while the core was asleep. */
+static volatile bool wakeMatched = false;
+#endif
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Idle task hook: sleep until the next kernel deadline or
+           interrupt.
+    \return None
+ */
+static void tickless_idleHook (void);
+
+#if (TICKLESS_ENABLED)
+/**
+    \brief Wake-up CMT2 compare match interrupt service routine.
+    \return None
+ */
+static void tickless_isr (void);
+#endif
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void tickless_init (void) {
+    CPU_SR_ALLOC();
+
+#if (TICKLESS_ENABLED)
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA50B;  /* Protect off */
+#endif
+
+    /* Power up CMT2. */
+    MSTP(CMT2) = 0;
+
+#ifdef PLATFORM_BOARD_RDKRX63N
+    SYSTEM.PRCR.WORD = 0xA500;  /* Protect on */
+#endif
+
+    /* Stop CMT2; it only runs while the core sleeps. */
+    CMT.CMSTR1.BIT.STR2 = 0;
+
+    /* CMCR: Compare Match Timer Control Register
+    b6    CMIE  1  Compare match interrupt enabled.
+    b1:b0 CKS   -  Count source = that of CMT0, the kernel tick.
+    */
+    CMT2.CMCR.WORD = 0x00C0 | (CMT0.CMCR.WORD & 0x0003);
+    CMT2.CMCNT = 0;
+
+    /* Kernel-aware priority; enabled for each sleep. */
+    IPR(CMT2,CMI2) = TICKLESS_IPL;
+    IR(CMT2,CMI2) = 0;
+    IEN(CMT2,CMI2) = 0;
+#endif
+
+    CPU_CRITICAL_ENTER();
+    OS_AppIdleTaskHookPtr = tickless_idleHook;
+    CPU_CRITICAL_EXIT();
+}
+
+uint32_t tickless_wakeups (void) {
+    return wakeups;
+}
+
+OS_TICK tickless_idleTicks (const OS_TICK_SPOKE* wheel, OS_OBJ_QTY spokes,
+                            OS_TICK now, OS_TICK limit) {
+    OS_TICK nearest = limit;
+    OS_TICK remain;
+    OS_OBJ_QTY i;
+
+    for (i = 0; i < spokes; i++) {
+        if (wheel[i].FirstPtr == (OS_TCB*)0) {
+            continue;
+        }
+
+        /* Unsigned difference: right across a tick counter wrap. */
+        remain = wheel[i].FirstPtr->TickCtrMatch - now;
+
+        if (remain > ((OS_TICK)-1 / 2u)) {
+            /* Passed and not yet handled. */
+            return 0;
+        }
+
+        if (remain < nearest) {
+            nearest = remain;
+        }
+    }
+
+    return nearest;
+}
+
+uint16_t tickless_crossings (uint16_t phase, uint32_t elapsed,
+                             uint16_t phaseNow, uint32_t period) {
+    int32_t counts = (int32_t)phase + (int32_t)elapsed - (int32_t)phaseNow;
+
+    if (counts <= 0) {
+        return 0;
+    }
+
+    return (uint16_t)(((uint32_t)counts + (period / 2u)) / period);
+}
+
+static void tickless_idleHook (void) {
+    OS_ERR err;
+#if (TICKLESS_ENABLED)
+    uint32_t period;
+    uint32_t elapsed;
+    OS_TICK ticks;
+    uint16_t phase;
+    uint16_t phaseNow;
+    uint16_t crossings;
+    bool matched;
+    bool pending;
+#endif
+
+    /* Interrupts still run, but a task they ready only gets the CPU once
+       the tick count is up to date. */
+    OSSchedLock(&err);
+
+    if (err != OS_ERR_NONE) {
+        return;
+    }
+
+    clrpsw_i();
+
+    if (OS_PrioGetHighest() < (OS_CFG_PRIO_MAX - 1u)) {
+        /* An interrupt readied a task before the lock took effect. */
+        setpsw_i();
+        OSSchedUnlock(&err);
+
+        return;
+    }
+
+#if (TICKLESS_ENABLED)
+    period = (uint32_t)CMT0.CMCOR + 1u;
+    ticks = tickless_idleTicks(OSCfg_TickWheel, OSCfg_TickWheelSize,
+                               OSTickCtr, (OS_TICK)(65536ul / period));
+
+    if (ticks >= TICKLESS_MIN_TICKS) {
+        /* CMT0 keeps counting; only its interrupt is held off. */
+        IEN(CMT0,CMI0) = 0;
+        phase = CMT0.CMCNT;
+
+        if (IR(CMT0,CMI0) == 0) {
+            /* Match on the CMT0 boundary of the deadline tick. */
+            CMT2.CMCNT = 0;
+            CMT2.CMCOR = (uint16_t)((ticks * period) - phase - 1u);
+            IR(CMT2,CMI2) = 0;
+            IEN(CMT2,CMI2) = 1;
+            CMT.CMSTR1.BIT.STR2 = 1;
+
+            wait();
+            clrpsw_i();
+
+            /* Sleep length: CMT2 clears itself on its match. */
+            CMT.CMSTR1.BIT.STR2 = 0;
+            matched = wakeMatched || (IR(CMT2,CMI2) != 0);
+            elapsed = (uint32_t)CMT2.CMCNT +
+                      (matched ? ((uint32_t)CMT2.CMCOR + 1u) : 0u);
+            IEN(CMT2,CMI2) = 0;
+            IR(CMT2,CMI2) = 0;
+            wakeMatched = false;
+
+            /* Read the pending flag between two counts without a wrap, so
+               it only stands for boundaries counted here. */
+            do {
+                phaseNow = CMT0.CMCNT;
+                pending = (IR(CMT0,CMI0) != 0);
+            } while (CMT0.CMCNT < phaseNow);
+
+            crossings = tickless_crossings(phase, elapsed, phaseNow, period);
+
+            /* The tick ISR takes the pending one once unmasked. */
+            if (pending && (crossings > 0u)) {
+                crossings--;
+            }
+
+            while (crossings > 0u) {
+                OSTaskSemPost(&OSTickTaskTCB, OS_OPT_POST_NO_SCHED, &err);
+                crossings--;
+            }
+
+            wakeups++;
+            IEN(CMT0,CMI0) = 1;
+            setpsw_i();
+            OSSchedUnlock(&err);
+
+            return;
+        }
+
+        /* A tick is due: sleep until it is taken. */
+        IEN(CMT0,CMI0) = 1;
+    }
+#endif
+
+    /* Until the next interrupt, the tick at the latest. */
+    wait();
+
+    wakeups++;
+    setpsw_i();
+    OSSchedUnlock(&err);
+}
+
+
+
+/******************************************************************************
+*                         INTERRUPT SERVICE ROUTINES                          *
+******************************************************************************/
+
+#if (TICKLESS_ENABLED)
+#pragma interrupt (tickless_isr (vect=VECT(CMT2,CMI2)))
+void tickless_isr (void) {
+    wakeMatched = true;
+}
+#endif
@@ -0,0 +1,111 @@
+/**
+    \file tickless.h
+    \brief Header file for the tickless idle library.
+    \details The kernel tick (CMT0) wakes the core on every tick, although
+             the tasks only have work every few ticks: the 10 ms control
+             cycle, the switch debounce poll, the display refresh and the
+             kernel statistic task. The idle task hook installed by
+             tickless_init() puts the core to sleep instead of spinning:
+             \par
+             - it finds the nearest kernel deadline, the first entry of
+               each tick wheel spoke (tickless_idleTicks());
+             - if that is TICKLESS_MIN_TICKS ticks away or more, it masks
+               the tick interrupt, leaves CMT0 counting and starts CMT2 as
+               a one-shot that matches on the CMT0 count boundary of the
+               deadline tick;
+             - it sleeps (WAIT) until CMT2 or any other interrupt wakes it;
+             - it counts the CMT0 periods that went by (tickless_crossings())
+               and hands all but the last to the kernel tick task; the last
+               one is still pending on CMT0 and is taken by the tick ISR
+               when the tick interrupt is unmasked.
+             \par
+             CMT0 is never stopped or reloaded, so the tick grid does not
+             drift: tasks released by the kernel (the controller on its
+             absolute deadline schedule) keep their exact period and phase.
+             Ticks handed to the tick task skip OSTimeTickHook() and round
+             robin; neither is used. The scheduler is locked while the core
+             sleeps, so an interrupt that readies a task switches to it
+             only once the tick count is up to date; the sleep time thus
+             shows in the kernel scheduler lock time measurement.
+             \par
+             A sleep is at most 65536 CMT0 counts long: 10 ticks at 1 kHz
+             and PCLK/8, which covers the control period. With
+             TICKLESS_ENABLED at zero the hook still sleeps, but only until
+             the next interrupt, so every tick wakes the core;
+             tickless_wakeups() counts the wake-ups either way and the
+             diagnostics page shows the rate.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <os.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Tickless idle enable flag (compile time). */
+#define TICKLESS_ENABLED (1)
+
+/** Shortest sleep, in ticks, worth masking the tick for. */
+#define TICKLESS_MIN_TICKS (2u)
+
+/** Interrupt priority of the CMT2 wake-up; kernel-aware. */
+#define TICKLESS_IPL (1u)
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Set up CMT2 and install the idle task hook. Call from the start
+           task, after OS_CPU_TickInit().
+    \return None
+ */
+void tickless_init (void);
+
+/**
+    \brief Get the number of wake-ups from idle sleep since start.
+    \return Wake-up count.
+ */
+uint32_t tickless_wakeups (void);
+
+/**
+    \brief Find the nearest kernel deadline in the tick wheel. The first
+           entry of a spoke is the one of the spoke that expires first.
+    \param wheel Tick wheel spokes.
+    \param spokes Number of spokes.
+    \param now Current tick count.
+    \param limit Longest result.
+    \return Ticks from now to the nearest deadline, up to limit; zero if a
+            deadline is due and not yet handled.
+ */
+OS_TICK tickless_idleTicks (const OS_TICK_SPOKE* wheel, OS_OBJ_QTY spokes,
+                            OS_TICK now, OS_TICK limit);
+
+/**
+    \brief Count the timer periods a sleep went across.
+    \param phase Timer count when the sleep started.
+    \param elapsed Sleep length, in timer counts.
+    \param phaseNow Timer count when the sleep ended.
+    \param period Timer period, in counts.
+    \return Timer period boundaries crossed; rounded, so that a few counts
+            of read skew are absorbed.
+ */
+uint16_t tickless_crossings (uint16_t phase, uint32_t elapsed,
+                             uint16_t phaseNow, uint32_t period);
+
+#endif /* TICKLESS_H */
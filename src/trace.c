@@ -0,0 +1,59 @@
+/**
+    \file trace.c
+    \brief Implementation file for the binary event trace library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpu_core.h>
+#include <os.h>
+#include "trace.h"
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Trace ring; shared with TRACE_RECORD(). */
+TraceBuffer traceBuffer;
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void trace_init (uint32_t frequency) {
+    uint16_t i;
+
+    traceBuffer.enabled = 0u;
+    traceBuffer.head = 0;
+
+    for (i = 0; i < TRACE_SIZE; i++) {
+        traceBuffer.event[i].time = 0;
+        traceBuffer.event[i].type = TRACE_EVENT_NONE;
+        traceBuffer.event[i].arg = 0;
+        traceBuffer.event[i].value = 0;
+    }
+
+    traceBuffer.magic = TRACE_MAGIC;
+    traceBuffer.frequency = frequency;
+    traceBuffer.size = TRACE_SIZE;
+    traceBuffer.eventSize = (uint16_t)sizeof(TraceEvent);
+    traceBuffer.enabled = 1u;
+}
+
+void trace_enable (bool enable) {
+    traceBuffer.enabled = enable ? 1u : 0u;
+}
+
+void trace_taskSwitchHook (void) {
+    TRACE_RECORD(TRACE_EVENT_TASK, OSTCBHighRdyPtr->Prio, 0u);
+}
@@ -0,0 +1,201 @@
+/**
+    \file trace.h
+    \brief Header file for the binary event trace library.
+    \details A fixed-size ring of TRACE_SIZE compact, timestamped events kept
+             in RAM for post-mortem analysis: task switches, ISR entry and
+             exit, control samples, button events and menu transitions.
+             Events are recorded by the TRACE_* macros; the oldest event is
+             overwritten once the ring is full.
+             \par
+             Recording never waits: a macro claims the next slot and fills
+             it with interrupts masked for a handful of instructions (a flag
+             test, a timer read and five stores), so tasks and kernel-aware
+             ISRs may record at any time without a lock. Interrupts above
+             the kernel priority (the fast loop) are not masked by the
+             critical section and must not record.
+             \par
+             The whole traceBuffer structure is the dump format: stop the
+             target (or call trace_enable(false) to freeze it), save
+             sizeof(traceBuffer) bytes from &traceBuffer to a binary file
+             and run the host decoder, tools/traceDecode.c, to get a
+             Chrome/Perfetto timeline JSON.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpu_core.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Event trace enable flag (compile time). */
+#define TRACE_ENABLED (1)
+
+/** Events kept in the ring; a power of two. 8 bytes each. */
+#define TRACE_SIZE (1024u)
+
+#if (TRACE_SIZE & (TRACE_SIZE - 1u)) || (TRACE_SIZE > 32768u)
+#error "TRACE_SIZE must be a power of two, up to 32768."
+#endif
+
+/** Ring index mask. */
+#define TRACE_MASK (TRACE_SIZE - 1u)
+
+/** Dump header magic: "TRC1" when read as little-endian bytes. */
+#define TRACE_MAGIC (0x31435254ul)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Event types. The host decoder knows these values. */
+enum TraceEventType {
+    TRACE_EVENT_NONE,       /**< Unused slot. */
+    TRACE_EVENT_TASK,       /**< Task switch; arg: priority switched in. */
+    TRACE_EVENT_ISR_ENTER,  /**< ISR entry; arg: TraceIsrType. */
+    TRACE_EVENT_ISR_EXIT,   /**< ISR exit; arg: TraceIsrType. */
+    TRACE_EVENT_SAMPLE,     /**< Control sample; arg: signal, value: raw. */
+    TRACE_EVENT_BUTTON,     /**< Button; arg: debounce key event. */
+    TRACE_EVENT_MENU,       /**< Menu transition; arg: from, value: to. */
+    TRACE_EVENTS            /**< Number of event types. */
+};
+
+/** Traced interrupt service routines. */
+enum TraceIsrType {
+    TRACE_ISR_SW1,          /**< Switch 1. */
+    TRACE_ISR_SW2,          /**< Switch 2. */
+    TRACE_ISR_SW3,          /**< Switch 3. */
+    TRACE_ISR_ADC_BLOCK,    /**< S12ADC block complete. */
+    TRACE_ISR_MODBUS,       /**< Modbus frame end. */
+    TRACE_ISR_CONSOLE,      /**< Console line end or reply end. */
+    TRACE_ISRS              /**< Number of traced ISRs. */
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Timestamp source: free running timer counts. */
+#ifndef TRACE_NOW
+#define TRACE_NOW() ((uint32_t)CPU_TS_TmrRd())
+#endif
+
+/** Record an event, if enabled. Arguments are evaluated with interrupts
+    masked; keep them to plain variables. */
+#if (TRACE_ENABLED)
+#define TRACE_RECORD(eventType, eventArg, eventValue)                       \
+    do {                                                                    \
+        TraceEvent* traceSlot;                                              \
+        CPU_SR_ALLOC();                                                     \
+        CPU_CRITICAL_ENTER();                                               \
+        if (traceBuffer.enabled) {                                          \
+            traceSlot = &traceBuffer.event[traceBuffer.head & TRACE_MASK];  \
+            traceBuffer.head++;                                             \
+            traceSlot->time = TRACE_NOW();                                  \
+            traceSlot->type = (uint8_t)(eventType);                         \
+            traceSlot->arg = (uint8_t)(eventArg);                           \
+            traceSlot->value = (uint16_t)(eventValue);                      \
+        }                                                                   \
+        CPU_CRITICAL_EXIT();                                                \
+    } while (0)
+#else
+#define TRACE_RECORD(eventType, eventArg, eventValue) do { } while (0)
+#endif
+
+/** Record the entry of a kernel-aware ISR. */
+#define TRACE_ISR_ENTER(isr) TRACE_RECORD(TRACE_EVENT_ISR_ENTER, (isr), 0u)
+
+/** Record the exit of a kernel-aware ISR. */
+#define TRACE_ISR_EXIT(isr) TRACE_RECORD(TRACE_EVENT_ISR_EXIT, (isr), 0u)
+
+/** Record a control sample of a signal, in raw units. */
+#define TRACE_SAMPLE(signal, raw) \
+    TRACE_RECORD(TRACE_EVENT_SAMPLE, (signal), (raw))
+
+/** Record a debounced key event. */
+#define TRACE_BUTTON(keyEvent) TRACE_RECORD(TRACE_EVENT_BUTTON, (keyEvent), 0u)
+
+/** Record a menu state transition. */
+#define TRACE_MENU(from, to) TRACE_RECORD(TRACE_EVENT_MENU, (from), (to))
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Trace event: 8 bytes. */
+typedef struct TraceEvent_struct {
+    uint32_t time;          /**< Timestamp, in timer counts. */
+    uint8_t type;           /**< Event type. */
+    uint8_t arg;            /**< Type dependent argument. */
+    uint16_t value;         /**< Type dependent value. */
+} TraceEvent;
+
+/** Trace ring; also the dump format, so the layout is fixed: a 20 byte
+    header, then the events. */
+typedef struct TraceBuffer_struct {
+    uint32_t magic;         /**< TRACE_MAGIC once initialized. */
+    uint32_t frequency;     /**< Timestamp timer frequency, in Hz. */
+    uint16_t size;          /**< Events in the ring, TRACE_SIZE. */
+    uint16_t eventSize;     /**< Bytes per event. */
+    volatile uint32_t head; /**< Events recorded; next slot is head & mask. */
+    volatile uint8_t enabled;           /**< Run-time enable. */
+    uint8_t reserved[3];                /**< Header padding. */
+    TraceEvent event[TRACE_SIZE];       /**< Event ring. */
+} TraceBuffer;
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/** Trace ring; only written by TRACE_RECORD(). */
+extern TraceBuffer traceBuffer;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Initialize the trace ring, empty and enabled.
+    \param frequency Timestamp timer frequency, in Hz.
+    \return None
+ */
+void trace_init (uint32_t frequency);
+
+/**
+    \brief Start or stop recording at run time. Stopping freezes the ring
+           for a dump.
+    \param enable True to record events.
+    \return None
+ */
+void trace_enable (bool enable);
+
+/**
+    \brief Record a task switch. Installed as the uC/OS-III application task
+           switch hook; called by the kernel with interrupts disabled.
+    \return None
+ */
+void trace_taskSwitchHook (void);
+
+#endif /* TRACE_H */
@@ -0,0 +1,200 @@
+/**
+    \file trend.c
+    \brief Implementation file for the PV/SP trend chart library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "memBarrier.h"
+#include "trend.h"
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Column ring; column n is stored at n % TREND_COLUMNS. */
+static TrendColumn columns[TREND_COLUMNS];
+
+/** Number of columns completed since start (sampling task). */
+static volatile uint32_t completed = 0;
+
+/** Number of columns drawn since start (UI). */
+static uint32_t drawn = 0;
+
+/** Samples accumulated into the column in progress. */
+static uint16_t sampleCount = 0;
+
+/** Process variable minimum of the column in progress. */
+static int16_t pvMin = INT16_MAX;
+
+/** Process variable maximum of the column in progress. */
+static int16_t pvMax = INT16_MIN;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Scale a raw value to chart pixels from the bottom.
+    \param raw Raw value, clamped to 0 - TREND_FULL_SCALE.
+    \return Pixels from the bottom (0 - TREND_HEIGHT-1).
+ */
+static uint8_t trend_scale (int16_t raw);
+
+/**
+    \brief Draw one column; a null column erases it.
+    \param writer Page writer.
+    \param x Column position.
+    \param column Pointer to column data, or null.
+    \return None
+ */
+static void trend_drawColumn (TrendWriter writer, uint8_t x,
+                              const TrendColumn* column);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+bool trend_sample (int16_t pv, int16_t sp) {
+    TrendColumn* column;
+    uint32_t index = completed;
+
+    if (pv < pvMin) {
+        pvMin = pv;
+    }
+
+    if (pv > pvMax) {
+        pvMax = pv;
+    }
+
+    if (++sampleCount < TREND_SAMPLES_PER_COLUMN) {
+        return false;
+    }
+
+    column = &columns[index % TREND_COLUMNS];
+    column->pvMin = trend_scale(pvMin);
+    column->pvMax = trend_scale(pvMax);
+    column->sp    = trend_scale(sp);
+
+    /* Start the next column. */
+    sampleCount = 0;
+    pvMin = INT16_MAX;
+    pvMax = INT16_MIN;
+
+    /* Column must be stored before it is made visible. */
+    MEM_BARRIER_RELEASE();
+    completed = index + 1u;
+
+    return true;
+}
+
+uint8_t trend_render (TrendWriter writer) {
+    uint32_t done = completed;
+    uint8_t count = 0;
+    uint8_t x;
+
+    /* Column must be read after it was seen as completed. */
+    MEM_BARRIER_ACQUIRE();
+
+    /* Columns already overwritten in the ring cannot be drawn. */
+    if ((done - drawn) > TREND_COLUMNS) {
+        drawn = done - TREND_COLUMNS;
+    }
+
+    while (drawn != done) {
+        x = (uint8_t)(drawn % TREND_COLUMNS);
+        trend_drawColumn(writer, x, &columns[x]);
+        drawn++;
+        count++;
+    }
+
+    if (count > 0u) {
+        /* Move the gap ahead of the newest column. */
+        trend_drawColumn(writer, (uint8_t)(done % TREND_COLUMNS), NULL);
+    }
+
+    return count;
+}
+
+void trend_redraw (TrendWriter writer) {
+    uint32_t done = completed;
+    uint8_t x;
+
+    MEM_BARRIER_ACQUIRE();
+
+    for (x = 0; x < TREND_COLUMNS; x++) {
+        if ((done >= TREND_COLUMNS) || (x < done)) {
+            trend_drawColumn(writer, x, &columns[x]);
+        } else {
+            trend_drawColumn(writer, x, NULL);
+        }
+    }
+
+    trend_drawColumn(writer, (uint8_t)(done % TREND_COLUMNS), NULL);
+
+    drawn = done;
+}
+
+static uint8_t trend_scale (int16_t raw) {
+    if (raw < 0) {
+        raw = 0;
+    } else if (raw > TREND_FULL_SCALE) {
+        raw = TREND_FULL_SCALE;
+    }
+
+    return (uint8_t)((((int32_t)raw * (TREND_HEIGHT - 1u)) +
+                      (TREND_FULL_SCALE / 2)) / TREND_FULL_SCALE);
+}
+
+static void trend_drawColumn (TrendWriter writer, uint8_t x,
+                              const TrendColumn* column) {
+    uint8_t page;
+    uint8_t top;
+    uint8_t bottom;
+    uint8_t first;
+    uint8_t last;
+    uint8_t spRow;
+    uint8_t pvBits;
+    uint8_t spBits;
+
+    for (page = 0; page < TREND_PAGES; page++) {
+        pvBits = 0;
+        spBits = 0;
+
+        if (column != NULL) {
+            /* Pixel rows counted from the top. */
+            top    = (uint8_t)(TREND_HEIGHT - 1u - column->pvMax);
+            bottom = (uint8_t)(TREND_HEIGHT - 1u - column->pvMin);
+            spRow  = (uint8_t)(TREND_HEIGHT - 1u - column->sp);
+
+            /* PV min-max span clipped to this page. */
+            first = (top > (page * 8u)) ? top : (uint8_t)(page * 8u);
+            last  = (bottom < (page * 8u + 7u)) ? bottom :
+                                                  (uint8_t)(page * 8u + 7u);
+
+            if (first <= last) {
+                pvBits = (uint8_t)((0xFFu >> (7u - (last - first))) <<
+                                   (first - page * 8u));
+            }
+
+            if ((spRow / 8u) == page) {
+                spBits = (uint8_t)(1u << (spRow % 8u));
+            }
+        }
+
+        (*writer)(x, page, pvBits, spBits);
+    }
+}
@@ -0,0 +1,102 @@
+/**
+    \file trend.h
+    \brief Header file for the PV/SP trend chart library.
+    \details ControllerTask feeds every loop sample to trend_sample(), which
+             decimates TREND_SAMPLES_PER_COLUMN samples into one chart
+             column holding the PV minimum and maximum and the last SP.
+             Columns are kept in a ring of TREND_COLUMNS entries, written
+             only by the sampling task and read only by the UI.
+             \par
+             The chart is drawn in sweep mode: each new column overwrites
+             the oldest one in place and the column after it is erased as
+             a moving gap, so an update writes two columns instead of
+             scrolling the whole chart. Drawing goes through a writer
+             callback that receives one 8-pixel page of a column at a time
+             (bit 0 is the top pixel), so the same renderer serves a pixel
+             display or a character-cell one.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef TREND_H
+#define TREND_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Number of chart columns. */
+#define TREND_COLUMNS (16u)
+
+/** Number of 8-pixel pages in the chart height. */
+#define TREND_PAGES (6u)
+
+/** Chart height in pixels. */
+#define TREND_HEIGHT (TREND_PAGES * 8u)
+
+/** Loop samples per column: 15 s at 100 Hz, 4 minutes over the chart. */
+#define TREND_SAMPLES_PER_COLUMN (1500u)
+
+/** Full scale raw value (0 - 1023). */
+#define TREND_FULL_SCALE (1023)
+
+#if (TREND_PAGES > 32u)
+#error "TREND_PAGES too large for 8-bit pixel rows."
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Chart column; values in pixels from the bottom (0 - TREND_HEIGHT-1). */
+typedef struct TrendColumn_struct {
+    uint8_t pvMin;      /**< Process variable minimum. */
+    uint8_t pvMax;      /**< Process variable maximum. */
+    uint8_t sp;         /**< Setpoint at the end of the column. */
+} TrendColumn;
+
+/** Chart page writer: column x (0 - TREND_COLUMNS-1), page (0 is the top)
+    and the PV and SP pixels of that page, bit 0 on top. */
+typedef void (*TrendWriter)(uint8_t x, uint8_t page, uint8_t pvBits,
+                            uint8_t spBits);
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Add a loop sample. Only the sampling task may call this.
+    \param pv Process variable raw value.
+    \param sp Setpoint raw value.
+    \return True if the sample completed a column.
+ */
+bool trend_sample (int16_t pv, int16_t sp);
+
+/**
+    \brief Draw the columns completed since the last draw, plus the gap.
+    \param writer Page writer.
+    \return Number of new columns drawn.
+ */
+uint8_t trend_render (TrendWriter writer);
+
+/**
+    \brief Draw the whole chart.
+    \param writer Page writer.
+    \return None
+ */
+void trend_redraw (TrendWriter writer);
+
+#endif /* TREND_H */
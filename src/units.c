@@ -0,0 +1,125 @@
+/**
+    \file units.c
+    \brief Implementation file for the engineering unit conversion library.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "units.h"
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Precompute round(x * num / den) for 0 <= x <= den.
+    \details round(x * num / den) is floor(n / d) with n = 2 * x * num + den
+             and d = 2 * den. With 2^shift >= nMax * d and
+             mul = ceil(2^shift / d), the error of mul is below d, so
+             (n * mul) >> shift equals floor(n / d) for every n <= nMax.
+    \param scale Pointer to the scale to prepare.
+    \param num Numerator; num * den <= UNITS_MAX_SPAN_PRODUCT.
+    \param den Denominator, not zero.
+    \return None
+ */
+static void units_scaleInit (UnitsScale* scale, uint32_t num, uint32_t den);
+
+/**
+    \brief Apply a precomputed scale.
+    \param scale Pointer to the scale.
+    \param x Value to scale, 0 - den.
+    \return round(x * num / den).
+ */
+static uint32_t units_scale (const UnitsScale* scale, uint32_t x);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+bool units_init (UnitsRange* range, const UnitsConfig* config) {
+    uint32_t rawSpan;
+    uint32_t euSpan;
+
+    if ((config->rawMax <= config->rawMin) ||
+        (config->euMax <= config->euMin)) {
+        return false;
+    }
+
+    rawSpan = (uint32_t)((int32_t)config->rawMax - config->rawMin);
+    euSpan  = (uint32_t)config->euMax - (uint32_t)config->euMin;
+
+    if ((euSpan > UNITS_MAX_SPAN_PRODUCT) ||
+        (((uint64_t)rawSpan * euSpan) > UNITS_MAX_SPAN_PRODUCT)) {
+        return false;
+    }
+
+    range->config = config;
+    units_scaleInit(&range->toEu, euSpan, rawSpan);
+    units_scaleInit(&range->toRaw, rawSpan, euSpan);
+
+    return true;
+}
+
+int32_t units_toEu (const UnitsRange* range, int16_t raw) {
+    const UnitsConfig* config = range->config;
+
+    if (raw <= config->rawMin) {
+        return config->euMin;
+    }
+
+    if (raw >= config->rawMax) {
+        return config->euMax;
+    }
+
+    return config->euMin + (int32_t)units_scale(&range->toEu,
+                              (uint32_t)((int32_t)raw - config->rawMin));
+}
+
+int16_t units_toRaw (const UnitsRange* range, int32_t eu) {
+    const UnitsConfig* config = range->config;
+
+    if (eu <= config->euMin) {
+        return config->rawMin;
+    }
+
+    if (eu >= config->euMax) {
+        return config->rawMax;
+    }
+
+    return (int16_t)(config->rawMin + (int32_t)units_scale(&range->toRaw,
+                                          (uint32_t)eu -
+                                          (uint32_t)config->euMin));
+}
+
+static void units_scaleInit (UnitsScale* scale, uint32_t num, uint32_t den) {
+    uint64_t divisor = 2u * (uint64_t)den;
+    uint64_t limit = (2u * (uint64_t)num + 1u) * den * divisor;
+    uint8_t shift = 0;
+
+    /* Smallest shift that keeps the reciprocal exact up to x = den. */
+    while (((uint64_t)1u << shift) < limit) {
+        shift++;
+    }
+
+    scale->num2  = 2u * num;
+    scale->den   = den;
+    scale->mul   = (uint32_t)((((uint64_t)1u << shift) + divisor - 1u) /
+                              divisor);
+    scale->shift = shift;
+}
+
+static uint32_t units_scale (const UnitsScale* scale, uint32_t x) {
+    /* 32 x 32 -> 64 bit product; no division. */
+    return (uint32_t)(((uint64_t)(x * scale->num2 + scale->den) *
+                       scale->mul) >> scale->shift);
+}
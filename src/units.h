@@ -0,0 +1,102 @@
+/**
+    \file units.h
+    \brief Header file for the engineering unit conversion library.
+    \details A signal range maps raw converter counts (rawMin - rawMax) to
+             engineering units (euMin - euMax), e.g. 0 - 1023 counts to
+             0 - 100 %, 0.00 - 3.30 V or -40.0 - 150.0 C. Engineering values
+             are integers scaled by 10^decimals, so 1.25 V with 2 decimals
+             is 125.
+             \par
+             Both directions round to the nearest value, halves away from
+             the range minimum, so a value converted to raw and back is
+             unchanged whenever the raw span is at least the engineering
+             span. units_init() precomputes a reciprocal multiplier for
+             each direction; the conversions themselves only multiply, add
+             and shift, and are exact over the whole range (inputs outside
+             it are clamped).
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef UNITS_H
+#define UNITS_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Largest raw span times engineering span; keeps products in 32 bits. */
+#define UNITS_MAX_SPAN_PRODUCT (0x1FFFFFFFuL)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Signal range configuration; minimums below maximums. */
+typedef struct UnitsConfig_struct {
+    int16_t rawMin;         /**< Raw value at the bottom of the range. */
+    int16_t rawMax;         /**< Raw value at the top of the range. */
+    int32_t euMin;          /**< Scaled engineering value at the bottom. */
+    int32_t euMax;          /**< Scaled engineering value at the top. */
+    uint8_t decimals;       /**< Decimals in the engineering values. */
+    const char* unit;       /**< Unit text, up to 3 characters. */
+} UnitsConfig;
+
+/** Precomputed round(x * num / den) for 0 <= x <= den. */
+typedef struct UnitsScale_struct {
+    uint32_t num2;          /**< Twice the numerator. */
+    uint32_t den;           /**< Denominator. */
+    uint32_t mul;           /**< Reciprocal of twice the denominator. */
+    uint8_t shift;          /**< Reciprocal scale, in bits. */
+} UnitsScale;
+
+/** Signal range ready for conversion. */
+typedef struct UnitsRange_struct {
+    const UnitsConfig* config;  /**< Range configuration. */
+    UnitsScale toEu;            /**< Raw to engineering units. */
+    UnitsScale toRaw;           /**< Engineering units to raw. */
+} UnitsRange;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Prepare a signal range for conversion.
+    \param range Pointer to the range to prepare.
+    \param config Pointer to the range configuration; must stay valid.
+    \return False if the configuration is invalid: an empty or reversed
+            span, or spans whose product exceeds UNITS_MAX_SPAN_PRODUCT.
+ */
+bool units_init (UnitsRange* range, const UnitsConfig* config);
+
+/**
+    \brief Convert a raw value to engineering units.
+    \param range Pointer to a prepared range.
+    \param raw Raw value, clamped to the range.
+    \return Scaled engineering value, rounded to nearest.
+ */
+int32_t units_toEu (const UnitsRange* range, int16_t raw);
+
+/**
+    \brief Convert an engineering value to raw.
+    \param range Pointer to a prepared range.
+    \param eu Scaled engineering value, clamped to the range.
+    \return Raw value, rounded to nearest.
+ */
+int16_t units_toRaw (const UnitsRange* range, int32_t eu);
+
+#endif /* UNITS_H */
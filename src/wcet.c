@@ -0,0 +1,453 @@
+/**
+    \file wcet.c
+    \brief Implementation file for the execution time measurement harness.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cpu_core.h>
+#include "format.h"
+#include "units.h"
+#include "controller.h"
+#include "controllerSysControl.h"
+#include "menu.h"
+#include "fastLoop.h"
+#include "wcet.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Timer read overhead calibration runs. */
+#define WCET_CALIBRATION_RUNS (32u)
+
+/** Maximum values swept over a unit range; wider ranges are stepped. */
+#define WCET_SWEEP_STEPS (1024u)
+
+/** Calls of printMainMenu(). */
+#define WCET_MAIN_MENU_RUNS (8u)
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Time one call with interrupts masked and count it. */
+#define WCET_MEASURE(function, call)                                        \
+    do {                                                                    \
+        uint32_t start;                                                     \
+        uint32_t elapsed;                                                   \
+        CPU_SR_ALLOC();                                                     \
+        CPU_CRITICAL_ENTER();                                               \
+        start = WCET_NOW();                                                 \
+        call;                                                               \
+        elapsed = WCET_NOW() - start;                                       \
+        CPU_CRITICAL_EXIT();                                                \
+        wcet_count((function), elapsed);                                    \
+    } while (0)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern PIDControl pid;
+extern MenuControl menu;
+extern const UnitsConfig signalUnitsConfig[SIGNALS];
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Results, per function. */
+static WcetResult results[WCET_FUNCTIONS];
+
+/** Function names, in WcetFunctionType order. */
+static const char* const names[WCET_FUNCTIONS] = {
+    "getOP_PID", "insertArray", "toValue", "toRaw", "printMainMenu",
+    "printSP", "printOP", "printPV", "menuDispatch", "fastLoop_step"
+};
+
+/** Error and output history values: zero, the smallest steps, mid scale
+    and the limits of the reachable range, so both clamps are taken. */
+static const int16_t pidValues[] = {
+    0, 1, -1, (U_MAX / 2), -(U_MAX / 2), (U_MAX - U_MIN), -(U_MAX - U_MIN)
+};
+
+/** Number of PID history values. */
+#define PID_VALUES (sizeof(pidValues) / sizeof(pidValues[0]))
+
+/** Menu states the value printers behave differently in. */
+static const uint8_t printStates[] = {
+    MENU_ON_OFF_VIEW, MENU_SP_EDIT, MENU_OP_EDIT
+};
+
+/** Number of printer menu states. */
+#define PRINT_STATES (sizeof(printStates) / sizeof(printStates[0]))
+
+/** Timer read overhead, subtracted from every call. */
+static uint32_t overhead = 0;
+
+/** WCET_NOW() frequency, in Hz. */
+static uint32_t timerFrequency = 0;
+
+/** Keeps function results alive. */
+static volatile int32_t sink;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Count one call, less the timer read overhead.
+    \param function Function type.
+    \param elapsed Measured time, in timer counts.
+    \return None
+ */
+static void wcet_count (uint8_t function, uint32_t elapsed);
+
+/**
+    \brief Measure the timer read overhead.
+    \return None
+ */
+static void wcet_calibrate (void);
+
+/**
+    \brief Measure getOP_PID() and insertArray().
+    \return None
+ */
+static void wcet_runController (void);
+
+/**
+    \brief Measure toValue() and toRaw() over every signal range.
+    \return None
+ */
+static void wcet_runUnits (void);
+
+/**
+    \brief Measure the print functions.
+    \return None
+ */
+static void wcet_runPrint (void);
+
+/**
+    \brief Measure menuDispatch() for every state and button.
+    \return None
+ */
+static void wcet_runDispatch (void);
+
+/**
+    \brief Measure fastLoop_step() in both modes over the raw range.
+    \return None
+ */
+static void wcet_runFastLoop (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+void wcet_run (uint32_t frequency) {
+    PIDControl pidSaved = pid;
+    MenuControl menuSaved = menu;
+    uint8_t i;
+
+    for (i = 0; i < WCET_FUNCTIONS; i++) {
+        results[i].name = names[i];
+        results[i].cases = 0;
+        results[i].best = UINT32_MAX;
+        results[i].worst = 0;
+        results[i].total = 0;
+    }
+
+    timerFrequency = frequency;
+
+    wcet_calibrate();
+    wcet_runController();
+    wcet_runUnits();
+    wcet_runPrint();
+    wcet_runDispatch();
+    wcet_runFastLoop();
+
+    /* Put the LEDs back with the commit effects, then the state itself. */
+    pid = pidSaved;
+    menu = menuSaved;
+    menu.activeTemp = pid.active;
+    onOffCommit();
+    menu.modeTemp = pid.mode;
+    manAutCommit();
+
+    pid = pidSaved;
+    menu = menuSaved;
+    printMainMenu();
+}
+
+const WcetResult* wcet_get (uint8_t function) {
+    return &results[function];
+}
+
+uint16_t wcet_format (char* out) {
+    char* position = out;
+    const WcetResult* result;
+    uint8_t i;
+
+    position = format_append(position, "# wcet timer_hz=");
+    position = format_appendUnsigned(position, timerFrequency, 0u);
+    position = format_append(position, " overhead=");
+    position = format_appendUnsigned(position, overhead, 0u);
+    position = format_append(position, " fast_loop_budget=");
+    position = format_appendUnsigned(position,
+                                     timerFrequency / FAST_LOOP_RATE_HZ, 0u);
+    position = format_append(position, "\nfunction,cases,best,avg,worst\n");
+
+    for (i = 0; i < WCET_FUNCTIONS; i++) {
+        result = &results[i];
+
+        position = format_append(position, result->name);
+        position = format_append(position, ",");
+        position = format_appendUnsigned(position, result->cases, 0u);
+        position = format_append(position, ",");
+        position = format_appendUnsigned(position,
+                                         (result->cases > 0u) ?
+                                         result->best : 0u, 0u);
+        position = format_append(position, ",");
+
+        /* The average is at most the worst case, so it fits. */
+        position = format_appendUnsigned(position,
+                                         (result->cases > 0u) ?
+                                         (uint32_t)(result->total /
+                                                    result->cases) : 0u, 0u);
+        position = format_append(position, ",");
+        position = format_appendUnsigned(position, result->worst, 0u);
+        position = format_append(position, "\n");
+    }
+
+    *position = '\0';
+
+    return (uint16_t)(position - out);
+}
+
+static void wcet_count (uint8_t function, uint32_t elapsed) {
+    WcetResult* result = &results[function];
+
+    elapsed = (elapsed > overhead) ? (elapsed - overhead) : 0u;
+
+    result->cases++;
+    result->total += elapsed;
+
+    if (elapsed < result->best) {
+        result->best = elapsed;
+    }
+
+    if (elapsed > result->worst) {
+        result->worst = elapsed;
+    }
+}
+
+static void wcet_calibrate (void) {
+    uint32_t start;
+    uint32_t elapsed;
+    uint8_t i;
+    CPU_SR_ALLOC();
+
+    overhead = UINT32_MAX;
+
+    /* Back-to-back reads: the fastest pair is the fixed cost of a call's
+       two reads. */
+    for (i = 0; i < WCET_CALIBRATION_RUNS; i++) {
+        CPU_CRITICAL_ENTER();
+        start = WCET_NOW();
+        elapsed = WCET_NOW() - start;
+        CPU_CRITICAL_EXIT();
+
+        if (elapsed < overhead) {
+            overhead = elapsed;
+        }
+    }
+}
+
+static void wcet_runController (void) {
+    int16_t u[3];
+    int16_t e[3];
+    uint8_t i;
+    uint8_t j;
+    uint8_t k;
+    uint8_t m;
+
+    for (m = 0; m < PID_VALUES; m++) {
+        u[0] = (int16_t)(pidValues[m] < U_MIN ? U_MIN : pidValues[m]);
+        u[1] = u[0];
+        u[2] = u[0];
+
+        for (i = 0; i < PID_VALUES; i++) {
+            for (j = 0; j < PID_VALUES; j++) {
+                for (k = 0; k < PID_VALUES; k++) {
+                    e[0] = pidValues[i];
+                    e[1] = pidValues[j];
+                    e[2] = pidValues[k];
+
+                    WCET_MEASURE(WCET_GET_OP_PID, sink = getOP_PID(u, e));
+                }
+            }
+        }
+
+        WCET_MEASURE(WCET_INSERT_ARRAY, insertArray(e, pidValues[m]));
+    }
+}
+
+static void wcet_runUnits (void) {
+    const UnitsConfig* config;
+    uint8_t signal;
+    uint32_t step;
+    int32_t value;
+    int32_t raw;
+
+    for (signal = 0; signal < SIGNALS; signal++) {
+        config = &signalUnitsConfig[signal];
+
+        /* Every raw value, or evenly stepped, plus one past each limit. */
+        step = ((uint32_t)((int32_t)config->rawMax - config->rawMin) /
+                WCET_SWEEP_STEPS) + 1u;
+
+        for (raw = (int32_t)config->rawMin - 1;
+             raw <= (int32_t)config->rawMax + 1; raw += (int32_t)step) {
+            WCET_MEASURE(WCET_TO_VALUE,
+                         sink = toValue(signal, (int16_t)raw));
+        }
+
+        WCET_MEASURE(WCET_TO_VALUE, sink = toValue(signal, INT16_MIN));
+        WCET_MEASURE(WCET_TO_VALUE, sink = toValue(signal, INT16_MAX));
+
+        step = (((uint32_t)config->euMax - (uint32_t)config->euMin) /
+                WCET_SWEEP_STEPS) + 1u;
+
+        for (value = config->euMin - 1; value <= config->euMax + 1;
+             value += (int32_t)step) {
+            WCET_MEASURE(WCET_TO_RAW, sink = toRaw(signal, value));
+        }
+
+        WCET_MEASURE(WCET_TO_RAW, sink = toRaw(signal, INT32_MIN));
+        WCET_MEASURE(WCET_TO_RAW, sink = toRaw(signal, INT32_MAX));
+    }
+}
+
+static void wcet_runPrint (void) {
+    PIDSnapshot state;
+    uint8_t limit;
+    uint8_t mode;
+    uint8_t s;
+    uint8_t i;
+
+    for (i = 0; i < WCET_MAIN_MENU_RUNS; i++) {
+        WCET_MEASURE(WCET_PRINT_MAIN_MENU, printMainMenu());
+    }
+
+    state.active = PID_ON;
+    state.er = 0;
+
+    for (mode = PID_MAN; mode <= PID_AUTO; mode++) {
+        state.mode = mode;
+
+        for (s = 0; s < PRINT_STATES; s++) {
+            menu.state = printStates[s];
+
+            /* Shortest and longest values of each range. */
+            for (limit = 0; limit < 2u; limit++) {
+                state.sp = limit ? signalUnitsConfig[SIGNAL_SP].rawMax :
+                                   signalUnitsConfig[SIGNAL_SP].rawMin;
+                state.op = limit ? signalUnitsConfig[SIGNAL_OP].rawMax :
+                                   signalUnitsConfig[SIGNAL_OP].rawMin;
+                state.pv = limit ? signalUnitsConfig[SIGNAL_PV].rawMax :
+                                   signalUnitsConfig[SIGNAL_PV].rawMin;
+                pid.spValue = limit ? signalUnitsConfig[SIGNAL_SP].euMax :
+                                      signalUnitsConfig[SIGNAL_SP].euMin;
+                pid.opValue = limit ? signalUnitsConfig[SIGNAL_OP].euMax :
+                                      signalUnitsConfig[SIGNAL_OP].euMin;
+                menu.spTemp = pid.spValue;
+                menu.opTemp = pid.opValue;
+
+                WCET_MEASURE(WCET_PRINT_SP, printSP(&state));
+                WCET_MEASURE(WCET_PRINT_OP, printOP(&state));
+                WCET_MEASURE(WCET_PRINT_PV, printPV(&state));
+            }
+        }
+    }
+}
+
+static void wcet_runDispatch (void) {
+    uint8_t action;
+    uint8_t limit;
+    uint8_t mode;
+    uint8_t state;
+
+    for (mode = PID_MAN; mode <= PID_AUTO; mode++) {
+        for (limit = 0; limit < 2u; limit++) {
+            for (state = 0; state < MENU_STATES; state++) {
+                /* One out-of-range action on each side. */
+                for (action = 0; action <= MENU_BUTTONS + 1u; action++) {
+                    pid.mode = mode;
+                    pid.active = limit ? PID_ON : PID_OFF;
+                    pid.spValue = limit ? signalUnitsConfig[SIGNAL_SP].euMax :
+                                          signalUnitsConfig[SIGNAL_SP].euMin;
+                    pid.opValue = limit ? signalUnitsConfig[SIGNAL_OP].euMax :
+                                          signalUnitsConfig[SIGNAL_OP].euMin;
+                    menu.spTemp = pid.spValue;
+                    menu.opTemp = pid.opValue;
+                    menu.state = state;
+                    menu.activeTemp = pid.active;
+                    menu.modeTemp = mode;
+
+                    WCET_MEASURE(WCET_MENU_DISPATCH,
+                                 sink = menuDispatch(action));
+                }
+            }
+        }
+    }
+}
+
+static void wcet_runFastLoop (void) {
+    int16_t value[PID_VALUES];
+    uint8_t mode;
+    uint8_t i;
+    uint8_t j;
+    uint16_t k;
+
+    /* Raw values only: fastLoop_step() takes DAC counts. */
+    for (i = 0; i < PID_VALUES; i++) {
+        value[i] = (int16_t)((pidValues[i] < U_MIN) ? U_MIN : pidValues[i]);
+    }
+
+    for (mode = PID_MAN; mode <= PID_AUTO; mode++) {
+        pid.mode = mode;
+
+        for (i = 0; i < PID_VALUES; i++) {
+            pid.sp = value[i];
+            pid.op = value[i];
+
+            for (j = 0; j < PID_VALUES; j++) {
+                /* A whole window, toggling the PV LSB, so the extremes
+                   are tracked and the snapshot published. */
+                for (k = 0; k < FAST_LOOP_DECIMATION; k++) {
+                    WCET_MEASURE(WCET_FAST_LOOP_STEP,
+                                 sink = fastLoop_step((int16_t)(value[j] ^
+                                                               (k & 1u))));
+                }
+            }
+        }
+    }
+}
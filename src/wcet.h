@@ -0,0 +1,140 @@
+/**
+    \file wcet.h
+    \brief Header file for the execution time measurement harness.
+    \details wcet_run() calls every hot function of the controller and the
+             user interface over a fixed set of adversarial inputs and
+             keeps the best, average and worst execution time of each:
+             - getOP_PID(): errors and outputs at zero, the raw limits and
+               the int16_t limits, so both clamps are taken;
+             - insertArray();
+             - toValue() and toRaw(): every raw value plus both sides of
+               each range limit;
+             - printMainMenu(), printSP(), printOP() and printPV(), in view
+               and edit states and in both controller modes;
+             - menuDispatch(), which runs the transition effects, for every
+               menu state and button, in both controller modes and with the
+               edited values at their limits;
+             - fastLoop_step(), the body of the fast loop interrupt, in
+               both controller modes with the setpoint and PV across the
+               raw range, over whole decimation windows so the snapshot is
+               published; the table header gives its budget, the timer
+               counts of one FAST_LOOP_RATE_HZ period.
+             \par
+             Each call is timed alone between two WCET_NOW() reads with
+             interrupts masked; the cost of the reads is measured first
+             and subtracted. wcet_format() writes the results as a CSV
+             table. The harness saves and restores the controller and menu
+             state, then redraws the main menu.
+             \par
+             The same cases run on the target (WCET_ENABLED, from the start
+             task) and on the host with tools/wcetHost.c, so a regression
+             in the hot path shows up before flashing.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef WCET_H
+#define WCET_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Run the harness at start-up (compile time); measurement builds only. */
+#define WCET_ENABLED (0)
+
+/** Characters of one CSV line, terminator included. */
+#define WCET_LINE_SIZE (80u)
+
+/** Buffer size that holds the whole CSV table. */
+#define WCET_TEXT_SIZE ((WCET_FUNCTIONS + 2u) * WCET_LINE_SIZE)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Measured functions. */
+enum WcetFunctionType {
+    WCET_GET_OP_PID,        /**< getOP_PID(). */
+    WCET_INSERT_ARRAY,      /**< insertArray(). */
+    WCET_TO_VALUE,          /**< toValue(). */
+    WCET_TO_RAW,            /**< toRaw(). */
+    WCET_PRINT_MAIN_MENU,   /**< printMainMenu(). */
+    WCET_PRINT_SP,          /**< printSP(). */
+    WCET_PRINT_OP,          /**< printOP(). */
+    WCET_PRINT_PV,          /**< printPV(). */
+    WCET_MENU_DISPATCH,     /**< menuDispatch() and transition effects. */
+    WCET_FAST_LOOP_STEP,    /**< fastLoop_step(). */
+    WCET_FUNCTIONS          /**< Number of measured functions. */
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Timestamp source: free running timer counts. */
+#ifndef WCET_NOW
+#define WCET_NOW() ((uint32_t)CPU_TS_TmrRd())
+#endif
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Execution times of one function, in timer counts. */
+typedef struct WcetResult_struct {
+    const char* name;       /**< Function name. */
+    uint32_t cases;         /**< Calls measured. */
+    uint32_t best;          /**< Shortest call. */
+    uint32_t worst;         /**< Longest call. */
+    uint64_t total;         /**< Sum of all calls. */
+} WcetResult;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Measure every function over every case. Run before the tasks
+           that use the controller and menu state are created.
+    \param frequency WCET_NOW() frequency, in Hz, for the table header;
+           zero if unknown.
+    \return None
+ */
+void wcet_run (uint32_t frequency);
+
+/**
+    \brief Get the results of one function.
+    \param function Function type.
+    \return Pointer to the results.
+ */
+const WcetResult* wcet_get (uint8_t function);
+
+/**
+    \brief Export the results as CSV: a comment line with the timer
+           frequency, the read overhead subtracted and the fast loop
+           budget, a column header,
+           then "function,cases,best,avg,worst" per function.
+    \param out Buffer receiving the text; see WCET_TEXT_SIZE.
+    \return Number of characters written, without the terminator.
+ */
+uint16_t wcet_format (char* out);
+
+#endif /* WCET_H */
@@ -0,0 +1,373 @@
+/**
+    \file adcBlockHost.c
+    \brief Host test for the block acquisition and block filter kernels.
+    \details Runs src/blockFilter.c and src/adcBlock.c on the development
+             host, with the stand-in headers of tools/host for the board and
+             kernel. adcBlock.c is included, so that its interrupt service
+             routine can be called, and a simulated DTC moves each
+             conversion into the block its transfer information points at:
+             \par
+             - blockFilter_decimate() and blockFilter_minMax() against plain
+               references, over random blocks, every factor up to 64, runs
+               that end with a partial window and full-scale samples;
+             - each completed block posts the consumer once and
+               adcBlock_get() returns it whole, with the DTC re-armed on the
+               other half;
+             - a consumer that pends before each adcBlock_get(), as the
+               controller task does, sees every block once and in order;
+             - blocks completed while the consumer was away count as
+               overruns;
+             - the decimation throughput over full blocks.
+             \par
+             The DTC takes 32-bit addresses, cut short on a 64-bit host;
+             the simulated DTC adds them back to the block base. Built and
+             run by make -C tools check; add EXTRA_CFLAGS=-U__SSE2__ to time
+             the scalar path on x86.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostTest.h"
+#include "cpu_core.h"
+#include "os.h"
+#include "blockFilter.h"
+#include "adcBlock.c"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Random blocks per decimation factor. */
+#define FILTER_ROUNDS (200u)
+
+/** Largest input block of the filter checks. */
+#define FILTER_BLOCK (1024u)
+
+/** Full-scale S12ADC result. */
+#define ADC_FULL_SCALE (4095u)
+
+/** Samples decimated per throughput measurement. */
+#define BENCH_SAMPLES (20000000ul)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Kernel stand-ins. */
+
+OS_TCB* OSTCBHighRdyPtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Consumer task of the blocks. */
+static OS_TCB consumer;
+
+/** Posts to the consumer: its task semaphore count. */
+static uint32_t posts = 0;
+
+/** Value of the next simulated conversion. */
+static uint16_t nextSample = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the filter kernels against the references.
+    \return None
+ */
+static void testFilter (void);
+
+/**
+    \brief Check the block hand-off with a simulated DTC.
+    \return None
+ */
+static void testBlocks (void);
+
+/**
+    \brief Time full-block decimation.
+    \return None
+ */
+static void benchFilter (void);
+
+/**
+    \brief One conversion: the DTC moves it, and raises the block complete
+           interrupt after the last one of a block.
+    \return None
+ */
+static void convert (void);
+
+/**
+    \brief Check that a block holds consecutive samples.
+    \param block Block.
+    \param first Expected first sample.
+    \return True if it does.
+ */
+static bool blockHolds (const uint16_t* block, uint16_t first);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    srand(1);
+
+    testFilter();
+    testBlocks();
+    benchFilter();
+
+    return hostTest_exit();
+}
+
+void OSIntEnter (void) {
+}
+
+void OSIntExit (void) {
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    (void)opt;
+
+    HOST_CHECK(p_tcb == &consumer);
+    posts++;
+    *p_err = OS_ERR_NONE;
+
+    return (OS_SEM_CTR)posts;
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return 0u;
+}
+
+static void testFilter (void) {
+    static uint16_t in[FILTER_BLOCK];
+    static int16_t out[FILTER_BLOCK];
+    uint32_t mismatches = 0;
+    uint32_t sum;
+    uint16_t factor;
+    uint16_t count;
+    uint16_t written;
+    uint16_t low;
+    uint16_t high;
+    uint16_t i;
+    uint16_t j;
+    uint16_t round;
+
+    for (factor = 1; factor <= 64u; factor++) {
+        for (round = 0; round < FILTER_ROUNDS; round++) {
+            count = (uint16_t)(1u + ((unsigned)rand() % FILTER_BLOCK));
+
+            for (i = 0; i < count; i++) {
+                in[i] = (uint16_t)((round & 1u) ?
+                                   ((unsigned)rand() & ADC_FULL_SCALE) :
+                                   (ADC_FULL_SCALE - (i & 3u)));
+            }
+
+            written = blockFilter_decimate(in, count, factor, out);
+
+            if (written != (count / factor)) {
+                mismatches++;
+            }
+
+            /* Rounded mean, shifted to DAC resolution; a partial window at
+               the end is left out. */
+            for (i = 0; i < written; i++) {
+                sum = 0;
+
+                for (j = 0; j < factor; j++) {
+                    sum += in[(i * factor) + j];
+                }
+
+                if (out[i] != (int16_t)(((sum + (factor / 2u)) / factor) >>
+                                        BLOCK_FILTER_SHIFT)) {
+                    mismatches++;
+                }
+            }
+
+            blockFilter_minMax(in, count, &low, &high);
+
+            for (i = 0; i < count; i++) {
+                if ((in[i] < low) || (in[i] > high)) {
+                    mismatches++;
+                }
+            }
+
+            for (i = 0; (i < count) && (in[i] != low); i++) {
+            }
+
+            for (j = 0; (j < count) && (in[j] != high); j++) {
+            }
+
+            if ((i == count) || (j == count)) {
+                mismatches++;
+            }
+        }
+    }
+
+    HOST_CHECK(mismatches == 0u);
+
+    /* The widest window at full scale: the sum still fits. */
+    for (i = 0; i < FILTER_BLOCK; i++) {
+        in[i] = ADC_FULL_SCALE;
+    }
+
+    HOST_CHECK(blockFilter_decimate(in, FILTER_BLOCK, FILTER_BLOCK, out) ==
+               1u);
+    HOST_CHECK(out[0] == (int16_t)(ADC_FULL_SCALE >> BLOCK_FILTER_SHIFT));
+}
+
+static void testBlocks (void) {
+    const uint16_t* block;
+    uint16_t first;
+    uint32_t i;
+    uint32_t n;
+    uint32_t taken = 0;
+    bool inOrder = true;
+
+    adcBlock_init(&consumer);
+
+    HOST_CHECK(DTCE(S12AD,S12ADI0) == 1u);
+    HOST_CHECK(IEN(S12AD,S12ADI0) == 1u);
+    HOST_CHECK(dtcVectorTable[VECT(S12AD,S12ADI0)] ==
+               (uint32_t)(uintptr_t)&adcTransfer);
+    HOST_CHECK(posts == 0u);
+
+    /* A consumer that pends first: each post stands for one whole
+       block, which adcBlock_get() returns. */
+    for (n = 0; n < 1000u; n++) {
+        first = nextSample;
+
+        for (i = 0; i < ADC_BLOCK_SIZE; i++) {
+            convert();
+
+            if ((i + 1u) < ADC_BLOCK_SIZE) {
+                /* Nothing to take before the block is complete. */
+                inOrder = inOrder && (posts == taken);
+            }
+        }
+
+        inOrder = inOrder && (posts == (taken + 1u));
+        taken = posts;
+
+        block = adcBlock_get();
+        inOrder = inOrder && blockHolds(block, first);
+
+        /* The DTC fills the other half meanwhile. */
+        inOrder = inOrder && (DTCE(S12AD,S12ADI0) == 1u);
+        inOrder = inOrder &&
+                  (adcTransfer.dest == (uint32_t)(uintptr_t)
+                                       &blocks[fillIndex][0]);
+        inOrder = inOrder && (&blocks[fillIndex][0] != block);
+    }
+
+    HOST_CHECK(inOrder);
+    HOST_CHECK(adcBlock_overruns() == 0u);
+
+    /* Three blocks while the consumer was away: two were lost. */
+    for (n = 0; n < 3u; n++) {
+        first = nextSample;
+
+        for (i = 0; i < ADC_BLOCK_SIZE; i++) {
+            convert();
+        }
+    }
+
+    block = adcBlock_get();
+    HOST_CHECK(blockHolds(block, first));
+    HOST_CHECK(adcBlock_overruns() == 2u);
+    HOST_CHECK(posts == (taken + 3u));
+}
+
+static void benchFilter (void) {
+    static uint16_t in[FILTER_BLOCK];
+    static int16_t out[FILTER_BLOCK];
+    volatile int16_t sink = 0;
+    uint16_t count;
+    uint32_t rounds;
+    uint32_t r;
+    double start;
+    double ns;
+
+    for (r = 0; r < FILTER_BLOCK; r++) {
+        in[r] = (uint16_t)((unsigned)rand() & ADC_FULL_SCALE);
+    }
+
+    for (count = 16; count <= FILTER_BLOCK; count = (uint16_t)(count * 4u)) {
+        rounds = (uint32_t)(BENCH_SAMPLES / count);
+        start = hostTest_now();
+
+        for (r = 0; r < rounds; r++) {
+            (void)blockFilter_decimate(in, count, count, out);
+            sink = (int16_t)(sink + out[0]);
+            in[r & (FILTER_BLOCK - 1u)] ^= 1u;
+        }
+
+        ns = hostTest_now() - start;
+
+        printf("decimate %4u samples: %.2f Gsamples/s\n", (unsigned)count,
+               ((double)count * (double)rounds) / ns);
+    }
+
+    (void)sink;
+}
+
+static void convert (void) {
+    uint16_t* dest;
+
+    S12AD.ADDR3 = nextSample++ & ADC_FULL_SCALE;
+
+    if (DTCE(S12AD,S12ADI0) == 0u) {
+        /* Not re-armed: the interrupt would go to the CPU instead. */
+        HOST_CHECK(DTCE(S12AD,S12ADI0) != 0u);
+
+        return;
+    }
+
+    /* DAR holds the low 32 bits of the address; the block is near. */
+    dest = (uint16_t*)(void*)((uint8_t*)blocks +
+           (uint32_t)(adcTransfer.dest - (uint32_t)(uintptr_t)blocks));
+    *dest = S12AD.ADDR3;
+
+    adcTransfer.dest += sizeof(uint16_t);
+    adcTransfer.count -= 1ul << 16;
+
+    if ((adcTransfer.count >> 16) == 0u) {
+        /* Last transfer: DTCE cleared and the CPU interrupted. */
+        DTCE(S12AD,S12ADI0) = 0;
+        adcBlock_isr();
+    }
+}
+
+static bool blockHolds (const uint16_t* block, uint16_t first) {
+    uint16_t i;
+
+    for (i = 0; i < ADC_BLOCK_SIZE; i++) {
+        if (block[i] != ((first + i) & ADC_FULL_SCALE)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,1033 @@
+/**
+    \file consoleSerialHost.c
+    \brief Host test for the serial command console.
+    \details Runs src/consoleSerial.c and src/console.c on the development
+             host, against the real controller, units, statistics, loop
+             timing, trace and memory budget sources. consoleSerial.c is
+             included, so that its interrupt service routines can be
+             called: a simulated SCI0 feeds them the characters of a
+             pseudo-terminal and sends their replies back, and the test
+             is the terminal on its other end:
+             \par
+             - console_split() in place, console_find() on every command
+               of the table and on names around them, console_parseFixed()
+               decimals and limits;
+             - no console without the reclaimed memory pool, the blocks
+               given back when the pool is too small, and the SCI0 8N1 bit
+               rate once started;
+             - each command: settings refused in the wrong mode and out of
+               range or finer than the signal decimals, the value applied
+               in the reply, the modes and power, the coefficients, usage
+               errors, unknown commands, long lines, backspace and delete,
+               blank lines, the stats and the loop timing; the controller
+               state agrees with the reply, and a return goes before each
+               line feed;
+             - the trace dump: every event of the ring, in order, the
+               recording state kept, and a line sent during the dump run
+               after it;
+             - lines sent while the UI task is held off, past the line
+               ring, and a line hit by a framing error: dropped and
+               counted;
+             - the cost of the periodic call with nothing to do, and of a
+               command flood kept CONSOLE_SERIAL_LINES lines ahead: every
+               command answered, none dropped, none waiting for the
+               periodic call.
+             \par
+             The line buffers come from a memory partition stand-in. Built
+             and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _XOPEN_SOURCE 600
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hostTest.h"
+#include "menu.h"
+#include "tickless.h"
+#include "consoleSerial.c"
+
+/* After the registers: termios.h defines B0 as a bit rate. */
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** SCR transmit interrupt, receive interrupt and transmitter bits. */
+#define SCR_TIE (0x80u)
+#define SCR_RIE (0x40u)
+#define SCR_TE (0x20u)
+
+/** SSR framing error flag. */
+#define SSR_FER (0x10u)
+
+/** Blocks of the reclaimed memory pool. */
+#define POOL_BLOCKS (6u)
+
+/** Period of the simulated peripherals, in nanoseconds. */
+#define STEP_NS (50000l)
+
+/** Wait for a reply, in milliseconds. */
+#define REPLY_MS (1000u)
+
+/** Wait before taking the silence as no reply, in milliseconds. */
+#define SILENCE_MS (20u)
+
+/** Replies held, trace dump included. */
+#define TEXT_SIZE (65536u)
+
+/** Periodic calls of the idle cost measurement. */
+#define IDLE_CALLS (1000000ul)
+
+/** Commands of the flood. */
+#define FLOOD_COMMANDS (20000ul)
+
+/** First trace event count of the dump check; the ring has wrapped. */
+#define TRACE_HEAD (1500u)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
+
+/** Engineering unit range of each signal: the setpoint and PV with one
+    decimal, the output in whole percent. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 1000, 1, "%"},     /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, -400, 1500, 1, "C"}   /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+/** PID control structure variable. */
+PIDControl pid = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
+
+/* Board and kernel stand-ins. */
+
+volatile uint8_t LED4;
+volatile uint8_t LED7;
+volatile uint8_t LED13;
+
+OS_TCB* OSTCBHighRdyPtr;
+OS_TCB OSIdleTaskTCB;
+OS_CPU_USAGE OSStatTaskCPUUsage;
+OS_CTX_SW_CTR OSTaskCtxSwCtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Pseudo-terminal: the board end and the terminal end. */
+static int line = -1;
+static int port = -1;
+
+/** Memory reclaimed from the start task. */
+static uint64_t region[(POOL_BLOCKS * MEM_BUDGET_BLK_SIZE) / 8u];
+
+/** UI task, notified of line ends, reply ends and display changes. */
+static OS_TCB uiTask;
+
+/** Posts to the UI task not taken yet. */
+static unsigned long uiPending = 0;
+
+/** The UI task is held off; lines wait for it. */
+static bool uiHeld = false;
+
+/** Last wake-up of the UI task, in nanoseconds. */
+static double lastWake = 0.0;
+
+/** Work found by the periodic call rather than by a post. */
+static unsigned long lateServes = 0;
+
+/** Time in the console interrupts and consoleSerial_serve() calls, in
+    nanoseconds. */
+static double boardTime = 0.0;
+
+/** Time in the receive interrupt, in nanoseconds, and its calls. */
+static double rxTime = 0.0;
+static unsigned long rxCalls = 0;
+
+/** Received characters, and the one hit by a framing error; -1 for
+    none. */
+static long lineBytes = 0;
+static long errorByte = -1;
+
+/** Reply line feeds without a return before them. */
+static unsigned long bareFeeds = 0;
+
+/** Reply text. */
+static char text[TEXT_SIZE];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the line splitting, command lookup and number parsing.
+    \return None
+ */
+static void testConsole (void);
+
+/**
+    \brief Start the console without and with the line buffers.
+    \return None
+ */
+static void testInit (void);
+
+/**
+    \brief Run each command through the terminal.
+    \return None
+ */
+static void testCommands (void);
+
+/**
+    \brief Dump the trace ring.
+    \return None
+ */
+static void testTrace (void);
+
+/**
+    \brief Send lines the console must drop.
+    \return None
+ */
+static void testDropped (void);
+
+/**
+    \brief Time the periodic call with nothing to do.
+    \return None
+ */
+static void benchIdle (void);
+
+/**
+    \brief Time a flood of commands kept a line ring ahead.
+    \return None
+ */
+static void benchFlood (void);
+
+/**
+    \brief Open the pseudo-terminal.
+    \return True on success.
+ */
+static bool openLine (void);
+
+/**
+    \brief Send a line and take its reply.
+    \param command Line, without its end.
+    \return Reply, in text; empty if none came whole.
+ */
+static const char* command (const char* command);
+
+/**
+    \brief Take a reply: up to its "ok" or "error: " line.
+    \return Reply, in text; empty if none came whole.
+ */
+static const char* takeReply (void);
+
+/**
+    \brief Send characters and check that nothing comes back.
+    \param characters Characters.
+    \return True if no reply came.
+ */
+static bool unanswered (const char* characters);
+
+/**
+    \brief Run the simulated SCI0 and the UI task for a while.
+    \param ms Time, in milliseconds.
+    \return None
+ */
+static void runBoard (unsigned ms);
+
+/**
+    \brief Run the simulated SCI0 and the UI task once.
+    \return None
+ */
+static void stepBoard (void);
+
+/**
+    \brief Take a character on RXD0.
+    \param data Character.
+    \return None
+ */
+static void receive (uint8_t data);
+
+/**
+    \brief Send the reply loaded by the transmit interrupts.
+    \return None
+ */
+static void transmit (void);
+
+/**
+    \brief Check that a text starts with another.
+    \param whole Text.
+    \param start Start.
+    \return True if it does.
+ */
+static bool startsWith (const char* whole, const char* start);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    initUnits();
+    displayDirty_init(&uiTask);
+    trace_init(48000000u);
+
+    testConsole();
+    testInit();
+    HOST_CHECK(openLine());
+
+    if (started && (line >= 0)) {
+        testCommands();
+        testTrace();
+        testDropped();
+        benchIdle();
+        benchFlood();
+        close(port);
+        close(line);
+    }
+
+    return hostTest_exit();
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return (CPU_TS_TMR)hostTest_now();
+}
+
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err) {
+    *p_err = CPU_ERR_NONE;
+
+    return 1000000000u;
+}
+
+void OSIntEnter (void) {
+}
+
+void OSIntExit (void) {
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    (void)opt;
+    uiPending += (p_tcb == &uiTask) ? 1u : 0u;
+    *p_err = OS_ERR_NONE;
+
+    return 0u;
+}
+
+void OSMemCreate (OS_MEM* p_mem, CPU_CHAR* p_name, void* p_addr,
+                  OS_MEM_QTY n_blks, OS_MEM_SIZE blk_size, OS_ERR* p_err) {
+    uint8_t* block = (uint8_t*)p_addr;
+    OS_MEM_QTY i;
+
+    (void)p_name;
+
+    /* Each free block holds the address of the next, as in the kernel. */
+    for (i = 0; i < n_blks; i++) {
+        *(void**)&block[i * blk_size] = ((i + 1u) < n_blks) ?
+                                        &block[(i + 1u) * blk_size] : NULL;
+    }
+
+    p_mem->FreeListPtr = p_addr;
+    p_mem->BlkSize = blk_size;
+    p_mem->NbrMax = n_blks;
+    p_mem->NbrFree = n_blks;
+    *p_err = OS_ERR_NONE;
+}
+
+void* OSMemGet (OS_MEM* p_mem, OS_ERR* p_err) {
+    void* block = p_mem->FreeListPtr;
+
+    if (p_mem->NbrFree == 0u) {
+        *p_err = OS_ERR_MEM_NO_FREE_BLKS;
+        return NULL;
+    }
+
+    p_mem->FreeListPtr = *(void**)block;
+    p_mem->NbrFree--;
+    *p_err = OS_ERR_NONE;
+
+    return block;
+}
+
+void OSMemPut (OS_MEM* p_mem, void* p_blk, OS_ERR* p_err) {
+    *(void**)p_blk = p_mem->FreeListPtr;
+    p_mem->FreeListPtr = p_blk;
+    p_mem->NbrFree++;
+    *p_err = OS_ERR_NONE;
+}
+
+void OSTaskStkChk (OS_TCB* p_tcb, CPU_STK_SIZE* p_free, CPU_STK_SIZE* p_used,
+                   OS_ERR* p_err) {
+    (void)p_tcb;
+    *p_free = 0u;
+    *p_used = 0u;
+    *p_err = OS_ERR_NONE;
+}
+
+uint32_t tickless_wakeups (void) {
+    return 0u;
+}
+
+void lcd_clear (void) {
+}
+
+void lcd_display (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void lcd_display_inverted (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+static void testConsole (void) {
+    static const char* const absent[] = {
+        "", "a", "gain", "gainsx", "geta", "hel", "tracez", "zz"
+    };
+    char words[CONSOLE_LINE_SIZE];
+    /* One more, to see that no word is stored past the last. */
+    char* argv[CONSOLE_ARGS_MAX + 1u] = {NULL};
+    int32_t value = 7;
+    uint8_t i;
+
+    /* The words stay where they are. */
+    snprintf(words, sizeof(words), "  set\tsp  42.5 ");
+    HOST_CHECK(console_split(words, (uint16_t)strlen(words), argv) == 3u);
+    HOST_CHECK((argv[0] == &words[2]) && (argv[1] == &words[6]) &&
+               (argv[2] == &words[10]));
+    HOST_CHECK((strcmp(argv[0], "set") == 0) &&
+               (strcmp(argv[1], "sp") == 0) &&
+               (strcmp(argv[2], "42.5") == 0));
+
+    snprintf(words, sizeof(words), "a b c d e f");
+    HOST_CHECK(console_split(words, (uint16_t)strlen(words), argv) ==
+               CONSOLE_ARGS_MAX);
+    snprintf(words, sizeof(words), "a b c d e f g");
+    HOST_CHECK(console_split(words, (uint16_t)strlen(words), argv) ==
+               (CONSOLE_ARGS_MAX + 1u));
+    HOST_CHECK(argv[CONSOLE_ARGS_MAX] == NULL);
+    snprintf(words, sizeof(words), " \t ");
+    HOST_CHECK(console_split(words, (uint16_t)strlen(words), argv) == 0u);
+
+    for (i = 0; i < commandCount; i++) {
+        HOST_CHECK(console_find(commands, commandCount, commands[i].name) ==
+                   &commands[i]);
+    }
+
+    for (i = 0; i < (sizeof(absent) / sizeof(absent[0])); i++) {
+        HOST_CHECK(console_find(commands, commandCount, absent[i]) == NULL);
+    }
+
+    HOST_CHECK(console_parseFixed("42.5", 1u, &value) && (value == 425));
+    HOST_CHECK(console_parseFixed("42.500", 1u, &value) && (value == 425));
+    HOST_CHECK(console_parseFixed("-42.0", 0u, &value) && (value == -42));
+    HOST_CHECK(console_parseFixed("+7", 2u, &value) && (value == 700));
+    HOST_CHECK(console_parseFixed("0.0001", 4u, &value) && (value == 1));
+    HOST_CHECK(console_parseFixed("2147483647.0", 0u, &value) &&
+               (value == INT32_MAX));
+    HOST_CHECK(console_parseFixed("-2147483648", 0u, &value) &&
+               (value == INT32_MIN));
+    value = 7;
+    HOST_CHECK(!console_parseFixed("2147483648", 0u, &value));
+    HOST_CHECK(!console_parseFixed("2147483647.5", 0u, &value));
+
+    /* Finer than the decimals: refused, not rounded. */
+    HOST_CHECK(!console_parseFixed("42.46", 1u, &value));
+    HOST_CHECK(!console_parseFixed("42.501", 1u, &value));
+    HOST_CHECK(!console_parseFixed("-42.5", 0u, &value));
+    HOST_CHECK(!console_parseFixed("0.00005", 4u, &value));
+    HOST_CHECK(!console_parseFixed("214748364.8", 1u, &value));
+    HOST_CHECK(!console_parseFixed("4x", 0u, &value));
+    HOST_CHECK(!console_parseFixed("1.2.3", 1u, &value));
+    HOST_CHECK(!console_parseFixed("-", 0u, &value));
+    HOST_CHECK(!console_parseFixed("", 0u, &value));
+    HOST_CHECK(value == 7);
+}
+
+static void testInit (void) {
+    /* No pool yet. */
+    consoleSerial_init(&uiTask);
+    HOST_CHECK(!started);
+    HOST_CHECK(SCI0.SCR.BYTE == 0u);
+
+    /* Too few blocks: all of them given back. */
+    memBudget_reclaim(region, 2u * MEM_BUDGET_BLK_SIZE);
+    consoleSerial_init(&uiTask);
+    HOST_CHECK(!started);
+    HOST_CHECK(memBudget_pool()->NbrFree == 2u);
+    consoleSerial_serve();
+    HOST_CHECK(!consoleSerial_ready());
+
+    memBudget_reclaim(region, sizeof(region));
+    consoleSerial_init(&uiTask);
+    HOST_CHECK(started);
+    HOST_CHECK(memBudget_pool()->NbrFree ==
+               (POOL_BLOCKS - CONSOLE_SERIAL_LINES));
+
+    /* 8N1 at 115385 bit/s. */
+    HOST_CHECK(SCI0.SMR.BYTE == 0x00u);
+    HOST_CHECK(SCI0.BRR == 12u);
+    HOST_CHECK(SCI0.SCR.BYTE == CONSOLE_SERIAL_SCR_RECEIVE);
+    HOST_CHECK(IEN(SCI0,RXI0) && IEN(SCI0,TXI0) && IEN(SCI0,TEI0));
+}
+
+static void testCommands (void) {
+    static const char twice[] = "get mode\rget mode\r";
+    PIDCoefficients coefficients = {1.25f, -0.5f, 0.0625f};
+    char expected[128];
+    char longLine[CONSOLE_LINE_SIZE + 8u];
+    uint8_t i;
+
+    lateServes = 0;
+    command("help");
+
+    for (i = 0; i < commandCount; i++) {
+        snprintf(expected, sizeof(expected), "%s%s%s\r\n",
+                 commands[i].name, (commands[i].usage[0] != '\0') ? " " : "",
+                 commands[i].usage);
+        HOST_CHECK(strstr(text, expected) != NULL);
+    }
+
+    HOST_CHECK(strstr(text, "ok\r\n") != NULL);
+
+    HOST_CHECK(strcmp(command("get mode"), "man\r\nok\r\n") == 0);
+    HOST_CHECK(strcmp(command("get power"), "off\r\nok\r\n") == 0);
+
+    /* As in the menu: no setpoint in manual, no output in automatic. */
+    HOST_CHECK(strcmp(command("set sp 42.5"),
+                      "error: not allowed now\r\n") == 0);
+    HOST_CHECK(pid.spValue == 0);
+
+    (void)displayDirty_take(DISPLAY_MODE);
+    HOST_CHECK(strcmp(command("mode auto"), "ok\r\n") == 0);
+    HOST_CHECK(pid.mode == PID_AUTO);
+    HOST_CHECK(displayDirty_take(DISPLAY_MODE));
+
+    (void)displayDirty_take(DISPLAY_SP);
+    HOST_CHECK(strcmp(command("set sp 42.5"), "sp 42.5 %\r\nok\r\n") == 0);
+    HOST_CHECK(pid.spValue == 425);
+    HOST_CHECK(displayDirty_take(DISPLAY_SP));
+    snprintf(expected, sizeof(expected), "42.5 %% raw %d\r\nok\r\n",
+             (int)pid.sp);
+    HOST_CHECK(strcmp(command("get sp"), expected) == 0);
+
+    HOST_CHECK(strcmp(command("set sp 42.46"), "error: bad value\r\n") == 0);
+    HOST_CHECK(pid.spValue == 425);
+    HOST_CHECK(strcmp(command("set sp 100.1"), "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("set sp -0.1"), "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("set sp 4x"), "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("set op 10"),
+                      "error: not allowed now\r\n") == 0);
+    HOST_CHECK(pid.spValue == 425);
+
+    HOST_CHECK(strcmp(command("mode man"), "ok\r\n") == 0);
+    HOST_CHECK(pid.mode == PID_MAN);
+    HOST_CHECK(strcmp(command("set op 42.5"), "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("set op 43.0"), "op 43 %\r\nok\r\n") == 0);
+    HOST_CHECK(pid.opValue == 43);
+    snprintf(expected, sizeof(expected), "43 %% raw %d\r\nok\r\n",
+             (int)pid.op);
+    HOST_CHECK(strcmp(command("get op"), expected) == 0);
+    HOST_CHECK(strcmp(command("set op 101"), "error: bad value\r\n") == 0);
+    HOST_CHECK(pid.opValue == 43);
+    HOST_CHECK(strcmp(command("mode auto"), "ok\r\n") == 0);
+
+    snprintf(expected, sizeof(expected), "%d.%d C raw %d\r\nok\r\n",
+             (int)(toValue(SIGNAL_PV, pid.pv) / 10),
+             (int)abs(toValue(SIGNAL_PV, pid.pv) % 10), (int)pid.pv);
+    HOST_CHECK(strcmp(command("get pv"), expected) == 0);
+
+    HOST_CHECK(strcmp(command("power on"), "ok\r\n") == 0);
+    HOST_CHECK(pid.active == PID_ON);
+    HOST_CHECK(strcmp(command("get power"), "on\r\nok\r\n") == 0);
+    HOST_CHECK(strcmp(command("power maybe"),
+                      "error: usage: power on|off\r\n") == 0);
+    HOST_CHECK(strcmp(command("mode maybe"),
+                      "error: usage: mode man|auto\r\n") == 0);
+    HOST_CHECK(pid.mode == PID_AUTO);
+
+    /* The coefficients, to CONSOLE_SERIAL_GAIN_DECIMALS. */
+    HOST_CHECK(setCoefficients_PID(&coefficients));
+    HOST_CHECK(strcmp(command("gains"),
+                      "b1 1.2500 b2 -0.5000 b3 0.0625\r\nok\r\n") == 0);
+    HOST_CHECK(strcmp(command("gains 1 0.00005 0"),
+                      "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("gains 2.5 -1.25 0.0001"), "ok\r\n") == 0);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 2.5f) && (coefficients.b2 == -1.25f) &&
+               (coefficients.b3 == (1.0f / CONSOLE_SERIAL_GAIN_SCALE)));
+    HOST_CHECK(strcmp(command("gains 1000 0 0"), "error: bad value\r\n") == 0);
+    HOST_CHECK(strcmp(command("gains 1 x 0"), "error: bad value\r\n") == 0);
+    HOST_CHECK(startsWith(command("gains 1 2"), "error: usage: gains"));
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK(coefficients.b1 == 2.5f);
+
+    HOST_CHECK(strcmp(command("nosuch"),
+                      "error: unknown command, try help\r\n") == 0);
+    HOST_CHECK(startsWith(command("get"), "error: usage: get"));
+    HOST_CHECK(startsWith(command("get sp pv"), "error: usage: get"));
+    HOST_CHECK(startsWith(command("get xy"), "error: usage: get"));
+    HOST_CHECK(startsWith(command("gains 1 2 3 4 5 6 7"),
+                          "error: usage: gains"));
+
+    memset(longLine, 'x', sizeof(longLine) - 1u);
+    longLine[sizeof(longLine) - 1u] = '\0';
+    HOST_CHECK(strcmp(command(longLine), "error: line too long\r\n") == 0);
+    longLine[sizeof(longLine) - 2u] = '\b';
+    HOST_CHECK(strcmp(command(longLine), "error: line too long\r\n") == 0);
+
+    /* Line editing, and the line feed after a return. */
+    HOST_CHECK(strcmp(command("get modx\bf\x7f" "e"), "auto\r\nok\r\n") == 0);
+    HOST_CHECK(strcmp(command("\b\x7fget mode"), "auto\r\nok\r\n") == 0);
+    HOST_CHECK(unanswered("\r\n\n\r"));
+    HOST_CHECK(unanswered("   \t\r"));
+
+    HOST_CHECK(strstr(command("stats"), "console lines dropped 0\r\nok\r\n")
+               != NULL);
+
+    HOST_CHECK(strcmp(command("timing on"), "ok\r\n") == 0);
+    HOST_CHECK(loopTiming_enabled());
+    HOST_CHECK(startsWith(command("timing show"),
+                          "timing on, 1000000000 Hz: name samples max "
+                          "<counts:number\r\njitter 0 0\r\n"
+                          "compute 0 0\r\nlatency 0 0\r\nok\r\n"));
+    HOST_CHECK(strcmp(command("timing off"), "ok\r\n") == 0);
+    HOST_CHECK(!loopTiming_enabled());
+    HOST_CHECK(strcmp(command("timing reset"), "ok\r\n") == 0);
+
+    /* Nothing to serve while a reply goes out. */
+    for (i = 0; i < (sizeof(twice) - 1u); i++) {
+        receive((uint8_t)twice[i]);
+    }
+
+    consoleSerial_serve();
+    HOST_CHECK(sending && (lineTail != lineHead));
+    HOST_CHECK(!consoleSerial_ready());
+    HOST_CHECK(strcmp(takeReply(), "auto\r\nok\r\n") == 0);
+    HOST_CHECK(strcmp(takeReply(), "auto\r\nok\r\n") == 0);
+
+    HOST_CHECK(bareFeeds == 0u);
+    HOST_CHECK(lateServes == 0u);
+}
+
+static void testTrace (void) {
+    TraceEvent* event;
+    const char* at;
+    char expected[64];
+    unsigned long mismatches = 0;
+    unsigned long count = 0;
+    uint32_t i;
+
+    HOST_CHECK(strcmp(command("trace off"), "ok\r\n") == 0);
+    HOST_CHECK(traceBuffer.enabled == 0u);
+
+    for (i = TRACE_HEAD - TRACE_SIZE; i < TRACE_HEAD; i++) {
+        event = &traceBuffer.event[i & TRACE_MASK];
+        event->time = 4000000000u + (i * 1000u);
+        event->type = (uint8_t)(1u + (i % 6u));
+        event->arg = (uint8_t)(i % 5u);
+        event->value = (uint16_t)i;
+    }
+
+    traceBuffer.head = TRACE_HEAD;
+
+    /* A line sent behind the dump waits for its end. */
+    HOST_CHECK(write(port, "trace dump\r\nget mode\r\n", 22u) == 22);
+    at = takeReply();
+    snprintf(expected, sizeof(expected), "trace %u events, 48000000 Hz: "
+             "time type arg value\r\n", TRACE_SIZE);
+    HOST_CHECK(startsWith(at, expected));
+    at = strchr(at, '\n');
+
+    for (i = TRACE_HEAD - TRACE_SIZE; (at != NULL) && (i < TRACE_HEAD);
+         i++) {
+        event = &traceBuffer.event[i & TRACE_MASK];
+        snprintf(expected, sizeof(expected), "%lu %u %u %u\r\n",
+                 (unsigned long)event->time, (unsigned)event->type,
+                 (unsigned)event->arg, (unsigned)event->value);
+        mismatches += startsWith(at + 1, expected) ? 0u : 1u;
+        at = strchr(at + 1, '\n');
+        count++;
+    }
+
+    HOST_CHECK(count == TRACE_SIZE);
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK((at != NULL) && (strcmp(at + 1, "ok\r\n") == 0));
+    HOST_CHECK(strcmp(takeReply(), "auto\r\nok\r\n") == 0);
+    HOST_CHECK(traceBuffer.enabled == 0u);
+
+    /* Recording goes on after the dump. */
+    HOST_CHECK(strcmp(command("trace on"), "ok\r\n") == 0);
+    HOST_CHECK(traceBuffer.enabled != 0u);
+    at = command("trace dump");
+    HOST_CHECK(startsWith(at, "trace "));
+    HOST_CHECK((strlen(at) > 4u) && (strcmp(at + strlen(at) - 4u,
+                                            "ok\r\n") == 0));
+    HOST_CHECK(traceBuffer.enabled != 0u);
+    HOST_CHECK(strcmp(command("trace maybe"),
+                      "error: usage: trace dump|on|off\r\n") == 0);
+    HOST_CHECK(bareFeeds == 0u);
+}
+
+static void testDropped (void) {
+    unsigned replies = 0;
+    unsigned i;
+
+    /* Past the line ring while the task is held off. */
+    uiHeld = true;
+
+    for (i = 0; i < (CONSOLE_SERIAL_LINES + 2u); i++) {
+        HOST_CHECK(write(port, "get mode\r\n", 10u) == 10);
+    }
+
+    runBoard(SILENCE_MS);
+    uiHeld = false;
+
+    while ((replies <= CONSOLE_SERIAL_LINES) &&
+           (strcmp(takeReply(), "auto\r\nok\r\n") == 0)) {
+        replies++;
+    }
+
+    HOST_CHECK(replies == CONSOLE_SERIAL_LINES);
+    HOST_CHECK(dropped == 2u);
+
+    /* A framing error: the rest of the line is lost until the periodic
+       call restarts the receiver, and the next line end closes it. */
+    errorByte = lineBytes + 4;
+    HOST_CHECK(unanswered("set sp 50\r\n"));
+    runBoard(CONSOLE_SERIAL_POLL_MS + SILENCE_MS);
+    HOST_CHECK((SCI0.SSR.BYTE & CONSOLE_SERIAL_SSR_ERRORS) == 0u);
+    HOST_CHECK(unanswered("get sp\r\n"));
+    HOST_CHECK(pid.spValue == 425);
+    HOST_CHECK(dropped == 3u);
+    HOST_CHECK(strstr(command("stats"), "console lines dropped 3\r\n") !=
+               NULL);
+}
+
+static void benchIdle (void) {
+    unsigned long i;
+    double start;
+
+    start = hostTest_now();
+
+    for (i = 0; i < IDLE_CALLS; i++) {
+        consoleSerial_serve();
+    }
+
+    printf("idle: %.1f ns per periodic call\n",
+           (hostTest_now() - start) / (double)IDLE_CALLS);
+
+    HOST_CHECK(!consoleSerial_ready());
+}
+
+static void benchFlood (void) {
+    static const char* const lines[] = {
+        "get pv\r\n", "set sp 42.5\r\n", "gains\r\n", "get mode\r\n"
+    };
+    char in[4096];
+    unsigned long sent = 0;
+    unsigned long done = 0;
+    unsigned long errors = 0;
+    unsigned long before = dropped;
+    size_t held = 0;
+    size_t length;
+    ssize_t count;
+    char* end;
+    char* start;
+    double begin;
+    double elapsed;
+    double deadline;
+
+    boardTime = 0.0;
+    rxTime = 0.0;
+    rxCalls = 0;
+    lateServes = 0;
+    begin = hostTest_now();
+    deadline = begin + 60e9;
+
+    while ((done < FLOOD_COMMANDS) && (hostTest_now() < deadline)) {
+        while ((sent < FLOOD_COMMANDS) &&
+               ((sent - done) < CONSOLE_SERIAL_LINES)) {
+            length = strlen(lines[sent % 4u]);
+
+            if (write(port, lines[sent % 4u], length) != (ssize_t)length) {
+                break;
+            }
+
+            sent++;
+        }
+
+        stepBoard();
+        count = read(port, &in[held], sizeof(in) - held - 1u);
+
+        if (count <= 0) {
+            continue;
+        }
+
+        held += (size_t)count;
+        in[held] = '\0';
+
+        /* Count the status lines; keep a partial one. */
+        for (start = in; (end = strstr(start, "\r\n")) != NULL;
+             start = end + 2) {
+            if (startsWith(start, "ok\r\n")) {
+                done++;
+            } else if (startsWith(start, "error: ")) {
+                errors++;
+                done++;
+            }
+        }
+
+        held = strlen(start);
+        memmove(in, start, held);
+    }
+
+    elapsed = (hostTest_now() - begin) / 1e9;
+
+    printf("flood: %lu commands in %.2f s, %.0f commands/s over the "
+           "pseudo-terminal; console %.2f us per command, %.0f ns per "
+           "received character\n", done, elapsed, (double)done / elapsed,
+           boardTime / (double)done / 1e3,
+           (rxCalls > 0u) ? (rxTime / (double)rxCalls) : 0.0);
+
+    HOST_CHECK(done == FLOOD_COMMANDS);
+    HOST_CHECK(errors == 0u);
+    HOST_CHECK(dropped == before);
+    HOST_CHECK(lateServes == 0u);
+}
+
+static bool openLine (void) {
+    struct termios settings;
+
+    line = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((line < 0) || (grantpt(line) != 0) || (unlockpt(line) != 0)) {
+        return false;
+    }
+
+    port = open(ptsname(line), O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    if ((port < 0) || (tcgetattr(port, &settings) != 0)) {
+        return false;
+    }
+
+    /* A raw terminal: the console sends the returns itself. */
+    settings.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                    INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    settings.c_oflag &= ~(tcflag_t)OPOST;
+    settings.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(tcflag_t)(CSIZE | PARENB | CSTOPB);
+    settings.c_cflag |= CS8 | CREAD | CLOCAL;
+
+    return tcsetattr(port, TCSANOW, &settings) == 0;
+}
+
+static const char* command (const char* command) {
+    size_t length = strlen(command);
+
+    if ((write(port, command, length) != (ssize_t)length) ||
+        (write(port, "\r\n", 2u) != 2)) {
+        text[0] = '\0';
+        return text;
+    }
+
+    return takeReply();
+}
+
+static const char* takeReply (void) {
+    struct timespec step = {0, STEP_NS};
+    double deadline = hostTest_now() + (REPLY_MS * 1e6);
+    size_t length = 0;
+    ssize_t count;
+    char* last;
+    size_t i;
+
+    text[0] = '\0';
+
+    while (hostTest_now() < deadline) {
+        stepBoard();
+
+        /* One character at a time: the next reply stays on the line. */
+        while ((length < (TEXT_SIZE - 1u)) &&
+               ((count = read(port, &text[length], 1u)) == 1)) {
+            length++;
+            text[length] = '\0';
+
+            if ((length < 2u) || (text[length - 1u] != '\n')) {
+                continue;
+            }
+
+            text[length - 1u] = '\0';
+            last = strrchr(text, '\n');
+            last = (last != NULL) ? (last + 1) : text;
+            text[length - 1u] = '\n';
+
+            if (startsWith(last, "ok\r") || startsWith(last, "error: ")) {
+                for (i = 0; i < length; i++) {
+                    bareFeeds += ((text[i] == '\n') &&
+                                  ((i == 0u) || (text[i - 1u] != '\r'))) ?
+                                 1u : 0u;
+                }
+
+                return text;
+            }
+        }
+
+        nanosleep(&step, NULL);
+    }
+
+    text[0] = '\0';
+
+    return text;
+}
+
+static bool unanswered (const char* characters) {
+    size_t length = strlen(characters);
+    int pending = 0;
+
+    if (write(port, characters, length) != (ssize_t)length) {
+        return false;
+    }
+
+    runBoard(SILENCE_MS);
+
+    return (ioctl(port, FIONREAD, &pending) == 0) && (pending == 0);
+}
+
+static void runBoard (unsigned ms) {
+    struct timespec step = {0, STEP_NS};
+    double end = hostTest_now() + (ms * 1e6);
+
+    do {
+        stepBoard();
+        nanosleep(&step, NULL);
+    } while (hostTest_now() < end);
+}
+
+static void stepBoard (void) {
+    struct pollfd ready;
+    uint8_t data[64];
+    ssize_t count;
+    ssize_t i;
+    double start;
+    bool timedOut;
+
+    ready.fd = line;
+    ready.events = POLLIN;
+
+    while ((poll(&ready, 1, 0) > 0) && (ready.revents & POLLIN)) {
+        count = read(line, data, sizeof(data));
+
+        for (i = 0; i < count; i++) {
+            receive(data[i]);
+        }
+    }
+
+    /* The UI task: woken by a post, or after CONSOLE_SERIAL_POLL_MS. */
+    timedOut = ((hostTest_now() - lastWake) >=
+                (CONSOLE_SERIAL_POLL_MS * 1e6));
+
+    if (!uiHeld && ((uiPending > 0u) || timedOut)) {
+        lateServes += ((uiPending == 0u) && consoleSerial_ready()) ? 1u : 0u;
+        uiPending = 0;
+        lastWake = hostTest_now();
+
+        start = hostTest_now();
+        consoleSerial_serve();
+        boardTime += hostTest_now() - start;
+    }
+
+    transmit();
+}
+
+static void receive (uint8_t data) {
+    double start;
+
+    if (lineBytes++ == errorByte) {
+        SCI0.SSR.BYTE |= SSR_FER;
+    }
+
+    /* A line error stops the receiver until its flag is cleared. */
+    if (((SCI0.SSR.BYTE & CONSOLE_SERIAL_SSR_ERRORS) != 0u) ||
+        ((SCI0.SCR.BYTE & SCR_RIE) == 0u)) {
+        return;
+    }
+
+    SCI0.RDR = data;
+    start = hostTest_now();
+    consoleSerial_rxIsr();
+    rxTime += hostTest_now() - start;
+    boardTime += hostTest_now() - start;
+    rxCalls++;
+}
+
+static void transmit (void) {
+    uint8_t data[2u * CONSOLE_SERIAL_REPLY_SIZE];
+    uint16_t count = 0;
+    double start = hostTest_now();
+
+    /* TXI while the transmit data register empties. */
+    while (((SCI0.SCR.BYTE & (SCR_TIE | SCR_TE)) == (SCR_TIE | SCR_TE)) &&
+           (count < sizeof(data))) {
+        consoleSerial_txIsr();
+        data[count++] = SCI0.TDR;
+    }
+
+    /* TEI once the last character left. */
+    if ((SCI0.SCR.BYTE & (SCR_TIE | CONSOLE_SERIAL_SCR_TEIE)) ==
+        CONSOLE_SERIAL_SCR_TEIE) {
+        consoleSerial_txEndIsr();
+    }
+
+    boardTime += (count > 0u) ? (hostTest_now() - start) : 0.0;
+
+    if ((count > 0u) && (write(line, data, count) != (ssize_t)count)) {
+        HOST_CHECK(false);
+    }
+}
+
+static bool startsWith (const char* whole, const char* start) {
+    return strncmp(whole, start, strlen(start)) == 0;
+}
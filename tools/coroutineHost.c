@@ -0,0 +1,345 @@
+/**
+    \file coroutineHost.c
+    \brief Host test for the stackless coroutine library.
+    \details Runs src/coroutine.c on the development host, with tick counts
+             that start just before the 32-bit wrap:
+             \par
+             - COROUTINE_DELAY() resumes on its deadline, not before, across
+               the wrap, and coroutine_run() returns the ticks to it;
+             - COROUTINE_WAIT_TIMEOUT() ends early when its condition holds
+               and on its deadline otherwise;
+             - COROUTINE_YIELD() asks for the next pass,
+               COROUTINE_WAIT_UNTIL() for none, and an ended coroutine is
+               never run again;
+             - coroutines with random delays, driven only by the ticks each
+               pass returns, as the UI task sleeps: every one resumes
+               exactly on its deadline;
+             - the cost of a pass.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostTest.h"
+#include "coroutine.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** First tick of the tests, 16 ticks before the wrap. */
+#define START_TICK (0xFFFFFFF0ul)
+
+/** Coroutines of the driven test. */
+#define DRIVEN_COROUTINES (4u)
+
+/** First tick of the driven test, which wraps midway. */
+#define DRIVEN_START_TICK (START_TICK - 100000ul)
+
+/** Passes of the driven test. */
+#define DRIVEN_PASSES (200000ul)
+
+/** Passes of the cost measurement. */
+#define COST_PASSES (20000000ul)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Coroutine of the driven test, with the state it keeps across waits. */
+typedef struct DrivenType_struct {
+    Coroutine cr;                       /**< Coroutine; first member. */
+    uint32_t delay;                     /**< Longest delay, in ticks. */
+    uint32_t due;                       /**< Tick the delay ends. */
+    uint32_t runs;                      /**< Resumes. */
+    uint32_t early;                     /**< Resumes before the deadline. */
+    uint32_t late;                      /**< Resumes after the deadline. */
+} DrivenType;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Condition the waiting coroutines check. */
+static int flag = 0;
+
+/** Runs of the delay coroutine. */
+static uint32_t delayRuns = 0;
+
+/** Condition waits ended, early or on timeout. */
+static uint32_t timeoutRuns = 0;
+
+/** Last step reached by the step coroutine. */
+static uint32_t stepReached = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check delays and timed waits across the tick wrap.
+    \return None
+ */
+static void testWaits (void);
+
+/**
+    \brief Check yield, wait-until and end.
+    \return None
+ */
+static void testSteps (void);
+
+/**
+    \brief Check random delays driven by the returned ticks.
+    \return None
+ */
+static void testDriven (void);
+
+/**
+    \brief Coroutine: runs every 5 ticks.
+    \param cr Coroutine.
+    \return Coroutine status.
+ */
+static uint8_t delayBody (Coroutine* cr);
+
+/**
+    \brief Coroutine: waits for the flag, 100 ticks at most.
+    \param cr Coroutine.
+    \return Coroutine status.
+ */
+static uint8_t timeoutBody (Coroutine* cr);
+
+/**
+    \brief Coroutine: yields, waits for the flag and ends.
+    \param cr Coroutine.
+    \return Coroutine status.
+ */
+static uint8_t stepBody (Coroutine* cr);
+
+/**
+    \brief Coroutine: sleeps random delays and checks each wake-up.
+    \param cr Coroutine, first member of a DrivenType.
+    \return Coroutine status.
+ */
+static uint8_t drivenBody (Coroutine* cr);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    CoroutineScheduler sched;
+    Coroutine a;
+    Coroutine b;
+    uint32_t now = START_TICK;
+    uint32_t i;
+    double start;
+
+    srand(1);
+
+    testWaits();
+    testSteps();
+    testDriven();
+
+    /* A pass over a sleeping and a waiting coroutine, each resumed once
+       every 5 passes. */
+    delayRuns = 0;
+    coroutine_schedInit(&sched);
+    coroutine_add(&sched, &a, delayBody);
+    coroutine_add(&sched, &b, timeoutBody);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_PASSES; i++) {
+        (void)coroutine_run(&sched, now++);
+    }
+
+    printf("coroutine_run: %.1f ns per pass of 2 coroutines\n",
+           (hostTest_now() - start) / (double)COST_PASSES);
+    HOST_CHECK(delayRuns == (COST_PASSES / 5u));
+
+    return hostTest_exit();
+}
+
+static void testWaits (void) {
+    CoroutineScheduler sched;
+    Coroutine a;
+    Coroutine b;
+    uint32_t now = START_TICK;
+
+    coroutine_schedInit(&sched);
+    coroutine_add(&sched, &a, delayBody);
+    coroutine_add(&sched, &b, timeoutBody);
+
+    /* Both start; the delay is the nearest deadline. */
+    HOST_CHECK(coroutine_run(&sched, now) == 5u);
+    HOST_CHECK((delayRuns == 1u) && (timeoutRuns == 0u));
+
+    /* Not yet: the delay stays asleep. */
+    HOST_CHECK(coroutine_run(&sched, now + 3u) == 2u);
+    HOST_CHECK(delayRuns == 1u);
+
+    /* The flag ends the timed wait early. */
+    flag = 1;
+    HOST_CHECK(coroutine_run(&sched, now + 3u) == 2u);
+    HOST_CHECK(timeoutRuns == 1u);
+
+    /* On the deadline, with the ticks wrapping meanwhile. */
+    HOST_CHECK(coroutine_run(&sched, now + 5u) == 5u);
+    HOST_CHECK(delayRuns == 2u);
+    HOST_CHECK(coroutine_run(&sched, now + 10u) == 5u);
+    HOST_CHECK(coroutine_run(&sched, now + 15u) == 5u);
+    HOST_CHECK(coroutine_run(&sched, now + 20u) == 5u);
+    HOST_CHECK(delayRuns == 5u);
+
+    /* The timed wait restarted at +3 and times out at +103; the delay,
+       resumed late at +102, is due again at +107. */
+    HOST_CHECK(coroutine_run(&sched, now + 102u) == 1u);
+    HOST_CHECK((timeoutRuns == 1u) && (delayRuns == 6u));
+    HOST_CHECK(coroutine_run(&sched, now + 103u) == 4u);
+    HOST_CHECK(timeoutRuns == 2u);
+}
+
+static void testSteps (void) {
+    CoroutineScheduler sched;
+    Coroutine c;
+
+    flag = 0;
+    coroutine_schedInit(&sched);
+    coroutine_add(&sched, &c, stepBody);
+
+    HOST_CHECK(coroutine_run(&sched, 0u) == 0u);
+    HOST_CHECK(stepReached == 1u);
+    HOST_CHECK(coroutine_run(&sched, 0u) == COROUTINE_FOREVER);
+    HOST_CHECK(stepReached == 2u);
+    HOST_CHECK(coroutine_run(&sched, 9u) == COROUTINE_FOREVER);
+    HOST_CHECK(stepReached == 2u);
+
+    flag = 2;
+    HOST_CHECK(coroutine_run(&sched, 9u) == COROUTINE_FOREVER);
+    HOST_CHECK((stepReached == 3u) && (c.status == COROUTINE_ENDED));
+
+    stepReached = 0;
+    (void)coroutine_run(&sched, 10u);
+    HOST_CHECK(stepReached == 0u);
+}
+
+static void testDriven (void) {
+    static const uint32_t delays[DRIVEN_COROUTINES] = {1u, 7u, 50u, 500u};
+    CoroutineScheduler sched;
+    DrivenType driven[DRIVEN_COROUTINES];
+    uint32_t now = DRIVEN_START_TICK;
+    uint32_t wait;
+    uint32_t runs = 0;
+    uint32_t early = 0;
+    uint32_t late = 0;
+    uint32_t i;
+
+    coroutine_schedInit(&sched);
+
+    for (i = 0; i < DRIVEN_COROUTINES; i++) {
+        driven[i].delay = delays[i];
+        driven[i].runs = 0;
+        driven[i].early = 0;
+        driven[i].late = 0;
+        coroutine_add(&sched, &driven[i].cr, drivenBody);
+    }
+
+    for (i = 0; i < DRIVEN_PASSES; i++) {
+        wait = coroutine_run(&sched, now);
+        HOST_CHECK(wait != COROUTINE_FOREVER);
+
+        /* Sleep as the task would; never return immediately. */
+        now += (wait == 0u) ? 1u : wait;
+    }
+
+    for (i = 0; i < DRIVEN_COROUTINES; i++) {
+        runs += driven[i].runs;
+        early += driven[i].early;
+        late += driven[i].late;
+    }
+
+    printf("driven: %lu passes to tick %lu, %lu resumes, %lu early, "
+           "%lu late\n", (unsigned long)DRIVEN_PASSES, (unsigned long)now,
+           (unsigned long)runs, (unsigned long)early, (unsigned long)late);
+
+    HOST_CHECK(now < DRIVEN_START_TICK);
+    HOST_CHECK((early == 0u) && (late == 0u));
+}
+
+static uint8_t delayBody (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    while (true) {
+        delayRuns++;
+        COROUTINE_DELAY(cr, 5u);
+    }
+
+    COROUTINE_END(cr);
+}
+
+static uint8_t timeoutBody (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    while (true) {
+        COROUTINE_WAIT_TIMEOUT(cr, flag != 0, 100u);
+        timeoutRuns++;
+        flag = 0;
+    }
+
+    COROUTINE_END(cr);
+}
+
+static uint8_t stepBody (Coroutine* cr) {
+    COROUTINE_BEGIN(cr);
+
+    stepReached = 1;
+    COROUTINE_YIELD(cr);
+
+    stepReached = 2;
+    COROUTINE_WAIT_UNTIL(cr, flag == 2);
+
+    stepReached = 3;
+
+    COROUTINE_END(cr);
+}
+
+static uint8_t drivenBody (Coroutine* cr) {
+    DrivenType* driven = (DrivenType*)(void*)cr;
+
+    COROUTINE_BEGIN(cr);
+
+    while (true) {
+        driven->due = cr->now + 1u + ((uint32_t)rand() % driven->delay);
+        COROUTINE_DELAY(cr, driven->due - cr->now);
+
+        driven->runs++;
+
+        if ((int32_t)(cr->now - driven->due) < 0) {
+            driven->early++;
+        } else if (cr->now != driven->due) {
+            driven->late++;
+        }
+    }
+
+    COROUTINE_END(cr);
+}
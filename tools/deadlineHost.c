@@ -0,0 +1,370 @@
+/**
+    \file deadlineHost.c
+    \brief Host test for the control cycle deadline monitor.
+    \details Runs src/deadline.c on the development host, simulating a
+             periodic task that does its work, calls deadline_end() and
+             waits the returned delay, with injected execution times:
+             \par
+             - on-time cycles, and a completion exactly at the deadline;
+             - a 25 tick overrun of a 10 tick period under each policy:
+               skip drops two releases, catch-up runs three cycles late
+               back to back and lands on the grid, safe latches the alarm
+               until cleared;
+             - a backlog past DEADLINE_MAX_CATCH_UP is dropped, one of
+               exactly that many periods is caught up;
+             - a deadline shorter than the period, and one longer clamped;
+             - the overrun across a tick counter wrap;
+             - 100000 random cycles per policy: releases stay on the grid,
+               no delay exceeds the period, no cycle starts before its
+               release, misses and lateness match a reference, and cycles
+               run plus releases dropped equal the releases so far;
+             - the cost of deadline_end().
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "hostTest.h"
+#include "deadline.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Release period of the tests, in ticks. */
+#define PERIOD (10u)
+
+/** Cycles of the overrun tests. */
+#define OVERRUN_CYCLES (6u)
+
+/** Random cycles per policy. */
+#define RANDOM_CYCLES (100000ul)
+
+/** Calls of the cost measurement. */
+#define COST_CALLS (100000000ul)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Cycles seen by the simulated task. */
+typedef struct CycleLog_struct {
+    uint32_t start[OVERRUN_CYCLES];     /**< Release of each cycle. */
+    uint8_t cycles;                     /**< Cycles logged. */
+    uint8_t safe;                       /**< Cycles run with the alarm set. */
+} CycleLog;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Execution times of a 25 tick overrun in the third cycle. */
+static const uint32_t overrun[OVERRUN_CYCLES] = {3, 3, 25, 3, 3, 3};
+
+/** Delays longer than the period, or cycles started before release. */
+static unsigned long violations = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Run cycles of the simulated task.
+    \param monitor Pointer to the monitor.
+    \param now Current time, in ticks.
+    \param cycles Cycles to run.
+    \param execution Execution time of each cycle, in ticks.
+    \param log Pointer to the log of cycles run, or null.
+    \return Time after the last wait, in ticks.
+ */
+static uint32_t simulate (DeadlineMonitor* monitor, uint32_t now,
+                          uint8_t cycles, const uint32_t* execution,
+                          CycleLog* log);
+
+/**
+    \brief Check on-time cycles.
+    \return None
+ */
+static void testOnTime (void);
+
+/**
+    \brief Check one overrun under each policy.
+    \return None
+ */
+static void testOverrun (void);
+
+/**
+    \brief Check the catch-up limit, the deadline bounds and a tick wrap.
+    \return None
+ */
+static void testEdges (void);
+
+/**
+    \brief Check the schedule invariants over random execution times.
+    \return None
+ */
+static void testRandom (void);
+
+/**
+    \brief Time deadline_end() on schedule.
+    \return None
+ */
+static void benchDeadline (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    testOnTime();
+    testOverrun();
+    testEdges();
+    testRandom();
+
+    HOST_CHECK(violations == 0u);
+
+    benchDeadline();
+
+    return hostTest_exit();
+}
+
+static uint32_t simulate (DeadlineMonitor* monitor, uint32_t now,
+                          uint8_t cycles, const uint32_t* execution,
+                          CycleLog* log) {
+    uint32_t delay;
+    uint8_t i;
+
+    for (i = 0; i < cycles; i++) {
+        if (log != NULL) {
+            log->start[log->cycles++] = monitor->release;
+            log->safe += deadline_alarm(monitor) ? 1u : 0u;
+        }
+
+        now += execution[i];
+        delay = deadline_end(monitor, now);
+        now += delay;
+
+        /* A wait ends at the next release, at most a period away; no
+           wait only for a release already past. */
+        if ((delay > monitor->period) ||
+            ((delay != 0u) && (now != monitor->release)) ||
+            ((int32_t)(now - monitor->release) < 0)) {
+            violations++;
+        }
+    }
+
+    return now;
+}
+
+static void testOnTime (void) {
+    static const uint32_t execution[16] = {
+        3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3
+    };
+    static const uint32_t atDeadline[1] = {PERIOD};
+    DeadlineMonitor monitor;
+    uint32_t now;
+
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, 1000u);
+    now = simulate(&monitor, 1000u, 16u, execution, NULL);
+
+    HOST_CHECK((monitor.cycles == 16u) && (monitor.misses == 0u) &&
+               (monitor.skipped == 0u));
+    HOST_CHECK((now == 1160u) && (monitor.release == 1160u));
+
+    /* Exactly at the deadline is not a miss. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, 0u);
+    (void)simulate(&monitor, 0u, 1u, atDeadline, NULL);
+
+    HOST_CHECK((monitor.misses == 0u) && (monitor.release == PERIOD));
+}
+
+static void testOverrun (void) {
+    DeadlineMonitor monitor;
+    CycleLog log = {{0}, 0, 0};
+    uint32_t now;
+    uint8_t i;
+    bool onGrid = true;
+
+    /* Skip: the releases at 30 and 40 are dropped. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, 0u);
+    (void)simulate(&monitor, 0u, OVERRUN_CYCLES, overrun, &log);
+
+    HOST_CHECK((monitor.misses == 1u) && (monitor.maxLateness == 15u));
+    HOST_CHECK((monitor.skipped == 2u) && (monitor.caughtUp == 0u));
+    HOST_CHECK(!deadline_alarm(&monitor) && (log.safe == 0u));
+    HOST_CHECK(log.start[3] == 50u);
+
+    for (i = 0; i < OVERRUN_CYCLES; i++) {
+        onGrid = onGrid && ((log.start[i] % PERIOD) == 0u);
+    }
+
+    HOST_CHECK(onGrid);
+
+    /* Catch-up: 30, 40 and 50 run late, back to back. */
+    log.cycles = 0;
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_CATCH_UP, 0u);
+    now = simulate(&monitor, 0u, OVERRUN_CYCLES, overrun, &log);
+
+    HOST_CHECK((monitor.skipped == 0u) && (monitor.caughtUp == 3u));
+    HOST_CHECK((monitor.misses == 3u) && (monitor.maxLateness == 15u));
+    HOST_CHECK((log.start[3] == 30u) && (log.start[4] == 40u) &&
+               (log.start[5] == 50u));
+    HOST_CHECK(now == 60u);
+
+    /* Safe: as skip, and the three cycles after the miss run safe. */
+    log.cycles = 0;
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SAFE, 0u);
+    (void)simulate(&monitor, 0u, OVERRUN_CYCLES, overrun, &log);
+
+    HOST_CHECK((monitor.misses == 1u) && (monitor.skipped == 2u));
+    HOST_CHECK(deadline_alarm(&monitor) && (log.safe == 3u));
+
+    deadline_clearAlarm(&monitor);
+    HOST_CHECK(!deadline_alarm(&monitor));
+}
+
+static void testEdges (void) {
+    static const uint32_t backlog[3] = {3, 100, 3};
+    static const uint32_t limit[2] = {30, 3};
+    static const uint32_t shorter[3] = {7, 3, 3};
+    static const uint32_t growing[2] = {25, 26};
+    static const uint32_t wrapStart = UINT32_MAX - 25u;
+    DeadlineMonitor monitor;
+    CycleLog log = {{0}, 0, 0};
+    uint32_t now;
+
+    /* 9 periods behind: too many to catch up, dropped instead. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_CATCH_UP, 0u);
+    (void)simulate(&monitor, 0u, 3u, backlog, &log);
+
+    HOST_CHECK((monitor.caughtUp == 0u) && (monitor.skipped == 9u));
+    HOST_CHECK((log.start[2] == 110u) && (monitor.maxLateness == 90u));
+
+    /* Behind by exactly the limit: still caught up. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_CATCH_UP, 0u);
+    (void)simulate(&monitor, 0u, 2u, limit, NULL);
+
+    HOST_CHECK((monitor.caughtUp == DEADLINE_MAX_CATCH_UP) &&
+               (monitor.skipped == 0u));
+
+    /* A deadline shorter than the period: a miss, nothing dropped. */
+    deadline_init(&monitor, PERIOD, 5u, DEADLINE_SKIP, 0u);
+    now = simulate(&monitor, 0u, 3u, shorter, NULL);
+
+    HOST_CHECK((monitor.misses == 1u) && (monitor.skipped == 0u));
+    HOST_CHECK((monitor.maxLateness == 2u) && (now == 30u));
+
+    /* Lateness growing by a single tick. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, 0u);
+    (void)simulate(&monitor, 0u, 2u, growing, NULL);
+
+    HOST_CHECK((monitor.misses == 2u) && (monitor.maxLateness == 16u));
+
+    /* A deadline longer than the period is clamped to it. */
+    deadline_init(&monitor, PERIOD, 50u, DEADLINE_SKIP, 0u);
+    HOST_CHECK(monitor.deadline == PERIOD);
+
+    /* The overrun across a tick counter wrap. */
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, wrapStart);
+    now = simulate(&monitor, wrapStart, OVERRUN_CYCLES, overrun, NULL);
+
+    HOST_CHECK((monitor.misses == 1u) && (monitor.skipped == 2u));
+    HOST_CHECK(monitor.maxLateness == 15u);
+    HOST_CHECK(now == (uint32_t)(wrapStart + 80u));
+}
+
+static void testRandom (void) {
+    DeadlineMonitor monitor;
+    uint32_t seed = 1;
+    uint32_t now;
+    uint32_t execution;
+    uint32_t elapsed;
+    uint32_t maxLateness;
+    unsigned long cycle;
+    unsigned long offGrid;
+    unsigned long misses;
+    uint8_t policy;
+
+    for (policy = DEADLINE_SKIP; policy <= DEADLINE_SAFE; policy++) {
+        deadline_init(&monitor, PERIOD, 8u, policy, 0u);
+        now = 0;
+        offGrid = 0;
+        misses = 0;
+        maxLateness = 0;
+
+        for (cycle = 0; cycle < RANDOM_CYCLES; cycle++) {
+            /* Mostly on time; one cycle in twenty up to 6 periods long. */
+            seed = (seed * 1103515245u) + 12345u;
+            execution = (((seed >> 16) % 100u) < 95u) ? ((seed >> 8) % 8u) :
+                                                        ((seed >> 8) % 60u);
+
+            /* Reference miss and lateness of the cycle. */
+            elapsed = now + execution - monitor.release;
+
+            if (elapsed > monitor.deadline) {
+                misses++;
+                maxLateness = ((elapsed - monitor.deadline) > maxLateness) ?
+                              (elapsed - monitor.deadline) : maxLateness;
+            }
+
+            offGrid += ((monitor.release % PERIOD) != 0u) ? 1u : 0u;
+            now = simulate(&monitor, now, 1u, &execution, NULL);
+        }
+
+        printf("policy %u: %lu cycles, %lu misses, %lu skipped, "
+               "%lu caught up, max lateness %lu ticks\n", (unsigned)policy,
+               (unsigned long)monitor.cycles, (unsigned long)monitor.misses,
+               (unsigned long)monitor.skipped,
+               (unsigned long)monitor.caughtUp,
+               (unsigned long)monitor.maxLateness);
+
+        HOST_CHECK(offGrid == 0u);
+        HOST_CHECK((monitor.cycles + monitor.skipped) ==
+                   (monitor.release / PERIOD));
+        HOST_CHECK((monitor.misses == misses) && (misses != 0u));
+        HOST_CHECK(monitor.maxLateness == maxLateness);
+    }
+}
+
+static void benchDeadline (void) {
+    DeadlineMonitor monitor;
+    volatile uint32_t sink = 0;
+    unsigned long i;
+    uint32_t now = 0;
+    double start;
+
+    deadline_init(&monitor, PERIOD, PERIOD, DEADLINE_SKIP, 0u);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS; i++) {
+        now += 3u;
+        now += deadline_end(&monitor, now);
+    }
+
+    sink = now;
+    (void)sink;
+
+    printf("deadline_end on schedule: %.2f ns\n",
+           (hostTest_now() - start) / (double)COST_CALLS);
+    HOST_CHECK(monitor.misses == 0u);
+}
@@ -0,0 +1,339 @@
+/**
+    \file debounceHost.c
+    \brief Host test for the switch debouncing state machine.
+    \details Runs src/debounce.c on the development host, with the sampling
+             period and repeat keys of switches.h:
+             \par
+             - the debounced state of all eight inputs against a plain
+               per-input counter, over random traces: levels held from one
+               sample, shorter than DEBOUNCE_SAMPLES, up to 2 s, and
+               one-sample glitches;
+             - the events of each key against a reference schedule, worked
+               out from the sample its press registered: the long press
+               after DEBOUNCE_LONG_PRESS_MS, then repeats on the repeat keys
+               only, each interval half the previous one down to a sample;
+             - a bouncing SW1 press held 1.2 s, with an SW2 chord in the
+               middle: one press, one long press and one release per key,
+               and the hundredth SW1 action, which takes SP from 0 to
+               100 %, 1025 ms after the press;
+             - debounce_idle() only with every input released and settled;
+             - the cost of an update.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostTest.h"
+#include "switches.h"
+#include "debounce.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Inputs of a sample. */
+#define INPUTS (8u)
+
+/** Samples of the random traces. */
+#define RANDOM_SAMPLES (2000000ul)
+
+/** Samples of the cost measurement. */
+#define COST_SAMPLES (50000000ul)
+
+/** Hold time, in samples, before the long press. */
+#define LONG_TICKS (DEBOUNCE_LONG_PRESS_MS / DEBOUNCE_PERIOD_MS)
+
+/** First repeat interval, in samples. */
+#define REPEAT_TICKS (DEBOUNCE_REPEAT_START_MS / DEBOUNCE_PERIOD_MS)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Reference state of the inputs. */
+typedef struct ReferenceType_struct {
+    uint8_t state;                      /**< Debounced input states. */
+    uint8_t count[INPUTS];              /**< Consecutive differing samples. */
+    uint32_t pressed[DEBOUNCE_KEYS];    /**< Sample each key registered. */
+    uint32_t nextRepeat[DEBOUNCE_KEYS]; /**< Hold time of the next repeat. */
+    uint32_t interval[DEBOUNCE_KEYS];   /**< Interval after that repeat. */
+} ReferenceType;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check state and events against the reference over random traces.
+    \return None
+ */
+static void testRandom (void);
+
+/**
+    \brief Check the bouncing press and chord scenario.
+    \return None
+ */
+static void testScenario (void);
+
+/**
+    \brief Feed a sample to the reference.
+    \param ref Reference state.
+    \param sample Key sample, bit set = key pressed.
+    \param t Sample number.
+    \param events Array receiving the expected key events.
+    \return Number of expected key events.
+ */
+static uint8_t referenceUpdate (ReferenceType* ref, uint8_t sample,
+                                uint32_t t, uint8_t* events);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    DebounceControlType ctrl;
+    uint8_t events[DEBOUNCE_MAX_EVENTS];
+    volatile uint8_t sink = 0;
+    double start;
+    uint32_t t;
+
+    srand(1);
+
+    testRandom();
+    testScenario();
+
+    debounce_init(&ctrl, DEBOUNCE_PERIOD_MS, SWITCH_REPEAT_KEYS);
+    start = hostTest_now();
+
+    for (t = 0; t < COST_SAMPLES; t++) {
+        sink = (uint8_t)(sink + debounce_update(&ctrl, (uint8_t)(t >> 7),
+                                                events));
+    }
+
+    printf("debounce_update: %.1f ns per sample\n",
+           (hostTest_now() - start) / (double)COST_SAMPLES);
+    (void)sink;
+
+    return hostTest_exit();
+}
+
+static void testRandom (void) {
+    DebounceControlType ctrl;
+    ReferenceType ref = {0};
+    uint8_t events[DEBOUNCE_MAX_EVENTS];
+    uint8_t expected[DEBOUNCE_MAX_EVENTS];
+    uint8_t level = 0;
+    uint8_t sample;
+    uint8_t count;
+    uint8_t i;
+    uint32_t until[INPUTS] = {0};
+    uint32_t mismatches = 0;
+    uint32_t idleMismatches = 0;
+    uint32_t eventCount = 0;
+    uint32_t repeats = 0;
+    uint32_t t;
+    bool settled;
+
+    debounce_init(&ctrl, DEBOUNCE_PERIOD_MS, SWITCH_REPEAT_KEYS);
+
+    for (t = 0; t < RANDOM_SAMPLES; t++) {
+        /* Each input holds a level for a random time, up to 2 s; one
+           sample in eight has a glitch on a random input. */
+        for (i = 0; i < INPUTS; i++) {
+            if (t >= until[i]) {
+                level ^= (uint8_t)(1u << i);
+                until[i] = t + 1u + ((uint32_t)rand() % 400u);
+            }
+        }
+
+        sample = level;
+
+        if ((rand() % 8) == 0) {
+            sample ^= (uint8_t)(1u << ((unsigned)rand() % INPUTS));
+        }
+
+        count = debounce_update(&ctrl, sample, events);
+
+        if ((count != referenceUpdate(&ref, sample, t, expected)) ||
+            (ctrl.state != ref.state)) {
+            mismatches++;
+        } else {
+            for (i = 0; i < count; i++) {
+                mismatches += (events[i] != expected[i]) ? 1u : 0u;
+                repeats += (KEY_EVENT_TYPE(events[i]) == KEY_EVENT_REPEAT) ?
+                           1u : 0u;
+            }
+        }
+
+        eventCount += count;
+
+        settled = (ref.state == 0u);
+
+        for (i = 0; i < INPUTS; i++) {
+            settled = settled && (ref.count[i] == 0u);
+        }
+
+        if (debounce_idle(&ctrl) != settled) {
+            idleMismatches++;
+        }
+    }
+
+    printf("random: %lu samples, %lu events, %lu repeats, %lu mismatches\n",
+           (unsigned long)RANDOM_SAMPLES, (unsigned long)eventCount,
+           (unsigned long)repeats, (unsigned long)mismatches);
+
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK(idleMismatches == 0u);
+    HOST_CHECK(repeats > 0u);
+}
+
+static void testScenario (void) {
+    DebounceControlType ctrl;
+    uint8_t events[DEBOUNCE_MAX_EVENTS];
+    uint8_t presses[DEBOUNCE_KEYS] = {0};
+    uint8_t longs[DEBOUNCE_KEYS] = {0};
+    uint8_t releases[DEBOUNCE_KEYS] = {0};
+    uint32_t spSteps = 0;
+    uint32_t pressedMs = 0;
+    uint32_t fullMs = 0;
+    uint8_t sample;
+    uint8_t count;
+    uint8_t type;
+    uint8_t key;
+    uint8_t i;
+    uint32_t t;
+
+    debounce_init(&ctrl, DEBOUNCE_PERIOD_MS, SWITCH_REPEAT_KEYS);
+    HOST_CHECK(debounce_idle(&ctrl));
+
+    /* SW1 from 15 ms to 1215 ms, bouncing for 40 ms at each edge; SW2
+       from 250 ms to 350 ms. */
+    for (t = 0; t < 400u; t++) {
+        sample = 0;
+
+        if ((t >= 3u) && (t < 243u)) {
+            sample |= 0x01u;
+        }
+
+        if (((t < 8u) || ((t >= 240u) && (t < 248u))) && (rand() & 1)) {
+            sample ^= 0x01u;
+        }
+
+        if ((t >= 50u) && (t < 70u)) {
+            sample |= 0x02u;
+        }
+
+        count = debounce_update(&ctrl, sample, events);
+
+        for (i = 0; i < count; i++) {
+            type = KEY_EVENT_TYPE(events[i]);
+            key = (uint8_t)(KEY_EVENT_KEY(events[i]) - 1u);
+
+            if (type == KEY_EVENT_PRESS) {
+                presses[key]++;
+
+                if (key == 0u) {
+                    pressedMs = t * DEBOUNCE_PERIOD_MS;
+                }
+            } else if (type == KEY_EVENT_LONG) {
+                longs[key]++;
+            } else if (type == KEY_EVENT_RELEASE) {
+                releases[key]++;
+            }
+
+            /* A press or a repeat of SW1 raises SP by 1 %. */
+            if ((key == 0u) && ((type == KEY_EVENT_PRESS) ||
+                                (type == KEY_EVENT_REPEAT))) {
+                spSteps++;
+
+                if (spSteps == 100u) {
+                    fullMs = (t * DEBOUNCE_PERIOD_MS) - pressedMs;
+                }
+            }
+        }
+    }
+
+    printf("scenario: SP at 100 %% %lu ms after the press\n",
+           (unsigned long)fullMs);
+
+    HOST_CHECK((presses[0] == 1u) && (longs[0] == 1u) && (releases[0] == 1u));
+    HOST_CHECK((presses[1] == 1u) && (longs[1] == 0u) && (releases[1] == 1u));
+    HOST_CHECK((presses[2] == 0u) && (releases[2] == 0u));
+    HOST_CHECK(fullMs == 1025u);
+    HOST_CHECK(debounce_idle(&ctrl));
+}
+
+static uint8_t referenceUpdate (ReferenceType* ref, uint8_t sample,
+                                uint32_t t, uint8_t* events) {
+    uint8_t count = 0;
+    uint8_t mask;
+    uint8_t i;
+    uint32_t held;
+    bool toggled;
+
+    for (i = 0; i < INPUTS; i++) {
+        mask = (uint8_t)(1u << i);
+
+        if (((sample ^ ref->state) & mask) == 0u) {
+            ref->count[i] = 0;
+            toggled = false;
+        } else if (++ref->count[i] == DEBOUNCE_SAMPLES) {
+            ref->count[i] = 0;
+            ref->state ^= mask;
+            toggled = true;
+        } else {
+            toggled = false;
+        }
+
+        if (i >= DEBOUNCE_KEYS) {
+            continue;
+        }
+
+        if (toggled) {
+            if ((ref->state & mask) != 0u) {
+                events[count++] = KEY_EVENT(KEY_EVENT_PRESS, i + 1u);
+                ref->pressed[i] = t;
+                ref->nextRepeat[i] = LONG_TICKS + REPEAT_TICKS;
+                ref->interval[i] = REPEAT_TICKS;
+            } else {
+                events[count++] = KEY_EVENT(KEY_EVENT_RELEASE, i + 1u);
+            }
+        } else if ((ref->state & mask) != 0u) {
+            held = t - ref->pressed[i];
+
+            if (held == LONG_TICKS) {
+                events[count++] = KEY_EVENT(KEY_EVENT_LONG, i + 1u);
+            } else if (((SWITCH_REPEAT_KEYS & mask) != 0u) &&
+                       (held == ref->nextRepeat[i])) {
+                events[count++] = KEY_EVENT(KEY_EVENT_REPEAT, i + 1u);
+
+                if (ref->interval[i] > 1u) {
+                    ref->interval[i] /= 2u;
+                }
+
+                ref->nextRepeat[i] += ref->interval[i];
+            }
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,465 @@
+/**
+    \file displayDirtyHost.c
+    \brief Host test for the LCD field change tracking.
+    \details Runs src/displayDirty.c and src/coroutine.c on the development
+             host, with the signal ranges of app.c:
+             \par
+             - SP and OP are marked when their displayed value changes, not
+               on every raw change; a mode change marks both; PV is marked
+               on a change of DISPLAY_PV_DEADBAND counts or more;
+             - only a clear-to-dirty change posts the UI task;
+             - a change published after a field was taken, while it is
+               drawn, marks it again;
+             - a simulation of ControllerTask and the LCD coroutine of the
+               UI task, 1 ms ticks for 600 s, against the former 500 ms
+               redraw: field writes, UI wake-ups and the time from a change
+               of a displayed value to its redraw, with the PV settled
+               under ADC noise and with SP steps every 20 s.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostTest.h"
+#include "os.h"
+#include "app_cfg.h"
+#include "units.h"
+#include "controllerSysControl.h"
+#include "coroutine.h"
+#include "displayDirty.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Simulated time, in 1 ms ticks. */
+#define SIM_TICKS (600000ul)
+
+/** Period of the former unconditional redraw, in ticks. */
+#define OLD_REFRESH_TICKS (500u)
+
+/** Period of the SP steps, in ticks. */
+#define STEP_TICKS (20000ul)
+
+/** Peak ADC noise, in raw counts. */
+#define NOISE_COUNTS (2)
+
+/** Value fields: SP, OP and PV. */
+#define VALUE_FIELDS (3u)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Result of a simulation run. */
+typedef struct SimResultType_struct {
+    unsigned long writes;               /**< Value fields drawn. */
+    unsigned long wakeups;              /**< UI task wake-ups. */
+    unsigned long changes;              /**< Displayed value changes. */
+    double latencySum;                  /**< Change to redraw, summed. */
+    uint32_t latencyMax;                /**< Longest change to redraw. */
+} SimResultType;
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Engineering unit range of each signal; as in app.c. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** UI task; only its address is used. */
+static OS_TCB uiTask;
+
+/** Posts to the UI task. */
+static unsigned long posts = 0;
+
+/** Published loop state. */
+static PIDControl published;
+
+/** Current tick of the simulation. */
+static uint32_t now = 0;
+
+/** Raw value each field shows. */
+static int16_t shown[VALUE_FIELDS];
+
+/** Tick each field went stale, while stale. */
+static uint32_t staleSince[VALUE_FIELDS];
+
+/** Field stale: its shown value differs from the published one. */
+static bool stale[VALUE_FIELDS];
+
+/** Results of the run under way. */
+static SimResultType result;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check marking, posting and taking.
+    \return None
+ */
+static void testMarks (void);
+
+/**
+    \brief Simulate ControllerTask and the UI for SIM_TICKS.
+    \param tracked True for change tracking, false for the former redraw.
+    \param steps True for SP steps, false for a settled loop.
+    \param out Results.
+    \return None
+ */
+static void simulate (bool tracked, bool steps, SimResultType* out);
+
+/**
+    \brief Draw a value field and account for its latency.
+    \param field Value field.
+    \return None
+ */
+static void draw (uint8_t field);
+
+/**
+    \brief LCD coroutine, as in app.c without menu regions.
+    \param cr Coroutine.
+    \return Coroutine status.
+ */
+static uint8_t lcdBody (Coroutine* cr);
+
+/**
+    \brief Raw value of a value field in the published state.
+    \param field Value field.
+    \return Raw value.
+ */
+static int16_t publishedValue (uint8_t field);
+
+/**
+    \brief Print a simulation result.
+    \param name Run name.
+    \param r Result.
+    \return None
+ */
+static void printResult (const char* name, const SimResultType* r);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    SimResultType oldSettled;
+    SimResultType newSettled;
+    SimResultType oldSteps;
+    SimResultType newSteps;
+    uint8_t signal;
+
+    for (signal = 0; signal < SIGNALS; signal++) {
+        (void)units_init(&signalUnits[signal], &signalUnitsConfig[signal]);
+    }
+
+    testMarks();
+
+    simulate(false, false, &oldSettled);
+    simulate(true, false, &newSettled);
+    simulate(false, true, &oldSteps);
+    simulate(true, true, &newSteps);
+
+    printResult("settled, 500 ms redraw", &oldSettled);
+    printResult("settled, tracked", &newSettled);
+    printResult("SP steps, 500 ms redraw", &oldSteps);
+    printResult("SP steps, tracked", &newSteps);
+
+    /* Noise alone redraws nothing once settled. */
+    HOST_CHECK(newSettled.writes < (SIM_TICKS / 10000u));
+    HOST_CHECK(newSettled.wakeups < (SIM_TICKS / 10000u));
+
+    /* A change is drawn within the rate cap and a controller period, and
+       at most once per cap. */
+    HOST_CHECK(newSteps.latencyMax <=
+               (DISPLAY_MIN_PERIOD_MS + CONTROLLER_TASK_PERIOD_MS));
+    HOST_CHECK(newSteps.writes <=
+               ((SIM_TICKS / DISPLAY_MIN_PERIOD_MS) * VALUE_FIELDS));
+    HOST_CHECK((newSteps.latencySum / (double)newSteps.changes) <
+               (oldSteps.latencySum / (double)oldSteps.changes));
+
+    return hostTest_exit();
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    (void)opt;
+
+    HOST_CHECK(p_tcb == &uiTask);
+    posts++;
+    *p_err = OS_ERR_NONE;
+
+    return (OS_SEM_CTR)posts;
+}
+
+int32_t toValue (uint8_t signal, int16_t raw) {
+    return units_toEu(&signalUnits[signal], raw);
+}
+
+static void testMarks (void) {
+    PIDControl state = {PID_ON, PID_AUTO, 0, 0, 0, 0, 0, 0};
+    uint8_t field;
+
+    displayDirty_init(&uiTask);
+
+    /* Everything dirty at first, and taken once. */
+    HOST_CHECK(displayDirty_pending());
+
+    for (field = 0; field < DISPLAY_FIELDS; field++) {
+        HOST_CHECK(displayDirty_take(field));
+        HOST_CHECK(!displayDirty_take(field));
+    }
+
+    HOST_CHECK(!displayDirty_pending());
+
+    /* The mode marks SP and OP; then one raw count of SP shows as 0 %,
+       and 11 as 1 %. */
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_SP) && displayDirty_take(DISPLAY_OP));
+    HOST_CHECK(!displayDirty_pending() && (posts == 1u));
+
+    state.sp = 1;
+    displayDirty_check(&state);
+    HOST_CHECK(!displayDirty_pending());
+
+    state.sp = 11;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_SP) && !displayDirty_pending());
+    HOST_CHECK(posts == 2u);
+
+    /* Further changes while dirty post nothing. */
+    state.op = 200;
+    displayDirty_check(&state);
+    state.op = 300;
+    displayDirty_check(&state);
+    HOST_CHECK(posts == 3u);
+    HOST_CHECK(displayDirty_take(DISPLAY_OP) && !displayDirty_pending());
+
+    /* PV within the deadband, then on it, both ways. */
+    state.pv = DISPLAY_PV_DEADBAND - 1;
+    displayDirty_check(&state);
+    HOST_CHECK(!displayDirty_pending());
+
+    state.pv = DISPLAY_PV_DEADBAND;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_PV) && !displayDirty_pending());
+
+    state.pv = 1;
+    displayDirty_check(&state);
+    HOST_CHECK(!displayDirty_pending());
+
+    state.pv = 0;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_PV) && (posts == 5u));
+
+    /* Taken, then changed while drawn: marked again. */
+    HOST_CHECK(!displayDirty_take(DISPLAY_SP));
+    state.sp = 512;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_SP));
+    state.sp = 600;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_pending() && displayDirty_take(DISPLAY_SP));
+
+    /* Set from another task: posts on the first one only. */
+    displayDirty_set(DISPLAY_TREND);
+    displayDirty_set(DISPLAY_TREND);
+    HOST_CHECK(posts == 8u);
+    HOST_CHECK(displayDirty_take(DISPLAY_TREND) && !displayDirty_pending());
+
+    /* Mode alone marks SP and OP, not PV. */
+    state.mode = PID_MAN;
+    displayDirty_check(&state);
+    HOST_CHECK(displayDirty_take(DISPLAY_SP) && displayDirty_take(DISPLAY_OP));
+    HOST_CHECK(!displayDirty_take(DISPLAY_PV));
+}
+
+static void simulate (bool tracked, bool steps, SimResultType* out) {
+    CoroutineScheduler sched;
+    Coroutine lcd;
+    uint32_t nextUi = 0;
+    uint32_t wait;
+    unsigned long lastPosts;
+    double pv = 300.0;
+    double op = 300.0;
+    int16_t sp = 300;
+    int16_t value;
+    uint8_t field;
+    bool changed;
+
+    srand(3);
+
+    result.writes = 0;
+    result.wakeups = 0;
+    result.changes = 0;
+    result.latencySum = 0.0;
+    result.latencyMax = 0;
+
+    published.active = PID_ON;
+    published.mode = PID_AUTO;
+
+    for (field = 0; field < VALUE_FIELDS; field++) {
+        shown[field] = 0;
+        stale[field] = false;
+    }
+
+    displayDirty_init(&uiTask);
+    coroutine_schedInit(&sched);
+    coroutine_add(&sched, &lcd, lcdBody);
+
+    for (now = 0; now < SIM_TICKS; now++) {
+        if ((now % CONTROLLER_TASK_PERIOD_MS) == 0u) {
+            /* ControllerTask: a first-order plant under integral action,
+               ADC noise on the measurement. */
+            if (steps && ((now % STEP_TICKS) == 0u)) {
+                sp = (sp == 300) ? 700 : 300;
+            }
+
+            op += 0.02 * ((double)sp - pv);
+            op = (op < 0.0) ? 0.0 : ((op > 1023.0) ? 1023.0 : op);
+            pv += (op - pv) * 0.01;
+
+            published.sp = sp;
+            published.op = (int16_t)op;
+            published.pv = (int16_t)(pv + (double)((rand() %
+                                     ((2 * NOISE_COUNTS) + 1)) -
+                                     NOISE_COUNTS));
+
+            /* A displayed value went stale: SP and OP by their shown
+               percent, PV by twice the deadband, as noise within the
+               deadband is held back on purpose. */
+            for (field = 0; field < VALUE_FIELDS; field++) {
+                value = publishedValue(field);
+                changed = (field == DISPLAY_PV) ?
+                          (abs(value - shown[field]) >=
+                           (2 * DISPLAY_PV_DEADBAND)) :
+                          (toValue(field, value) !=
+                           toValue(field, shown[field]));
+
+                if (changed && !stale[field]) {
+                    stale[field] = true;
+                    staleSince[field] = now;
+                    result.changes++;
+                }
+            }
+
+            if (tracked) {
+                lastPosts = posts;
+                displayDirty_check(&published);
+
+                if (posts != lastPosts) {
+                    nextUi = now;
+                }
+            }
+        }
+
+        if (!tracked) {
+            if ((now % OLD_REFRESH_TICKS) == 0u) {
+                result.wakeups++;
+
+                for (field = 0; field < VALUE_FIELDS; field++) {
+                    draw(field);
+                }
+            }
+        } else if (now == nextUi) {
+            /* UI task: runs the coroutines and sleeps as they ask. */
+            result.wakeups++;
+            wait = coroutine_run(&sched, now);
+            nextUi = (wait == COROUTINE_FOREVER) ? (now - 1u) : (now + wait);
+        }
+    }
+
+    *out = result;
+}
+
+static void draw (uint8_t field) {
+    uint32_t latency;
+
+    result.writes++;
+    shown[field] = publishedValue(field);
+
+    if (stale[field]) {
+        latency = now - staleSince[field];
+        result.latencySum += (double)latency;
+        result.latencyMax = (latency > result.latencyMax) ? latency :
+                            result.latencyMax;
+        stale[field] = false;
+    }
+}
+
+static uint8_t lcdBody (Coroutine* cr) {
+    uint8_t field;
+
+    COROUTINE_BEGIN(cr);
+
+    while (true) {
+        /* Take every field, as app.c does; only values are drawn here. */
+        for (field = 0; field < DISPLAY_FIELDS; field++) {
+            if (displayDirty_take(field) && (field < VALUE_FIELDS)) {
+                draw(field);
+            }
+        }
+
+        /* Rate cap, then sleep until a field is dirty. */
+        COROUTINE_WAIT_TIMEOUT(cr, false, DISPLAY_MIN_PERIOD_MS);
+        COROUTINE_WAIT_UNTIL(cr, displayDirty_pending());
+    }
+
+    COROUTINE_END(cr);
+}
+
+static int16_t publishedValue (uint8_t field) {
+    if (field == DISPLAY_SP) {
+        return published.sp;
+    }
+
+    if (field == DISPLAY_OP) {
+        return published.op;
+    }
+
+    return published.pv;
+}
+
+static void printResult (const char* name, const SimResultType* r) {
+    printf("%-24s %6.2f writes/s, %5.2f wakeups/s, latency avg %5.1f ms "
+           "max %3lu ms\n", name, (double)r->writes / 600.0,
+           (double)r->wakeups / 600.0,
+           (r->changes != 0u) ? (r->latencySum / (double)r->changes) : 0.0,
+           (unsigned long)r->latencyMax);
+}
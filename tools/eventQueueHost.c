@@ -0,0 +1,316 @@
+/**
+    \file eventQueueHost.c
+    \brief Host stress test for the single-producer/single-consumer event
+           queue.
+    \details Runs src/eventQueue.c on the development host. Events carry a
+             running count, so the consumer can tell a lost, repeated or
+             reordered event:
+             \par
+             - order, capacity, the full and empty cases and the drop count,
+               across the wrap of the free-running indices;
+             - preemption, as with the switch interrupt on the target: a
+               POSIX interval timer signal posts bursts of 1 to
+               EVENT_QUEUE_SIZE events at any point of eventQueue_get() in
+               the main thread; a post to a full queue is dropped and
+               counted, never retried. The main thread handles each event
+               slower than they come, so the queue runs full and a post
+               lands on the slot being read;
+             - threads: a producer thread posting bursts and retrying while
+               the queue is full, and a consumer thread, for the fences of
+               memBarrier.h on the host; each yields when it cannot go on,
+               or a single core would spin away whole time slices.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include "hostTest.h"
+#include "eventQueue.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Timer signal period of the preemption test, in microseconds. */
+#define PREEMPT_PERIOD_US (20)
+
+/** Bursts of the preemption test, one per signal. */
+#define PREEMPT_BURSTS (100000ul)
+
+/** Time the preemption consumer spends on each event, in nanoseconds; it
+    takes fewer events than the timer signal posts. */
+#define HANDLING_NS (3000.0)
+
+/** Bursts of the thread test. */
+#define THREAD_BURSTS (200000ul)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Queue under test. */
+static EventQueue queue;
+
+/** Next event the producer posts. */
+static volatile uint8_t nextEvent = 0;
+
+/** Events posted. */
+static volatile unsigned long posted = 0;
+
+/** Posts refused, queue full. */
+static volatile unsigned long refused = 0;
+
+/** Bursts posted by the timer signal. */
+static volatile unsigned long bursts = 0;
+
+/** Thread producer done. */
+static volatile bool producerDone = false;
+
+/** Events taken by the consumer thread. */
+static unsigned long threadTaken = 0;
+
+/** Events out of order at the consumer thread. */
+static unsigned long threadDisorder = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check order, capacity and the drop count on one thread.
+    \return None
+ */
+static void testSequential (void);
+
+/**
+    \brief Get while the timer signal posts.
+    \return None
+ */
+static void testPreemption (void);
+
+/**
+    \brief Post from one thread and get from another.
+    \return None
+ */
+static void testThreads (void);
+
+/**
+    \brief Timer signal handler: one burst of switch events.
+    \param signal Signal number.
+    \return None
+ */
+static void onTimer (int signal);
+
+/**
+    \brief Consumer thread.
+    \param argument Unused.
+    \return Null.
+ */
+static void* consumer (void* argument);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    testSequential();
+    testPreemption();
+    testThreads();
+
+    return hostTest_exit();
+}
+
+static void testSequential (void) {
+    uint8_t event;
+    uint16_t round;
+    uint8_t i;
+    bool ordered = true;
+    uint8_t expected = 0;
+
+    eventQueue_init(&queue);
+    HOST_CHECK(eventQueue_isEmpty(&queue));
+    HOST_CHECK(!eventQueue_get(&queue, &event));
+
+    /* Fill and drain, enough rounds to wrap the 8-bit indices. */
+    for (round = 0; round < 100u; round++) {
+        for (i = 0; i < EVENT_QUEUE_SIZE; i++) {
+            ordered = ordered && eventQueue_post(&queue, (uint8_t)(expected +
+                                                                   i));
+        }
+
+        ordered = ordered && !eventQueue_post(&queue, 0xFFu);
+
+        for (i = 0; i < EVENT_QUEUE_SIZE; i++) {
+            ordered = ordered && eventQueue_get(&queue, &event) &&
+                      (event == expected);
+            expected++;
+        }
+
+        ordered = ordered && eventQueue_isEmpty(&queue);
+    }
+
+    HOST_CHECK(ordered);
+    HOST_CHECK(queue.dropped == 100u);
+}
+
+static void testPreemption (void) {
+    struct sigaction action;
+    struct itimerval timer;
+    unsigned long taken = 0;
+    unsigned long disorder = 0;
+    uint8_t expected = 0;
+    uint8_t event;
+    double start;
+
+    eventQueue_init(&queue);
+    nextEvent = 0;
+    posted = 0;
+    refused = 0;
+
+    action.sa_handler = onTimer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, (struct sigaction*)0);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = PREEMPT_PERIOD_US;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    while (bursts < PREEMPT_BURSTS) {
+        if (eventQueue_get(&queue, &event)) {
+            if (event != expected) {
+                disorder++;
+            }
+
+            expected = (uint8_t)(event + 1u);
+            taken++;
+
+            for (start = hostTest_now();
+                 (hostTest_now() - start) < HANDLING_NS;) {
+            }
+        }
+    }
+
+    timer.it_value.tv_usec = 0;
+    timer.it_interval.tv_usec = 0;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    while (eventQueue_get(&queue, &event)) {
+        disorder += (event != expected) ? 1u : 0u;
+        expected = (uint8_t)(event + 1u);
+        taken++;
+    }
+
+    printf("preemption: %lu posted, %lu refused, %lu taken, %lu out of "
+           "order\n", (unsigned long)posted, (unsigned long)refused, taken,
+           disorder);
+
+    HOST_CHECK(taken == posted);
+    HOST_CHECK(disorder == 0u);
+    HOST_CHECK((uint8_t)refused == queue.dropped);
+}
+
+static void testThreads (void) {
+    pthread_t thread;
+    unsigned long burst;
+    unsigned long n;
+    unsigned long i;
+
+    eventQueue_init(&queue);
+    nextEvent = 0;
+    posted = 0;
+    refused = 0;
+
+    pthread_create(&thread, (pthread_attr_t*)0, consumer, (void*)0);
+
+    for (burst = 0; burst < THREAD_BURSTS; burst++) {
+        n = 1u + (burst % EVENT_QUEUE_SIZE);
+
+        for (i = 0; i < n; i++) {
+            while (!eventQueue_post(&queue, nextEvent)) {
+                refused++;
+                sched_yield();
+            }
+
+            nextEvent++;
+            posted++;
+        }
+    }
+
+    producerDone = true;
+    pthread_join(thread, (void**)0);
+
+    printf("threads: %lu posted, %lu full retries, %lu taken, %lu out of "
+           "order\n", (unsigned long)posted, (unsigned long)refused,
+           threadTaken, threadDisorder);
+
+    HOST_CHECK(threadTaken == posted);
+    HOST_CHECK(threadDisorder == 0u);
+}
+
+static void onTimer (int signal) {
+    unsigned long n = 1u + (bursts % EVENT_QUEUE_SIZE);
+    unsigned long i;
+
+    (void)signal;
+
+    for (i = 0; i < n; i++) {
+        /* An interrupt cannot wait for room: the event is lost. */
+        if (eventQueue_post(&queue, nextEvent)) {
+            nextEvent++;
+            posted++;
+        } else {
+            refused++;
+        }
+    }
+
+    bursts++;
+}
+
+static void* consumer (void* argument) {
+    uint8_t expected = 0;
+    uint8_t event;
+
+    (void)argument;
+
+    for (;;) {
+        if (eventQueue_get(&queue, &event)) {
+            if (event != expected) {
+                threadDisorder++;
+            }
+
+            expected = (uint8_t)(event + 1u);
+            threadTaken++;
+        } else if (producerDone && eventQueue_isEmpty(&queue)) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+
+    return (void*)0;
+}
@@ -0,0 +1,398 @@
+/**
+    \file fastLoopHost.c
+    \brief Host test for the interrupt-context fast control loop.
+    \details Runs src/fastLoop.c on the development host, with the stand-in
+             headers of tools/host for the board and kernel:
+             \par
+             - each automatic mode step against a reference PID history
+               kept here, over random PV samples;
+             - manual mode (SP follows PV, the operator OP) and the bumpless
+               return to automatic mode;
+             - one snapshot per FAST_LOOP_DECIMATION samples, with the PV
+               extremes of its window;
+             - the snapshot hand-off under preemption: a POSIX interval
+               timer signal plays the CMT1 interrupt and runs a window of
+               samples at any point of fastLoop_getSnapshot(), which must
+               never return a snapshot mixed from two windows;
+             - the cost of a step.
+             \par
+             Built at -O0 for the hand-off check: at -O2 x86 compilers
+             copy the 16-byte snapshot with a single vector load, which no
+             signal can split. The cost figure wants -O2. Built and run by
+             make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/time.h>
+#include "hostTest.h"
+#include "platform.h"
+#include "S12ADC.h"
+#include "DAC.h"
+#include "menu.h"
+#include "controllerSysControl.h"
+#include "controller.h"
+#include "fastLoop.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Random steps checked against the reference. */
+#define REFERENCE_STEPS (100000u)
+
+/** PV period of the preemption test; the PV of sample n is n % PV_SPAN. */
+#define PV_SPAN (1000u)
+
+/** Timer signal period of the preemption test, in microseconds. */
+#define PREEMPT_PERIOD_US (10)
+
+/** Length of the preemption test, in seconds. */
+#define PREEMPT_SECONDS (2)
+
+/** Steps of the cost measurement. */
+#define COST_STEPS (10000000ul)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** PID control structure variable. */
+PIDControl pid = {PID_ON, PID_AUTO, 500, 0, 0, 0, 0, 0};
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Samples stepped since start. */
+static volatile uint32_t steps = 0;
+
+/** Preemption test over. */
+static volatile sig_atomic_t preemptDone = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the steps against the reference PID history, in automatic
+           and manual mode.
+    \return None
+ */
+static void testSteps (void);
+
+/**
+    \brief Check the snapshots published by a run of whole windows.
+    \return None
+ */
+static void testDecimation (void);
+
+/**
+    \brief Read snapshots while the timer signal steps the loop.
+    \return None
+ */
+static void testPreemption (void);
+
+/**
+    \brief Step the loop and count the sample.
+    \param pv Process variable.
+    \return Controller output.
+ */
+static int16_t step (int16_t pv);
+
+/**
+    \brief Timer signal handler: one fast loop interrupt.
+    \param signal Signal number.
+    \return None
+ */
+static void onTimer (int signal);
+
+/**
+    \brief Reference PID output.
+    \param u Previous outputs, newest first.
+    \param e Errors, newest first.
+    \return Clamped output.
+ */
+static int16_t referenceOp (const int16_t* u, const int16_t* e);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    FastLoopSnapshot snapshot;
+    volatile int16_t sink = 0;
+    double start;
+    double ns;
+    uint32_t i;
+
+    srand(1);
+
+    testSteps();
+    testDecimation();
+    testPreemption();
+
+    pid.mode = PID_AUTO;
+    start = hostTest_now();
+
+    for (i = 0; i < COST_STEPS; i++) {
+        sink = fastLoop_step((int16_t)(400u + (i & 255u)));
+    }
+
+    ns = (hostTest_now() - start) / (double)COST_STEPS;
+    (void)fastLoop_getSnapshot(&snapshot);
+    (void)sink;
+
+    printf("fastLoop_step: %.1f ns per sample\n", ns);
+
+    return hostTest_exit();
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+void DAC_set (uint16_t dacNewValue) {
+    (void)dacNewValue;
+}
+
+static void testSteps (void) {
+    int16_t u[3] = {0, 0, 0};
+    int16_t e[3] = {0, 0, 0};
+    int16_t pv;
+    int16_t op;
+    int16_t expected;
+    uint32_t mismatches = 0;
+    uint32_t i;
+
+    pid.mode = PID_AUTO;
+    pid.sp = 500;
+
+    for (i = 0; i < REFERENCE_STEPS; i++) {
+        pv = (int16_t)(rand() % 1024);
+
+        insertArray(e, (int16_t)(pid.sp - pv));
+        expected = referenceOp(u, e);
+        insertArray(u, expected);
+
+        op = step(pv);
+
+        if (op != expected) {
+            mismatches++;
+        }
+    }
+
+    HOST_CHECK(mismatches == 0u);
+
+    /* Manual mode: the operator output, SP on PV and no error. */
+    pid.mode = PID_MAN;
+    pid.op = 321;
+
+    for (i = 0; i < 3u; i++) {
+        op = step(600);
+        HOST_CHECK(op == 321);
+        insertArray(e, 0);
+        insertArray(u, op);
+    }
+
+    /* Back in automatic mode, the first output starts from the manual
+       one with a clean error history. */
+    pid.mode = PID_AUTO;
+    pid.sp = 610;
+
+    insertArray(e, 10);
+    expected = referenceOp(u, e);
+    HOST_CHECK(e[1] == 0);
+    HOST_CHECK(e[2] == 0);
+    HOST_CHECK(step(600) == expected);
+}
+
+static void testDecimation (void) {
+    FastLoopSnapshot snapshot;
+    uint32_t samples;
+    uint32_t i;
+    int16_t pv;
+    int16_t low = 1023;
+    int16_t high = 0;
+
+    /* Align with a window and consume what the step test left. */
+    while ((steps % FAST_LOOP_DECIMATION) != 0u) {
+        (void)step(100);
+    }
+
+    samples = steps;
+    (void)fastLoop_getSnapshot(&snapshot);
+    HOST_CHECK(!fastLoop_getSnapshot(&snapshot));
+
+    pid.mode = PID_AUTO;
+    pid.sp = 700;
+
+    for (i = 0; i < FAST_LOOP_DECIMATION; i++) {
+        pv = (int16_t)(200u + ((i * 37u) % 101u));
+        low = (pv < low) ? pv : low;
+        high = (pv > high) ? pv : high;
+
+        (void)step(pv);
+
+        if (i < (FAST_LOOP_DECIMATION - 1u)) {
+            HOST_CHECK(!fastLoop_getSnapshot(&snapshot));
+        }
+    }
+
+    HOST_CHECK(fastLoop_getSnapshot(&snapshot));
+    HOST_CHECK(snapshot.samples == samples + FAST_LOOP_DECIMATION);
+    HOST_CHECK(snapshot.pvMin == low);
+    HOST_CHECK(snapshot.pvMax == high);
+    HOST_CHECK(snapshot.pv == pv);
+    HOST_CHECK(snapshot.sp == 700);
+    HOST_CHECK(snapshot.er == snapshot.sp - snapshot.pv);
+    HOST_CHECK(!fastLoop_getSnapshot(&snapshot));
+}
+
+static void testPreemption (void) {
+    struct sigaction action;
+    struct itimerval timer;
+    FastLoopSnapshot snapshot;
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t first;
+    uint32_t n;
+    int16_t low;
+    int16_t high;
+    int16_t pv;
+
+    pid.mode = PID_AUTO;
+    pid.sp = 500;
+
+    /* Sample n has PV n % span; complete the window under way. */
+    while ((steps % FAST_LOOP_DECIMATION) != 0u) {
+        (void)step((int16_t)(steps % PV_SPAN));
+    }
+
+    n = steps;
+    (void)fastLoop_getSnapshot(&snapshot);
+
+    action.sa_handler = onTimer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, (struct sigaction*)0);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = PREEMPT_PERIOD_US;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    while (preemptDone == 0) {
+        if (!fastLoop_getSnapshot(&snapshot)) {
+            continue;
+        }
+
+        reads++;
+
+        /* The window of the snapshot, from its sample count. */
+        first = snapshot.samples - FAST_LOOP_DECIMATION;
+        low = (int16_t)(first % PV_SPAN);
+        high = (int16_t)((snapshot.samples - 1u) % PV_SPAN);
+        pv = high;
+
+        if (high < low) {
+            /* The PV wrapped within the window. */
+            low = 0;
+            high = (int16_t)(PV_SPAN - 1u);
+        }
+
+        if ((snapshot.pv != pv) || (snapshot.pvMin != low) ||
+            (snapshot.pvMax != high) || (snapshot.sp != 500) ||
+            (snapshot.er != (int16_t)(500 - pv))) {
+            torn++;
+        }
+    }
+
+    timer.it_value.tv_usec = 0;
+    timer.it_interval.tv_usec = 0;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    printf("preemption: %lu samples, %lu snapshots read, %lu mixed\n",
+           (unsigned long)(steps - n), (unsigned long)reads,
+           (unsigned long)torn);
+
+    HOST_CHECK(reads > 0u);
+    HOST_CHECK(torn == 0u);
+}
+
+static void onTimer (int signal) {
+    static uint32_t calls = 0;
+    uint32_t i;
+
+    (void)signal;
+
+    if (preemptDone != 0) {
+        return;
+    }
+
+    /* A whole window per signal, so that every preemption publishes. */
+    for (i = 0; i < FAST_LOOP_DECIMATION; i++) {
+        (void)step((int16_t)(steps % PV_SPAN));
+    }
+
+    calls++;
+
+    if (calls >= ((PREEMPT_SECONDS * 1000000) / PREEMPT_PERIOD_US)) {
+        preemptDone = 1;
+    }
+}
+
+static int16_t step (int16_t pv) {
+    steps++;
+
+    return fastLoop_step(pv);
+}
+
+static int16_t referenceOp (const int16_t* u, const int16_t* e) {
+    PIDCoefficients bc;
+    int16_t op;
+
+    getCoefficients_PID(&bc);
+
+    op = (int16_t)(u[0] + (bc.b1 * e[0]) - (bc.b2 * e[1]) + (bc.b3 * e[2]));
+
+    if (op > U_MAX) {
+        op = U_MAX;
+    }
+
+    if (op < U_MIN) {
+        op = U_MIN;
+    }
+
+    return op;
+}
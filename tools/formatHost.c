@@ -0,0 +1,297 @@
+/**
+    \file formatHost.c
+    \brief Host test for the integer and fixed-point formatter.
+    \details Runs src/format.c on the development host against the C
+             library's sprintf(), which format_int() and format_fixed()
+             replace in the display path:
+             \par
+             - every value in -40000..40000 with 0 to 4 decimals and field
+               widths 0 to 8;
+             - the int32_t edges, INT32_MIN included, with 0 to
+               FORMAT_MAX_DECIMALS decimals and widths 0 to 12;
+             - random int32_t values, decimals and widths;
+             - every int8_t at widths 0 to 4, in FORMAT_INT8_SIZE;
+             - format_appendUnsigned() against "%*lu" at the uint32_t edges
+               and random values, and a chain of appends;
+             - the text, its length, and no write past the terminator or,
+               at widths up to 12, past FORMAT_INT32_SIZE;
+             - the cost of "%3d" and of one decimal, against sprintf().
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostTest.h"
+#include "format.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Random cases. */
+#define RANDOM_CASES (3000000ul)
+
+/** Calls of each cost measurement. */
+#define COST_CALLS (20000000ul)
+
+/** Guard bytes after the output buffer. */
+#define GUARD_SIZE (8u)
+
+/** Guard byte value. */
+#define GUARD_BYTE ('X')
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Powers of ten, one per number of decimals. */
+static const double powers[FORMAT_MAX_DECIMALS + 1u] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+};
+
+/** Cases checked. */
+static unsigned long cases = 0;
+
+/** Cases that differ from sprintf(). */
+static unsigned long mismatches = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check one case against sprintf().
+    \param value Value, scaled by 10^decimals.
+    \param decimals Number of decimals.
+    \param width Minimum field width.
+    \param size Buffer size the caller would provide.
+    \return None
+ */
+static void check (int32_t value, uint8_t decimals, uint8_t width,
+                   uint8_t size);
+
+/**
+    \brief Check one format_appendUnsigned() case against sprintf().
+    \param value Value to append.
+    \param width Minimum field width.
+    \return None
+ */
+static void checkUnsigned (uint32_t value, uint8_t width);
+
+/**
+    \brief Time format_int(), format_fixed() and sprintf().
+    \return None
+ */
+static void benchFormat (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    static const int32_t edges[] = {
+        INT32_MIN, INT32_MIN + 1, INT32_MAX, -1, 0, 1, 999999999,
+        -1000000000
+    };
+    static const uint32_t unsignedEdges[] = {
+        0u, 1u, 9u, 10u, 999999999u, 1000000000u, (uint32_t)INT32_MAX,
+        (uint32_t)INT32_MAX + 1u, UINT32_MAX
+    };
+    char text[32];
+    char* position;
+    int32_t value;
+    unsigned long i;
+    uint8_t decimals;
+    uint8_t width;
+
+    srand(7);
+
+    for (value = -40000; value <= 40000; value++) {
+        for (decimals = 0; decimals <= 4u; decimals++) {
+            for (width = 0; width <= 8u; width++) {
+                check(value, decimals, width, FORMAT_INT32_SIZE);
+            }
+        }
+    }
+
+    for (i = 0; i < (sizeof(edges) / sizeof(edges[0])); i++) {
+        for (decimals = 0; decimals <= FORMAT_MAX_DECIMALS; decimals++) {
+            for (width = 0; width <= 12u; width++) {
+                check(edges[i], decimals, width, FORMAT_INT32_SIZE);
+            }
+        }
+    }
+
+    for (i = 0; i < RANDOM_CASES; i++) {
+        value = (int32_t)(((uint32_t)rand() << 16) ^ (uint32_t)rand());
+        check(value, (uint8_t)((unsigned)rand() % (FORMAT_MAX_DECIMALS + 1u)),
+              (uint8_t)((unsigned)rand() % 13u), FORMAT_INT32_SIZE);
+    }
+
+    for (value = INT8_MIN; value <= INT8_MAX; value++) {
+        for (width = 0; width <= 4u; width++) {
+            check(value, 0u, width, FORMAT_INT8_SIZE);
+        }
+    }
+
+    for (i = 0; i < (sizeof(unsignedEdges) / sizeof(unsignedEdges[0]));
+         i++) {
+        for (width = 0; width <= 12u; width++) {
+            checkUnsigned(unsignedEdges[i], width);
+        }
+    }
+
+    for (i = 0; i < RANDOM_CASES; i++) {
+        checkUnsigned(((uint32_t)rand() << 16) ^ (uint32_t)rand(),
+                      (uint8_t)((unsigned)rand() % 13u));
+    }
+
+    printf("sprintf equivalence: %lu cases, %lu mismatches\n", cases,
+           mismatches);
+    HOST_CHECK(mismatches == 0u);
+
+    /* Appends chain, each terminating the text so far. */
+    position = format_append(text, "a=");
+    position = format_appendUnsigned(position, 42u, 4u);
+    HOST_CHECK(strcmp(text, "a=  42") == 0);
+    position = format_append(position, "");
+    position = format_append(position, " ok");
+    HOST_CHECK((strcmp(text, "a=  42 ok") == 0) &&
+               (position == (text + 9)));
+
+    benchFormat();
+
+    return hostTest_exit();
+}
+
+static void check (int32_t value, uint8_t decimals, uint8_t width,
+                   uint8_t size) {
+    char expected[64];
+    char out[FORMAT_INT32_SIZE + GUARD_SIZE];
+    uint8_t length;
+    uint8_t i;
+    bool guarded = true;
+
+    if (decimals == 0u) {
+        sprintf(expected, "%*d", (int)width, (int)value);
+    } else {
+        sprintf(expected, "%*.*f", (int)width, (int)decimals,
+                (double)value / powers[decimals]);
+    }
+
+    memset(out, GUARD_BYTE, sizeof(out));
+
+    if ((decimals == 0u) && ((rand() & 1) != 0)) {
+        length = format_int(out, value, width);
+    } else {
+        length = format_fixed(out, value, decimals, width);
+    }
+
+    /* Nothing past the terminator, nor past the buffer size. */
+    for (i = (uint8_t)(length + 1u); i < sizeof(out); i++) {
+        guarded = guarded && (out[i] == GUARD_BYTE);
+    }
+
+    guarded = guarded && (length < size);
+    cases++;
+
+    if ((strcmp(expected, out) != 0) || (length != strlen(expected)) ||
+        !guarded) {
+        if (mismatches < 10u) {
+            printf("%ld / 10^%u, width %u: sprintf \"%s\", got \"%.*s\" "
+                   "(%u)\n", (long)value, (unsigned)decimals,
+                   (unsigned)width, expected, (int)(length + 1u), out,
+                   (unsigned)length);
+        }
+
+        mismatches++;
+    }
+}
+
+static void checkUnsigned (uint32_t value, uint8_t width) {
+    char expected[64];
+    char out[FORMAT_INT32_SIZE + GUARD_SIZE];
+    char* end;
+    uint8_t i;
+    bool guarded = true;
+
+    sprintf(expected, "%*lu", (int)width, (unsigned long)value);
+    memset(out, GUARD_BYTE, sizeof(out));
+    end = format_appendUnsigned(out, value, width);
+
+    for (i = (uint8_t)((end - out) + 1); i < sizeof(out); i++) {
+        guarded = guarded && (out[i] == GUARD_BYTE);
+    }
+
+    cases++;
+
+    if ((strcmp(expected, out) != 0) ||
+        ((size_t)(end - out) != strlen(expected)) || !guarded) {
+        if (mismatches < 10u) {
+            printf("%lu, width %u: sprintf \"%s\", got \"%.*s\"\n",
+                   (unsigned long)value, (unsigned)width, expected,
+                   (int)((end - out) + 1), out);
+        }
+
+        mismatches++;
+    }
+}
+
+static void benchFormat (void) {
+    char out[FORMAT_INT32_SIZE + 3u];
+    volatile unsigned sink = 0;
+    unsigned long i;
+    double start;
+    double formatInt;
+    double formatFixed;
+    double library;
+
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS; i++) {
+        (void)format_int(out, (int32_t)(i % 101u), 3u);
+        sink += (unsigned)out[2];
+    }
+
+    formatInt = (hostTest_now() - start) / (double)COST_CALLS;
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS; i++) {
+        (void)format_fixed(out, (int32_t)(i % 1001u), 1u, 5u);
+        sink += (unsigned)out[2];
+    }
+
+    formatFixed = (hostTest_now() - start) / (double)COST_CALLS;
+    start = hostTest_now();
+
+    for (i = 0; i < (COST_CALLS / 10u); i++) {
+        sprintf(out, "%3d", (int)(i % 101u));
+        sink += (unsigned)out[2];
+    }
+
+    library = (hostTest_now() - start) / (double)(COST_CALLS / 10u);
+
+    printf("format_int \"%%3d\": %.1f ns, format_fixed 1 decimal: %.1f ns, "
+           "sprintf \"%%3d\": %.1f ns\n", formatInt, formatFixed, library);
+    (void)sink;
+}
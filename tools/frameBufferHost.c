@@ -0,0 +1,397 @@
+/**
+    \file frameBufferHost.c
+    \brief Host test for the LCD frame buffer.
+    \details Runs src/frameBuffer.c and the menu on the development host.
+             The LCD driver is a shadow screen here, so after every flush
+             its text image must equal frameBuffer_dump():
+             \par
+             - a flush without changes sends nothing, a changed cell one
+               transfer of one character, a clear one lcd_clear();
+             - changed runs merge across up to FB_MERGE_GAP unchanged
+               cells, never across an attribute change;
+             - text is clipped at the row end, out of range rows dropped;
+             - random text, attributes, positions and clears;
+             - random key presses through menuDispatch() and menuRender(),
+               each followed by a print of SP, OP and PV as the LCD
+               coroutine does, with the LCD traffic per action.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostTest.h"
+#include "platform.h"
+#include "lcd.h"
+#include "os.h"
+#include "cpu_core.h"
+#include "S12ADC.h"
+#include "units.h"
+#include "controllerSysControl.h"
+#include "pidSnapshot.h"
+#include "frameBuffer.h"
+#include "menu.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Drawing operations of the random test. */
+#define RANDOM_OPERATIONS (200000ul)
+
+/** Key presses of the menu test. */
+#define MENU_ACTIONS (100000ul)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
+
+/** Engineering unit range of each signal; as in app.c. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+/** PID control structure variable. */
+PIDControl pid = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
+
+/* Board and kernel stand-ins. */
+
+volatile uint8_t LED4;
+volatile uint8_t LED7;
+volatile uint8_t LED13;
+
+OS_TCB* OSTCBHighRdyPtr;
+OS_TCB OSIdleTaskTCB;
+OS_CPU_USAGE OSStatTaskCPUUsage;
+OS_CTX_SW_CTR OSTaskCtxSwCtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Characters the shadow LCD shows. */
+static char lcdText[FB_ROWS][FB_COLS];
+
+/** Inverted attribute of each shadow LCD cell. */
+static bool lcdInverted[FB_ROWS][FB_COLS];
+
+/** LCD transfers, clears included. */
+static unsigned long lcdTransfers = 0;
+
+/** Characters sent to the LCD. */
+static unsigned long lcdChars = 0;
+
+/** Flushes whose LCD image differed from the frame buffer. */
+static unsigned long mismatches = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check flush, merging and clipping on chosen cells.
+    \return None
+ */
+static void testFlush (void);
+
+/**
+    \brief Check random drawing.
+    \return None
+ */
+static void testRandom (void);
+
+/**
+    \brief Check the menu under random key presses.
+    \return None
+ */
+static void testMenu (void);
+
+/**
+    \brief Flush and compare the shadow LCD with the frame buffer.
+    \return Number of LCD transfers of the flush.
+ */
+static uint8_t flush (void);
+
+/**
+    \brief Write text to the shadow LCD.
+    \param position LCD position, see LCD_XY().
+    \param string Null terminated text.
+    \param inverted Inverted attribute.
+    \return None
+ */
+static void lcdPut (uint16_t position, const uint8_t* string,
+                    bool inverted);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    srand(1);
+
+    initUnits();
+
+    testFlush();
+    testRandom();
+    testMenu();
+
+    HOST_CHECK(mismatches == 0u);
+
+    return hostTest_exit();
+}
+
+void lcd_clear (void) {
+    memset(lcdText, ' ', sizeof(lcdText));
+    memset(lcdInverted, 0, sizeof(lcdInverted));
+    lcdTransfers++;
+}
+
+void lcd_display (uint16_t position, const uint8_t* string) {
+    lcdPut(position, string, false);
+}
+
+void lcd_display_inverted (uint16_t position, const uint8_t* string) {
+    lcdPut(position, string, true);
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return 0u;
+}
+
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err) {
+    *p_err = CPU_ERR_NONE;
+
+    return 0u;
+}
+
+uint32_t tickless_wakeups (void) {
+    return 0u;
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+static void testFlush (void) {
+    unsigned long chars;
+
+    /* A clear is one transfer, then nothing is left to send. */
+    frameBuffer_clear();
+    HOST_CHECK(flush() == 1u);
+    HOST_CHECK(flush() == 0u);
+
+    /* One cell; rewriting the same text sends nothing. */
+    chars = lcdChars;
+    frameBuffer_display(FB_XY(5, 2), "A");
+    HOST_CHECK(flush() == 1u);
+    HOST_CHECK(lcdChars == chars + 1u);
+    frameBuffer_display(FB_XY(5, 2), "A");
+    HOST_CHECK(flush() == 0u);
+
+    /* Changes 3 unchanged cells apart merge; 4 apart do not. */
+    chars = lcdChars;
+    frameBuffer_display(FB_XY(1, 3), "x");
+    frameBuffer_display(FB_XY(5, 3), "y");
+    HOST_CHECK(flush() == 1u);
+    HOST_CHECK(lcdChars == chars + 5u);
+
+    frameBuffer_display(FB_XY(1, 4), "x");
+    frameBuffer_display(FB_XY(6, 4), "y");
+    HOST_CHECK(flush() == 2u);
+
+    /* An attribute change ends a run. */
+    frameBuffer_display(FB_XY(1, 5), "ab");
+    frameBuffer_displayInverted(FB_XY(3, 5), "cd");
+    HOST_CHECK(flush() == 2u);
+    frameBuffer_display(FB_XY(3, 5), "cd");
+    HOST_CHECK(flush() == 1u);
+
+    /* Clipped at the row end; rows out of range are dropped. */
+    frameBuffer_display(FB_XY(14, 6), "clipped");
+    frameBuffer_display(FB_XY(1, 0), "none");
+    frameBuffer_display(FB_XY(1, FB_ROWS + 1u), "none");
+    frameBuffer_display(FB_XY(0, 7), "none");
+    HOST_CHECK(flush() == 1u);
+    HOST_CHECK(memcmp(&lcdText[5][13], "cli", 3) == 0);
+}
+
+static void testRandom (void) {
+    char text[FB_COLS + 2u];
+    unsigned long op;
+    unsigned long flushes = 0;
+    uint8_t length;
+    uint8_t i;
+
+    for (op = 0; op < RANDOM_OPERATIONS; op++) {
+        length = (uint8_t)(1u + ((unsigned)rand() % (FB_COLS + 1u)));
+
+        for (i = 0; i < length; i++) {
+            /* A small alphabet, so rewrites often match what is shown. */
+            text[i] = (char)('a' + (rand() % 3));
+        }
+
+        text[length] = '\0';
+
+        if ((rand() % 500) == 0) {
+            frameBuffer_clear();
+        } else if ((rand() % 4) == 0) {
+            frameBuffer_displayInverted(FB_XY(1 + (rand() % FB_COLS),
+                                              1 + (rand() % FB_ROWS)), text);
+        } else {
+            frameBuffer_display(FB_XY(1 + (rand() % FB_COLS),
+                                      1 + (rand() % FB_ROWS)), text);
+        }
+
+        if ((rand() % 3) == 0) {
+            (void)flush();
+            flushes++;
+        }
+    }
+
+    (void)flush();
+
+    printf("random: %lu operations, %lu flushes, %lu mismatches\n",
+           RANDOM_OPERATIONS, flushes + 1u, mismatches);
+}
+
+static void testMenu (void) {
+    PIDSnapshot state;
+    unsigned long transfers;
+    unsigned long chars;
+    unsigned long i;
+
+    frameBuffer_clear();
+    (void)flush();
+
+    transfers = lcdTransfers;
+    chars = lcdChars;
+    printMainMenu();
+    (void)flush();
+
+    printf("printMainMenu: %lu transfers, %lu chars\n",
+           lcdTransfers - transfers, lcdChars - chars);
+
+    transfers = lcdTransfers;
+    chars = lcdChars;
+
+    for (i = 0; i < MENU_ACTIONS; i++) {
+        (void)menuRender(menuDispatch((uint8_t)(1 + (rand() % 3))));
+
+        /* The loop moves on meanwhile. */
+        pid.pv = (int16_t)(300 + (rand() % 9));
+
+        if (pid.mode == PID_MAN) {
+            pid.sp = pid.pv;
+        } else {
+            pid.op = (int16_t)((i * 13u) % 1024u);
+        }
+
+        state.active = pid.active;
+        state.mode = pid.mode;
+        state.sp = pid.sp;
+        state.op = pid.op;
+        state.pv = pid.pv;
+        state.er = pid.er;
+
+        printSP(&state);
+        printOP(&state);
+        printPV(&state);
+        (void)flush();
+    }
+
+    printf("menu: %lu actions, %.2f transfers and %.2f chars per action\n",
+           MENU_ACTIONS, (double)(lcdTransfers - transfers) / MENU_ACTIONS,
+           (double)(lcdChars - chars) / MENU_ACTIONS);
+}
+
+static uint8_t flush (void) {
+    char lcd[FB_DUMP_SIZE];
+    char buffer[FB_DUMP_SIZE];
+    char* out = lcd;
+    uint8_t transfers;
+    uint8_t row;
+    uint8_t col;
+
+    transfers = frameBuffer_flush();
+
+    for (row = 0; row < FB_ROWS; row++) {
+        for (col = 0; col < FB_COLS; col++) {
+            *out++ = lcdText[row][col];
+        }
+
+        *out++ = ' ';
+
+        for (col = 0; col < FB_COLS; col++) {
+            *out++ = lcdInverted[row][col] ? '#' : '.';
+        }
+
+        *out++ = '\n';
+    }
+
+    *out = '\0';
+    frameBuffer_dump(buffer);
+
+    if (strcmp(lcd, buffer) != 0) {
+        if (mismatches == 0u) {
+            printf("LCD:\n%sframe buffer:\n%s", lcd, buffer);
+        }
+
+        mismatches++;
+    }
+
+    return transfers;
+}
+
+static void lcdPut (uint16_t position, const uint8_t* string,
+                    bool inverted) {
+    uint8_t x = (uint8_t)((position & 0xFFu) - 1u);
+    uint8_t y = (uint8_t)((position >> 8) - 1u);
+
+    HOST_CHECK((x < FB_COLS) && (y < FB_ROWS));
+    lcdTransfers++;
+
+    while ((*string != 0u) && (x < FB_COLS)) {
+        lcdText[y][x] = (char)*string++;
+        lcdInverted[y][x] = inverted;
+        lcdChars++;
+        x++;
+    }
+}
@@ -0,0 +1,75 @@
+/**
+    \file cpu_core.h
+    \brief Host stand-in for the uC/CPU core header.
+    \details Only what the host tools need from uC/CPU: types, an empty
+             critical section and the timestamp timer, which the host tool
+             implements. Single threaded, so nothing needs masking.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef CPU_CORE_H
+#define CPU_CORE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+#define DEF_ON (1)
+#define DEF_OFF (0)
+
+#define CPU_ERR_NONE (0u)
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+#define CPU_SR_ALLOC() CPU_SR cpu_sr = 0; (void)cpu_sr
+#define CPU_CRITICAL_ENTER() do { } while (0)
+#define CPU_CRITICAL_EXIT() do { } while (0)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+typedef char CPU_CHAR;
+typedef uint32_t CPU_SR;
+typedef uint32_t CPU_STK;
+typedef uint32_t CPU_STK_SIZE;
+typedef uint32_t CPU_TS;
+typedef uint32_t CPU_TS_TMR;
+typedef uint32_t CPU_TS_TMR_FREQ;
+typedef uint16_t CPU_ERR;
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+/**
+    \brief Read the timestamp timer.
+    \return Timer counts.
+ */
+CPU_TS_TMR CPU_TS_TmrRd (void);
+
+/**
+    \brief Get the timestamp timer frequency.
+    \param p_err Pointer to error code.
+    \return Frequency in Hz, zero if unknown.
+ */
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err);
+
+#endif /* CPU_CORE_H */
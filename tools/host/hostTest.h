@@ -0,0 +1,97 @@
+/**
+    \file hostTest.h
+    \brief Checks and clock of the host test drivers.
+    \details HOST_CHECK() prints each failed condition with its line and
+             counts it; a driver ends with hostTest_exit(), which prints
+             the verdict and gives the exit status. hostTest_now() reads a
+             monotonic clock in nanoseconds for the cost measurements.
+             Define _POSIX_C_SOURCE before the first include, and add a new
+             driver to tools/Makefile, which builds every driver with
+             -Wall -Wextra and runs it.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** Check a condition; count and report it if false. */
+#define HOST_CHECK(condition)                                               \
+    hostTest_check((condition) ? 1 : 0, #condition, __FILE__, __LINE__)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Failed checks. */
+static unsigned long hostFailures = 0;
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+/**
+    \brief Count and report a failed check.
+    \param passed Check result.
+    \param text Condition text.
+    \param file Source file.
+    \param line Source line.
+    \return The check result.
+ */
+static inline int hostTest_check (int passed, const char* text,
+                                  const char* file, int line) {
+    if (!passed) {
+        printf("FAIL %s:%d: %s\n", file, line, text);
+        hostFailures++;
+    }
+
+    return passed;
+}
+
+/**
+    \brief Read the monotonic clock.
+    \return Time, in nanoseconds.
+ */
+static inline double hostTest_now (void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+/**
+    \brief Print the verdict.
+    \return Exit status: EXIT_FAILURE if a check failed.
+ */
+static inline int hostTest_exit (void) {
+    if (hostFailures != 0u) {
+        printf("%lu checks failed\n", hostFailures);
+
+        return EXIT_FAILURE;
+    }
+
+    printf("all checks passed\n");
+
+    return EXIT_SUCCESS;
+}
+
+#endif /* HOST_TEST_H */
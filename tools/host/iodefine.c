@@ -0,0 +1,48 @@
+/**
+    \file iodefine.c
+    \brief Host stand-in for the RX63N peripheral registers.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include "iodefine.h"
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+HOST_PORT PORT0;
+HOST_PORT PORT2;
+HOST_PORT PORT4;
+HOST_PORT PORT5;
+HOST_PORT PORTE;
+HOST_MPC MPC;
+HOST_SYSTEM SYSTEM;
+HOST_ICU ICU;
+HOST_S12AD S12AD;
+HOST_DA DA;
+HOST_CMT CMT;
+HOST_CMTN CMT0;
+HOST_CMTN CMT1;
+HOST_CMTN CMT2;
+HOST_CMTN CMT3;
+HOST_TMR TMR0;
+HOST_SCI SCI0;
+HOST_SCI SCI2;
+HOST_SCI SCI6;
+HOST_DTC DTC;
+HOST_DMAC DMAC;
+HOST_DMACN DMAC0;
+
+volatile uint8_t hostIR[HOST_VECTORS];
+volatile uint8_t hostIEN[HOST_VECTORS];
+volatile uint8_t hostIPR[HOST_VECTORS];
+volatile uint8_t hostDTCE[HOST_VECTORS];
+volatile uint8_t hostMSTP;
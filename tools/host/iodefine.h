@@ -0,0 +1,253 @@
+/**
+    \file iodefine.h
+    \brief Host stand-in for the RX63N peripheral register header.
+    \details The registers the sources write, as plain variables defined in
+             iodefine.c, so board modules build and run on the host and a
+             host tool can play the peripheral: set a status flag or a
+             received byte, call the interrupt service routine, and read
+             back what the module wrote.
+             \par
+             Every register is one HOST_REG; its BIT view carries each bit
+             field name the sources use, without the hardware layout, so
+             only BYTE, WORD and LONG hold the hardware bit positions.
+             Interrupt request, enable and priority bits are arrays indexed
+             by interrupt source.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef IODEFINE_H
+#define IODEFINE_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Interrupt sources used by the sources. */
+enum HostVector {
+    HOST_VECT_CMI0,
+    HOST_VECT_CMI1,
+    HOST_VECT_CMI2,
+    HOST_VECT_CMI3,
+    HOST_VECT_DMAC0I,
+    HOST_VECT_IRQ8,
+    HOST_VECT_IRQ9,
+    HOST_VECT_IRQ12,
+    HOST_VECT_S12ADI0,
+    HOST_VECT_RXI0,
+    HOST_VECT_TXI0,
+    HOST_VECT_TEI0,
+    HOST_VECT_TXI2,
+    HOST_VECT_RXI6,
+    HOST_VECT_TXI6,
+    HOST_VECT_TEI6,
+    HOST_VECTORS
+};
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+#define IR(module, source) (hostIR[HOST_VECT_##source])
+#define IEN(module, source) (hostIEN[HOST_VECT_##source])
+#define IPR(module, source) (hostIPR[HOST_VECT_##source])
+#define DTCE(module, source) (hostDTCE[HOST_VECT_##source])
+#define VECT(module, source) (HOST_VECT_##source)
+#define MSTP(module) (hostMSTP)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Register, with every bit field name in use. */
+typedef union HostReg_union {
+    uint32_t LONG;
+    uint16_t WORD;
+    uint8_t BYTE;
+    struct {
+        unsigned B0 : 1;
+        unsigned B1 : 1;
+        unsigned B2 : 1;
+        unsigned B3 : 1;
+        unsigned B4 : 1;
+        unsigned B5 : 1;
+        unsigned B6 : 1;
+        unsigned B7 : 1;
+        unsigned ADST : 1;
+        unsigned STR1 : 1;
+        unsigned STR2 : 1;
+        unsigned STR3 : 1;
+        unsigned DTCST : 1;
+        unsigned RRS : 1;
+        unsigned SHORT : 1;
+        unsigned DMST : 1;
+        unsigned DTE : 1;
+        unsigned DTIF : 1;
+        unsigned IRQMD : 2;
+    } BIT;
+} HOST_REG;
+
+/** I/O port. */
+typedef struct HostPort_struct {
+    HOST_REG PDR;
+    HOST_REG PODR;
+    HOST_REG PIDR;
+    HOST_REG PMR;
+} HOST_PORT;
+
+/** Multi-function pin controller. */
+typedef struct HostMpc_struct {
+    HOST_REG PWPR;
+    HOST_REG P00PFS;
+    HOST_REG P01PFS;
+    HOST_REG P05PFS;
+    HOST_REG P20PFS;
+    HOST_REG P21PFS;
+    HOST_REG P40PFS;
+    HOST_REG P41PFS;
+    HOST_REG P42PFS;
+    HOST_REG P43PFS;
+    HOST_REG P44PFS;
+    HOST_REG P50PFS;
+} HOST_MPC;
+
+/** System control. */
+typedef struct HostSystem_struct {
+    HOST_REG PRCR;
+} HOST_SYSTEM;
+
+/** Interrupt controller. */
+typedef struct HostIcu_struct {
+    HOST_REG IRQCR[16];
+    uint8_t DMRSR0;
+} HOST_ICU;
+
+/** 12-bit A/D converter. */
+typedef struct HostS12ad_struct {
+    HOST_REG ADCSR;
+    HOST_REG ADANS0;
+    HOST_REG ADANS1;
+    HOST_REG ADADS0;
+    HOST_REG ADADS1;
+    HOST_REG ADADC;
+    HOST_REG ADCER;
+    HOST_REG ADSTRGR;
+    uint16_t ADDR2;
+    uint16_t ADDR3;
+} HOST_S12AD;
+
+/** D/A converter. */
+typedef struct HostDa_struct {
+    uint16_t DADR1;
+    HOST_REG DACR;
+    HOST_REG DADPR;
+    HOST_REG DAADSCR;
+} HOST_DA;
+
+/** Compare match timer start registers. */
+typedef struct HostCmt_struct {
+    HOST_REG CMSTR0;
+    HOST_REG CMSTR1;
+} HOST_CMT;
+
+/** Compare match timer channel. */
+typedef struct HostCmtn_struct {
+    HOST_REG CMCR;
+    uint16_t CMCNT;
+    uint16_t CMCOR;
+} HOST_CMTN;
+
+/** 8-bit timer channel. */
+typedef struct HostTmr_struct {
+    HOST_REG TCR;
+    HOST_REG TCSR;
+    HOST_REG TCCR;
+    uint8_t TCORA;
+} HOST_TMR;
+
+/** Serial communications interface channel. */
+typedef struct HostSci_struct {
+    HOST_REG SMR;
+    HOST_REG SCR;
+    HOST_REG SSR;
+    HOST_REG SCMR;
+    HOST_REG SEMR;
+    uint8_t BRR;
+    uint8_t TDR;
+    uint8_t RDR;
+} HOST_SCI;
+
+/** Data transfer controller. */
+typedef struct HostDtc_struct {
+    HOST_REG DTCCR;
+    HOST_REG DTCST;
+    HOST_REG DTCADMOD;
+    uint32_t DTCVBR;
+} HOST_DTC;
+
+/** DMA controller module registers. */
+typedef struct HostDmac_struct {
+    HOST_REG DMAST;
+} HOST_DMAC;
+
+/** DMA controller channel. */
+typedef struct HostDmacn_struct {
+    uint32_t DMSAR;
+    uint32_t DMDAR;
+    uint32_t DMCRA;
+    HOST_REG DMTMD;
+    HOST_REG DMINT;
+    HOST_REG DMAMD;
+    HOST_REG DMCNT;
+    HOST_REG DMSTS;
+    HOST_REG DMCSL;
+} HOST_DMACN;
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern HOST_PORT PORT0;
+extern HOST_PORT PORT2;
+extern HOST_PORT PORT4;
+extern HOST_PORT PORT5;
+extern HOST_PORT PORTE;
+extern HOST_MPC MPC;
+extern HOST_SYSTEM SYSTEM;
+extern HOST_ICU ICU;
+extern HOST_S12AD S12AD;
+extern HOST_DA DA;
+extern HOST_CMT CMT;
+extern HOST_CMTN CMT0;
+extern HOST_CMTN CMT1;
+extern HOST_CMTN CMT2;
+extern HOST_CMTN CMT3;
+extern HOST_TMR TMR0;
+extern HOST_SCI SCI0;
+extern HOST_SCI SCI2;
+extern HOST_SCI SCI6;
+extern HOST_DTC DTC;
+extern HOST_DMAC DMAC;
+extern HOST_DMACN DMAC0;
+
+extern volatile uint8_t hostIR[HOST_VECTORS];
+extern volatile uint8_t hostIEN[HOST_VECTORS];
+extern volatile uint8_t hostIPR[HOST_VECTORS];
+extern volatile uint8_t hostDTCE[HOST_VECTORS];
+extern volatile uint8_t hostMSTP;
+
+#endif /* IODEFINE_H */
@@ -0,0 +1,36 @@
+/**
+    \file lcd.h
+    \brief Host stand-in for the board LCD driver header.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef LCD_H
+#define LCD_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+
+
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+/** LCD character position. */
+#define LCD_XY(x, y) ((uint16_t)(((y) << 8) | (x)))
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+void lcd_clear (void);
+void lcd_display (uint16_t position, const uint8_t* string);
+void lcd_display_inverted (uint16_t position, const uint8_t* string);
+
+#endif /* LCD_H */
@@ -0,0 +1,23 @@
+/**
+    \file machine.h
+    \brief Host stand-in for the CCRX intrinsic functions header.
+    \details The interrupt mask and sleep intrinsics do nothing on the
+             host: a host tool calls the interrupt service routines itself,
+             between the statements of the code under test.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef MACHINE_H
+#define MACHINE_H
+
+/******************************************************************************
+*                                   MACROS                                    *
+******************************************************************************/
+
+#define nop() do { } while (0)
+#define wait() do { } while (0)
+#define setpsw_i() do { } while (0)
+#define clrpsw_i() do { } while (0)
+
+#endif /* MACHINE_H */
@@ -0,0 +1,37 @@
+/**
+    \file net.h
+    \brief Host stand-in for the uC/TCP-IP header.
+    \details The BSD socket API of uC/TCP-IP has the names and semantics of
+             the POSIX one, so the host sockets stand in for it and a board
+             service talks to host clients over loopback. Define
+             _POSIX_C_SOURCE 200809L before the first include.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef NET_H
+#define NET_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+#define DEF_DISABLED (0)
+#define DEF_ENABLED (1)
+
+/** BSD API enable, as in net_cfg.h. */
+#define NET_BSD_CFG_API_EN DEF_ENABLED
+
+#endif /* NET_H */
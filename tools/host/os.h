@@ -0,0 +1,120 @@
+/**
+    \file os.h
+    \brief Host stand-in for the uC/OS-III header.
+    \details Only the kernel types, variables and services the host tools
+             link against; no kernel runs on the host. A tool defines the
+             services its modules call, with the behaviour it checks.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef OS_H
+#define OS_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include "cpu_core.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+#define OS_CFG_STAT_TASK_EN (1u)
+#define OS_CFG_TASK_PROFILE_EN (1u)
+#define OS_CFG_STAT_TASK_STK_CHK_EN (1u)
+#define OS_CFG_APP_HOOKS_EN (1u)
+#define OS_CFG_MEM_EN (1u)
+#define OS_CFG_TMR_EN (0u)
+#define OS_CFG_PRIO_MAX (64u)
+#define OS_CFG_TICK_RATE_HZ (1000u)
+
+#define OS_ERR_NONE (0u)
+#define OS_ERR_MEM_NO_FREE_BLKS (22210u)
+
+#define OS_OPT_POST_NONE (0x0000u)
+#define OS_OPT_POST_NO_SCHED (0x8000u)
+#define OS_OPT_PEND_BLOCKING (0x0000u)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+typedef uint16_t OS_ERR;
+typedef uint8_t OS_PRIO;
+typedef uint16_t OS_CPU_USAGE;
+typedef uint32_t OS_CTX_SW_CTR;
+typedef uint32_t OS_TICK;
+typedef uint16_t OS_OBJ_QTY;
+typedef uint16_t OS_OPT;
+typedef uint32_t OS_SEM_CTR;
+typedef uint16_t OS_MEM_QTY;
+typedef uint16_t OS_MEM_SIZE;
+
+/** Task control block: the fields the application reads. */
+typedef struct os_tcb {
+    CPU_CHAR* NamePtr;
+    OS_PRIO Prio;
+    OS_CPU_USAGE CPUUsage;
+    OS_CTX_SW_CTR CtxSwCtr;
+    CPU_STK_SIZE StkUsed;
+    CPU_STK_SIZE StkFree;
+    CPU_STK_SIZE StkSize;
+    OS_TICK TickCtrMatch;
+} OS_TCB;
+
+/** Tick wheel spoke. */
+typedef struct os_tick_spoke {
+    OS_TCB* FirstPtr;
+    OS_OBJ_QTY NbrEntries;
+    OS_OBJ_QTY NbrEntriesMax;
+} OS_TICK_SPOKE;
+
+/** Memory partition. */
+typedef struct os_mem {
+    void* FreeListPtr;
+    OS_MEM_SIZE BlkSize;
+    OS_MEM_QTY NbrMax;
+    OS_MEM_QTY NbrFree;
+} OS_MEM;
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern OS_TCB* OSTCBHighRdyPtr;
+extern OS_TCB OSIdleTaskTCB;
+extern OS_CPU_USAGE OSStatTaskCPUUsage;
+extern OS_CTX_SW_CTR OSTaskCtxSwCtr;
+extern OS_TICK OSTickCtr;
+extern OS_TCB OSTickTaskTCB;
+extern OS_TICK_SPOKE OSCfg_TickWheel[];
+extern const OS_OBJ_QTY OSCfg_TickWheelSize;
+extern void (*OS_AppIdleTaskHookPtr)(void);
+
+
+
+/******************************************************************************
+*                             FUNCTION PROTOTYPES                             *
+******************************************************************************/
+
+void OSIntEnter (void);
+void OSIntExit (void);
+void OSSchedLock (OS_ERR* p_err);
+void OSSchedUnlock (OS_ERR* p_err);
+OS_PRIO OS_PrioGetHighest (void);
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err);
+void OSMemCreate (OS_MEM* p_mem, CPU_CHAR* p_name, void* p_addr,
+                  OS_MEM_QTY n_blks, OS_MEM_SIZE blk_size, OS_ERR* p_err);
+void* OSMemGet (OS_MEM* p_mem, OS_ERR* p_err);
+void OSMemPut (OS_MEM* p_mem, void* p_blk, OS_ERR* p_err);
+
+#endif /* OS_H */
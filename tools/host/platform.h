@@ -0,0 +1,43 @@
+/**
+    \file platform.h
+    \brief Host stand-in for the board platform header.
+    \details The board LEDs become plain variables, and the peripheral
+             registers the stand-ins of iodefine.h.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include "iodefine.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+#define LED_ON (0)
+#define LED_OFF (1)
+
+/** Board selection, as the board header makes it. */
+#define PLATFORM_BOARD_RDKRX63N
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+extern volatile uint8_t LED4;
+extern volatile uint8_t LED7;
+extern volatile uint8_t LED13;
+extern volatile uint8_t LED15;
+
+#endif /* PLATFORM_H */
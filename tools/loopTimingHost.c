@@ -0,0 +1,335 @@
+/**
+    \file loopTimingHost.c
+    \brief Host test for the control loop timing histograms.
+    \details Runs src/loopTiming.c on the development host, with
+             LOOP_TIMING_NOW() on a simulated 48 MHz timestamp timer that
+             wraps early in the run:
+             \par
+             - loopTiming_bucket() against the bit length of the value, over
+               a sweep of the full 32-bit range;
+             - 200000 simulated 10 ms cycles with random jitter and spikes,
+               cycles with the PID off, cycles without a wake-up mark and a
+               disabled window; every histogram equals an independent
+               reference, counts, maximum and buckets;
+             - a reset clears the histograms at the next fold only;
+             - the cost of a mark, enabled and disabled, and of a fold.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostTest.h"
+
+/** Simulated timestamp timer, in counts. */
+static volatile uint32_t hostClock;
+
+#define LOOP_TIMING_NOW() (hostClock)
+
+#include "loopTiming.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Nominal period: 10 ms at 48 MHz. */
+#define PERIOD_COUNTS (480000ul)
+
+/** Simulated cycles. */
+#define TEST_CYCLES (200000l)
+
+/** First and one past the last cycle with instrumentation off. */
+#define DISABLED_FROM (100000l)
+#define DISABLED_TO (100050l)
+
+/** Calls of each cost measurement. */
+#define COST_CALLS (100000000ul)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Reference histograms. */
+static LoopTimingHistogram reference[LOOP_TIMING_HISTOGRAMS];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the bucket of values across the 32-bit range.
+    \return None
+ */
+static void testBuckets (void);
+
+/**
+    \brief Simulate control cycles and check the histograms.
+    \return None
+ */
+static void testCycles (void);
+
+/**
+    \brief Check that a reset takes effect at the next fold.
+    \return None
+ */
+static void testReset (void);
+
+/**
+    \brief Time a mark, enabled and disabled, and a fold.
+    \return None
+ */
+static void benchMarks (void);
+
+/**
+    \brief Count a value in a reference histogram.
+    \param histogram Histogram type.
+    \param value Value, in timer counts.
+    \return None
+ */
+static void referenceCount (uint8_t histogram, uint32_t value);
+
+/**
+    \brief Reference bucket: the bit length of the value, capped.
+    \param value Value, in timer counts.
+    \return Bucket.
+ */
+static uint8_t referenceBucket (uint32_t value);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    testBuckets();
+    testCycles();
+    testReset();
+    benchMarks();
+
+    return hostTest_exit();
+}
+
+static void testBuckets (void) {
+    unsigned long mismatches = 0;
+    uint64_t value;
+
+    for (value = 0; value <= 0xFFFFFFFFull;
+         value += (value < 100000u) ? 1u : ((value / 997u) + 1u)) {
+        if (loopTiming_bucket((uint32_t)value) !=
+            referenceBucket((uint32_t)value)) {
+            mismatches++;
+        }
+    }
+
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK(loopTiming_bucket(0xFFFFFFFFul) == (LOOP_TIMING_BUCKETS - 1u));
+    HOST_CHECK(loopTiming_bucket(0u) == 0u);
+    HOST_CHECK(loopTiming_bucket(1u) == 1u);
+}
+
+static void testCycles (void) {
+    LoopTimingHistogram copy;
+    uint32_t lastTick = 0;
+    uint32_t tick;
+    uint32_t elapsed;
+    uint32_t compute;
+    uint32_t output;
+    int32_t jitter;
+    long cycle;
+    uint8_t h;
+    bool known = false;
+    bool active;
+    bool marked;
+    bool enabled;
+    bool wrapped = false;
+
+    srand(3);
+    memset(reference, 0, sizeof(reference));
+
+    loopTiming_init(PERIOD_COUNTS);
+    loopTiming_enable(true);
+    tick = 0xFFFFFFFFul - (5u * PERIOD_COUNTS);
+
+    for (cycle = 0; cycle < TEST_CYCLES; cycle++) {
+        jitter = (rand() % 2001) - 1000;
+
+        /* A late wake-up now and then, beyond the usual jitter. */
+        if ((cycle % 5000) == 0) {
+            jitter += 200000;
+        }
+
+        if (cycle != 0) {
+            tick = lastTick + PERIOD_COUNTS + (uint32_t)jitter;
+            wrapped = wrapped || (tick < lastTick);
+        }
+
+        active = (cycle % 97) != 0;
+        marked = (cycle % 1009) != 0;
+        enabled = (cycle < DISABLED_FROM) || (cycle >= DISABLED_TO);
+        loopTiming_enable(enabled);
+
+        hostClock = tick;
+
+        if (marked) {
+            LOOP_TIMING_MARK(LOOP_TIMING_TICK);
+        }
+
+        compute = 200u + ((uint32_t)rand() % 50u);
+        output = 30u + ((uint32_t)rand() % 10u);
+
+        /* With the PID off the cycle ends after the wake-up. */
+        if (active) {
+            hostClock += 3000u + ((uint32_t)rand() % 500u);
+            LOOP_TIMING_MARK(LOOP_TIMING_ADC);
+            hostClock += compute;
+            LOOP_TIMING_MARK(LOOP_TIMING_PID);
+            hostClock += output;
+            LOOP_TIMING_MARK(LOOP_TIMING_DAC);
+        }
+
+        loopTiming_fold();
+
+        if (enabled && marked) {
+            if (known) {
+                elapsed = tick - lastTick;
+                referenceCount(LOOP_TIMING_JITTER,
+                               (elapsed >= PERIOD_COUNTS) ?
+                               (elapsed - PERIOD_COUNTS) :
+                               (PERIOD_COUNTS - elapsed));
+            }
+
+            known = true;
+        } else {
+            known = false;
+        }
+
+        if (enabled && active) {
+            referenceCount(LOOP_TIMING_COMPUTE, compute);
+            referenceCount(LOOP_TIMING_LATENCY, compute + output);
+        }
+
+        lastTick = tick;
+    }
+
+    HOST_CHECK(wrapped);
+
+    for (h = 0; h < LOOP_TIMING_HISTOGRAMS; h++) {
+        loopTiming_get(h, &copy);
+
+        printf("histogram %u: %lu samples, max %lu counts\n", (unsigned)h,
+               (unsigned long)copy.samples, (unsigned long)copy.max);
+
+        HOST_CHECK(copy.samples == reference[h].samples);
+        HOST_CHECK(copy.max == reference[h].max);
+        HOST_CHECK(memcmp(copy.bucket, reference[h].bucket,
+                          sizeof(copy.bucket)) == 0);
+    }
+}
+
+static void testReset (void) {
+    LoopTimingHistogram copy;
+
+    loopTiming_get(LOOP_TIMING_COMPUTE, &copy);
+    HOST_CHECK(copy.samples != 0u);
+
+    /* Requested from another task: nothing changes until the fold. */
+    loopTiming_reset();
+    loopTiming_get(LOOP_TIMING_COMPUTE, &copy);
+    HOST_CHECK(copy.samples != 0u);
+
+    loopTiming_fold();
+    loopTiming_get(LOOP_TIMING_COMPUTE, &copy);
+    HOST_CHECK((copy.samples == 0u) && (copy.max == 0u));
+
+    /* The cycle after the reset is counted again. */
+    LOOP_TIMING_MARK(LOOP_TIMING_ADC);
+    LOOP_TIMING_MARK(LOOP_TIMING_PID);
+    loopTiming_fold();
+    loopTiming_get(LOOP_TIMING_COMPUTE, &copy);
+    HOST_CHECK(copy.samples == 1u);
+}
+
+static void benchMarks (void) {
+    unsigned long i;
+    double start;
+    double enabled;
+    double disabled;
+    double fold;
+
+    loopTiming_init(PERIOD_COUNTS);
+    loopTiming_enable(true);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS; i++) {
+        hostClock = (uint32_t)i;
+        LOOP_TIMING_MARK(LOOP_TIMING_ADC);
+    }
+
+    enabled = (hostTest_now() - start) / (double)COST_CALLS;
+
+    loopTiming_enable(false);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS; i++) {
+        hostClock = (uint32_t)i;
+        LOOP_TIMING_MARK(LOOP_TIMING_ADC);
+    }
+
+    disabled = (hostTest_now() - start) / (double)COST_CALLS;
+
+    loopTiming_enable(true);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CALLS / 10u; i++) {
+        hostClock = (uint32_t)(i * PERIOD_COUNTS);
+        LOOP_TIMING_MARK(LOOP_TIMING_TICK);
+        LOOP_TIMING_MARK(LOOP_TIMING_ADC);
+        LOOP_TIMING_MARK(LOOP_TIMING_PID);
+        LOOP_TIMING_MARK(LOOP_TIMING_DAC);
+        loopTiming_fold();
+    }
+
+    fold = (hostTest_now() - start) / (double)(COST_CALLS / 10u);
+
+    printf("mark %.2f ns, disabled %.2f ns; four marks and a fold %.2f ns\n",
+           enabled, disabled, fold);
+}
+
+static void referenceCount (uint8_t histogram, uint32_t value) {
+    reference[histogram].bucket[referenceBucket(value)]++;
+    reference[histogram].samples++;
+
+    if (value > reference[histogram].max) {
+        reference[histogram].max = value;
+    }
+}
+
+static uint8_t referenceBucket (uint32_t value) {
+    uint8_t bits = 0;
+
+    while (value != 0u) {
+        bits++;
+        value >>= 1;
+    }
+
+    return (bits < LOOP_TIMING_BUCKETS) ? bits :
+                                          (uint8_t)(LOOP_TIMING_BUCKETS - 1u);
+}
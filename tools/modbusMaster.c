@@ -0,0 +1,460 @@
+/**
+    \file modbusMaster.c
+    \brief Reference Modbus RTU master for the board slave.
+    \details Talks to the slave of src/modbusSlave.h over a serial port,
+             8E1 at 19200 bit/s as MODBUS_SLAVE_BAUD, with the CRC code of
+             the board itself, src/modbus.c:
+             \code
+             modbusMaster port slave read-holding address count
+             modbusMaster port slave read-input address count
+             modbusMaster port slave write address value
+             modbusMaster port slave write-i32 address value
+             modbusMaster port slave write-f32 address value
+             modbusMaster port slave bench requests
+             \endcode
+             The reads print one register per line, as unsigned and signed
+             16-bit values. write sends one register (function 0x06);
+             write-i32 and write-f32 send a 32-bit integer or float as two
+             registers, high word first (function 0x10). An exception reply
+             is printed with its code and makes the exit status non-zero.
+             A port without parity, such as a pseudo-terminal, is used with
+             a warning.
+             \par
+             bench repeats a read of the whole input map and reports the
+             turnaround: the time from the end of the request, once the
+             port has sent it, to the last byte of the reply. On the board
+             that is the 3.5 character frame end silence, the wake-up of the
+             UI task, the request processing and the reply on the wire.
+             \par
+             Built by make -C tools into tools/build; run on the host:
+             \code
+             tools/build/modbusMaster /dev/ttyUSB0 1 read-input 0 16
+             tools/build/modbusMaster /dev/ttyUSB0 1 write-f32 6 1.25
+             \endcode
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "modbus.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Reply timeout, in milliseconds. */
+#define MASTER_TIMEOUT_MS (1000)
+
+/** Input registers read by bench: the whole input map. */
+#define MASTER_BENCH_COUNT (16u)
+
+/** Exception reply flag of the function code. */
+#define MASTER_EXCEPTION_FLAG (0x80u)
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Set a serial port to raw 8E1 at 19200 bit/s.
+    \param fd Port.
+    \return False on failure.
+ */
+static bool setupPort (int fd);
+
+/**
+    \brief Send a request and receive its reply.
+    \param fd Port.
+    \param request Request, without its CRC; two bytes of room after it.
+    \param length Request length, without the CRC.
+    \param reply Reply buffer, MODBUS_FRAME_MAX bytes.
+    \param expected Length of a normal reply, CRC included; zero to expect
+           none.
+    \param turnaround Time from the request sent to the reply received, in
+           seconds; may be null.
+    \return Reply length; negative on timeout or a bad reply.
+ */
+static int transact (int fd, uint8_t* request, uint16_t length,
+                     uint8_t* reply, uint16_t expected, double* turnaround);
+
+/**
+    \brief Read registers and print them.
+    \return Exit status.
+ */
+static int readRegisters (int fd, uint8_t slave, uint8_t function,
+                          uint16_t address, uint16_t count);
+
+/**
+    \brief Write registers.
+    \return Exit status.
+ */
+static int writeRegisters (int fd, uint8_t slave, uint16_t address,
+                           const uint16_t* values, uint16_t count);
+
+/**
+    \brief Time repeated reads of the input map.
+    \return Exit status.
+ */
+static int bench (int fd, uint8_t slave, unsigned long requests);
+
+/**
+    \brief Print an exception reply, if it is one.
+    \param reply Reply.
+    \return True if it was an exception.
+ */
+static bool exception (const uint8_t* reply);
+
+/**
+    \brief Store a big-endian 16-bit value.
+    \param out Buffer position.
+    \param value Value to store.
+    \return None
+ */
+static void put16 (uint8_t* out, uint16_t value);
+
+/**
+    \brief Get a monotonic time.
+    \return Time, in seconds.
+ */
+static double now (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    uint16_t values[2];
+    uint32_t bits;
+    int32_t integer;
+    float value;
+    uint8_t slave;
+    int fd;
+    int result;
+
+    if (argc < 5) {
+        fprintf(stderr,
+                "usage: %s port slave read-holding|read-input address "
+                "count\n"
+                "       %s port slave write|write-i32|write-f32 address "
+                "value\n"
+                "       %s port slave bench requests\n",
+                argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    fd = open(argv[1], O_RDWR | O_NOCTTY);
+
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (isatty(fd) && !setupPort(fd)) {
+        perror(argv[1]);
+        close(fd);
+        return 1;
+    }
+
+    slave = (uint8_t)strtoul(argv[2], NULL, 0);
+
+    if ((strcmp(argv[3], "bench") == 0) && (argc == 5)) {
+        result = bench(fd, slave, strtoul(argv[4], NULL, 0));
+    } else if (argc != 6) {
+        fprintf(stderr, "%s: wrong arguments\n", argv[3]);
+        result = 2;
+    } else if (strcmp(argv[3], "read-holding") == 0) {
+        result = readRegisters(fd, slave, MODBUS_READ_HOLDING,
+                               (uint16_t)strtoul(argv[4], NULL, 0),
+                               (uint16_t)strtoul(argv[5], NULL, 0));
+    } else if (strcmp(argv[3], "read-input") == 0) {
+        result = readRegisters(fd, slave, MODBUS_READ_INPUT,
+                               (uint16_t)strtoul(argv[4], NULL, 0),
+                               (uint16_t)strtoul(argv[5], NULL, 0));
+    } else if (strcmp(argv[3], "write") == 0) {
+        values[0] = (uint16_t)strtol(argv[5], NULL, 0);
+        result = writeRegisters(fd, slave,
+                                (uint16_t)strtoul(argv[4], NULL, 0),
+                                values, 1);
+    } else if ((strcmp(argv[3], "write-i32") == 0) ||
+               (strcmp(argv[3], "write-f32") == 0)) {
+        if (strcmp(argv[3], "write-i32") == 0) {
+            integer = (int32_t)strtol(argv[5], NULL, 0);
+            bits = (uint32_t)integer;
+        } else {
+            value = strtof(argv[5], NULL);
+            memcpy(&bits, &value, sizeof(bits));
+        }
+
+        values[0] = (uint16_t)(bits >> 16);
+        values[1] = (uint16_t)bits;
+        result = writeRegisters(fd, slave,
+                                (uint16_t)strtoul(argv[4], NULL, 0),
+                                values, 2);
+    } else {
+        fprintf(stderr, "%s: unknown command\n", argv[3]);
+        result = 2;
+    }
+
+    close(fd);
+
+    return result;
+}
+
+static bool setupPort (int fd) {
+    struct termios settings;
+    struct termios applied;
+
+    if (tcgetattr(fd, &settings) != 0) {
+        return false;
+    }
+
+    /* Raw bytes both ways: no line editing, translation or echo. */
+    settings.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                    INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    settings.c_oflag &= ~(tcflag_t)OPOST;
+    settings.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(tcflag_t)(CSIZE | PARODD | CSTOPB);
+    settings.c_cflag |= CS8 | PARENB | CREAD | CLOCAL;
+    settings.c_cc[VMIN] = 1;
+    settings.c_cc[VTIME] = 0;
+
+    if ((cfsetispeed(&settings, B19200) != 0) ||
+        (cfsetospeed(&settings, B19200) != 0)) {
+        return false;
+    }
+
+    if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+        /* A pseudo-terminal drops the parity and glibc fails the call,
+           with the rest applied; the frames get through without it. */
+        if ((errno != EINVAL) || (tcgetattr(fd, &applied) != 0) ||
+            ((applied.c_cflag | PARENB) != settings.c_cflag)) {
+            return false;
+        }
+
+        fprintf(stderr, "warning: no parity on this port\n");
+    }
+
+    /* Nothing left over from an earlier exchange. */
+    return tcflush(fd, TCIOFLUSH) == 0;
+}
+
+static int transact (int fd, uint8_t* request, uint16_t length,
+                     uint8_t* reply, uint16_t expected, double* turnaround) {
+    struct pollfd ready;
+    uint16_t crc = modbus_crc(request, length);
+    uint16_t received = 0;
+    double sent;
+    double deadline;
+    ssize_t count;
+    int wait;
+
+    request[length] = (uint8_t)crc;
+    request[length + 1u] = (uint8_t)(crc >> 8);
+    length += 2u;
+
+    if ((write(fd, request, length) != (ssize_t)length) ||
+        (isatty(fd) && (tcdrain(fd) != 0))) {
+        perror("write");
+        return -1;
+    }
+
+    sent = now();
+    deadline = sent + (MASTER_TIMEOUT_MS / 1000.0);
+
+    if (expected == 0u) {
+        return 0;
+    }
+
+    /* An exception reply is five bytes; its function code says so. */
+    while ((received < expected) &&
+           !((received >= 5u) && (reply[1] & MASTER_EXCEPTION_FLAG))) {
+        wait = (int)((deadline - now()) * 1000.0);
+        ready.fd = fd;
+        ready.events = POLLIN;
+
+        if ((wait <= 0) || (poll(&ready, 1, wait) <= 0)) {
+            fprintf(stderr, "no reply\n");
+            return -1;
+        }
+
+        count = read(fd, &reply[received], MODBUS_FRAME_MAX - received);
+
+        if (count <= 0) {
+            fprintf(stderr, "port closed\n");
+            return -1;
+        }
+
+        received = (uint16_t)(received + count);
+    }
+
+    if (turnaround != NULL) {
+        *turnaround = now() - sent;
+    }
+
+    if ((modbus_crc(reply, received) != 0u) || (reply[0] != request[0]) ||
+        ((reply[1] & ~MASTER_EXCEPTION_FLAG) != request[1])) {
+        fprintf(stderr, "bad reply\n");
+        return -1;
+    }
+
+    return received;
+}
+
+static int readRegisters (int fd, uint8_t slave, uint8_t function,
+                          uint16_t address, uint16_t count) {
+    uint8_t request[8];
+    uint8_t reply[MODBUS_FRAME_MAX];
+    uint16_t value;
+    uint16_t i;
+
+    if ((count == 0u) || (count > MODBUS_READ_MAX)) {
+        fprintf(stderr, "count must be from 1 to %u\n", MODBUS_READ_MAX);
+        return 2;
+    }
+
+    request[0] = slave;
+    request[1] = function;
+    put16(&request[2], address);
+    put16(&request[4], count);
+
+    if (transact(fd, request, 6, reply, (uint16_t)(5u + (count * 2u)),
+                 NULL) < 0) {
+        return 1;
+    }
+
+    if (exception(reply)) {
+        return 1;
+    }
+
+    for (i = 0; i < count; i++) {
+        value = (uint16_t)((reply[3u + (i * 2u)] << 8) |
+                           reply[4u + (i * 2u)]);
+        printf("%u %u %d\n", (unsigned)(address + i), (unsigned)value,
+               (int)(int16_t)value);
+    }
+
+    return 0;
+}
+
+static int writeRegisters (int fd, uint8_t slave, uint16_t address,
+                           const uint16_t* values, uint16_t count) {
+    uint8_t request[13];
+    uint8_t reply[MODBUS_FRAME_MAX];
+    uint16_t length;
+    uint16_t i;
+
+    request[0] = slave;
+    put16(&request[2], address);
+
+    if (count == 1u) {
+        request[1] = MODBUS_WRITE_SINGLE;
+        put16(&request[4], values[0]);
+        length = 6;
+    } else {
+        request[1] = MODBUS_WRITE_MULTIPLE;
+        put16(&request[4], count);
+        request[6] = (uint8_t)(count * 2u);
+
+        for (i = 0; i < count; i++) {
+            put16(&request[7u + (i * 2u)], values[i]);
+        }
+
+        length = (uint16_t)(7u + (count * 2u));
+    }
+
+    /* A broadcast is not answered: send it and stop there. */
+    if (transact(fd, request, length, reply,
+                 (slave == MODBUS_BROADCAST) ? 0u : 8u, NULL) < 0) {
+        return 1;
+    }
+
+    return ((slave != MODBUS_BROADCAST) && exception(reply)) ? 1 : 0;
+}
+
+static int bench (int fd, uint8_t slave, unsigned long requests) {
+    uint8_t request[8];
+    uint8_t reply[MODBUS_FRAME_MAX];
+    double turnaround;
+    double total = 0.0;
+    double lowest = 0.0;
+    double highest = 0.0;
+    unsigned long done;
+
+    for (done = 0; done < requests; done++) {
+        request[0] = slave;
+        request[1] = MODBUS_READ_INPUT;
+        put16(&request[2], 0);
+        put16(&request[4], MASTER_BENCH_COUNT);
+
+        if ((transact(fd, request, 6, reply,
+                      (uint16_t)(5u + (MASTER_BENCH_COUNT * 2u)),
+                      &turnaround) < 0) || exception(reply)) {
+            break;
+        }
+
+        total += turnaround;
+
+        if ((done == 0u) || (turnaround < lowest)) {
+            lowest = turnaround;
+        }
+
+        if (turnaround > highest) {
+            highest = turnaround;
+        }
+    }
+
+    if (done == 0u) {
+        return 1;
+    }
+
+    printf("%lu requests: turnaround min %.1f us, average %.1f us, "
+           "max %.1f us\n", done, lowest * 1e6, (total / done) * 1e6,
+           highest * 1e6);
+
+    return (done == requests) ? 0 : 1;
+}
+
+static bool exception (const uint8_t* reply) {
+    if ((reply[1] & MASTER_EXCEPTION_FLAG) == 0u) {
+        return false;
+    }
+
+    fprintf(stderr, "exception %u\n", (unsigned)reply[2]);
+
+    return true;
+}
+
+static void put16 (uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+}
+
+static double now (void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1e9);
+}
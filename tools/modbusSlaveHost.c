@@ -0,0 +1,1062 @@
+/**
+    \file modbusSlaveHost.c
+    \brief Host test for the Modbus RTU slave and its reference master.
+    \details Runs src/modbusSlave.c on the development host, against the
+             real controller, units, statistics and deadline sources.
+             modbusSlave.c is included, so that its interrupt service
+             routines can be called: a simulated SCI6 feeds them the bytes
+             of a pseudo-terminal and sends their reply back, and a
+             simulated CMT3 ends each frame after its compare match time of
+             silence. tools/modbusMaster.c is the master, on the other end
+             of the pseudo-terminal:
+             \par
+             - the SCI6 8E1 format and bit rate, and the CMT3 frame timer;
+             - each command through the master: reads of both maps, a
+               setpoint refused in manual mode and out of range, mode and
+               power changes, the output refused in automatic mode, 32-bit
+               integers and floats, a coefficient written alone next to the
+               ones in use, an unknown register; the exit status of
+               the master, its output and the controller state agree, and a
+               mode change marks the display;
+             - raw requests: a write of several registers checked whole
+               before any applies, coefficients applied together, a
+               broadcast applied without a reply, and no reply to another
+               slave, to a bad CRC, to a request hit by a line error or to
+               one longer than any request; the slave answers the next one;
+             - a line error with no request, cleared by the periodic call;
+             - a request in pieces, with gaps under the 3.5 character
+               silence and with one over it, and bytes coming while a
+               request waits for the UI task;
+             - the turnaround the master measures: never shorter than the
+               3.5 character silence, and the slave's share of it.
+             \par
+             A pseudo-terminal has no parity, which the master warns of,
+             and sends every byte at once, so the turnaround leaves out the
+             time on the wire. Built and run, with the master, by
+             make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _XOPEN_SOURCE 600
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hostTest.h"
+#include "units.h"
+#include "menu.h"
+#include "tickless.h"
+#include "modbusSlave.c"
+
+/* After the registers: termios.h defines B0 as a bit rate, and
+   sys/wait.h declares the wait() of machine.h. */
+#undef wait
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Master output files, in the working directory. */
+#define OUT_FILE "modbusSlaveHost.out"
+#define ERR_FILE "modbusSlaveHost.err"
+
+/** SCR transmit interrupt, transmitter and receive interrupt bits. */
+#define SCR_TIE (0x80u)
+#define SCR_RIE (0x40u)
+#define SCR_TE (0x20u)
+
+/** SSR framing error flag. */
+#define SSR_FER (0x10u)
+
+/** CMT3 count rate: PCLK/32, in counts per second. */
+#define CMT3_HZ (MODBUS_SLAVE_PCLK_HZ / 32u)
+
+/** Period of the simulated peripherals, in nanoseconds. */
+#define STEP_NS (50000l)
+
+/** Wait for the reply to a raw request, in milliseconds. */
+#define ANSWER_MS (30u)
+
+/** Requests of the turnaround measurement. */
+#define BENCH_REQUESTS "1000"
+
+/** Longest master output line. */
+#define LINE_SIZE (256u)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
+
+/** Engineering unit range of each signal; as in app.c. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+/** PID control structure variable. */
+PIDControl pid = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
+
+/* Board and kernel stand-ins. */
+
+volatile uint8_t LED4;
+volatile uint8_t LED7;
+volatile uint8_t LED13;
+
+OS_TCB* OSTCBHighRdyPtr;
+OS_TCB OSIdleTaskTCB;
+OS_CPU_USAGE OSStatTaskCPUUsage;
+OS_CTX_SW_CTR OSTaskCtxSwCtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Master program. */
+static const char* masterPath = "./modbusMaster";
+
+/** Pseudo-terminal: the board end, and the master end, held open by the
+    board so that the line outlives each master run. */
+static int line = -1;
+static int port = -1;
+
+/** Master end path. */
+static char portName[64];
+
+/** UI task, notified of frame ends and display changes. */
+static OS_TCB uiTask;
+
+/** Posts to the UI task not taken yet, and in all. */
+static unsigned long uiPending = 0;
+static unsigned long uiPosts = 0;
+
+/** Last periodic call of modbusSlave_serve(), in nanoseconds. */
+static double lastServe = 0.0;
+
+/** Requests served, and their time in modbusSlave_serve(), in
+    nanoseconds. */
+static unsigned long served = 0;
+static double serveTime = 0.0;
+
+/** Last CMT3 count update, in nanoseconds. */
+static double timerStart = 0.0;
+
+/** Received bytes, and the one hit by a framing error; -1 for none. */
+static long lineBytes = 0;
+static long errorByte = -1;
+
+/** The UI task is held off; frames wait for it. */
+static bool uiHeld = false;
+
+/** Control cycle deadline monitor, with one miss. */
+static DeadlineMonitor monitor;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the SCI6 and CMT3 set-up.
+    \return None
+ */
+static void testInit (void);
+
+/**
+    \brief Apply and read back each command through the master.
+    \return None
+ */
+static void testCommands (void);
+
+/**
+    \brief Send raw requests the master does not build.
+    \return None
+ */
+static void testRaw (void);
+
+/**
+    \brief Send requests in pieces, and while one waits for the UI task.
+    \return None
+ */
+static void testLine (void);
+
+/**
+    \brief Measure the turnaround through the master.
+    \return None
+ */
+static void benchTurnaround (void);
+
+/**
+    \brief Open the pseudo-terminal.
+    \return True on success.
+ */
+static bool openLine (void);
+
+/**
+    \brief Run the master with one command while the board runs.
+    \param command Slave address, command and its values, space separated.
+    \return Master exit status, or -1 if it did not exit.
+ */
+static int runMaster (const char* command);
+
+/**
+    \brief Run a read command and take the registers it printed.
+    \param command Read command, as for runMaster().
+    \param words Registers read.
+    \param count Number of registers expected.
+    \return True if the master printed them all, in order.
+ */
+static bool readWords (const char* command, uint16_t* words, unsigned count);
+
+/**
+    \brief Get the exception the master reported last.
+    \return Exception code, or zero if none.
+ */
+static unsigned lastException (void);
+
+/**
+    \brief Send a raw request and run the board until its reply is due.
+    \param request Request, without its CRC; room for two more bytes.
+    \param length Request length, in bytes.
+    \param reply Buffer for the reply, MODBUS_FRAME_MAX bytes.
+    \return Reply length, or zero if none came.
+ */
+static uint16_t exchange (uint8_t* request, uint16_t length, uint8_t* reply);
+
+/**
+    \brief Run the board until a reply is due and take it.
+    \param reply Buffer for the reply, MODBUS_FRAME_MAX bytes.
+    \return Reply length, or zero if none came.
+ */
+static uint16_t answer (uint8_t* reply);
+
+/**
+    \brief Send bytes as they are and run the board until a reply is due.
+    \param data Bytes.
+    \param length Number of bytes.
+    \return True if no reply came.
+ */
+static bool unanswered (const uint8_t* data, uint16_t length);
+
+/**
+    \brief Build a write of several registers with 32-bit values.
+    \param out Request buffer.
+    \param slave Slave address.
+    \param address First register.
+    \param values Values, two registers each.
+    \param count Number of values.
+    \return Request length, without its CRC.
+ */
+static uint16_t writeRequest (uint8_t* out, uint8_t slave, uint16_t address,
+                              const uint32_t* values, uint16_t count);
+
+/**
+    \brief Run the simulated peripherals and the UI task for a while.
+    \param ms Time, in milliseconds.
+    \return None
+ */
+static void runBoard (unsigned ms);
+
+/**
+    \brief Run the simulated peripherals and the UI task once.
+    \return None
+ */
+static void stepBoard (void);
+
+/**
+    \brief Take a byte on RXD6.
+    \param data Byte.
+    \return None
+ */
+static void receive (uint8_t data);
+
+/**
+    \brief Update the CMT3 count; raise the compare match at its end.
+    \return None
+ */
+static void timerTick (void);
+
+/**
+    \brief Send the reply loaded by the transmit interrupts.
+    \return None
+ */
+static void transmit (void);
+
+/**
+    \brief Put a 32-bit value, high byte first.
+    \param out Output.
+    \param value Value.
+    \return None
+ */
+static void put32 (uint8_t* out, uint32_t value);
+
+/**
+    \brief Get the bits of a float.
+    \param value Value.
+    \return Bits.
+ */
+static uint32_t bitsOf (float value);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    if (argc > 1) {
+        masterPath = argv[1];
+    }
+
+    initUnits();
+    displayDirty_init(&uiTask);
+
+    /* A cycle past its deadline under the safe policy. */
+    deadline_init(&monitor, 10u, 10u, DEADLINE_SAFE, 0u);
+    (void)deadline_end(&monitor, 15u);
+
+    /* One statistics period behind the input registers. */
+    OSIdleTaskTCB.CPUUsage = 7500u;
+    OSTaskCtxSwCtr = 321u;
+    stats_collect();
+
+    modbusSlave_init(&uiTask, &monitor);
+    testInit();
+    HOST_CHECK(openLine());
+
+    if (line >= 0) {
+        testCommands();
+        testRaw();
+        testLine();
+        benchTurnaround();
+        close(port);
+        close(line);
+    }
+
+    remove(OUT_FILE);
+    remove(ERR_FILE);
+
+    return hostTest_exit();
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return (CPU_TS_TMR)hostTest_now();
+}
+
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err) {
+    *p_err = CPU_ERR_NONE;
+
+    return 1000000000u;
+}
+
+void OSIntEnter (void) {
+}
+
+void OSIntExit (void) {
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    (void)opt;
+
+    if (p_tcb == &uiTask) {
+        uiPending++;
+        uiPosts++;
+    }
+
+    *p_err = OS_ERR_NONE;
+
+    return 0u;
+}
+
+uint32_t tickless_wakeups (void) {
+    return 0u;
+}
+
+void lcd_clear (void) {
+}
+
+void lcd_display (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void lcd_display_inverted (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+static void testInit (void) {
+    /* 8E1: parity on, even, 8 bits, one stop bit. */
+    HOST_CHECK(SCI6.SMR.BYTE == 0x20u);
+    HOST_CHECK(SCI6.BRR == 77u);        /* 19231 bit/s at 48 MHz. */
+    HOST_CHECK(SCI6.SCR.BYTE == MODBUS_SLAVE_SCR_RECEIVE);
+    HOST_CHECK(CMT3.CMCR.WORD == 0x00C1u);
+    HOST_CHECK(CMT3.CMCOR == 3008u);    /* 2006 us at 1.5 MHz. */
+    HOST_CHECK(CMT.CMSTR1.BIT.STR3 == 0u);
+    HOST_CHECK(IEN(SCI6,RXI6) && IEN(SCI6,TXI6) && IEN(SCI6,TEI6) &&
+               IEN(CMT3,CMI3));
+}
+
+static void testCommands (void) {
+    PIDCoefficients coefficients;
+    uint16_t words[16];
+    unsigned long posts;
+    float value;
+
+    /* As in the menu: no setpoint in manual. */
+    HOST_CHECK(readWords("1 read-holding 4 2", words, 2u) &&
+               (words[0] == PID_MAN) && (words[1] == PID_OFF));
+    HOST_CHECK(runMaster("1 write-i32 0 50") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_DEVICE_FAILURE);
+    HOST_CHECK(pid.spValue == 0);
+
+    HOST_CHECK(runMaster("1 write-i32 2 100") == 0);
+    HOST_CHECK(pid.opValue == 100);
+    HOST_CHECK(runMaster("1 write-i32 2 101") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(runMaster("1 write-i32 2 40") == 0);
+    HOST_CHECK(pid.opValue == 40);
+    HOST_CHECK(readWords("1 read-input 8 2", words, 2u) &&
+               (words[0] == 0u) && (words[1] == 40u));
+
+    posts = uiPosts;
+    (void)displayDirty_take(DISPLAY_MODE);
+    HOST_CHECK(runMaster("1 write 4 1") == 0);
+    HOST_CHECK(pid.mode == PID_AUTO);
+    HOST_CHECK(displayDirty_take(DISPLAY_MODE));
+    HOST_CHECK(uiPosts > posts);
+
+    HOST_CHECK(runMaster("1 write-i32 0 0") == 0);
+    HOST_CHECK(pid.spValue == 0);
+    HOST_CHECK(runMaster("1 write-i32 0 100") == 0);
+    HOST_CHECK(pid.spValue == 100);
+    HOST_CHECK(runMaster("1 write-i32 0 60") == 0);
+    HOST_CHECK((pid.spValue == 60) && (pid.sp == toRaw(SIGNAL_SP, 60)));
+    HOST_CHECK(readWords("1 read-holding 0 2", words, 2u) &&
+               (words[0] == 0u) && (words[1] == 60u));
+    HOST_CHECK(readWords("1 read-input 0 1", words, 1u) &&
+               (words[0] == (uint16_t)pid.sp));
+    HOST_CHECK(runMaster("1 write-i32 0 101") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(runMaster("1 write-i32 0 -1") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(pid.spValue == 60);
+
+    /* As in the menu: the output is the controller's in automatic. */
+    HOST_CHECK(runMaster("1 write-i32 2 70") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_DEVICE_FAILURE);
+    HOST_CHECK(pid.opValue == 40);
+
+    HOST_CHECK(runMaster("1 write 5 0") == 0);
+    HOST_CHECK(pid.active == PID_ON);
+    HOST_CHECK(runMaster("1 write 5 2") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(runMaster("1 write 4 2") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(pid.mode == PID_AUTO);
+
+    HOST_CHECK(runMaster("1 write-f32 6 2.5") == 0);
+    HOST_CHECK(runMaster("1 write-f32 8 -1.25") == 0);
+    HOST_CHECK(runMaster("1 write-f32 10 0.5") == 0);
+    HOST_CHECK(runMaster("1 write-f32 8 1000") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    HOST_CHECK(runMaster("1 write-f32 8 nan") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_VALUE);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 2.5f) && (coefficients.b2 == -1.25f) &&
+               (coefficients.b3 == 0.5f));
+    HOST_CHECK(readWords("1 read-holding 8 2", words, 2u));
+    value = -1.25f;
+    HOST_CHECK((((uint32_t)words[0] << 16) | words[1]) == bitsOf(value));
+
+    /* One coefficient written; the others as in use, set from the menu
+       since. */
+    coefficients.b1 = 4.0f;
+    coefficients.b2 = 5.0f;
+    coefficients.b3 = 6.0f;
+    HOST_CHECK(setCoefficients_PID(&coefficients));
+    HOST_CHECK(runMaster("1 write-f32 10 7") == 0);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 4.0f) && (coefficients.b2 == 5.0f) &&
+               (coefficients.b3 == 7.0f));
+
+    /* The statistics and the deadline misses, through their accessors. */
+    HOST_CHECK(readWords("1 read-input 10 6", words, 6u) &&
+               (words[0] == stats_get()->cpuUsage) &&
+               (words[0] == 2500u) &&
+               (words[1] == stats_get()->switches) &&
+               (words[1] == 321u) &&
+               (words[2] == stats_get()->wakeups) &&
+               (words[3] == stats_get()->intDisMaxUs) &&
+               (words[4] == 0u) && (words[5] == monitor.misses) &&
+               (words[5] == 1u));
+
+    HOST_CHECK(runMaster("1 read-holding 12 1") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_ADDRESS);
+    HOST_CHECK(runMaster("1 read-input 15 2") == 1);
+    HOST_CHECK(lastException() == MODBUS_EX_ILLEGAL_ADDRESS);
+
+    /* The line is back to receiving after each reply, with the frame
+       timer stopped. */
+    HOST_CHECK(SCI6.SCR.BYTE == MODBUS_SLAVE_SCR_RECEIVE);
+    HOST_CHECK(CMT.CMSTR1.BIT.STR3 == 0u);
+}
+
+static void testRaw (void) {
+    uint8_t request[MODBUS_FRAME_MAX + 64u];
+    uint8_t reply[MODBUS_FRAME_MAX];
+    PIDCoefficients coefficients;
+    uint32_t values[3];
+    uint16_t length;
+    uint16_t got;
+    uint16_t crc;
+
+    /* A valid setpoint does not go in with an output refused in
+       automatic mode, nor does the mode that would allow it. */
+    values[0] = 70u;
+    values[1] = 50u;
+    values[2] = ((uint32_t)PID_MAN << 16) | PID_ON;
+    length = writeRequest(request, 1u, 0u, values, 3u);
+    got = exchange(request, length, reply);
+    HOST_CHECK((got == 5u) && (reply[1] == (MODBUS_WRITE_MULTIPLE |
+                                            MODBUS_EXCEPTION_FLAG)) &&
+               (reply[2] == MODBUS_EX_DEVICE_FAILURE));
+    HOST_CHECK((pid.spValue == 60) && (pid.opValue == 40) &&
+               (pid.mode == PID_AUTO));
+
+    /* Nor do a mode and power ahead of a bad coefficient. */
+    values[0] = ((uint32_t)PID_MAN << 16) | PID_OFF;
+    values[1] = bitsOf(1000.0f);
+    length = writeRequest(request, 1u, 4u, values, 2u);
+    got = exchange(request, length, reply);
+    HOST_CHECK((got == 5u) && (reply[2] == MODBUS_EX_ILLEGAL_VALUE));
+    HOST_CHECK((pid.mode == PID_AUTO) && (pid.active == PID_ON));
+
+    /* Coefficients: none with a bad one, all three together. */
+    values[0] = bitsOf(1.0f);
+    values[1] = bitsOf(2.0f);
+    values[2] = bitsOf(-1000.0f);
+    length = writeRequest(request, 1u, 6u, values, 3u);
+    got = exchange(request, length, reply);
+    HOST_CHECK((got == 5u) && (reply[2] == MODBUS_EX_ILLEGAL_VALUE));
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 4.0f) && (coefficients.b2 == 5.0f) &&
+               (coefficients.b3 == 7.0f));
+
+    values[2] = bitsOf(3.0f);
+    length = writeRequest(request, 1u, 6u, values, 3u);
+    got = exchange(request, length, reply);
+    HOST_CHECK((got == 8u) && (reply[1] == MODBUS_WRITE_MULTIPLE) &&
+               (reply[5] == 6u));
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 1.0f) && (coefficients.b2 == 2.0f) &&
+               (coefficients.b3 == 3.0f));
+
+    /* A broadcast applies without a reply, whatever the last reply. */
+    request[0] = MODBUS_SLAVE_ADDRESS;
+    request[1] = MODBUS_READ_HOLDING;
+    request[2] = 0u;
+    request[3] = 12u;
+    request[4] = 0u;
+    request[5] = 1u;
+    got = exchange(request, 6u, reply);
+    HOST_CHECK((got == 5u) && (reply[2] == MODBUS_EX_ILLEGAL_ADDRESS));
+
+    values[0] = bitsOf(0.25f);
+    values[1] = bitsOf(0.5f);
+    values[2] = bitsOf(0.75f);
+    length = writeRequest(request, MODBUS_BROADCAST, 6u, values, 3u);
+    HOST_CHECK(exchange(request, length, reply) == 0u);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 0.25f) && (coefficients.b2 == 0.5f) &&
+               (coefficients.b3 == 0.75f));
+
+    /* Another slave, and a bad CRC: no reply, nothing applied. */
+    values[0] = bitsOf(9.0f);
+    length = writeRequest(request, 2u, 6u, values, 1u);
+    HOST_CHECK(exchange(request, length, reply) == 0u);
+
+    length = writeRequest(request, 1u, 6u, values, 1u);
+    crc = modbus_crc(request, length);
+    request[length] = (uint8_t)(crc ^ 0x01u);
+    request[length + 1u] = (uint8_t)(crc >> 8);
+    HOST_CHECK(unanswered(request, length + 2u));
+
+    /* A framing error inside the request, and one right behind it: the
+       bytes left may look whole. */
+    length = writeRequest(request, 1u, 6u, values, 1u);
+    errorByte = lineBytes + 3;
+    HOST_CHECK(exchange(request, length, reply) == 0u);
+    HOST_CHECK((SCI6.SSR.BYTE & MODBUS_SLAVE_SSR_ERRORS) == 0u);
+    request[length] = (uint8_t)crc;
+    request[length + 2u] = 0u;
+    errorByte = lineBytes + length + 2;
+    HOST_CHECK(unanswered(request, length + 3u));
+    HOST_CHECK((SCI6.SSR.BYTE & MODBUS_SLAVE_SSR_ERRORS) == 0u);
+
+    /* Longer than any request, with no silence inside. */
+    memset(request, MODBUS_SLAVE_ADDRESS, sizeof(request));
+    HOST_CHECK(exchange(request, sizeof(request) - 2u, reply) == 0u);
+
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK(coefficients.b1 == 0.25f);
+    HOST_CHECK(served > 0u);
+
+    /* The slave still answers. */
+    request[0] = MODBUS_SLAVE_ADDRESS;
+    request[1] = MODBUS_READ_INPUT;
+    request[2] = 0u;
+    request[3] = 14u;
+    request[4] = 0u;
+    request[5] = 2u;
+    got = exchange(request, 6u, reply);
+    HOST_CHECK((got == 9u) && (reply[2] == 4u) && (reply[6] == 1u));
+
+    /* A line error with no request: the periodic call clears it, or the
+       receiver would stay stopped. */
+    SCI6.SSR.BYTE |= 0x20u;
+    runBoard(MODBUS_SLAVE_POLL_MS + 10u);
+    HOST_CHECK((SCI6.SSR.BYTE & MODBUS_SLAVE_SSR_ERRORS) == 0u);
+    got = exchange(request, 6u, reply);
+    HOST_CHECK(got == 9u);
+}
+
+static void testLine (void) {
+    uint8_t request[8];
+    uint8_t reply[MODBUS_FRAME_MAX];
+    uint8_t noise[4] = {0x55u, 0xAAu, 0x55u, 0xAAu};
+    uint16_t crc;
+    unsigned i;
+
+    /* The deadline misses, as the bench reads. */
+    request[0] = MODBUS_SLAVE_ADDRESS;
+    request[1] = MODBUS_READ_INPUT;
+    request[2] = 0u;
+    request[3] = 14u;
+    request[4] = 0u;
+    request[5] = 2u;
+    crc = modbus_crc(request, 6u);
+    request[6] = (uint8_t)crc;
+    request[7] = (uint8_t)(crc >> 8);
+
+    /* Gaps under 3.5 characters, more than that in all: one frame. */
+    for (i = 0; i < sizeof(request); i += 2u) {
+        HOST_CHECK(write(port, &request[i], 2u) == 2);
+        runBoard(1u);
+    }
+
+    HOST_CHECK((answer(reply) == 9u) && (reply[6] == 1u));
+
+    /* A gap over it: two frames, neither whole. */
+    HOST_CHECK(write(port, request, 4u) == 4);
+    runBoard(4u);
+    HOST_CHECK(unanswered(&request[4], 4u));
+
+    /* Bytes while a frame waits for the task do not join it. */
+    uiHeld = true;
+    HOST_CHECK(write(port, request, sizeof(request)) ==
+               (ssize_t)sizeof(request));
+    runBoard(5u);
+    HOST_CHECK(modbusSlave_ready());
+    HOST_CHECK(write(port, noise, sizeof(noise)) == (ssize_t)sizeof(noise));
+    runBoard(5u);
+    uiHeld = false;
+    HOST_CHECK((answer(reply) == 9u) && (reply[6] == 1u));
+}
+
+static void benchTurnaround (void) {
+    char text[LINE_SIZE];
+    unsigned long requests = 0;
+    unsigned long before = served;
+    double beforeTime = serveTime;
+    double lowest = 0.0;
+    double average = 0.0;
+    double highest = 0.0;
+    FILE* file;
+
+    HOST_CHECK(runMaster("1 bench " BENCH_REQUESTS) == 0);
+
+    file = fopen(OUT_FILE, "r");
+
+    if ((file == NULL) || (fgets(text, sizeof(text), file) == NULL)) {
+        text[0] = '\0';
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    (void)sscanf(text, "%lu requests: turnaround min %lf us, average %lf "
+                       "us, max %lf us", &requests, &lowest, &average,
+                 &highest);
+
+    printf("master: %sslave: %.1f us per request in modbusSlave_serve()\n",
+           text, (served > before) ?
+           (serveTime - beforeTime) / (double)(served - before) / 1e3 :
+           0.0);
+
+    HOST_CHECK(requests == strtoul(BENCH_REQUESTS, NULL, 10));
+    HOST_CHECK((served - before) == requests);
+    HOST_CHECK(lowest >= (double)MODBUS_SLAVE_T35_US);
+}
+
+static bool openLine (void) {
+    struct termios settings;
+
+    line = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if ((line < 0) || (grantpt(line) != 0) || (unlockpt(line) != 0)) {
+        return false;
+    }
+
+    snprintf(portName, sizeof(portName), "%s", ptsname(line));
+    port = open(portName, O_RDWR | O_NOCTTY);
+
+    if ((port < 0) || (tcgetattr(port, &settings) != 0)) {
+        return false;
+    }
+
+    /* Raw until the master sets it up; nothing echoed back. */
+    settings.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                    INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    settings.c_oflag &= ~(tcflag_t)OPOST;
+    settings.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(tcflag_t)(CSIZE | CSTOPB);
+    settings.c_cflag |= CS8 | CREAD | CLOCAL;
+
+    return tcsetattr(port, TCSANOW, &settings) == 0;
+}
+
+static int runMaster (const char* command) {
+    char text[LINE_SIZE];
+    char* argv[10];
+    unsigned count = 2;
+    int status;
+    pid_t child;
+
+    snprintf(text, sizeof(text), "%s", command);
+    argv[0] = (char*)masterPath;
+    argv[1] = portName;
+
+    for (argv[count] = strtok(text, " "); (argv[count] != NULL) &&
+         (count < 9u); argv[count] = strtok(NULL, " ")) {
+        count++;
+    }
+
+    argv[count] = NULL;
+    fflush(stdout);
+    child = fork();
+
+    if (child == 0) {
+        /* Only the board holds the pseudo-terminal. */
+        close(line);
+        close(port);
+
+        if ((freopen(OUT_FILE, "w", stdout) == NULL) ||
+            (freopen(ERR_FILE, "w", stderr) == NULL)) {
+            _exit(127);
+        }
+
+        execv(masterPath, argv);
+        _exit(127);
+    }
+
+    if (child < 0) {
+        return -1;
+    }
+
+    while (waitpid(child, &status, WNOHANG) == 0) {
+        runBoard(1u);
+    }
+
+    /* A broadcast is still on the line when the master exits. */
+    runBoard(ANSWER_MS);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static bool readWords (const char* command, uint16_t* words,
+                       unsigned count) {
+    char text[LINE_SIZE];
+    unsigned address;
+    unsigned first = 0;
+    unsigned value;
+    unsigned lines = 0;
+    int signedValue;
+    FILE* file;
+
+    if ((runMaster(command) != 0) ||
+        (sscanf(command, "%*u %*s %u", &first) != 1)) {
+        return false;
+    }
+
+    file = fopen(OUT_FILE, "r");
+
+    while ((file != NULL) && (fgets(text, sizeof(text), file) != NULL)) {
+        if ((sscanf(text, "%u %u %d", &address, &value, &signedValue) !=
+             3) || (lines >= count) || (address != (first + lines)) ||
+            (signedValue != (int)(int16_t)value)) {
+            lines = count + 1u;
+            break;
+        }
+
+        words[lines++] = (uint16_t)value;
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    return lines == count;
+}
+
+static unsigned lastException (void) {
+    char text[LINE_SIZE];
+    unsigned code = 0;
+    FILE* file;
+
+    file = fopen(ERR_FILE, "r");
+
+    while ((file != NULL) && (code == 0u) &&
+           (fgets(text, sizeof(text), file) != NULL)) {
+        (void)sscanf(text, "exception %u", &code);
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    return code;
+}
+
+static uint16_t exchange (uint8_t* request, uint16_t length, uint8_t* reply) {
+    uint16_t crc = modbus_crc(request, length);
+
+    request[length] = (uint8_t)crc;
+    request[length + 1u] = (uint8_t)(crc >> 8);
+    length += 2u;
+
+    if (write(port, request, length) != (ssize_t)length) {
+        return 0u;
+    }
+
+    return answer(reply);
+}
+
+static uint16_t answer (uint8_t* reply) {
+    ssize_t count;
+    int pending = 0;
+
+    runBoard(ANSWER_MS);
+
+    if ((ioctl(port, FIONREAD, &pending) != 0) || (pending <= 0)) {
+        return 0u;
+    }
+
+    count = read(port, reply, MODBUS_FRAME_MAX);
+
+    /* A reply that is not a Modbus frame counts as none. */
+    if ((count < (ssize_t)MODBUS_FRAME_MIN) ||
+        (modbus_crc(reply, (uint16_t)count) != 0u)) {
+        return 0u;
+    }
+
+    return (uint16_t)count;
+}
+
+static bool unanswered (const uint8_t* data, uint16_t length) {
+    int pending = 0;
+
+    if (write(port, data, length) != (ssize_t)length) {
+        return false;
+    }
+
+    runBoard(ANSWER_MS);
+
+    return (ioctl(port, FIONREAD, &pending) == 0) && (pending == 0);
+}
+
+static uint16_t writeRequest (uint8_t* out, uint8_t slave, uint16_t address,
+                              const uint32_t* values, uint16_t count) {
+    uint16_t i;
+
+    out[0] = slave;
+    out[1] = MODBUS_WRITE_MULTIPLE;
+    out[2] = (uint8_t)(address >> 8);
+    out[3] = (uint8_t)address;
+    out[4] = 0u;
+    out[5] = (uint8_t)(count * 2u);
+    out[6] = (uint8_t)(count * 4u);
+
+    for (i = 0; i < count; i++) {
+        put32(&out[7u + (i * 4u)], values[i]);
+    }
+
+    return (uint16_t)(7u + (count * 4u));
+}
+
+static void runBoard (unsigned ms) {
+    struct timespec step = {0, STEP_NS};
+    double end = hostTest_now() + (ms * 1e6);
+
+    do {
+        stepBoard();
+        nanosleep(&step, NULL);
+    } while (hostTest_now() < end);
+}
+
+static void stepBoard (void) {
+    struct pollfd ready;
+    uint8_t data[64];
+    ssize_t count;
+    ssize_t i;
+    double start;
+
+    ready.fd = line;
+    ready.events = POLLIN;
+
+    while ((poll(&ready, 1, 0) > 0) && (ready.revents & POLLIN)) {
+        count = read(line, data, sizeof(data));
+
+        for (i = 0; i < count; i++) {
+            receive(data[i]);
+        }
+    }
+
+    timerTick();
+
+    /* The UI task: at each post, and every MODBUS_SLAVE_POLL_MS. */
+    if (!uiHeld && ((uiPending > 0u) ||
+                    ((hostTest_now() - lastServe) >=
+                     (MODBUS_SLAVE_POLL_MS * 1e6)))) {
+        uiPending = 0;
+        lastServe = hostTest_now();
+
+        if (modbusSlave_ready()) {
+            start = hostTest_now();
+            modbusSlave_serve();
+            serveTime += hostTest_now() - start;
+            served++;
+        } else {
+            modbusSlave_serve();
+        }
+    }
+
+    transmit();
+}
+
+static void receive (uint8_t data) {
+    if (lineBytes++ == errorByte) {
+        SCI6.SSR.BYTE |= SSR_FER;
+    }
+
+    /* A line error stops the receiver until its flag is cleared. */
+    if (((SCI6.SSR.BYTE & MODBUS_SLAVE_SSR_ERRORS) != 0u) ||
+        ((SCI6.SCR.BYTE & SCR_RIE) == 0u)) {
+        return;
+    }
+
+    SCI6.RDR = data;
+    timerTick();
+    modbusSlave_rxIsr();
+
+    if (CMT3.CMCNT == 0u) {
+        timerStart = hostTest_now();
+    }
+}
+
+static void timerTick (void) {
+    double now = hostTest_now();
+    double counts = (now - timerStart) * (CMT3_HZ / 1e9);
+
+    if (!CMT.CMSTR1.BIT.STR3) {
+        timerStart = now;
+        return;
+    }
+
+    /* Compare match: the counter clears and the interrupt is raised. */
+    if (counts > (double)CMT3.CMCOR) {
+        CMT3.CMCNT = 0;
+        timerStart = now;
+        modbusSlave_frameIsr();
+    } else {
+        CMT3.CMCNT = (uint16_t)counts;
+    }
+}
+
+static void transmit (void) {
+    uint8_t data[MODBUS_FRAME_MAX];
+    uint16_t count = 0;
+
+    /* TXI while the transmit data register empties. */
+    while (((SCI6.SCR.BYTE & (SCR_TIE | SCR_TE)) == (SCR_TIE | SCR_TE)) &&
+           (count < MODBUS_FRAME_MAX)) {
+        modbusSlave_txIsr();
+        data[count++] = SCI6.TDR;
+    }
+
+    if ((count > 0u) && (write(line, data, count) != (ssize_t)count)) {
+        HOST_CHECK(false);
+    }
+
+    /* TEI once the last byte left. */
+    if ((SCI6.SCR.BYTE & (SCR_TIE | MODBUS_SLAVE_SCR_TEIE)) ==
+        MODBUS_SLAVE_SCR_TEIE) {
+        modbusSlave_txEndIsr();
+    }
+}
+
+static void put32 (uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)(value >> 24);
+    out[1] = (uint8_t)(value >> 16);
+    out[2] = (uint8_t)(value >> 8);
+    out[3] = (uint8_t)value;
+}
+
+static uint32_t bitsOf (float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
@@ -0,0 +1,444 @@
+/**
+    \file netClient.c
+    \brief Reference client of the UDP monitoring protocol.
+    \details Talks to the board service (see src/netService.h) with the
+             protocol code of the board itself, src/netProto.c:
+             \code
+             netClient host[:port] watch seconds [samples.csv]
+             netClient host[:port] sp value
+             netClient host[:port] mode man|auto
+             netClient host[:port] coef b1 b2 b3
+             \endcode
+             watch subscribes and receives for the given time: the samples
+             go to the CSV file (index,sp,pv,op,er), each status to
+             standard error, and a summary at the end gives the sample and
+             datagram rates and the samples lost, from the index gaps. The
+             other commands set a value and wait for its ACK, resending up
+             to CLIENT_TRIES times; the exit status is zero only if the
+             board accepted it. Values are as in the protocol: the setpoint
+             in engineering units, the coefficients as in controller.h.
+             \par
+             Built by make -C tools into tools/build; run on the host:
+             \code
+             tools/build/netClient 192.168.1.50 watch 10 loop.csv
+             \endcode
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "netProto.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Command sends before giving up. */
+#define CLIENT_TRIES (3)
+
+/** Wait for an ACK, in milliseconds. */
+#define CLIENT_ACK_MS (1000)
+
+/** Receive poll timeout while watching, in milliseconds. */
+#define CLIENT_POLL_MS (100)
+
+/** Subscription refresh while watching, in seconds. */
+#define CLIENT_RESUBSCRIBE_S (5.0)
+
+/** PID_MAN and PID_AUTO, as in src/controllerSysControl.h. */
+#define CLIENT_MODE_MAN (0u)
+#define CLIENT_MODE_AUTO (1u)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Result names, in NetProtoResult order. */
+static const char* const resultNames[] = {
+    "ok", "bad header", "bad length", "bad type", "bad value", "refused"
+};
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Open a UDP socket connected to the board.
+    \param target Board address, host[:port].
+    \return Socket, or -1.
+ */
+static int openBoard (const char* target);
+
+/**
+    \brief Send a command and wait for its ACK.
+    \param sock Socket.
+    \param command Command; its sequence number is set here.
+    \return Command result, or -1 if no ACK came.
+ */
+static int sendCommand (int sock, NetCommand* command);
+
+/**
+    \brief Subscribe and receive samples and status for a while.
+    \param sock Socket.
+    \param seconds Watch time.
+    \param csv CSV output, or null.
+    \return Zero if any sample arrived.
+ */
+static int watch (int sock, double seconds, FILE* csv);
+
+/**
+    \brief Get a monotonic time.
+    \return Time, in seconds.
+ */
+static double now (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    NetCommand command;
+    FILE* csv = NULL;
+    int sock;
+    int result;
+
+    if (argc < 3) {
+        fprintf(stderr,
+                "usage: %s host[:port] watch seconds [samples.csv]\n"
+                "       %s host[:port] sp value\n"
+                "       %s host[:port] mode man|auto\n"
+                "       %s host[:port] coef b1 b2 b3\n",
+                argv[0], argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    sock = openBoard(argv[1]);
+
+    if (sock < 0) {
+        return 1;
+    }
+
+    memset(&command, 0, sizeof(command));
+
+    if ((strcmp(argv[2], "watch") == 0) && ((argc == 4) || (argc == 5))) {
+        if (argc == 5) {
+            csv = fopen(argv[4], "w");
+
+            if (csv == NULL) {
+                perror(argv[4]);
+                close(sock);
+                return 1;
+            }
+        }
+
+        result = watch(sock, atof(argv[3]), csv);
+
+        if ((csv != NULL) && (fclose(csv) != 0)) {
+            perror(argv[4]);
+            result = 1;
+        }
+
+        close(sock);
+
+        return result;
+    }
+
+    if ((strcmp(argv[2], "sp") == 0) && (argc == 4)) {
+        command.type = NET_PROTO_SET_SP;
+        command.setpoint = (int32_t)strtol(argv[3], NULL, 0);
+    } else if ((strcmp(argv[2], "mode") == 0) && (argc == 4) &&
+               ((strcmp(argv[3], "man") == 0) ||
+                (strcmp(argv[3], "auto") == 0))) {
+        command.type = NET_PROTO_SET_MODE;
+        command.mode = (strcmp(argv[3], "man") == 0) ? CLIENT_MODE_MAN :
+                                                       CLIENT_MODE_AUTO;
+    } else if ((strcmp(argv[2], "coef") == 0) && (argc == 6)) {
+        command.type = NET_PROTO_SET_COEF;
+        command.coefficients[0] = strtof(argv[3], NULL);
+        command.coefficients[1] = strtof(argv[4], NULL);
+        command.coefficients[2] = strtof(argv[5], NULL);
+    } else {
+        fprintf(stderr, "%s: unknown command\n", argv[2]);
+        close(sock);
+        return 2;
+    }
+
+    result = sendCommand(sock, &command);
+    close(sock);
+
+    if (result < 0) {
+        fprintf(stderr, "no answer from %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(stderr, "%s\n",
+            (result < (int)(sizeof(resultNames) / sizeof(resultNames[0]))) ?
+            resultNames[result] : "unknown result");
+
+    return (result == NET_PROTO_OK) ? 0 : 1;
+}
+
+static int openBoard (const char* target) {
+    struct addrinfo hints;
+    struct addrinfo* found;
+    char host[256];
+    char port[8];
+    const char* colon;
+    int sock;
+    int error;
+
+    colon = strrchr(target, ':');
+
+    if ((colon == NULL) || ((size_t)(colon - target) >= sizeof(host))) {
+        snprintf(host, sizeof(host), "%s", target);
+        snprintf(port, sizeof(port), "%u", NET_PROTO_PORT);
+    } else {
+        memcpy(host, target, (size_t)(colon - target));
+        host[colon - target] = '\0';
+        snprintf(port, sizeof(port), "%s", colon + 1);
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    error = getaddrinfo(host, port, &hints, &found);
+
+    if (error != 0) {
+        fprintf(stderr, "%s: %s\n", target, gai_strerror(error));
+        return -1;
+    }
+
+    sock = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+
+    /* Connected: only datagrams from the board are received. */
+    if ((sock < 0) ||
+        (connect(sock, found->ai_addr, found->ai_addrlen) != 0)) {
+        perror(target);
+
+        if (sock >= 0) {
+            close(sock);
+        }
+
+        sock = -1;
+    }
+
+    freeaddrinfo(found);
+
+    return sock;
+}
+
+static int sendCommand (int sock, NetCommand* command) {
+    static uint16_t sequence = 0;
+    struct pollfd ready;
+    uint8_t data[NET_PROTO_DATAGRAM_MAX];
+    uint16_t length;
+    ssize_t received;
+    uint8_t type;
+    uint8_t result;
+    double deadline;
+    int tries;
+    int wait;
+
+    command->sequence = ++sequence;
+    length = netProto_encodeCommand(data, command);
+
+    for (tries = 0; tries < CLIENT_TRIES; tries++) {
+        if (send(sock, data, length, 0) != (ssize_t)length) {
+            perror("send");
+            return -1;
+        }
+
+        deadline = now() + (CLIENT_ACK_MS / 1000.0);
+
+        while ((wait = (int)((deadline - now()) * 1000.0)) > 0) {
+            ready.fd = sock;
+            ready.events = POLLIN;
+
+            if (poll(&ready, 1, wait) <= 0) {
+                break;
+            }
+
+            received = recv(sock, data, sizeof(data), 0);
+
+            /* Samples and status may arrive in between; skip them. */
+            if ((received > 0) &&
+                (netProto_decodeAck(data, (uint16_t)received, &type,
+                                    &result) == NET_PROTO_OK) &&
+                (data[4] == (uint8_t)command->sequence) &&
+                (data[5] == (uint8_t)(command->sequence >> 8)) &&
+                (type == command->type)) {
+                return result;
+            }
+        }
+
+        /* The datagram buffer was reused by the receive; encode again. */
+        length = netProto_encodeCommand(data, command);
+    }
+
+    return -1;
+}
+
+static int watch (int sock, double seconds, FILE* csv) {
+    uint8_t data[NET_PROTO_DATAGRAM_MAX];
+    struct pollfd ready;
+    NetCommand subscribe;
+    NetProtoHeader header;
+    NetSample sample;
+    NetStatus status;
+    ssize_t received;
+    double start;
+    double end;
+    double lastSubscribe;
+    double elapsed;
+    uint32_t first;
+    uint32_t next = 0;
+    uint16_t count;
+    uint16_t length;
+    uint16_t i;
+    unsigned long samples = 0;
+    unsigned long datagrams = 0;
+    unsigned long lost = 0;
+    unsigned long bad = 0;
+    bool started = false;
+
+    memset(&subscribe, 0, sizeof(subscribe));
+    subscribe.type = NET_PROTO_SUBSCRIBE;
+
+    if (sendCommand(sock, &subscribe) != NET_PROTO_OK) {
+        fprintf(stderr, "subscription not answered\n");
+        return 1;
+    }
+
+    if (csv != NULL) {
+        fprintf(csv, "index,sp,pv,op,er\n");
+    }
+
+    start = now();
+    end = start + seconds;
+    lastSubscribe = start;
+
+    while (now() < end) {
+        if ((now() - lastSubscribe) >= CLIENT_RESUBSCRIBE_S) {
+            /* The board follows the last subscriber; claim it again, and
+               let the ACK be skipped below. */
+            subscribe.sequence++;
+            length = netProto_encodeCommand(data, &subscribe);
+            (void)send(sock, data, length, 0);
+            lastSubscribe = now();
+        }
+
+        ready.fd = sock;
+        ready.events = POLLIN;
+
+        if (poll(&ready, 1, CLIENT_POLL_MS) <= 0) {
+            continue;
+        }
+
+        received = recv(sock, data, sizeof(data), 0);
+
+        if ((received <= 0) ||
+            (netProto_decodeHeader(data, (uint16_t)received, &header) !=
+             NET_PROTO_OK)) {
+            bad++;
+            continue;
+        }
+
+        if (header.type == NET_PROTO_STATUS) {
+            if (netProto_decodeStatus(data, (uint16_t)received, &status) ==
+                NET_PROTO_OK) {
+                fprintf(stderr, "status: alarms 0x%04X %s %s sp %ld pv %ld "
+                                "op %ld cpu %u.%02u%% misses %lu lost %lu "
+                                "b %g %g %g\n",
+                        (unsigned)status.alarms,
+                        status.active ? "off" : "on",
+                        status.mode ? "auto" : "man",
+                        (long)status.spValue, (long)status.pvValue,
+                        (long)status.opValue,
+                        (unsigned)(status.cpuUsage / 100u),
+                        (unsigned)(status.cpuUsage % 100u),
+                        (unsigned long)status.deadlineMisses,
+                        (unsigned long)status.samplesLost,
+                        (double)status.coefficients[0],
+                        (double)status.coefficients[1],
+                        (double)status.coefficients[2]);
+            } else {
+                bad++;
+            }
+
+            continue;
+        }
+
+        if ((header.type != NET_PROTO_SAMPLES) ||
+            (netProto_decodeSamples(data, (uint16_t)received, &first,
+                                    &count) != NET_PROTO_OK)) {
+            /* Late ACKs of the subscription land here too. */
+            if (header.type != NET_PROTO_ACK) {
+                bad++;
+            }
+
+            continue;
+        }
+
+        datagrams++;
+
+        if (started) {
+            /* Unsigned difference: right across an index wrap. */
+            lost += (uint32_t)(first - next);
+        }
+
+        started = true;
+        next = first + count;
+        samples += count;
+
+        if (csv != NULL) {
+            for (i = 0; i < count; i++) {
+                netProto_getSample(data, i, &sample);
+                fprintf(csv, "%lu,%d,%d,%d,%d\n",
+                        (unsigned long)(uint32_t)(first + i), sample.sp,
+                        sample.pv, sample.op, sample.er);
+            }
+        }
+    }
+
+    elapsed = now() - start;
+
+    printf("%lu samples in %lu datagrams over %.2f s: %.0f samples/s, "
+           "%.0f datagrams/s, %lu lost, %lu bad datagrams\n",
+           samples, datagrams, elapsed, samples / elapsed,
+           datagrams / elapsed, lost, bad);
+
+    return (samples > 0u) ? 0 : 1;
+}
+
+static double now (void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1e9);
+}
@@ -0,0 +1,788 @@
+/**
+    \file netServiceHost.c
+    \brief Host test for the UDP monitoring service and its client.
+    \details Runs src/netService.c on the development host, built with
+             NET_SERVICE_ENABLED over the host sockets of tools/host/net.h,
+             against the real controller, units and snapshot sources. The
+             reference client, tools/netClient.c, talks to it over loopback:
+             \par
+             - each command through the client: a setpoint refused in
+               manual mode, mode changes, a setpoint and coefficients in and
+               out of range; the exit status of the client and the
+               controller state agree with the result, and a mode change
+               marks the display;
+             - a datagram of another protocol gets no answer, one of an
+               unknown type an ACK with NET_PROTO_BAD_TYPE, and an unknown
+               mode one with NET_PROTO_BAD_VALUE;
+             - a watch while the control task runs at 100 Hz, bursts past
+               the ring size, runs at 5000 samples/s and slows to one
+               sample every 200 ms: the samples in the client CSV are the
+               ones queued, their index gaps add up to the samples the ring
+               dropped, the datagrams are batched up to NET_SERVICE_BATCH
+               samples, a batch that is not full still goes out, and the
+               status carries the state, the deadline alarm and, once, the
+               samples lost alarm;
+             - the samples per second the service sends over loopback.
+             \par
+             The service binds NET_PROTO_PORT on every interface. Built and
+             run, with the client, by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "hostTest.h"
+#include "cpu_core.h"
+#include "os.h"
+#include "platform.h"
+#include "units.h"
+#include "controllerSysControl.h"
+#include "menu.h"
+#include "tickless.h"
+#include "netService.h"
+
+/* The service itself, with the network stack of the host. */
+#undef NET_SERVICE_ENABLED
+#define NET_SERVICE_ENABLED (1)
+#include "netService.c"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Client output files, in the working directory. */
+#define CSV_FILE "netServiceHost.csv"
+#define OUT_FILE "netServiceHost.out"
+#define ERR_FILE "netServiceHost.err"
+
+/** Watch time of the client, in seconds. */
+#define WATCH_SECONDS "2"
+
+/** Control cycle, in kernel ticks. */
+#define CONTROL_TICKS (10u)
+
+/** Samples queued at once in the burst; more than the ring holds. */
+#define BURST_SAMPLES (300u)
+
+/** Samples per poll of the fast phase. */
+#define FAST_SAMPLES (100u)
+
+/** End of the 100 Hz, burst and fast phases, and the slow sample period,
+    in kernel ticks after the subscription. */
+#define NORMAL_END (500u)
+#define FAST_END (800u)
+#define SLOW_TICKS (200u)
+
+/** Wait for an answer to a raw datagram, in kernel ticks. */
+#define ANSWER_TICKS (200u)
+
+/** Samples of the throughput measurement. */
+#define COST_SAMPLES (5000000ul)
+
+/** Longest client output line. */
+#define LINE_SIZE (256u)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
+
+/** Engineering unit range of each signal; as in app.c. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+/** PID control structure variable. */
+PIDControl pid = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
+
+/* Board and kernel stand-ins. */
+
+volatile uint8_t LED4;
+volatile uint8_t LED7;
+volatile uint8_t LED13;
+
+OS_TCB* OSTCBHighRdyPtr;
+OS_TCB OSIdleTaskTCB;
+OS_CPU_USAGE OSStatTaskCPUUsage;
+OS_CTX_SW_CTR OSTaskCtxSwCtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Client program. */
+static const char* clientPath = "./netClient";
+
+/** Start of the run, in nanoseconds. */
+static double runStart;
+
+/** UI task, notified of display changes. */
+static OS_TCB uiTask;
+
+/** Posts to the UI task. */
+static unsigned long uiPosts = 0;
+
+/** Control cycle deadline monitor, with its alarm latched. */
+static DeadlineMonitor monitor;
+
+/** Next sample index of the control task. */
+static uint32_t nextIndex = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Apply each command through the client.
+    \return None
+ */
+static void testCommands (void);
+
+/**
+    \brief Send datagrams the service must not apply.
+    \return None
+ */
+static void testForeign (void);
+
+/**
+    \brief Stream samples to a watching client and check what it got.
+    \return None
+ */
+static void testWatch (void);
+
+/**
+    \brief Time the service sending samples to a subscriber.
+    \return None
+ */
+static void benchSend (void);
+
+/**
+    \brief Run the client with one command while serving it.
+    \param command Command and its values, space separated.
+    \return Client exit status, or -1 if it did not exit.
+ */
+static int runCommand (const char* command);
+
+/**
+    \brief Start the client, with its output in OUT_FILE and ERR_FILE.
+    \param args Client arguments after the board address; null ended.
+    \return Child process, or -1.
+ */
+static pid_t startClient (char* const args[]);
+
+/**
+    \brief Serve until the client exits.
+    \param child Client process.
+    \return Client exit status, or -1 if it did not exit.
+ */
+static int serve (pid_t child);
+
+/**
+    \brief Poll the service, with the controller state published first as
+           the control task does.
+    \return None
+ */
+static void pollService (void);
+
+/**
+    \brief Get the time since the start of the run.
+    \return Time, in kernel ticks.
+ */
+static uint32_t ticks (void);
+
+/**
+    \brief Sleep for about a kernel tick.
+    \return None
+ */
+static void sleepTick (void);
+
+/**
+    \brief Queue the next control sample.
+    \return None
+ */
+static void putSample (void);
+
+/**
+    \brief Get the sample queued with an index.
+    \param index Sample index.
+    \param sample Sample.
+    \return None
+ */
+static void sampleOf (uint32_t index, NetSample* sample);
+
+/**
+    \brief Open a socket towards the service.
+    \return Socket, or -1.
+ */
+static int openService (void);
+
+/**
+    \brief Send a raw datagram to the service and serve until it answers.
+    \param fd Socket from openService().
+    \param data Datagram.
+    \param length Datagram length, in bytes.
+    \param answer Buffer for the answer, NET_PROTO_DATAGRAM_MAX bytes.
+    \return Answer length, or zero if none came.
+ */
+static uint16_t exchange (int fd, const uint8_t* data, uint16_t length,
+                          uint8_t* answer);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    if (argc > 1) {
+        clientPath = argv[1];
+    }
+
+    runStart = hostTest_now();
+    initUnits();
+    displayDirty_init(&uiTask);
+
+    /* A cycle past its deadline under the safe policy. */
+    deadline_init(&monitor, CONTROL_TICKS, CONTROL_TICKS, DEADLINE_SAFE, 0u);
+    (void)deadline_end(&monitor, CONTROL_TICKS + 5u);
+
+    netService_init();
+    HOST_CHECK(sock >= 0);
+
+    if (sock >= 0) {
+        testCommands();
+        testForeign();
+        testWatch();
+        benchSend();
+    }
+
+    remove(CSV_FILE);
+    remove(OUT_FILE);
+    remove(ERR_FILE);
+
+    return hostTest_exit();
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return (CPU_TS_TMR)hostTest_now();
+}
+
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err) {
+    *p_err = CPU_ERR_NONE;
+
+    return 1000000000u;
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    (void)opt;
+    uiPosts += (p_tcb == &uiTask) ? 1u : 0u;
+    *p_err = OS_ERR_NONE;
+
+    return 0u;
+}
+
+uint32_t tickless_wakeups (void) {
+    return 0u;
+}
+
+void lcd_clear (void) {
+}
+
+void lcd_display (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void lcd_display_inverted (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+static void testCommands (void) {
+    PIDCoefficients coefficients;
+    unsigned long posts;
+
+    /* As in the menu: no setpoint in manual. */
+    HOST_CHECK(pid.mode == PID_MAN);
+    HOST_CHECK(runCommand("sp 50") == 1);
+    HOST_CHECK(pid.spValue == 0);
+
+    posts = uiPosts;
+    (void)displayDirty_take(DISPLAY_MODE);
+    HOST_CHECK(runCommand("mode auto") == 0);
+    HOST_CHECK(pid.mode == PID_AUTO);
+    HOST_CHECK(displayDirty_take(DISPLAY_MODE));
+    HOST_CHECK(uiPosts > posts);
+
+    HOST_CHECK(runCommand("sp 60") == 0);
+    HOST_CHECK((pid.spValue == 60) && (pid.sp == toRaw(SIGNAL_SP, 60)));
+    HOST_CHECK(runCommand("sp 101") == 1);
+    HOST_CHECK(runCommand("sp -1") == 1);
+    HOST_CHECK(pid.spValue == 60);
+
+    HOST_CHECK(runCommand("coef 2.5 -1.25 0.5") == 0);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK((coefficients.b1 == 2.5f) && (coefficients.b2 == -1.25f) &&
+               (coefficients.b3 == 0.5f));
+
+    /* Not finite, refused by the decoder; out of range, by the
+       controller. */
+    HOST_CHECK(runCommand("coef nan 0 0") == 1);
+    HOST_CHECK(runCommand("coef 0 1000 0") == 1);
+    getCoefficients_PID(&coefficients);
+    HOST_CHECK(coefficients.b2 == -1.25f);
+
+    HOST_CHECK(runCommand("mode man") == 0);
+    HOST_CHECK(pid.mode == PID_MAN);
+    HOST_CHECK(runCommand("mode auto") == 0);
+}
+
+static void testForeign (void) {
+    uint8_t data[NET_PROTO_HEADER_SIZE];
+    uint8_t mode[NET_PROTO_HEADER_SIZE + 12u];
+    NetCommand command;
+    uint8_t answer[NET_PROTO_DATAGRAM_MAX];
+    uint16_t length;
+    uint8_t type;
+    uint8_t result;
+    int foreign;
+
+    foreign = openService();
+    HOST_CHECK(foreign >= 0);
+
+    if (foreign < 0) {
+        return;
+    }
+
+    /* Header of another protocol. */
+    memset(data, 0, sizeof(data));
+    data[0] = 0x12;
+    data[1] = 0x34;
+    data[2] = NET_PROTO_VERSION;
+    data[3] = NET_PROTO_SET_MODE;
+    HOST_CHECK(exchange(foreign, data, sizeof(data), answer) == 0u);
+
+    /* This protocol, a type the board does not take. */
+    data[0] = (uint8_t)NET_PROTO_MAGIC;
+    data[1] = (uint8_t)(NET_PROTO_MAGIC >> 8);
+    data[3] = 0x7F;
+    length = exchange(foreign, data, sizeof(data), answer);
+    HOST_CHECK((length != 0u) &&
+               (netProto_decodeAck(answer, length, &type, &result) ==
+                NET_PROTO_OK) &&
+               (type == 0x7Fu) && (result == NET_PROTO_BAD_TYPE));
+
+    /* A mode the client never sends. */
+    memset(&command, 0, sizeof(command));
+    command.type = NET_PROTO_SET_MODE;
+    command.mode = 7u;
+    length = exchange(foreign, mode, netProto_encodeCommand(mode, &command),
+                      answer);
+    HOST_CHECK((length != 0u) &&
+               (netProto_decodeAck(answer, length, &type, &result) ==
+                NET_PROTO_OK) &&
+               (result == NET_PROTO_BAD_VALUE));
+    HOST_CHECK(pid.mode == PID_AUTO);
+
+    close(foreign);
+}
+
+static void testWatch (void) {
+    static char* const args[] = {"watch", WATCH_SECONDS, CSV_FILE, NULL};
+    NetSample want;
+    char line[LINE_SIZE];
+    char active[8];
+    char mode[8];
+    unsigned long index;
+    unsigned long next = 0;
+    unsigned long rows = 0;
+    unsigned long gaps = 0;
+    unsigned long mismatches = 0;
+    unsigned long samples = 0;
+    unsigned long datagrams = 0;
+    unsigned long lostReported = 0;
+    unsigned long statuses = 0;
+    unsigned long wrongStatuses = 0;
+    unsigned long lostAlarms = 0;
+    unsigned long misses;
+    unsigned long lostCount;
+    unsigned alarms;
+    long sp;
+    long pv;
+    long op;
+    float b[3];
+    uint32_t start;
+    uint32_t now;
+    uint32_t lastCycle;
+    uint32_t slowFirst = 0;
+    int values[4];
+    int status = -1;
+    pid_t child;
+    bool burst = false;
+    bool slowSeen = false;
+    FILE* file;
+
+    child = startClient(args);
+    HOST_CHECK(child > 0);
+
+    if (child <= 0) {
+        return;
+    }
+
+    /* The subscription comes first. */
+    start = ticks();
+
+    while (!subscribed && ((ticks() - start) < 2000u)) {
+        pollService();
+        sleepTick();
+    }
+
+    HOST_CHECK(subscribed);
+    start = ticks();
+    lastCycle = start;
+
+    while (waitpid(child, &status, WNOHANG) == 0) {
+        now = ticks() - start;
+
+        if (now < NORMAL_END) {
+            /* The control task at 100 Hz. */
+            while ((ticks() - lastCycle) >= CONTROL_TICKS) {
+                putSample();
+                lastCycle += CONTROL_TICKS;
+            }
+        } else if (!burst) {
+            for (index = 0; index < BURST_SAMPLES; index++) {
+                putSample();
+            }
+
+            burst = true;
+        } else if (now < FAST_END) {
+            for (index = 0; index < FAST_SAMPLES; index++) {
+                putSample();
+            }
+        } else if ((ticks() - lastCycle) >= SLOW_TICKS) {
+            slowFirst = (slowFirst == 0u) ? nextIndex : slowFirst;
+            putSample();
+            lastCycle = ticks();
+        }
+
+        pollService();
+
+        /* The UI task polls every NET_SERVICE_POLL_MS. */
+        for (index = 0; index < NET_SERVICE_POLL_MS; index++) {
+            sleepTick();
+        }
+    }
+
+    HOST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+    /* Every sample row as queued; gaps only where the ring was full. */
+    file = fopen(CSV_FILE, "r");
+    HOST_CHECK(file != NULL);
+
+    if (file != NULL) {
+        HOST_CHECK((fgets(line, sizeof(line), file) != NULL) &&
+                   (strcmp(line, "index,sp,pv,op,er\n") == 0));
+
+        while (fscanf(file, "%lu,%d,%d,%d,%d", &index, &values[0],
+                      &values[1], &values[2], &values[3]) == 5) {
+            sampleOf((uint32_t)index, &want);
+
+            if ((values[0] != want.sp) || (values[1] != want.pv) ||
+                (values[2] != want.op) || (values[3] != want.er) ||
+                ((rows > 0u) && (index < next))) {
+                mismatches++;
+            }
+
+            gaps += ((rows > 0u) && (index > next)) ? (index - next) : 0u;
+            slowSeen = slowSeen || ((slowFirst != 0u) &&
+                                    (index == slowFirst));
+            next = index + 1u;
+            rows++;
+        }
+
+        fclose(file);
+    }
+
+    file = fopen(OUT_FILE, "r");
+
+    if ((file == NULL) || (fgets(line, sizeof(line), file) == NULL) ||
+        (sscanf(line, "%lu samples in %lu datagrams over %*f s: %*f "
+                      "samples/s, %*f datagrams/s, %lu lost", &samples,
+                &datagrams, &lostReported) != 3)) {
+        line[0] = '\0';
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    printf("client: %s", line);
+
+    /* Every status as set; the loss flagged in one of them. */
+    file = fopen(ERR_FILE, "r");
+
+    while ((file != NULL) && (fgets(line, sizeof(line), file) != NULL)) {
+        if (sscanf(line, "status: alarms 0x%x %7s %7s sp %ld pv %ld op %ld "
+                         "cpu %*u.%*u%% misses %lu lost %lu b %g %g %g",
+                   &alarms, active, mode, &sp, &pv, &op, &misses,
+                   &lostCount, &b[0], &b[1], &b[2]) != 11) {
+            continue;
+        }
+
+        statuses++;
+        lostAlarms += ((alarms & NET_ALARM_SAMPLES_LOST) != 0u) ? 1u : 0u;
+
+        if (((alarms & NET_ALARM_DEADLINE) == 0u) ||
+            ((alarms & NET_ALARM_CONTROLLER_OFF) == 0u) ||
+            (strcmp(mode, "auto") != 0) || (sp != 60) || (misses != 1u) ||
+            (b[0] != 2.5f) || (b[1] != -1.25f) || (b[2] != 0.5f) ||
+            (((alarms & NET_ALARM_SAMPLES_LOST) != 0u) &&
+             (lostCount != netService_lost()))) {
+            wrongStatuses++;
+        }
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    HOST_CHECK(burst && slowSeen);
+    HOST_CHECK(rows == samples);
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK(netService_lost() == (BURST_SAMPLES - NET_SERVICE_RING));
+    HOST_CHECK(gaps == netService_lost());
+    HOST_CHECK(lostReported == netService_lost());
+    HOST_CHECK((datagrams > 0u) && ((samples / datagrams) >= 30u));
+    HOST_CHECK(samples <= (datagrams * NET_SERVICE_BATCH));
+    HOST_CHECK(statuses >= 1u);
+    HOST_CHECK(wrongStatuses == 0u);
+    HOST_CHECK(lostAlarms == 1u);
+}
+
+static void benchSend (void) {
+    uint8_t data[NET_PROTO_HEADER_SIZE];
+    uint8_t answer[NET_PROTO_DATAGRAM_MAX];
+    NetCommand subscribe;
+    unsigned long datagrams = 0;
+    unsigned long i;
+    unsigned j;
+    uint16_t before;
+    double start;
+    double elapsed;
+    int sink;
+
+    sink = openService();
+
+    if (sink < 0) {
+        return;
+    }
+
+    memset(&subscribe, 0, sizeof(subscribe));
+    subscribe.type = NET_PROTO_SUBSCRIBE;
+    (void)exchange(sink, data, netProto_encodeCommand(data, &subscribe),
+                   answer);
+
+    /* Nothing reads the samples; loopback drops what overflows. */
+    start = hostTest_now();
+
+    for (i = 0; i < COST_SAMPLES; i += FAST_SAMPLES) {
+        for (j = 0; j < FAST_SAMPLES; j++) {
+            putSample();
+        }
+
+        before = txSequence;
+        netService_poll((uint32_t)i, NULL);
+        datagrams += (uint16_t)(txSequence - before);
+    }
+
+    elapsed = (hostTest_now() - start) / 1e9;
+
+    printf("service: %.1f M samples/s in %.0f k datagrams/s over loopback\n",
+           (double)COST_SAMPLES / elapsed / 1e6,
+           (double)datagrams / elapsed / 1e3);
+
+    close(sink);
+}
+
+static int runCommand (const char* command) {
+    char text[LINE_SIZE];
+    char* args[8];
+    unsigned count = 0;
+    pid_t child;
+
+    snprintf(text, sizeof(text), "%s", command);
+
+    for (args[count] = strtok(text, " "); (args[count] != NULL) &&
+         (count < 7u); args[count] = strtok(NULL, " ")) {
+        count++;
+    }
+
+    args[count] = NULL;
+    child = startClient(args);
+
+    return (child > 0) ? serve(child) : -1;
+}
+
+static pid_t startClient (char* const args[]) {
+    char* argv[12];
+    unsigned i;
+    pid_t child;
+
+    argv[0] = (char*)clientPath;
+    argv[1] = "127.0.0.1";
+
+    for (i = 0; (args[i] != NULL) && (i < 9u); i++) {
+        argv[i + 2u] = args[i];
+    }
+
+    argv[i + 2u] = NULL;
+    fflush(stdout);
+    child = fork();
+
+    if (child == 0) {
+        /* Only the board holds the service socket. */
+        close(sock);
+
+        if ((freopen(OUT_FILE, "w", stdout) == NULL) ||
+            (freopen(ERR_FILE, "w", stderr) == NULL)) {
+            _exit(127);
+        }
+
+        execv(clientPath, argv);
+        _exit(127);
+    }
+
+    return child;
+}
+
+static int serve (pid_t child) {
+    int status;
+
+    while (waitpid(child, &status, WNOHANG) == 0) {
+        pollService();
+        sleepTick();
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void pollService (void) {
+    pidSnapshot_publish(&pid);
+    netService_poll(ticks(), &monitor);
+}
+
+static uint32_t ticks (void) {
+    return (uint32_t)((hostTest_now() - runStart) /
+                      (1e9 / OS_CFG_TICK_RATE_HZ));
+}
+
+static void sleepTick (void) {
+    struct timespec tick = {0, 1000000000l / OS_CFG_TICK_RATE_HZ};
+
+    nanosleep(&tick, NULL);
+}
+
+static void putSample (void) {
+    NetSample sample;
+
+    sampleOf(nextIndex++, &sample);
+    netService_put(sample.sp, sample.pv, sample.op, sample.er);
+}
+
+static void sampleOf (uint32_t index, NetSample* sample) {
+    sample->sp = (int16_t)(index & 1023u);
+    sample->pv = (int16_t)((index * 7u) & 1023u);
+    sample->op = (int16_t)((int16_t)((index >> 2) & 1023u) - 512);
+    sample->er = (int16_t)(sample->sp - sample->pv);
+}
+
+static int openService (void) {
+    struct sockaddr_in board;
+    int fd;
+
+    fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (fd < 0) {
+        return -1;
+    }
+
+    memset(&board, 0, sizeof(board));
+    board.sin_family = AF_INET;
+    board.sin_port = htons(NET_PROTO_PORT);
+    board.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (connect(fd, (struct sockaddr*)&board, sizeof(board)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static uint16_t exchange (int fd, const uint8_t* data, uint16_t length,
+                          uint8_t* answer) {
+    struct pollfd ready;
+    uint32_t start = ticks();
+    ssize_t received;
+
+    if (send(fd, data, length, 0) != (ssize_t)length) {
+        return 0u;
+    }
+
+    while ((ticks() - start) < ANSWER_TICKS) {
+        pollService();
+
+        ready.fd = fd;
+        ready.events = POLLIN;
+
+        if (poll(&ready, 1, 1) > 0) {
+            received = recv(fd, answer, NET_PROTO_DATAGRAM_MAX, 0);
+
+            return (received > 0) ? (uint16_t)received : 0u;
+        }
+    }
+
+    return 0u;
+}
@@ -0,0 +1,277 @@
+/**
+    \file pidSnapshotHost.c
+    \brief Host stress test for the published PID state snapshot.
+    \details Runs src/pidSnapshot.c on the development host. Every publish
+             writes one value k to SP, OP and PV, -k to the error, and the
+             low bits of k to the active and mode flags, so a reader can
+             tell a snapshot mixed from two publishes:
+             \par
+             - preemption, as on the target: a POSIX interval timer signal
+               plays ControllerTask and publishes at any point of
+               pidSnapshot_read() in the main thread, which plays the UI
+               task;
+             - threads: one writer and READERS readers, for the fences of
+               memBarrier.h on the host; on one core they still preempt
+               each other at any point;
+             - the cost of a publish, without readers.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "hostTest.h"
+#include "controllerSysControl.h"
+#include "pidSnapshot.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Timer signal period of the preemption test, in microseconds. */
+#define PREEMPT_PERIOD_US (10)
+
+/** Publishes of the preemption test, one per signal. */
+#define PREEMPT_PUBLISHES (200000ul)
+
+/** Reader threads. */
+#define READERS (3u)
+
+/** Publishes of the thread test. */
+#define THREAD_PUBLISHES (20000000ul)
+
+/** Publishes of the cost measurement. */
+#define COST_PUBLISHES (50000000ul)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Publishes done by the timer signal. */
+static volatile uint32_t signalPublishes = 0;
+
+/** Thread test over. */
+static volatile bool threadsDone = false;
+
+/** Snapshots read by each reader thread. */
+static unsigned long threadReads[READERS];
+
+/** Mixed snapshots seen by each reader thread. */
+static unsigned long threadTorn[READERS];
+
+/** Retries of each reader thread. */
+static unsigned long threadRetries[READERS];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Publish the state of step k.
+    \param k Step.
+    \return None
+ */
+static void publish (uint32_t k);
+
+/**
+    \brief Check that a snapshot comes from a single publish.
+    \param snapshot Snapshot.
+    \return True if it does.
+ */
+static bool consistent (const PIDSnapshot* snapshot);
+
+/**
+    \brief Read while the timer signal publishes.
+    \return None
+ */
+static void testPreemption (void);
+
+/**
+    \brief Read from threads while one thread publishes.
+    \return None
+ */
+static void testThreads (void);
+
+/**
+    \brief Timer signal handler: one ControllerTask cycle.
+    \param signal Signal number.
+    \return None
+ */
+static void onTimer (int signal);
+
+/**
+    \brief Reader thread.
+    \param argument Reader index.
+    \return Null.
+ */
+static void* reader (void* argument);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    PIDSnapshot snapshot;
+    uint32_t k;
+    double start;
+
+    /* Nothing published yet: the initial state, without retries. */
+    HOST_CHECK(pidSnapshot_read(&snapshot) == 0u);
+    HOST_CHECK((snapshot.active == PID_OFF) && (snapshot.mode == PID_MAN));
+    HOST_CHECK((snapshot.sp == 0) && (snapshot.er == 0));
+
+    publish(1234u);
+    HOST_CHECK(pidSnapshot_read(&snapshot) == 0u);
+    HOST_CHECK(consistent(&snapshot) && (snapshot.sp == 1234));
+
+    testPreemption();
+    testThreads();
+
+    start = hostTest_now();
+
+    for (k = 0; k < COST_PUBLISHES; k++) {
+        publish(k);
+    }
+
+    printf("publish: %.1f ns without readers\n",
+           (hostTest_now() - start) / (double)COST_PUBLISHES);
+
+    return hostTest_exit();
+}
+
+static void publish (uint32_t k) {
+    PIDControl state;
+
+    state.active = (uint8_t)(k & 1u);
+    state.mode = (uint8_t)((k >> 1) & 1u);
+    state.sp = (int16_t)(k & 0x3FFFu);
+    state.op = state.sp;
+    state.pv = state.sp;
+    state.er = (int16_t)-state.sp;
+
+    pidSnapshot_publish(&state);
+}
+
+static bool consistent (const PIDSnapshot* snapshot) {
+    uint32_t k = (uint32_t)snapshot->sp;
+
+    return (snapshot->op == snapshot->sp) && (snapshot->pv == snapshot->sp) &&
+           (snapshot->er == -snapshot->sp) &&
+           (snapshot->active == (uint8_t)(k & 1u)) &&
+           (snapshot->mode == (uint8_t)((k >> 1) & 1u));
+}
+
+static void testPreemption (void) {
+    struct sigaction action;
+    struct itimerval timer;
+    PIDSnapshot snapshot;
+    unsigned long reads = 0;
+    unsigned long torn = 0;
+    unsigned long retries = 0;
+
+    action.sa_handler = onTimer;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, (struct sigaction*)0);
+
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = PREEMPT_PERIOD_US;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    while (signalPublishes < PREEMPT_PUBLISHES) {
+        retries += pidSnapshot_read(&snapshot);
+        reads++;
+
+        if (!consistent(&snapshot)) {
+            torn++;
+        }
+    }
+
+    timer.it_value.tv_usec = 0;
+    timer.it_interval.tv_usec = 0;
+    setitimer(ITIMER_REAL, &timer, (struct itimerval*)0);
+
+    printf("preemption: %lu publishes, %lu reads, %lu retries, %lu mixed\n",
+           (unsigned long)signalPublishes, reads, retries, torn);
+
+    HOST_CHECK(torn == 0u);
+}
+
+static void testThreads (void) {
+    pthread_t threads[READERS];
+    unsigned long reads = 0;
+    unsigned long torn = 0;
+    unsigned long retries = 0;
+    uintptr_t i;
+    uint32_t k;
+
+    for (i = 0; i < READERS; i++) {
+        pthread_create(&threads[i], (pthread_attr_t*)0, reader, (void*)i);
+    }
+
+    for (k = 0; k < THREAD_PUBLISHES; k++) {
+        publish(k);
+    }
+
+    threadsDone = true;
+
+    for (i = 0; i < READERS; i++) {
+        pthread_join(threads[i], (void**)0);
+        reads += threadReads[i];
+        torn += threadTorn[i];
+        retries += threadRetries[i];
+    }
+
+    printf("threads: %lu publishes, %u readers, %lu reads, %lu retries, "
+           "%lu mixed\n", (unsigned long)THREAD_PUBLISHES,
+           (unsigned)READERS, reads, retries, torn);
+
+    HOST_CHECK(torn == 0u);
+}
+
+static void onTimer (int signal) {
+    uint32_t k = signalPublishes;
+
+    (void)signal;
+
+    publish(k);
+    signalPublishes = k + 1u;
+}
+
+static void* reader (void* argument) {
+    uintptr_t index = (uintptr_t)argument;
+    PIDSnapshot snapshot;
+
+    while (!threadsDone) {
+        threadRetries[index] += pidSnapshot_read(&snapshot);
+        threadReads[index]++;
+
+        if (!consistent(&snapshot)) {
+            threadTorn[index]++;
+        }
+    }
+
+    return (void*)0;
+}
@@ -0,0 +1,502 @@
+/**
+    \file telemetryDecode.c
+    \brief Host decoder for the UART telemetry stream.
+    \details Reads the SCI2 telemetry stream (see src/telemetry.h) from a
+             capture file or straight from a serial port, and writes:
+             - a CSV file, one line per record: seq,sp,pv,op,er;
+             - optionally a column file, with each signal stored as one
+               contiguous little-endian array, for tools that load whole
+               columns at once:
+             \code
+             offset  0  char[4]   "TLC1"
+                     4  uint32    number of columns
+                     8  uint32    number of rows
+                    12  columns x { char[8] name, char type, char[3] pad },
+                                  type 'u' for uint16, 'i' for int16
+                     *  columns x rows x 2 bytes
+             \endcode
+             Frames are split on the zero delimiters, COBS decoded and
+             checked for their length and CRC; a gap in the sequence
+             numbers counts the records lost on the way, dropped by the
+             target on a full ring or by a bad frame. A capture started in
+             the middle of a frame loses that first frame only.
+             \par
+             A serial port is set to 8N1, raw, at the target bit rate;
+             decoding stops at the end of the file, when the port goes
+             away, or on Ctrl-C, and the files are written in full either
+             way. Built by make -C tools into tools/build; run on the host:
+             \code
+             tools/build/telemetryDecode /dev/ttyUSB0 loop.csv loop.tlc
+             \endcode
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Record size, CRC included, as in src/telemetry.h. */
+#define RECORD_SIZE (12u)
+
+/** Bytes of a record covered by its CRC. */
+#define CRC_SIZE (RECORD_SIZE - 2u)
+
+/** Longest encoded frame accepted, delimiter excluded. */
+#define FRAME_MAX (64u)
+
+/** Signals of a record, sequence number included. */
+#define COLUMNS (5u)
+
+/** Column file magic. */
+#define COLUMN_MAGIC "TLC1"
+
+/** Column name field size, in bytes. */
+#define COLUMN_NAME_SIZE (8u)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Decoder state. */
+typedef struct DecodeState_struct {
+    uint8_t frame[FRAME_MAX];   /**< Encoded frame being received. */
+    size_t length;              /**< Bytes of the frame so far. */
+    bool overflow;              /**< Frame longer than FRAME_MAX. */
+    uint16_t* columns[COLUMNS]; /**< Decoded records, one array per signal. */
+    size_t rows;                /**< Decoded records. */
+    size_t capacity;            /**< Records the arrays hold. */
+    uint16_t nextSequence;      /**< Expected sequence number. */
+    unsigned long badFrames;    /**< Frames of the wrong length or coding. */
+    unsigned long crcErrors;    /**< Frames with a CRC mismatch. */
+    unsigned long lost;         /**< Records missing from the sequence. */
+    FILE* csv;                  /**< CSV output. */
+} DecodeState;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Column names, in record order. */
+static const char* const columnNames[COLUMNS] = {
+    "seq", "sp", "pv", "op", "er"
+};
+
+/** Column types, in record order. */
+static const char columnTypes[COLUMNS] = { 'u', 'i', 'i', 'i', 'i' };
+
+/** Set by Ctrl-C. */
+static volatile sig_atomic_t stopRequested = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Set a serial port to raw 8N1 at 115200 bit/s.
+    \param fd Open port.
+    \return False if the settings were refused.
+ */
+static bool setupPort (int fd);
+
+/**
+    \brief Take one byte of the stream.
+    \param state Decoder state.
+    \param byte Received byte.
+    \return False if out of memory.
+ */
+static bool decodeByte (DecodeState* state, uint8_t byte);
+
+/**
+    \brief Decode and check a complete frame.
+    \param state Decoder state.
+    \return False if out of memory.
+ */
+static bool decodeFrame (DecodeState* state);
+
+/**
+    \brief COBS decode a frame.
+    \param in Encoded frame, delimiter excluded.
+    \param length Encoded length.
+    \param out Decoded bytes.
+    \param size Size of out.
+    \return Decoded length, or -1 if the coding is broken or out is too
+            small.
+ */
+static long cobsDecode (const uint8_t* in, size_t length, uint8_t* out,
+                        size_t size);
+
+/**
+    \brief Compute the CRC-16/CCITT-FALSE of a buffer.
+    \param data Buffer.
+    \param size Buffer size, in bytes.
+    \return CRC value.
+ */
+static uint16_t crc16 (const uint8_t* data, size_t size);
+
+/**
+    \brief Write the column file.
+    \param state Decoder state.
+    \param path Output path.
+    \return False on a write error.
+ */
+static bool writeColumns (const DecodeState* state, const char* path);
+
+/**
+    \brief Store a 32-bit value, little-endian.
+    \param out Buffer.
+    \param value Value to store.
+    \return None
+ */
+static void write32 (uint8_t* out, uint32_t value);
+
+/**
+    \brief SIGINT handler: stop reading.
+    \param signal Signal number.
+    \return None
+ */
+static void onInterrupt (int signal);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    static DecodeState state;
+    struct sigaction action;
+    uint8_t buffer[256];
+    ssize_t count;
+    ssize_t i;
+    bool ok = true;
+    int fd;
+    int c;
+
+    if ((argc < 3) || (argc > 4)) {
+        fprintf(stderr, "usage: %s capture|tty out.csv [out.tlc]\n",
+                argv[0]);
+        return 2;
+    }
+
+    fd = open(argv[1], O_RDONLY | O_NOCTTY);
+
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    if (isatty(fd) && !setupPort(fd)) {
+        perror(argv[1]);
+        close(fd);
+        return 1;
+    }
+
+    state.csv = fopen(argv[2], "w");
+
+    if (state.csv == NULL) {
+        perror(argv[2]);
+        close(fd);
+        return 1;
+    }
+
+    /* No restart: a blocked read returns and the files are finished. */
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+
+    fprintf(state.csv, "seq,sp,pv,op,er\n");
+
+    while (ok && !stopRequested) {
+        count = read(fd, buffer, sizeof(buffer));
+
+        if (count < 0) {
+            if ((errno == EINTR) && !stopRequested) {
+                continue;
+            }
+
+            /* EIO: the port or the other end of a pty went away. */
+            break;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        for (i = 0; ok && (i < count); i++) {
+            ok = decodeByte(&state, buffer[i]);
+        }
+    }
+
+    close(fd);
+
+    if (!ok) {
+        fprintf(stderr, "out of memory after %lu records\n",
+                (unsigned long)state.rows);
+    }
+
+    if (state.length > 0u) {
+        /* Cut off by the end of the capture. */
+        state.badFrames++;
+    }
+
+    ok = (fclose(state.csv) == 0) && ok;
+
+    if (argc == 4) {
+        ok = writeColumns(&state, argv[3]) && ok;
+    }
+
+    fprintf(stderr, "%lu records, %lu lost, %lu bad frames, "
+                    "%lu CRC errors\n",
+            (unsigned long)state.rows, state.lost, state.badFrames,
+            state.crcErrors);
+
+    for (c = 0; c < (int)COLUMNS; c++) {
+        free(state.columns[c]);
+    }
+
+    return ok ? 0 : 1;
+}
+
+static bool setupPort (int fd) {
+    struct termios settings;
+
+    if (tcgetattr(fd, &settings) != 0) {
+        return false;
+    }
+
+    /* Raw bytes in: no line editing, translation or echo. */
+    settings.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                    INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    settings.c_oflag &= ~(tcflag_t)OPOST;
+    settings.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(tcflag_t)(CSIZE | PARENB | CSTOPB);
+    settings.c_cflag |= CS8 | CREAD | CLOCAL;
+    settings.c_cc[VMIN] = 1;
+    settings.c_cc[VTIME] = 0;
+
+    if ((cfsetispeed(&settings, B115200) != 0) ||
+        (cfsetospeed(&settings, B115200) != 0)) {
+        return false;
+    }
+
+    return tcsetattr(fd, TCSANOW, &settings) == 0;
+}
+
+static bool decodeByte (DecodeState* state, uint8_t byte) {
+    bool ok = true;
+
+    if (byte != 0u) {
+        if (state->length < FRAME_MAX) {
+            state->frame[state->length++] = byte;
+        } else {
+            state->overflow = true;
+        }
+
+        return true;
+    }
+
+    if (state->overflow) {
+        state->badFrames++;
+    } else if (state->length > 0u) {
+        ok = decodeFrame(state);
+    }
+
+    state->length = 0;
+    state->overflow = false;
+
+    return ok;
+}
+
+static bool decodeFrame (DecodeState* state) {
+    uint8_t record[FRAME_MAX];
+    uint16_t values[COLUMNS];
+    uint16_t* grown;
+    size_t capacity;
+    long length;
+    unsigned c;
+
+    length = cobsDecode(state->frame, state->length, record, sizeof(record));
+
+    if (length != (long)RECORD_SIZE) {
+        state->badFrames++;
+        return true;
+    }
+
+    if (crc16(record, CRC_SIZE) !=
+        (uint16_t)(record[CRC_SIZE] | (record[CRC_SIZE + 1u] << 8))) {
+        state->crcErrors++;
+        return true;
+    }
+
+    for (c = 0; c < COLUMNS; c++) {
+        values[c] = (uint16_t)(record[2u * c] | (record[(2u * c) + 1u] << 8));
+    }
+
+    if (state->rows > 0u) {
+        /* Unsigned difference: right across a sequence wrap. */
+        state->lost += (uint16_t)(values[0] - state->nextSequence);
+    }
+
+    state->nextSequence = (uint16_t)(values[0] + 1u);
+
+    if (state->rows == state->capacity) {
+        capacity = (state->capacity == 0u) ? 1024u : (2u * state->capacity);
+
+        for (c = 0; c < COLUMNS; c++) {
+            grown = realloc(state->columns[c], capacity * sizeof(uint16_t));
+
+            if (grown == NULL) {
+                return false;
+            }
+
+            state->columns[c] = grown;
+        }
+
+        state->capacity = capacity;
+    }
+
+    for (c = 0; c < COLUMNS; c++) {
+        state->columns[c][state->rows] = values[c];
+    }
+
+    state->rows++;
+
+    fprintf(state->csv, "%u,%d,%d,%d,%d\n", (unsigned)values[0],
+            (int)(int16_t)values[1], (int)(int16_t)values[2],
+            (int)(int16_t)values[3], (int)(int16_t)values[4]);
+
+    return true;
+}
+
+static long cobsDecode (const uint8_t* in, size_t length, uint8_t* out,
+                        size_t size) {
+    size_t read = 0;
+    size_t written = 0;
+    uint8_t code;
+    uint8_t i;
+
+    while (read < length) {
+        code = in[read++];
+
+        for (i = 1; i < code; i++) {
+            if ((read >= length) || (written >= size)) {
+                return -1;
+            }
+
+            out[written++] = in[read++];
+        }
+
+        /* A block shorter than the longest ends on a zero, except the
+           last one, which ends on the delimiter. */
+        if ((code < 0xFFu) && (read < length)) {
+            if (written >= size) {
+                return -1;
+            }
+
+            out[written++] = 0;
+        }
+    }
+
+    return (long)written;
+}
+
+static uint16_t crc16 (const uint8_t* data, size_t size) {
+    uint16_t crc = 0xFFFF;
+    int bit;
+
+    while (size-- > 0u) {
+        crc ^= (uint16_t)(*data++ << 8);
+
+        for (bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) :
+                                    (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static bool writeColumns (const DecodeState* state, const char* path) {
+    uint8_t header[12];
+    uint8_t entry[COLUMN_NAME_SIZE + 4u];
+    uint8_t value[2];
+    FILE* out;
+    size_t row;
+    unsigned c;
+    bool ok;
+
+    out = fopen(path, "wb");
+
+    if (out == NULL) {
+        perror(path);
+        return false;
+    }
+
+    memcpy(header, COLUMN_MAGIC, 4u);
+    write32(header + 4, COLUMNS);
+    write32(header + 8, (uint32_t)state->rows);
+    ok = (fwrite(header, 1, sizeof(header), out) == sizeof(header));
+
+    for (c = 0; ok && (c < COLUMNS); c++) {
+        memset(entry, 0, sizeof(entry));
+        strncpy((char*)entry, columnNames[c], COLUMN_NAME_SIZE);
+        entry[COLUMN_NAME_SIZE] = (uint8_t)columnTypes[c];
+        ok = (fwrite(entry, 1, sizeof(entry), out) == sizeof(entry));
+    }
+
+    /* Byte by byte: little-endian whatever the host. */
+    for (c = 0; ok && (c < COLUMNS); c++) {
+        for (row = 0; ok && (row < state->rows); row++) {
+            value[0] = (uint8_t)state->columns[c][row];
+            value[1] = (uint8_t)(state->columns[c][row] >> 8);
+            ok = (fwrite(value, 1, sizeof(value), out) == sizeof(value));
+        }
+    }
+
+    ok = (fclose(out) == 0) && ok;
+
+    if (!ok) {
+        fprintf(stderr, "%s: write error\n", path);
+    }
+
+    return ok;
+}
+
+static void write32 (uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static void onInterrupt (int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
@@ -0,0 +1,644 @@
+/**
+    \file telemetryHost.c
+    \brief Host test for the UART telemetry stream and its decoder.
+    \details Runs src/telemetry.c on the development host. telemetry.c is
+             included, so that its transfer end interrupt can be called,
+             and a simulated DMAC channel 0 moves the frames out of the
+             ring, a random number of bytes per control cycle, into a
+             pseudo-terminal read by tools/telemetryDecode.c:
+             \par
+             - telemetry_crc() on the CRC-16/CCITT-FALSE check string;
+             - telemetry_encode() on random records with and without zero
+               bytes: no zero inside the frame, and a reference COBS
+               decode gives the record back;
+             - the SCI2 bit rate and the DMAC channel 0 set-up;
+             - 70000 control cycles, with a stalled transmitter window
+               that fills the ring, one corrupted frame and the stream
+               picked up in the middle of the first frame, and line noise
+               between two frames: every transfer starts on a frame and
+               ends at the ring storage end or earlier, the sequence number
+               wraps inside the records dropped, and the decoder writes
+               exactly the records sent, counts the dropped and corrupted
+               ones as lost, the corrupted one as a CRC error, the cut one
+               and the noise as bad frames, and writes the same records as
+               columns;
+             - the cost of queueing a record.
+             \par
+             DMAC addresses are 32 bits, cut short on a 64-bit host; the
+             simulated DMAC adds them back to the ring base. Built and run,
+             with the decoder, by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _XOPEN_SOURCE 600
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostTest.h"
+#include "telemetry.c"
+
+/* After the registers: termios.h defines B0 as a bit rate, and
+   sys/wait.h declares the wait() of machine.h. */
+#undef wait
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Random records of the encoding check. */
+#define ENCODE_RECORDS (100000u)
+
+/** Control cycles of the stream; the sequence number wraps once. */
+#define STREAM_CYCLES (70000u)
+
+/** First and one past the last cycle with the transmitter stalled; the
+    records dropped span the sequence number wrap. */
+#define STALL_FROM (65480u)
+#define STALL_TO (65600u)
+
+/** Cycle after which line noise falls between two frames. */
+#define NOISE_CYCLE (20000u)
+
+/** Noise bytes: a frame too long to take, and one that decodes to the
+    wrong length. */
+#define NOISE_LONG (70u)
+#define NOISE_SHORT (15u)
+
+/** Sequence number of the corrupted record. */
+#define CORRUPT_SEQUENCE (5000u)
+
+/** Bytes of the first frame the decoder never sees. */
+#define CUT_BYTES (5u)
+
+/** Most bytes moved by the simulated DMAC per control cycle. */
+#define CYCLE_BYTES (40u)
+
+/** Records of the cost measurement. */
+#define COST_RECORDS (10000000ul)
+
+/** Decoder output files, in the working directory. */
+#define CSV_FILE "telemetryHost.csv"
+#define COLUMN_FILE "telemetryHost.tlc"
+#define REPORT_FILE "telemetryHost.txt"
+
+/** Signals of a record, sequence number included. */
+#define COLUMNS (5u)
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Record as the decoder should write it. */
+typedef struct Expected_struct {
+    uint16_t values[COLUMNS];
+} Expected;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Decoder program. */
+static const char* decoder = "./telemetryDecode";
+
+/** Records sent whole, in order. */
+static Expected expected[STREAM_CYCLES];
+
+/** Number of records sent whole. */
+static unsigned expectedCount = 0;
+
+/** Transfers started off a frame boundary or past the ring end. */
+static unsigned long badTransfers = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the CRC and the COBS encoding of random records.
+    \return None
+ */
+static void testEncode (void);
+
+/**
+    \brief Check the SCI2 and DMAC channel 0 set-up.
+    \return None
+ */
+static void testInit (void);
+
+/**
+    \brief Stream records through a pseudo-terminal to the decoder and
+           check its output.
+    \return None
+ */
+static void testStream (void);
+
+/**
+    \brief Time the queueing of a record, with the ring drained at once.
+    \return None
+ */
+static void benchPut (void);
+
+/**
+    \brief Move bytes as DMAC channel 0 does on TXI requests, and call the
+           transfer end interrupt.
+    \param out Buffer for the bytes moved.
+    \param budget Most bytes to move.
+    \return Bytes moved.
+ */
+static unsigned dmaMove (uint8_t* out, unsigned budget);
+
+/**
+    \brief Check the transfer DMAC channel 0 was given, if any.
+    \return None
+ */
+static void checkTransfer (void);
+
+/**
+    \brief Decode a COBS frame, delimiter excluded.
+    \param frame Encoded frame.
+    \param size Frame size, in bytes.
+    \param record Buffer for the decoded bytes.
+    \return Decoded size, or -1 if the coding is broken.
+ */
+static int cobsDecode (const uint8_t* frame, unsigned size, uint8_t* record);
+
+/**
+    \brief Set a terminal to raw bytes, as the decoder does.
+    \param fd Terminal file descriptor.
+    \return None
+ */
+static void makeRaw (int fd);
+
+/**
+    \brief Check the decoder CSV file against the records sent.
+    \return None
+ */
+static void checkCsv (void);
+
+/**
+    \brief Check the decoder column file against the records sent.
+    \return None
+ */
+static void checkColumns (void);
+
+/**
+    \brief Read a 32-bit little-endian value.
+    \param in Buffer.
+    \return Value.
+ */
+static uint32_t read32 (const uint8_t* in);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    if (argc > 1) {
+        decoder = argv[1];
+    }
+
+    testEncode();
+    testInit();
+    testStream();
+    benchPut();
+
+    remove(CSV_FILE);
+    remove(COLUMN_FILE);
+    remove(REPORT_FILE);
+
+    return hostTest_exit();
+}
+
+static void testEncode (void) {
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    uint8_t record[TELEMETRY_RECORD_SIZE];
+    uint8_t decoded[TELEMETRY_FRAME_SIZE];
+    unsigned long broken = 0;
+    unsigned i;
+    unsigned b;
+
+    HOST_CHECK(telemetry_crc((const uint8_t*)"123456789", 9u) == 0x29B1u);
+    HOST_CHECK(telemetry_crc(NULL, 0u) == 0xFFFFu);
+
+    srand(1);
+
+    for (i = 0; i < ENCODE_RECORDS; i++) {
+        /* From no zero byte at all to all zeros. */
+        for (b = 0; b < TELEMETRY_RECORD_SIZE; b++) {
+            record[b] = ((unsigned)rand() % (TELEMETRY_RECORD_SIZE + 1u) <
+                         (i % (TELEMETRY_RECORD_SIZE + 1u))) ?
+                        0u : (uint8_t)(1 + (rand() % 255));
+        }
+
+        memset(frame, 0x55, sizeof(frame));
+        memcpy(&frame[1], record, sizeof(record));
+        telemetry_encode(frame);
+
+        if ((memchr(frame, 0, TELEMETRY_FRAME_SIZE - 1u) != NULL) ||
+            (frame[TELEMETRY_FRAME_SIZE - 1u] != 0u) ||
+            (cobsDecode(frame, TELEMETRY_FRAME_SIZE - 1u, decoded) !=
+             (int)TELEMETRY_RECORD_SIZE) ||
+            (memcmp(decoded, record, sizeof(record)) != 0)) {
+            broken++;
+        }
+    }
+
+    HOST_CHECK(broken == 0u);
+}
+
+static void testInit (void) {
+    telemetry_init();
+
+    HOST_CHECK(SCI2.BRR == 12u);
+    HOST_CHECK(SCI2.SCR.BYTE == 0xA0u);
+    HOST_CHECK(DMAC0.DMDAR == (uint32_t)(uintptr_t)&SCI2.TDR);
+    HOST_CHECK(ICU.DMRSR0 == VECT(SCI2,TXI2));
+    HOST_CHECK(IEN(DMAC,DMAC0I) == 1u);
+    HOST_CHECK(DMAC0.DMCNT.BIT.DTE == 0u);
+}
+
+static void testStream (void) {
+    uint8_t out[CYCLE_BYTES];
+    char report[256];
+    char port[64];
+    unsigned long records = 0;
+    unsigned long lost = 0;
+    unsigned long badFrames = 0;
+    unsigned long crcErrors = 0;
+    unsigned long sent = 0;
+    unsigned long wraps = 0;
+    unsigned cycle;
+    unsigned count;
+    unsigned skip = CUT_BYTES;
+    uint8_t noise[NOISE_LONG + NOISE_SHORT + 2u];
+    uint32_t before;
+    int16_t values[4];
+    uint8_t* frame;
+    FILE* file;
+    pid_t child;
+    int master;
+    int slave;
+    int status;
+    int pending;
+    bool corrupted = false;
+    bool noisy = false;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    HOST_CHECK(master >= 0);
+
+    if ((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0)) {
+        return;
+    }
+
+    /* Raw before the first byte; the decoder may open it late. */
+    slave = open(ptsname(master), O_RDONLY | O_NOCTTY);
+    HOST_CHECK(slave >= 0);
+    makeRaw(slave);
+
+    snprintf(port, sizeof(port), "%s", ptsname(master));
+    child = fork();
+
+    if (child == 0) {
+        /* Only the parent holds the master: closing it hangs up. */
+        close(master);
+        close(slave);
+
+        if (freopen(REPORT_FILE, "w", stderr) == NULL) {
+            _exit(127);
+        }
+
+        execl(decoder, decoder, port, CSV_FILE, COLUMN_FILE, (char*)NULL);
+        _exit(127);
+    }
+
+    /* Zero-free runs, each ended by a delimiter. */
+    memset(noise, 0x55, NOISE_LONG);
+    noise[NOISE_LONG] = 0;
+    memset(&noise[NOISE_LONG + 1u], 0x01, NOISE_SHORT);
+    noise[sizeof(noise) - 1u] = 0;
+
+    srand(2);
+
+    for (cycle = 0; cycle < STREAM_CYCLES; cycle++) {
+        values[0] = (int16_t)(rand() % 1024);
+        values[1] = (int16_t)(((cycle % 7u) == 0u) ? 0 : (rand() % 1024));
+        values[2] = (int16_t)(((cycle % 11u) == 0u) ? 0 :
+                              ((rand() % 1024) - 512));
+        values[3] = (int16_t)(values[0] - values[1]);
+
+        /* Zeros throughout now and then. */
+        if ((cycle % 13u) == 0u) {
+            memset(values, 0, sizeof(values));
+        }
+
+        before = telemetry_dropped();
+        telemetry_put(values[0], values[1], values[2], values[3]);
+        checkTransfer();
+        wraps += (sequence == 0u) ? 1u : 0u;
+
+        if (telemetry_dropped() != before) {
+            /* Dropped; the decoder sees the gap. */
+        } else if (!corrupted && (cycle >= CORRUPT_SEQUENCE)) {
+            /* A bit error on the line, inside a byte that stays
+               non-zero, so the framing holds. */
+            frame = ring[(uint8_t)(ringHead - 1u) & TELEMETRY_MASK];
+            frame[5] = (frame[5] == 0x01u) ? 0x03u : (frame[5] ^ 0x01u);
+            corrupted = true;
+        } else if (cycle != 0u) {
+            expected[expectedCount].values[0] = (uint16_t)cycle;
+            expected[expectedCount].values[1] = (uint16_t)values[0];
+            expected[expectedCount].values[2] = (uint16_t)values[1];
+            expected[expectedCount].values[3] = (uint16_t)values[2];
+            expected[expectedCount].values[4] = (uint16_t)values[3];
+            expectedCount++;
+        }
+
+        count = ((cycle >= STALL_FROM) && (cycle < STALL_TO)) ? 0u :
+                (unsigned)rand() % CYCLE_BYTES;
+        count = dmaMove(out, count);
+        sent += count;
+
+        /* The capture starts inside the first frame. */
+        while ((skip > 0u) && (count > 0u)) {
+            memmove(out, out + 1, --count);
+            skip--;
+        }
+
+        if ((count > 0u) && (write(master, out, count) != (ssize_t)count)) {
+            HOST_CHECK(false);
+            break;
+        }
+
+        if (!noisy && (cycle >= NOISE_CYCLE) && (count > 0u) &&
+            (out[count - 1u] == 0u)) {
+            noisy = (write(master, noise, sizeof(noise)) ==
+                     (ssize_t)sizeof(noise));
+        }
+    }
+
+    /* Drain the ring. */
+    while ((count = dmaMove(out, CYCLE_BYTES)) > 0u) {
+        sent += count;
+
+        if (write(master, out, count) != (ssize_t)count) {
+            HOST_CHECK(false);
+            break;
+        }
+    }
+
+    /* Hang up once the decoder has read everything. */
+    do {
+        usleep(1000);
+        pending = 0;
+    } while ((ioctl(slave, FIONREAD, &pending) == 0) && (pending > 0));
+
+    close(master);
+    waitpid(child, &status, 0);
+    close(slave);
+
+    file = fopen(REPORT_FILE, "r");
+
+    if ((file == NULL) || (fgets(report, sizeof(report), file) == NULL)) {
+        report[0] = '\0';
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+
+    (void)sscanf(report, "%lu records, %lu lost, %lu bad frames, "
+                         "%lu CRC errors", &records, &lost, &badFrames,
+                 &crcErrors);
+
+    printf("%u cycles, %lu bytes, %lu dropped on a full ring; decoder: %s",
+           STREAM_CYCLES, sent, (unsigned long)telemetry_dropped(), report);
+
+    HOST_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    HOST_CHECK(corrupted);
+    HOST_CHECK(noisy);
+    HOST_CHECK(wraps == 1u);
+    HOST_CHECK(badTransfers == 0u);
+    HOST_CHECK(telemetry_dropped() > 0u);
+    HOST_CHECK(sent == ((STREAM_CYCLES - telemetry_dropped()) *
+                        TELEMETRY_FRAME_SIZE));
+    HOST_CHECK(records == expectedCount);
+    HOST_CHECK(lost == (telemetry_dropped() + 1u));
+    HOST_CHECK(badFrames == 3u);
+    HOST_CHECK(crcErrors == 1u);
+
+    checkCsv();
+    checkColumns();
+}
+
+static void benchPut (void) {
+    unsigned long i;
+    double start;
+    double cost;
+
+    start = hostTest_now();
+
+    for (i = 0; i < COST_RECORDS; i++) {
+        telemetry_put((int16_t)i, (int16_t)(i >> 3), (int16_t)(i >> 5),
+                      (int16_t)(i >> 7));
+
+        /* The transfer ends at once. */
+        if (DMAC0.DMCNT.BIT.DTE != 0u) {
+            DMAC0.DMCNT.BIT.DTE = 0;
+            telemetry_isr();
+        }
+    }
+
+    cost = (hostTest_now() - start) / (double)COST_RECORDS;
+
+    printf("telemetry_put %.1f ns per record\n", cost);
+}
+
+static unsigned dmaMove (uint8_t* out, unsigned budget) {
+    unsigned count = 0;
+
+    while ((count < budget) && (DMAC0.DMCNT.BIT.DTE != 0u)) {
+        out[count++] = ((uint8_t*)ring)[(uint32_t)(DMAC0.DMSAR -
+                                         (uint32_t)(uintptr_t)ring)];
+        DMAC0.DMSAR++;
+
+        if (--DMAC0.DMCRA == 0u) {
+            /* The hardware clears DTE and raises the end interrupt. */
+            DMAC0.DMCNT.BIT.DTE = 0;
+            telemetry_isr();
+            checkTransfer();
+        }
+    }
+
+    return count;
+}
+
+static void checkTransfer (void) {
+    uint32_t offset = (uint32_t)(DMAC0.DMSAR - (uint32_t)(uintptr_t)ring);
+
+    if (DMAC0.DMCNT.BIT.DTE == 0u) {
+        return;
+    }
+
+    /* Whole frames, from a frame start to the ring end at most. Checked
+       on start and mid-transfer alike: the offset moves with the count. */
+    if ((((offset + DMAC0.DMCRA) % TELEMETRY_FRAME_SIZE) != 0u) ||
+        (DMAC0.DMCRA == 0u) ||
+        ((offset + DMAC0.DMCRA) > sizeof(ring))) {
+        badTransfers++;
+    }
+}
+
+static int cobsDecode (const uint8_t* frame, unsigned size, uint8_t* record) {
+    unsigned in = 0;
+    unsigned written = 0;
+    unsigned code;
+    unsigned i;
+
+    while (in < size) {
+        code = frame[in++];
+
+        if ((code == 0u) || ((in + code - 1u) > size)) {
+            return -1;
+        }
+
+        for (i = 1; i < code; i++) {
+            record[written++] = frame[in++];
+        }
+
+        /* A code short of the end stands for a zero. */
+        if (in < size) {
+            record[written++] = 0;
+        }
+    }
+
+    return (int)written;
+}
+
+static void makeRaw (int fd) {
+    struct termios settings;
+
+    if (tcgetattr(fd, &settings) != 0) {
+        return;
+    }
+
+    settings.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP |
+                                    INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    settings.c_oflag &= ~(tcflag_t)OPOST;
+    settings.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    settings.c_cflag &= ~(tcflag_t)(CSIZE | PARENB | CSTOPB);
+    settings.c_cflag |= CS8 | CREAD | CLOCAL;
+
+    (void)tcsetattr(fd, TCSANOW, &settings);
+}
+
+static void checkCsv (void) {
+    unsigned long mismatches = 0;
+    unsigned row = 0;
+    unsigned seq;
+    int values[4];
+    char header[64];
+    FILE* csv;
+
+    csv = fopen(CSV_FILE, "r");
+    HOST_CHECK(csv != NULL);
+
+    if (csv == NULL) {
+        return;
+    }
+
+    HOST_CHECK((fgets(header, sizeof(header), csv) != NULL) &&
+               (strcmp(header, "seq,sp,pv,op,er\n") == 0));
+
+    while (fscanf(csv, "%u,%d,%d,%d,%d", &seq, &values[0], &values[1],
+                  &values[2], &values[3]) == 5) {
+        if ((row >= expectedCount) ||
+            (seq != expected[row].values[0]) ||
+            (values[0] != (int16_t)expected[row].values[1]) ||
+            (values[1] != (int16_t)expected[row].values[2]) ||
+            (values[2] != (int16_t)expected[row].values[3]) ||
+            (values[3] != (int16_t)expected[row].values[4])) {
+            mismatches++;
+        }
+
+        row++;
+    }
+
+    fclose(csv);
+
+    HOST_CHECK(row == expectedCount);
+    HOST_CHECK(mismatches == 0u);
+}
+
+static void checkColumns (void) {
+    static const char names[COLUMNS][8] = {"seq", "sp", "pv", "op", "er"};
+    uint8_t header[12u + (COLUMNS * 12u)];
+    uint8_t value[2];
+    unsigned long mismatches = 0;
+    unsigned c;
+    unsigned row;
+    bool ok;
+    FILE* file;
+
+    file = fopen(COLUMN_FILE, "rb");
+    HOST_CHECK(file != NULL);
+
+    if (file == NULL) {
+        return;
+    }
+
+    ok = (fread(header, 1, sizeof(header), file) == sizeof(header));
+    HOST_CHECK(ok && (memcmp(header, "TLC1", 4u) == 0));
+    HOST_CHECK(ok && (read32(header + 4) == COLUMNS));
+    HOST_CHECK(ok && (read32(header + 8) == expectedCount));
+
+    for (c = 0; ok && (c < COLUMNS); c++) {
+        HOST_CHECK(strncmp((const char*)&header[12u + (c * 12u)], names[c],
+                           8u) == 0);
+        HOST_CHECK(header[20u + (c * 12u)] == ((c == 0u) ? 'u' : 'i'));
+    }
+
+    /* Each column whole, one after the other. */
+    for (c = 0; ok && (c < COLUMNS); c++) {
+        for (row = 0; ok && (row < expectedCount); row++) {
+            ok = (fread(value, 1, sizeof(value), file) == sizeof(value));
+
+            if (ok && ((uint16_t)(value[0] | (value[1] << 8)) !=
+                       expected[row].values[c])) {
+                mismatches++;
+            }
+        }
+    }
+
+    HOST_CHECK(ok && (fread(value, 1, 1u, file) == 0u));
+    HOST_CHECK(mismatches == 0u);
+
+    fclose(file);
+}
+
+static uint32_t read32 (const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+           ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
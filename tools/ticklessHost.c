@@ -0,0 +1,600 @@
+/**
+    \file ticklessHost.c
+    \brief Host test for the tickless idle hook.
+    \details Runs src/tickless.c on the development host. tickless.c is
+             included with wait() bound to a simulated CMT0 and CMT2, so
+             the idle hook runs whole: it masks the tick, programs CMT2,
+             sleeps until CMT2, the tick or another interrupt wakes it, and
+             hands the ticks it slept over to the kernel:
+             \par
+             - tickless_idleTicks() on an empty wheel, the nearest
+               deadline, the limit, deadlines due or passed and across a
+               tick counter wrap;
+             - tickless_crossings() on exact and skewed counts, and the
+               programmed CMT2 match landing on the deadline boundary from
+               any CMT0 phase;
+             - 200000 random sleeps, with early interrupts, ticks falling
+               due inside the hook and tasks readied before the sleep: the
+               kernel gets exactly the ticks CMT0 counted, none lost or
+               twice, no sleep passes the nearest deadline, deadlines
+               nearer than TICKLESS_MIN_TICKS keep the tick, and CMT2
+               wakes the core on a CMT0 count boundary;
+             - 10 s of the application schedule: the control cycle
+               (10 ms), the switch poll (50 ms), the statistic task
+               (100 ms) and the display refresh (500 ms), with wake-ups per
+               second against one per tick, and again across a tick counter
+               wrap.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hostTest.h"
+#include "machine.h"
+
+/**
+    \brief Sleep the simulated core until an enabled interrupt.
+    \return None
+ */
+static void hostSleep (void);
+
+/* The idle hook sleeps in the simulated timers. */
+#undef wait
+#define wait() hostSleep()
+
+#include "tickless.c"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** CMT0 counts per kernel tick: PCLK/8 at 48 MHz, 1 kHz. */
+#define TICK_COUNTS (6000u)
+
+/** Tick wheel spokes, as OS_CFG_TICK_WHEEL_SIZE. */
+#define WHEEL_SPOKES (17u)
+
+/** Longest sleep, in ticks: 65536 CMT0 counts. */
+#define SLEEP_LIMIT (65536u / TICK_COUNTS)
+
+/** Random sleeps. */
+#define RANDOM_SLEEPS (200000ul)
+
+/** Largest number of deadlines in the wheel of a random sleep. */
+#define RANDOM_DEADLINES (4u)
+
+/** Most CMT0 counts the hook runs from a wake-up to stopping CMT2. */
+#define WAKE_SKEW (4u)
+
+/** Simulated time of a schedule run, in ticks: 10 s. */
+#define SCHEDULE_TICKS (10000u)
+
+/** Periodic tasks of the schedule. */
+#define SCHEDULE_TASKS (4u)
+
+/** CMT0 counts a released task runs: 50 us. */
+#define TASK_COUNTS (300u)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Kernel stand-ins. */
+
+OS_TICK OSTickCtr;
+OS_TCB OSTickTaskTCB;
+OS_TICK_SPOKE OSCfg_TickWheel[WHEEL_SPOKES];
+const OS_OBJ_QTY OSCfg_TickWheelSize = WHEEL_SPOKES;
+void (*OS_AppIdleTaskHookPtr)(void);
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** CMT0 counts since the start of a run. */
+static uint64_t hostCounts = 0;
+
+/** Counts from the start of a sleep to an interrupt other than the
+    timers; zero for none. */
+static uint32_t otherInterrupt = 0;
+
+/** A tick falls due in the hook, after interrupts were masked. */
+static bool tickInHook = false;
+
+/** Tick count at the start of a run. */
+static OS_TICK startTick = 0;
+
+/** Sleeps with CMT2 programmed. */
+static unsigned long timedSleeps = 0;
+
+/** CMT2 wake-ups off the CMT0 count boundary. */
+static unsigned long offBoundary = 0;
+
+/** Highest priority ready, as OS_PrioGetHighest() reports it. */
+static OS_PRIO readyPriority = OS_CFG_PRIO_MAX - 1u;
+
+/** Scheduler lock nesting. */
+static int schedulerLocks = 0;
+
+/** Tasks of the application schedule. */
+static OS_TCB scheduleTasks[SCHEDULE_TASKS];
+
+/** Period of each schedule task, in ticks. */
+static const OS_TICK schedulePeriods[SCHEDULE_TASKS] = {10, 50, 100, 500};
+
+/** First release of each schedule task, after the start. */
+static const OS_TICK schedulePhases[SCHEDULE_TASKS] = {10, 53, 101, 507};
+
+/** Releases of each schedule task not yet run. */
+static uint32_t scheduleReleases[SCHEDULE_TASKS];
+
+/** The kernel tick releases the schedule tasks. */
+static bool scheduleActive = false;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check the tick wheel search.
+    \return None
+ */
+static void testIdleTicks (void);
+
+/**
+    \brief Check the timer period count.
+    \return None
+ */
+static void testCrossings (void);
+
+/**
+    \brief Check random sleeps of the idle hook.
+    \return None
+ */
+static void testSleeps (void);
+
+/**
+    \brief Run the application schedule through the idle hook.
+    \param start Tick count at the start.
+    \return Wake-ups per second.
+ */
+static double runSchedule (OS_TICK start);
+
+/**
+    \brief Set the timers, the tick count and the wheel for a run.
+    \param start Tick count at the start.
+    \return None
+ */
+static void startRun (OS_TICK start);
+
+/**
+    \brief Let time pass on the simulated timers.
+    \param counts CMT0 counts.
+    \return None
+ */
+static void advance (uint32_t counts);
+
+/**
+    \brief Take the pending enabled interrupts, as the CPU does with
+           interrupts unmasked.
+    \return None
+ */
+static void takeInterrupts (void);
+
+/**
+    \brief Kernel tick: count it and release the tasks it makes due.
+    \return None
+ */
+static void kernelTick (void);
+
+/**
+    \brief Put a task in the tick wheel, first of its spoke if it expires
+           first.
+    \param task Pointer to the task, with its TickCtrMatch set.
+    \return None
+ */
+static void wheelInsert (OS_TCB* task);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    double tickless;
+    double wrapped;
+
+    srand(4);
+
+    testIdleTicks();
+    testCrossings();
+
+    tickless_init();
+    HOST_CHECK(OS_AppIdleTaskHookPtr == tickless_idleHook);
+    HOST_CHECK((CMT2.CMCR.WORD & 0x0003u) == (CMT0.CMCR.WORD & 0x0003u));
+
+    testSleeps();
+
+    tickless = runSchedule(0u);
+    wrapped = runSchedule(0xFFFFFFFFul - (SCHEDULE_TICKS / 2u));
+
+    printf("wake-ups per second: ticked %u, tickless %.1f, "
+           "across a tick wrap %.1f\n", OS_CFG_TICK_RATE_HZ, tickless,
+           wrapped);
+
+    HOST_CHECK(tickless == wrapped);
+    HOST_CHECK(tickless < (OS_CFG_TICK_RATE_HZ / 5u));
+
+    return hostTest_exit();
+}
+
+void OSSchedLock (OS_ERR* p_err) {
+    schedulerLocks++;
+    *p_err = OS_ERR_NONE;
+}
+
+void OSSchedUnlock (OS_ERR* p_err) {
+    schedulerLocks--;
+    *p_err = OS_ERR_NONE;
+}
+
+OS_PRIO OS_PrioGetHighest (void) {
+    /* Interrupts are masked here: a tick that falls due stays pending. */
+    if (tickInHook) {
+        advance(TICK_COUNTS - CMT0.CMCNT);
+    }
+
+    return readyPriority;
+}
+
+OS_SEM_CTR OSTaskSemPost (OS_TCB* p_tcb, OS_OPT opt, OS_ERR* p_err) {
+    HOST_CHECK(p_tcb == &OSTickTaskTCB);
+    (void)opt;
+
+    kernelTick();
+    *p_err = OS_ERR_NONE;
+
+    return 0u;
+}
+
+static void hostSleep (void) {
+    uint32_t counts = UINT32_MAX;
+    uint32_t toMatch = UINT32_MAX;
+
+    if ((IEN(CMT0,CMI0) && IR(CMT0,CMI0)) ||
+        (IEN(CMT2,CMI2) && IR(CMT2,CMI2))) {
+        counts = 0;
+    }
+
+    if (IEN(CMT0,CMI0) && (counts != 0u)) {
+        counts = TICK_COUNTS - CMT0.CMCNT;
+    }
+
+    if (IEN(CMT2,CMI2) && CMT.CMSTR1.BIT.STR2) {
+        timedSleeps++;
+        toMatch = (uint32_t)CMT2.CMCOR + 1u - CMT2.CMCNT;
+        counts = (toMatch < counts) ? toMatch : counts;
+    }
+
+    if ((otherInterrupt != 0u) && (otherInterrupt < counts)) {
+        counts = otherInterrupt;
+    }
+
+    /* Something must wake the core. */
+    HOST_CHECK(counts != UINT32_MAX);
+
+    advance(counts);
+
+    /* CMT2 matches on the boundary of the deadline tick. */
+    if ((counts == toMatch) && (CMT0.CMCNT != 0u)) {
+        offBoundary++;
+    }
+
+    takeInterrupts();
+
+    /* The hook runs on for a few counts before it stops CMT2. */
+    advance((uint32_t)rand() % (WAKE_SKEW + 1u));
+}
+
+static void testIdleTicks (void) {
+    OS_TCB first;
+    OS_TCB second;
+
+    memset(OSCfg_TickWheel, 0, sizeof(OSCfg_TickWheel));
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 100u, 10u) ==
+               10u);
+
+    first.TickCtrMatch = 105u;
+    OSCfg_TickWheel[105u % WHEEL_SPOKES].FirstPtr = &first;
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 100u, 10u) ==
+               5u);
+
+    second.TickCtrMatch = 103u;
+    OSCfg_TickWheel[103u % WHEEL_SPOKES].FirstPtr = &second;
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 100u, 10u) ==
+               3u);
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 100u, 2u) ==
+               2u);
+
+    /* Due now, and passed but not yet handled. */
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 103u, 10u) ==
+               0u);
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES, 104u, 10u) ==
+               0u);
+
+    /* Across the tick counter wrap. */
+    memset(OSCfg_TickWheel, 0, sizeof(OSCfg_TickWheel));
+    first.TickCtrMatch = 3u;
+    OSCfg_TickWheel[3].FirstPtr = &first;
+    HOST_CHECK(tickless_idleTicks(OSCfg_TickWheel, WHEEL_SPOKES,
+                                  0xFFFFFFFEul, 10u) == 5u);
+}
+
+static void testCrossings (void) {
+    unsigned long mismatches = 0;
+    uint32_t compare;
+    uint32_t phase;
+    uint32_t ticks;
+    uint32_t skew;
+    uint32_t elapsed;
+
+    HOST_CHECK(tickless_crossings(100u, 5899u, 5999u, TICK_COUNTS) == 0u);
+    HOST_CHECK(tickless_crossings(100u, 5900u, 0u, TICK_COUNTS) == 1u);
+
+    /* A few counts of read skew either way. */
+    HOST_CHECK(tickless_crossings(100u, 59900u, 2u, TICK_COUNTS) == 10u);
+    HOST_CHECK(tickless_crossings(100u, 59895u, 0u, TICK_COUNTS) == 10u);
+    HOST_CHECK(tickless_crossings(5990u, 3u, 5998u, TICK_COUNTS) == 0u);
+    HOST_CHECK(tickless_crossings(5999u, 2u, 1u, TICK_COUNTS) == 1u);
+
+    /* The CMT2 match of the hook lands on the deadline boundary. */
+    for (phase = 0; phase < TICK_COUNTS; phase++) {
+        for (ticks = TICKLESS_MIN_TICKS; ticks <= SLEEP_LIMIT; ticks++) {
+            compare = (ticks * TICK_COUNTS) - phase - 1u;
+            mismatches += (compare > 0xFFFFu) ? 1u : 0u;
+
+            for (skew = 0; skew <= WAKE_SKEW; skew++) {
+                elapsed = compare + 1u + skew;
+                mismatches +=
+                    (tickless_crossings((uint16_t)phase, elapsed,
+                                        (uint16_t)((phase + elapsed) %
+                                                   TICK_COUNTS),
+                                        TICK_COUNTS) != ticks) ? 1u : 0u;
+            }
+        }
+    }
+
+    HOST_CHECK(mismatches == 0u);
+}
+
+static void testSleeps (void) {
+    static OS_TCB waiting[RANDOM_DEADLINES];
+    OS_TICK nearest;
+    OS_TICK remain;
+    OS_TICK deadline;
+    uint32_t wakeups;
+    unsigned long sleep;
+    unsigned long timed;
+    unsigned long lost = 0;
+    unsigned long late = 0;
+    unsigned long shortSleeps = 0;
+    unsigned i;
+    unsigned deadlines;
+    bool due;
+
+    startRun(0xFFFFFFFFul - 100000u);
+
+    for (sleep = 0; sleep < RANDOM_SLEEPS; sleep++) {
+        memset(OSCfg_TickWheel, 0, sizeof(OSCfg_TickWheel));
+        deadlines = (unsigned)rand() % (RANDOM_DEADLINES + 1u);
+        nearest = SLEEP_LIMIT;
+        due = false;
+
+        /* Deadlines up to 14 ticks away; now and then one passed. */
+        for (i = 0; i < deadlines; i++) {
+            waiting[i].TickCtrMatch = OSTickCtr - 1u +
+                                      ((unsigned)rand() % 16u);
+            wheelInsert(&waiting[i]);
+
+            remain = waiting[i].TickCtrMatch - OSTickCtr;
+            due = due || (remain == 0u) || (remain > 0x7FFFFFFFul);
+            nearest = (remain < nearest) ? remain : nearest;
+        }
+
+        otherInterrupt = 0;
+
+        if ((rand() % 4) == 0) {
+            otherInterrupt = 1u + ((uint32_t)rand() %
+                                   (SLEEP_LIMIT * TICK_COUNTS));
+        }
+
+        tickInHook = (rand() % 50) == 0;
+        readyPriority = ((rand() % 50) == 0) ? 5u : (OS_CFG_PRIO_MAX - 1u);
+        deadline = OSTickCtr + (due ? 1u : nearest);
+        wakeups = tickless_wakeups();
+        timed = timedSleeps;
+
+        OS_AppIdleTaskHookPtr();
+        takeInterrupts();
+
+        /* Deadlines nearer than TICKLESS_MIN_TICKS keep the tick. */
+        if ((timedSleeps != timed) &&
+            (due || (nearest < TICKLESS_MIN_TICKS))) {
+            shortSleeps++;
+        }
+
+        /* Every tick CMT0 counted reached the kernel, once. */
+        lost += ((OSTickCtr - startTick) !=
+                 (OS_TICK)(hostCounts / TICK_COUNTS)) ? 1u : 0u;
+
+        /* No sleep went past the nearest deadline; one due or passed
+           ends at the next tick. */
+        late += ((int32_t)(OSTickCtr - deadline) > 0) ? 1u : 0u;
+
+        HOST_CHECK(schedulerLocks == 0);
+        HOST_CHECK(tickless_wakeups() == (wakeups +
+                   ((readyPriority == (OS_CFG_PRIO_MAX - 1u)) ? 1u : 0u)));
+    }
+
+    printf("%lu sleeps, %lu with CMT2, %lu ticks; %lu lost or doubled, "
+           "%lu late\n", RANDOM_SLEEPS, timedSleeps,
+           (unsigned long)(hostCounts / TICK_COUNTS), lost, late);
+
+    HOST_CHECK(lost == 0u);
+    HOST_CHECK(late == 0u);
+    HOST_CHECK(offBoundary == 0u);
+    HOST_CHECK(shortSleeps == 0u);
+    HOST_CHECK(timedSleeps != 0u);
+
+    otherInterrupt = 0;
+    tickInHook = false;
+    readyPriority = OS_CFG_PRIO_MAX - 1u;
+}
+
+static double runSchedule (OS_TICK start) {
+    uint32_t wakeups;
+    unsigned long missed = 0;
+    unsigned i;
+
+    startRun(start);
+    scheduleActive = true;
+
+    for (i = 0; i < SCHEDULE_TASKS; i++) {
+        scheduleTasks[i].TickCtrMatch = start + schedulePhases[i];
+        scheduleReleases[i] = 0;
+    }
+
+    wakeups = tickless_wakeups();
+
+    while ((OSTickCtr - start) < SCHEDULE_TICKS) {
+        memset(OSCfg_TickWheel, 0, sizeof(OSCfg_TickWheel));
+
+        for (i = 0; i < SCHEDULE_TASKS; i++) {
+            wheelInsert(&scheduleTasks[i]);
+        }
+
+        OS_AppIdleTaskHookPtr();
+        takeInterrupts();
+
+        /* Released tasks run; the tick interrupt stays enabled. */
+        for (i = 0; i < SCHEDULE_TASKS; i++) {
+            while (scheduleReleases[i] != 0u) {
+                scheduleReleases[i]--;
+                advance(TASK_COUNTS);
+                takeInterrupts();
+            }
+
+            missed += ((scheduleTasks[i].TickCtrMatch - OSTickCtr) >
+                       0x7FFFFFFFul) ? 1u : 0u;
+        }
+    }
+
+    scheduleActive = false;
+    HOST_CHECK(missed == 0u);
+
+    return (double)(tickless_wakeups() - wakeups) /
+           ((double)(OSTickCtr - start) / OS_CFG_TICK_RATE_HZ);
+}
+
+static void startRun (OS_TICK start) {
+    hostCounts = 0;
+    CMT0.CMCOR = TICK_COUNTS - 1u;
+    CMT0.CMCNT = 0;
+    CMT2.CMCNT = 0;
+    CMT2.CMCOR = 0;
+    CMT.CMSTR1.BIT.STR2 = 0;
+    IR(CMT0,CMI0) = 0;
+    IEN(CMT0,CMI0) = 1;
+    IR(CMT2,CMI2) = 0;
+    IEN(CMT2,CMI2) = 0;
+
+    OSTickCtr = start;
+    startTick = start;
+}
+
+static void advance (uint32_t counts) {
+    uint64_t ticks = hostCounts / TICK_COUNTS;
+    uint32_t count;
+
+    hostCounts += counts;
+    CMT0.CMCNT = (uint16_t)(hostCounts % TICK_COUNTS);
+
+    /* One request flag, however many boundaries went by. */
+    if ((hostCounts / TICK_COUNTS) != ticks) {
+        IR(CMT0,CMI0) = 1;
+    }
+
+    if (CMT.CMSTR1.BIT.STR2) {
+        count = (uint32_t)CMT2.CMCNT + counts;
+
+        /* Cleared on the match. */
+        if (count > CMT2.CMCOR) {
+            IR(CMT2,CMI2) = 1;
+            count %= (uint32_t)CMT2.CMCOR + 1u;
+        }
+
+        CMT2.CMCNT = (uint16_t)count;
+    }
+}
+
+static void takeInterrupts (void) {
+    if (IEN(CMT0,CMI0) && IR(CMT0,CMI0)) {
+        IR(CMT0,CMI0) = 0;
+        kernelTick();
+    }
+
+    /* The wake-up ISR may also be left pending for the hook to see. */
+    if (IEN(CMT2,CMI2) && IR(CMT2,CMI2) && ((rand() & 1) != 0)) {
+        IR(CMT2,CMI2) = 0;
+        tickless_isr();
+    }
+}
+
+static void kernelTick (void) {
+    unsigned i;
+
+    OSTickCtr++;
+
+    if (!scheduleActive) {
+        return;
+    }
+
+    for (i = 0; i < SCHEDULE_TASKS; i++) {
+        if (scheduleTasks[i].TickCtrMatch == OSTickCtr) {
+            scheduleTasks[i].TickCtrMatch += schedulePeriods[i];
+            scheduleReleases[i]++;
+        }
+    }
+}
+
+static void wheelInsert (OS_TCB* task) {
+    OS_TICK_SPOKE* spoke = &OSCfg_TickWheel[task->TickCtrMatch %
+                                            WHEEL_SPOKES];
+
+    if ((spoke->FirstPtr == (OS_TCB*)0) ||
+        ((task->TickCtrMatch - OSTickCtr) <
+         (spoke->FirstPtr->TickCtrMatch - OSTickCtr))) {
+        spoke->FirstPtr = task;
+    }
+}
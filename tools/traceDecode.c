@@ -0,0 +1,492 @@
+/**
+    \file traceDecode.c
+    \brief Host decoder for event trace dumps.
+    \details Reads a binary dump of the target traceBuffer (see src/trace.h)
+             and writes the events as Chrome trace event JSON, which
+             chrome://tracing and ui.perfetto.dev open as a timeline:
+             - one track per task priority, a slice per time slice;
+             - one track per traced ISR, a slice per entry/exit pair;
+             - SP, PV and OP counters, in raw units;
+             - instant events for buttons and menu transitions.
+             \par
+             Timestamps are unwrapped across 32-bit timer overflows, which
+             is exact as long as consecutive events are less than one timer
+             period apart; the control samples guarantee that. Dumps of
+             either byte order are accepted.
+             \par
+             Built by make -C tools into tools/build; run on the host:
+             \code
+             tools/build/traceDecode trace.bin trace.json
+             \endcode
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Dump header magic, as in src/trace.h. */
+#define TRACE_MAGIC (0x31435254ul)
+
+/** Dump header size, in bytes. */
+#define HEADER_SIZE (20u)
+
+/** Bytes of an event the decoder reads. */
+#define EVENT_SIZE (8u)
+
+/** Chrome trace process id of the target. */
+#define TARGET_PID (1)
+
+/** Track id of button and menu events. */
+#define EVENTS_TID (0)
+
+/** Track id of the first ISR; tasks use their priority. */
+#define ISR_TID (1000)
+
+/** Key event type mask, as in src/debounce.h. */
+#define KEY_EVENT_TYPE_MASK (0xF0u)
+
+/** Key mask, as in src/debounce.h. */
+#define KEY_EVENT_KEY_MASK (0x0Fu)
+
+
+
+/******************************************************************************
+*                                ENUMERATIONS                                 *
+******************************************************************************/
+
+/** Event types, as in src/trace.h. */
+enum TraceEventType {
+    TRACE_EVENT_NONE,
+    TRACE_EVENT_TASK,
+    TRACE_EVENT_ISR_ENTER,
+    TRACE_EVENT_ISR_EXIT,
+    TRACE_EVENT_SAMPLE,
+    TRACE_EVENT_BUTTON,
+    TRACE_EVENT_MENU,
+    TRACE_EVENTS
+};
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** ISR names, in src/trace.h TraceIsrType order. */
+static const char* const isrNames[] = {
+    "SW1 ISR", "SW2 ISR", "SW3 ISR", "ADC block ISR",
+    "Modbus frame ISR", "Console ISR"
+};
+
+/** Signal names, in src/controllerSysControl.h SignalType order. */
+static const char* const signalNames[] = {
+    "SP", "OP", "PV"
+};
+
+/** Key event type names, by type nibble (src/debounce.h). */
+static const char* const keyEventNames[] = {
+    "press", "release", "long", "repeat"
+};
+
+/** Menu state names, in src/menu.h MenuStateType order. */
+static const char* const menuNames[] = {
+    "ON_OFF_VIEW", "ON_OFF_EDIT", "MAN_AUT_VIEW", "MAN_AUT_EDIT",
+    "SP_VIEW", "SP_EDIT", "OP_VIEW", "OP_EDIT",
+    "TREND_VIEW", "TREND_EDIT", "DIAG_VIEW", "DIAG_EDIT"
+};
+
+/** Number of entries of a name table. */
+#define NAMES(table) (sizeof(table) / sizeof((table)[0]))
+
+
+
+/******************************************************************************
+*                              TYPE DEFINITIONS                               *
+******************************************************************************/
+
+/** Decoded dump header. */
+typedef struct DumpHeader_struct {
+    bool swap;              /**< Dump byte order differs from little-endian. */
+    uint32_t frequency;     /**< Timestamp timer frequency, in Hz. */
+    uint32_t size;          /**< Events in the ring. */
+    uint32_t eventSize;     /**< Bytes per event. */
+    uint32_t head;          /**< Events recorded. */
+} DumpHeader;
+
+/** Decoder state across events. */
+typedef struct DecodeState_struct {
+    FILE* out;              /**< JSON output. */
+    bool first;             /**< No JSON event written yet. */
+    double scale;           /**< Microseconds per timer count. */
+    uint64_t time;          /**< Unwrapped time of the last event. */
+    uint32_t lastStamp;     /**< Raw timestamp of the last event. */
+    bool started;           /**< lastStamp is valid. */
+    int task;               /**< Running task priority, -1 if unknown. */
+    bool taskSeen[256];     /**< Task track named. */
+    bool isrOpen[256];      /**< ISR entered and not yet exited. */
+    bool isrSeen[256];      /**< ISR track named. */
+} DecodeState;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Read a 16-bit dump field.
+    \param data Pointer to the field.
+    \param swap True for a big-endian dump.
+    \return Field value.
+ */
+static uint16_t read16 (const uint8_t* data, bool swap);
+
+/**
+    \brief Read a 32-bit dump field.
+    \param data Pointer to the field.
+    \param swap True for a big-endian dump.
+    \return Field value.
+ */
+static uint32_t read32 (const uint8_t* data, bool swap);
+
+/**
+    \brief Decode and check the dump header.
+    \param data Dump contents.
+    \param length Dump length, in bytes.
+    \param header Pointer to structure where the header is decoded.
+    \return Error message, or null if the dump is usable.
+ */
+static const char* decodeHeader (const uint8_t* data, size_t length,
+                                 DumpHeader* header);
+
+/**
+    \brief Start a JSON event object.
+    \param state Pointer to decoder state.
+    \param phase Chrome trace phase.
+    \param tid Track id.
+    \return None
+ */
+static void beginEvent (DecodeState* state, char phase, int tid);
+
+/**
+    \brief Write a thread name metadata event.
+    \param state Pointer to decoder state.
+    \param tid Track id.
+    \param name Track name.
+    \param index Number appended to the name, or -1 for none.
+    \return None
+ */
+static void nameTrack (DecodeState* state, int tid, const char* name,
+                       int index);
+
+/**
+    \brief Write the JSON events of one trace event.
+    \param state Pointer to decoder state.
+    \param type Event type.
+    \param arg Event argument.
+    \param value Event value.
+    \return None
+ */
+static void decodeEvent (DecodeState* state, uint8_t type, uint8_t arg,
+                         uint16_t value);
+
+/**
+    \brief Write a table name, or the number if out of the table.
+    \param out Output stream.
+    \param table Name table.
+    \param count Entries in the table.
+    \param index Entry to write.
+    \return None
+ */
+static void writeName (FILE* out, const char* const* table, size_t count,
+                       unsigned index);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    static DecodeState state;
+    DumpHeader header;
+    const char* error;
+    const uint8_t* event;
+    uint8_t* data;
+    size_t length;
+    long fileSize;
+    uint32_t count;
+    uint32_t index;
+    uint32_t stamp;
+    FILE* in;
+
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "usage: %s trace.bin [trace.json]\n", argv[0]);
+        return 2;
+    }
+
+    in = fopen(argv[1], "rb");
+
+    if (in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(in, 0, SEEK_END);
+    fileSize = ftell(in);
+    rewind(in);
+
+    data = (fileSize > 0) ? malloc((size_t)fileSize) : NULL;
+
+    if ((data == NULL) ||
+        (fread(data, 1, (size_t)fileSize, in) != (size_t)fileSize)) {
+        fprintf(stderr, "%s: cannot read dump\n", argv[1]);
+        fclose(in);
+        free(data);
+        return 1;
+    }
+
+    fclose(in);
+    length = (size_t)fileSize;
+
+    error = decodeHeader(data, length, &header);
+
+    if (error != NULL) {
+        fprintf(stderr, "%s: %s\n", argv[1], error);
+        free(data);
+        return 1;
+    }
+
+    state.out = (argc == 3) ? fopen(argv[2], "w") : stdout;
+
+    if (state.out == NULL) {
+        perror(argv[2]);
+        free(data);
+        return 1;
+    }
+
+    if (header.frequency == 0u) {
+        fprintf(stderr, "%s: no timer frequency, using counts as us\n",
+                argv[1]);
+        state.scale = 1.0;
+    } else {
+        state.scale = 1000000.0 / (double)header.frequency;
+    }
+
+    state.first = true;
+    state.task = -1;
+
+    fprintf(state.out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    beginEvent(&state, 'M', EVENTS_TID);
+    fprintf(state.out, "\"name\":\"process_name\","
+                       "\"args\":{\"name\":\"PID controller\"}}");
+    nameTrack(&state, EVENTS_TID, "Events", -1);
+
+    /* Oldest to newest; only the last size events are still in the ring. */
+    count = (header.head < header.size) ? header.head : header.size;
+
+    for (index = header.head - count; index != header.head; index++) {
+        event = data + HEADER_SIZE +
+                ((size_t)(index & (header.size - 1u)) * header.eventSize);
+
+        if (event[4] == TRACE_EVENT_NONE) {
+            continue;
+        }
+
+        /* Unsigned differences stay right across a timer wrap. */
+        stamp = read32(event, header.swap);
+
+        if (state.started) {
+            state.time += (uint32_t)(stamp - state.lastStamp);
+        }
+
+        state.lastStamp = stamp;
+        state.started = true;
+
+        decodeEvent(&state, event[4], event[5],
+                    read16(event + 6, header.swap));
+    }
+
+    if (state.task >= 0) {
+        /* Close the slice of the task running at the dump. */
+        beginEvent(&state, 'E', state.task);
+        fprintf(state.out, "\"name\":\"run\"}");
+    }
+
+    fprintf(state.out, "\n]}\n");
+
+    if (state.out != stdout) {
+        fclose(state.out);
+    }
+
+    fprintf(stderr, "%lu of %lu events decoded\n", (unsigned long)count,
+            (unsigned long)header.head);
+
+    free(data);
+
+    return 0;
+}
+
+static uint16_t read16 (const uint8_t* data, bool swap) {
+    return swap ? (uint16_t)((data[0] << 8) | data[1]) :
+                  (uint16_t)((data[1] << 8) | data[0]);
+}
+
+static uint32_t read32 (const uint8_t* data, bool swap) {
+    return swap ? (((uint32_t)read16(data, true) << 16) |
+                   read16(data + 2, true)) :
+                  (((uint32_t)read16(data + 2, false) << 16) |
+                   read16(data, false));
+}
+
+static const char* decodeHeader (const uint8_t* data, size_t length,
+                                 DumpHeader* header) {
+    if (length < HEADER_SIZE) {
+        return "too short for a trace dump";
+    }
+
+    if (read32(data, false) == TRACE_MAGIC) {
+        header->swap = false;
+    } else if (read32(data, true) == TRACE_MAGIC) {
+        header->swap = true;
+    } else {
+        return "not a trace dump, or trace_init() never ran";
+    }
+
+    header->frequency = read32(data + 4, header->swap);
+    header->size      = read16(data + 8, header->swap);
+    header->eventSize = read16(data + 10, header->swap);
+    header->head      = read32(data + 12, header->swap);
+
+    if ((header->size == 0u) || (header->size & (header->size - 1u))) {
+        return "ring size is not a power of two";
+    }
+
+    if (header->eventSize < EVENT_SIZE) {
+        return "events too small";
+    }
+
+    if (length < HEADER_SIZE + ((size_t)header->size * header->eventSize)) {
+        return "dump shorter than the ring";
+    }
+
+    return NULL;
+}
+
+static void beginEvent (DecodeState* state, char phase, int tid) {
+    fprintf(state->out, "%s{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,",
+            state->first ? "" : ",\n", phase, TARGET_PID, tid);
+
+    if (phase != 'M') {
+        fprintf(state->out, "\"ts\":%.3f,",
+                (double)state->time * state->scale);
+    }
+
+    state->first = false;
+}
+
+static void nameTrack (DecodeState* state, int tid, const char* name,
+                       int index) {
+    beginEvent(state, 'M', tid);
+    fprintf(state->out, "\"name\":\"thread_name\",\"args\":{\"name\":\"%s",
+            name);
+
+    if (index >= 0) {
+        fprintf(state->out, "%d", index);
+    }
+
+    fprintf(state->out, "\"}}");
+}
+
+static void decodeEvent (DecodeState* state, uint8_t type, uint8_t arg,
+                         uint16_t value) {
+    FILE* out = state->out;
+
+    switch (type) {
+        case TRACE_EVENT_TASK:
+            if (state->task >= 0) {
+                beginEvent(state, 'E', state->task);
+                fprintf(out, "\"name\":\"run\"}");
+            }
+
+            if (state->taskSeen[arg] == false) {
+                state->taskSeen[arg] = true;
+                nameTrack(state, arg, "Task prio ", arg);
+            }
+
+            state->task = arg;
+            beginEvent(state, 'B', arg);
+            fprintf(out, "\"name\":\"run\"}");
+        break;
+        case TRACE_EVENT_ISR_ENTER:
+            if (state->isrSeen[arg] == false) {
+                state->isrSeen[arg] = true;
+                nameTrack(state, ISR_TID + arg,
+                          (arg < NAMES(isrNames)) ? isrNames[arg] : "ISR ",
+                          (arg < NAMES(isrNames)) ? -1 : arg);
+            }
+
+            state->isrOpen[arg] = true;
+            beginEvent(state, 'B', ISR_TID + arg);
+            fprintf(out, "\"name\":\"isr\"}");
+        break;
+        case TRACE_EVENT_ISR_EXIT:
+            /* An exit without its entry was cut by the ring wrap. */
+            if (state->isrOpen[arg]) {
+                state->isrOpen[arg] = false;
+                beginEvent(state, 'E', ISR_TID + arg);
+                fprintf(out, "\"name\":\"isr\"}");
+            }
+        break;
+        case TRACE_EVENT_SAMPLE:
+            beginEvent(state, 'C', EVENTS_TID);
+            fprintf(out, "\"name\":\"");
+            writeName(out, signalNames, NAMES(signalNames), arg);
+            fprintf(out, "\",\"args\":{\"raw\":%d}}", (int16_t)value);
+        break;
+        case TRACE_EVENT_BUTTON:
+            beginEvent(state, 'i', EVENTS_TID);
+            fprintf(out, "\"s\":\"p\",\"name\":\"SW%u ",
+                    arg & KEY_EVENT_KEY_MASK);
+            writeName(out, keyEventNames, NAMES(keyEventNames),
+                      (arg & KEY_EVENT_TYPE_MASK) >> 4);
+            fprintf(out, "\"}");
+        break;
+        case TRACE_EVENT_MENU:
+            beginEvent(state, 'i', EVENTS_TID);
+            fprintf(out, "\"s\":\"p\",\"name\":\"menu ");
+            writeName(out, menuNames, NAMES(menuNames), arg);
+            fprintf(out, " -> ");
+            writeName(out, menuNames, NAMES(menuNames), value);
+            fprintf(out, "\"}");
+        break;
+        default:
+            beginEvent(state, 'i', EVENTS_TID);
+            fprintf(out, "\"s\":\"p\",\"name\":\"unknown %u\","
+                         "\"args\":{\"arg\":%u,\"value\":%u}}",
+                    type, arg, value);
+        break;
+    }
+}
+
+static void writeName (FILE* out, const char* const* table, size_t count,
+                       unsigned index) {
+    if (index < count) {
+        fprintf(out, "%s", table[index]);
+    } else {
+        fprintf(out, "%u", index);
+    }
+}
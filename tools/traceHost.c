@@ -0,0 +1,465 @@
+/**
+    \file traceHost.c
+    \brief Host test for the event trace ring and its decoder.
+    \details Runs src/trace.c on the development host with a simulated
+             timestamp timer, then dumps the ring and decodes the dump
+             with tools/traceDecode.c:
+             \par
+             - the dump layout: 8 byte events after a 20 byte header;
+             - a short stream of every event type, recorded in order, none
+               while disabled, and decoded to the expected names, values
+               and times;
+             - 5002 events that wrap the ring almost five times and the
+               timer once: the kept slots hold the newest TRACE_SIZE
+               events, and the decoded timeline is monotonic, in 2.5 ms
+               steps across the timer wrap, with balanced slices although
+               the oldest kept event is an ISR exit without its entry;
+             - a byte-swapped dump decodes to the same JSON; a truncated
+               one is rejected;
+             - the cost of recording an event.
+             \par
+             Built and run, with the decoder, by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "hostTest.h"
+#include "cpu_core.h"
+#include "os.h"
+#include "trace.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Events of the long stream; the oldest kept one is an ISR exit whose
+    entry was overwritten. */
+#define LONG_EVENTS (5002u)
+
+/** Timestamp timer frequency of the long stream: 48 MHz. */
+#define LONG_FREQUENCY (48000000ul)
+
+/** Timer counts between events of the long stream: 2.5 ms. */
+#define LONG_STEP (120000ul)
+
+/** Timer count of the long stream before its first event; the timer
+    wraps in the middle of the events kept. */
+#define LONG_START (0xFFFFFFFFul - (4500ul * LONG_STEP))
+
+/** Events of the cost measurement. */
+#define COST_EVENTS (100000000ul)
+
+/** Dump files, in the working directory. */
+#define DUMP_FILE "traceHost.bin"
+#define SWAPPED_FILE "traceHost.swapped.bin"
+#define TRUNCATED_FILE "traceHost.truncated.bin"
+
+/** Track id of the first ISR, as in tools/traceDecode.c. */
+#define ISR_TRACK (1000)
+
+/** Track ids: tasks by priority, then one per ISR. */
+#define TRACKS (ISR_TRACK + 256)
+
+/** Largest decoder output the test keeps. */
+#define JSON_SIZE (1u << 20)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Kernel stand-ins. */
+
+OS_TCB* OSTCBHighRdyPtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Simulated timestamp timer, in counts. */
+static uint32_t hostClock = 0;
+
+/** Task control blocks to switch to. */
+static OS_TCB tasks[3];
+
+/** Decoder program. */
+static const char* decoder = "./traceDecode";
+
+/** Decoder output of the dump. */
+static char json[JSON_SIZE];
+
+/** Decoder output of the byte-swapped dump. */
+static char swappedJson[JSON_SIZE];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Record and decode a short stream of every event type.
+    \return None
+ */
+static void testShort (void);
+
+/**
+    \brief Record and decode a stream that wraps the ring and the timer.
+    \return None
+ */
+static void testLong (void);
+
+/**
+    \brief Time the recording of an event.
+    \return None
+ */
+static void benchRecord (void);
+
+/**
+    \brief Switch to a task, as the kernel switch hook would.
+    \param task Task index.
+    \param priority Task priority.
+    \return None
+ */
+static void switchTask (uint8_t task, OS_PRIO priority);
+
+/**
+    \brief Write the ring to a dump file, optionally byte-swapped or cut.
+    \param name File name.
+    \param swap True to write a big-endian dump.
+    \param length Bytes to write; sizeof(traceBuffer) for all.
+    \return None
+ */
+static void writeDump (const char* name, bool swap, size_t length);
+
+/**
+    \brief Reverse the byte order of a dump field.
+    \param field Pointer to the field.
+    \param size Field size, in bytes.
+    \return None
+ */
+static void reverseBytes (uint8_t* field, uint8_t size);
+
+/**
+    \brief Run the decoder on a dump file.
+    \param name File name.
+    \param out Buffer of JSON_SIZE bytes for the JSON output.
+    \return Decoder exit status.
+ */
+static int decode (const char* name, char* out);
+
+/**
+    \brief Check the decoded timeline: monotonic time in the given steps,
+           slices balanced per track.
+    \param text Decoder output.
+    \param step Expected time step between events, in microseconds.
+    \param last Expected time of the last event, in microseconds.
+    \return True if the timeline is consistent.
+ */
+static bool timelineOk (const char* text, double step, double last);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    if (argc > 1) {
+        decoder = argv[1];
+    }
+
+    HOST_CHECK(sizeof(TraceEvent) == 8u);
+    HOST_CHECK(sizeof(TraceBuffer) == (20u + (8u * TRACE_SIZE)));
+
+    testShort();
+    testLong();
+    benchRecord();
+
+    remove(DUMP_FILE);
+    remove(SWAPPED_FILE);
+    remove(TRUNCATED_FILE);
+
+    return hostTest_exit();
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+    return hostClock;
+}
+
+static void testShort (void) {
+    trace_init(1000000ul);
+
+    hostClock = 100u;
+    switchTask(0u, 2u);
+    hostClock = 150u;
+    TRACE_ISR_ENTER(TRACE_ISR_SW1);
+    hostClock = 160u;
+    TRACE_ISR_EXIT(TRACE_ISR_SW1);
+    hostClock = 200u;
+    TRACE_SAMPLE(0u, 512);
+    TRACE_SAMPLE(2u, -1);
+    hostClock = 250u;
+    TRACE_BUTTON(0x31u);
+    TRACE_MENU(4u, 5u);
+
+    HOST_CHECK(traceBuffer.head == 7u);
+    HOST_CHECK((traceBuffer.event[0].type == TRACE_EVENT_TASK) &&
+               (traceBuffer.event[0].arg == 2u) &&
+               (traceBuffer.event[0].time == 100u));
+    HOST_CHECK((traceBuffer.event[3].type == TRACE_EVENT_SAMPLE) &&
+               (traceBuffer.event[3].value == 512u));
+    HOST_CHECK((traceBuffer.event[6].type == TRACE_EVENT_MENU) &&
+               (traceBuffer.event[6].arg == 4u) &&
+               (traceBuffer.event[6].value == 5u));
+
+    /* Stopped: nothing is recorded. */
+    trace_enable(false);
+    TRACE_SAMPLE(1u, 1);
+    HOST_CHECK(traceBuffer.head == 7u);
+
+    writeDump(DUMP_FILE, false, sizeof(traceBuffer));
+    HOST_CHECK(decode(DUMP_FILE, json) == 0);
+
+    /* 1 MHz timer: counts are microseconds from the first event. */
+    HOST_CHECK(strstr(json, "\"tid\":2,\"ts\":0.000,\"name\":\"run\"") !=
+               NULL);
+    HOST_CHECK(strstr(json, "\"name\":\"SW1 ISR\"") != NULL);
+    HOST_CHECK(strstr(json, "\"ts\":50.000,\"name\":\"isr\"") != NULL);
+    HOST_CHECK(strstr(json, "\"ts\":60.000,\"name\":\"isr\"") != NULL);
+    HOST_CHECK(strstr(json, "\"name\":\"SP\",\"args\":{\"raw\":512}") !=
+               NULL);
+    HOST_CHECK(strstr(json, "\"name\":\"PV\",\"args\":{\"raw\":-1}") !=
+               NULL);
+    HOST_CHECK(strstr(json, "\"name\":\"SW1 repeat\"") != NULL);
+    HOST_CHECK(strstr(json, "\"name\":\"menu SP_VIEW -> SP_EDIT\"") != NULL);
+    HOST_CHECK(strstr(json, "\"OP\"") == NULL);
+    HOST_CHECK(timelineOk(json, 0.0, 150.0));
+
+    trace_enable(true);
+}
+
+static void testLong (void) {
+    const TraceEvent* event;
+    uint32_t oldest;
+    uint32_t newest;
+    uint32_t sequence;
+    uint32_t i;
+    bool kept = true;
+
+    trace_init(LONG_FREQUENCY);
+    hostClock = LONG_START;
+
+    for (i = 0; i < LONG_EVENTS; i++) {
+        hostClock += LONG_STEP;
+
+        switch (i % 4u) {
+            case 0:
+                switchTask((uint8_t)(i % 3u), (OS_PRIO)(2u + (i % 3u)));
+            break;
+            case 1:
+                TRACE_ISR_ENTER(TRACE_ISR_ADC_BLOCK);
+            break;
+            case 2:
+                TRACE_ISR_EXIT(TRACE_ISR_ADC_BLOCK);
+            break;
+            default:
+                TRACE_SAMPLE(2u, (int16_t)(i & 1023u));
+            break;
+        }
+    }
+
+    HOST_CHECK(traceBuffer.head == LONG_EVENTS);
+
+    /* The timer wrapped between the oldest and the newest kept event. */
+    oldest = traceBuffer.event[(LONG_EVENTS - TRACE_SIZE) & TRACE_MASK].time;
+    newest = traceBuffer.event[(LONG_EVENTS - 1u) & TRACE_MASK].time;
+    HOST_CHECK(oldest > newest);
+
+    /* The newest TRACE_SIZE events, each in its slot. */
+    for (i = 0; i < TRACE_SIZE; i++) {
+        sequence = LONG_EVENTS - TRACE_SIZE + i;
+        event = &traceBuffer.event[sequence & TRACE_MASK];
+        kept = kept &&
+               (event->time ==
+                (uint32_t)(LONG_START + ((sequence + 1u) * LONG_STEP)));
+    }
+
+    HOST_CHECK(kept);
+
+    writeDump(DUMP_FILE, false, sizeof(traceBuffer));
+    writeDump(SWAPPED_FILE, true, sizeof(traceBuffer));
+    writeDump(TRUNCATED_FILE, false, 30u);
+
+    HOST_CHECK(decode(DUMP_FILE, json) == 0);
+    HOST_CHECK(timelineOk(json, 2500.0, (TRACE_SIZE - 1u) * 2500.0));
+
+    HOST_CHECK(decode(SWAPPED_FILE, swappedJson) == 0);
+    HOST_CHECK(strcmp(json, swappedJson) == 0);
+
+    HOST_CHECK(decode(TRUNCATED_FILE, swappedJson) != 0);
+
+    printf("%u events, %u kept; timeline %.1f ms\n", LONG_EVENTS,
+           TRACE_SIZE, (TRACE_SIZE - 1u) * 2.5);
+}
+
+static void benchRecord (void) {
+    unsigned long i;
+    double start;
+    double record;
+    double disabled;
+
+    trace_init(LONG_FREQUENCY);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_EVENTS; i++) {
+        hostClock = (uint32_t)i;
+        TRACE_SAMPLE(2u, (int16_t)i);
+    }
+
+    record = (hostTest_now() - start) / (double)COST_EVENTS;
+
+    trace_enable(false);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_EVENTS; i++) {
+        hostClock = (uint32_t)i;
+        TRACE_SAMPLE(2u, (int16_t)i);
+    }
+
+    disabled = (hostTest_now() - start) / (double)COST_EVENTS;
+
+    HOST_CHECK(traceBuffer.head == COST_EVENTS);
+
+    printf("record %.2f ns, disabled %.2f ns (no interrupt masking here)\n",
+           record, disabled);
+}
+
+static void switchTask (uint8_t task, OS_PRIO priority) {
+    tasks[task].Prio = priority;
+    OSTCBHighRdyPtr = &tasks[task];
+    trace_taskSwitchHook();
+}
+
+static void writeDump (const char* name, bool swap, size_t length) {
+    static uint8_t dump[sizeof(TraceBuffer)];
+    uint32_t i;
+    FILE* file;
+
+    memcpy(dump, &traceBuffer, sizeof(dump));
+
+    if (swap) {
+        /* Header fields, then the time and value of each event. */
+        reverseBytes(&dump[0], 4u);
+        reverseBytes(&dump[4], 4u);
+        reverseBytes(&dump[8], 2u);
+        reverseBytes(&dump[10], 2u);
+        reverseBytes(&dump[12], 4u);
+
+        for (i = 0; i < TRACE_SIZE; i++) {
+            reverseBytes(&dump[20u + (i * 8u)], 4u);
+            reverseBytes(&dump[20u + (i * 8u) + 6u], 2u);
+        }
+    }
+
+    file = fopen(name, "wb");
+    HOST_CHECK(file != NULL);
+
+    if (file != NULL) {
+        HOST_CHECK(fwrite(dump, 1, length, file) == length);
+        fclose(file);
+    }
+}
+
+static void reverseBytes (uint8_t* field, uint8_t size) {
+    uint8_t byte;
+    uint8_t i;
+
+    for (i = 0; i < (size / 2u); i++) {
+        byte = field[i];
+        field[i] = field[size - 1u - i];
+        field[size - 1u - i] = byte;
+    }
+}
+
+static int decode (const char* name, char* out) {
+    char command[512];
+    size_t length;
+    FILE* pipe;
+    int status;
+
+    snprintf(command, sizeof(command), "%s %s 2>/dev/null", decoder, name);
+    pipe = popen(command, "r");
+
+    if (pipe == NULL) {
+        return -1;
+    }
+
+    length = fread(out, 1, JSON_SIZE - 1u, pipe);
+    out[length] = '\0';
+    status = pclose(pipe);
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static bool timelineOk (const char* text, double step, double last) {
+    int open[TRACKS] = {0};
+    const char* line;
+    double previous = -1.0;
+    double ts;
+    char phase;
+    int tid;
+    int i;
+
+    for (line = text; line != NULL; line = strchr(line + 1, '\n')) {
+        if (sscanf(line, "\n{\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%lf",
+                   &phase, &tid, &ts) != 3) {
+            continue;
+        }
+
+        if ((tid < 0) || (tid >= TRACKS)) {
+            return false;
+        }
+
+        /* Same time, or one step later; a step of 0 allows any. */
+        if ((previous >= 0.0) && (ts != previous) &&
+            ((ts < previous) || ((step > 0.0) && (ts != previous + step)))) {
+            printf("time %.3f after %.3f\n", ts, previous);
+            return false;
+        }
+
+        previous = ts;
+        open[tid] += (phase == 'B') ? 1 : ((phase == 'E') ? -1 : 0);
+
+        if ((open[tid] < 0) || (open[tid] > 1)) {
+            return false;
+        }
+    }
+
+    /* The decoder closes the running task; an ISR entered just before
+       the dump stays open. */
+    for (i = 0; i < ISR_TRACK; i++) {
+        if (open[i] != 0) {
+            return false;
+        }
+    }
+
+    return previous == last;
+}
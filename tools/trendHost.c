@@ -0,0 +1,315 @@
+/**
+    \file trendHost.c
+    \brief Host test for the PV/SP trend chart.
+    \details Runs src/trend.c on the development host, drawing into a page
+             canvas through the writer callback, with noisy sine PV data
+             and random SP steps beyond full scale:
+             \par
+             - before the chart first fills, trend_redraw() leaves the
+               columns not yet completed blank;
+             - the pixels of each new column against a brute-force min/max
+               of its samples, and the gap column after it blank;
+             - the canvas drawn by trend_render() alone equals
+               trend_redraw(), also after the UI was away for longer than
+               the chart, when only the newest TREND_COLUMNS are drawn;
+             - the page writes of a new column against a full redraw.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "hostTest.h"
+#include "trend.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Columns of the test. */
+#define TEST_COLUMNS (200u)
+
+/** Columns completed while the UI is away. */
+#define AWAY_COLUMNS (TREND_COLUMNS * 2u + 5u)
+
+/** Samples between SP steps. */
+#define SP_STEP_SAMPLES (20000ul)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Canvas drawn by trend_render(): PV and SP bits of each page. */
+static uint8_t canvas[TREND_COLUMNS][TREND_PAGES][2];
+
+/** Canvas drawn by trend_redraw(). */
+static uint8_t reference[TREND_COLUMNS][TREND_PAGES][2];
+
+/** Page writes to the canvas. */
+static unsigned long writes = 0;
+
+/** Samples fed so far. */
+static unsigned long samples = 0;
+
+/** Setpoint of the samples. */
+static int16_t sp = 0;
+
+/** Lowest PV of the column in progress. */
+static int16_t low = INT16_MAX;
+
+/** Highest PV of the column in progress. */
+static int16_t high = INT16_MIN;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Feed samples up to the end of the next column.
+    \return None
+ */
+static void feedColumn (void);
+
+/**
+    \brief Check that the canvas equals a full redraw.
+    \return True if it does.
+ */
+static bool canvasMatchesRedraw (void);
+
+/**
+    \brief Check the pixels of a column against the brute-force values.
+    \param x Column position.
+    \param pvLow Lowest PV sample.
+    \param pvHigh Highest PV sample.
+    \param spLast Setpoint of the last sample.
+    \return True if they match.
+ */
+static bool columnMatches (uint8_t x, int16_t pvLow, int16_t pvHigh,
+                           int16_t spLast);
+
+/**
+    \brief Check that a column is blank on the canvas.
+    \param x Column position.
+    \return True if it is.
+ */
+static bool columnBlank (uint8_t x);
+
+/**
+    \brief Pixel row of a raw value, from the top, by exact rounding.
+    \param raw Raw value.
+    \return Pixel row.
+ */
+static int referenceRow (int16_t raw);
+
+/**
+    \brief Page writer into the canvas.
+    \param x Column position.
+    \param page Page, 0 on top.
+    \param pvBits PV pixels.
+    \param spBits SP pixels.
+    \return None
+ */
+static void canvasWriter (uint8_t x, uint8_t page, uint8_t pvBits,
+                          uint8_t spBits);
+
+/**
+    \brief Page writer into the reference canvas.
+    \param x Column position.
+    \param page Page, 0 on top.
+    \param pvBits PV pixels.
+    \param spBits SP pixels.
+    \return None
+ */
+static void referenceWriter (uint8_t x, uint8_t page, uint8_t pvBits,
+                             uint8_t spBits);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    unsigned long mismatches = 0;
+    unsigned long before;
+    unsigned long incremental;
+    unsigned long full;
+    uint32_t column;
+    uint8_t x;
+
+    srand(5);
+
+    /* Nothing completed: a redraw leaves a blank chart. */
+    memset(canvas, 0xFF, sizeof(canvas));
+    trend_redraw(canvasWriter);
+
+    for (x = 0; x < TREND_COLUMNS; x++) {
+        HOST_CHECK(columnBlank(x));
+    }
+
+    for (column = 0; column < TEST_COLUMNS; column++) {
+        feedColumn();
+        x = (uint8_t)(column % TREND_COLUMNS);
+
+        /* The UI sometimes draws late, two columns at once. */
+        if ((rand() % 3) != 0) {
+            if (trend_render(canvasWriter) == 0u) {
+                mismatches++;
+            }
+
+            mismatches += columnMatches(x, low, high, sp) ? 0u : 1u;
+            mismatches += columnBlank((uint8_t)((column + 1u) %
+                                                TREND_COLUMNS)) ? 0u : 1u;
+            mismatches += canvasMatchesRedraw() ? 0u : 1u;
+        }
+
+        low = INT16_MAX;
+        high = INT16_MIN;
+    }
+
+    (void)trend_render(canvasWriter);
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK(canvasMatchesRedraw());
+
+    /* Away longer than the chart: only the newest columns are drawn. */
+    for (column = 0; column < AWAY_COLUMNS; column++) {
+        feedColumn();
+        low = INT16_MAX;
+        high = INT16_MIN;
+    }
+
+    HOST_CHECK(trend_render(canvasWriter) == TREND_COLUMNS);
+    HOST_CHECK(canvasMatchesRedraw());
+
+    /* Page writes of one new column against a full redraw. */
+    before = writes;
+    feedColumn();
+    (void)trend_render(canvasWriter);
+    incremental = writes - before;
+
+    before = writes;
+    trend_redraw(canvasWriter);
+    full = writes - before;
+
+    printf("%lu columns; page writes per new column %lu, full redraw %lu\n",
+           (unsigned long)(TEST_COLUMNS + AWAY_COLUMNS + 1u), incremental,
+           full);
+
+    HOST_CHECK(incremental == (2u * TREND_PAGES));
+    HOST_CHECK(full == ((TREND_COLUMNS + 1u) * TREND_PAGES));
+
+    return hostTest_exit();
+}
+
+static void feedColumn (void) {
+    int16_t pv;
+    bool completed = false;
+
+    while (!completed) {
+        if ((samples % SP_STEP_SAMPLES) == 0u) {
+            /* Steps reach beyond full scale, to check the clamp. */
+            sp = (int16_t)((rand() % 1100) - 30);
+        }
+
+        pv = (int16_t)(512.0 + (400.0 * sin((double)samples / 3000.0)) +
+                       (double)((rand() % 21) - 10));
+        samples++;
+
+        low = (pv < low) ? pv : low;
+        high = (pv > high) ? pv : high;
+
+        completed = trend_sample(pv, sp);
+    }
+}
+
+static bool canvasMatchesRedraw (void) {
+    uint8_t saved[TREND_COLUMNS][TREND_PAGES][2];
+    bool same;
+
+    /* The redraw marks everything drawn; it adds nothing to draw. */
+    memcpy(saved, canvas, sizeof(saved));
+    memset(reference, 0xFF, sizeof(reference));
+    trend_redraw(referenceWriter);
+    same = (memcmp(reference, saved, sizeof(saved)) == 0);
+
+    return same && (trend_render(canvasWriter) == 0u);
+}
+
+static bool columnMatches (uint8_t x, int16_t pvLow, int16_t pvHigh,
+                           int16_t spLast) {
+    int top = referenceRow(pvHigh);
+    int bottom = referenceRow(pvLow);
+    int spRow = referenceRow(spLast);
+    int row;
+    bool pvBit;
+    bool spBit;
+
+    for (row = 0; row < (int)TREND_HEIGHT; row++) {
+        pvBit = ((canvas[x][row / 8][0] >> (row % 8)) & 1u) != 0u;
+        spBit = ((canvas[x][row / 8][1] >> (row % 8)) & 1u) != 0u;
+
+        if ((pvBit != ((row >= top) && (row <= bottom))) ||
+            (spBit != (row == spRow))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool columnBlank (uint8_t x) {
+    uint8_t page;
+
+    for (page = 0; page < TREND_PAGES; page++) {
+        if ((canvas[x][page][0] != 0u) || (canvas[x][page][1] != 0u)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int referenceRow (int16_t raw) {
+    double clamped = (raw < 0) ? 0.0 :
+                     ((raw > TREND_FULL_SCALE) ? (double)TREND_FULL_SCALE :
+                                                 (double)raw);
+
+    return (int)(TREND_HEIGHT - 1u) -
+           (int)floor((clamped * (double)(TREND_HEIGHT - 1u) /
+                       (double)TREND_FULL_SCALE) + 0.5);
+}
+
+static void canvasWriter (uint8_t x, uint8_t page, uint8_t pvBits,
+                          uint8_t spBits) {
+    HOST_CHECK((x < TREND_COLUMNS) && (page < TREND_PAGES));
+
+    canvas[x][page][0] = pvBits;
+    canvas[x][page][1] = spBits;
+    writes++;
+}
+
+static void referenceWriter (uint8_t x, uint8_t page, uint8_t pvBits,
+                             uint8_t spBits) {
+    HOST_CHECK((x < TREND_COLUMNS) && (page < TREND_PAGES));
+
+    reference[x][page][0] = pvBits;
+    reference[x][page][1] = spBits;
+}
@@ -0,0 +1,293 @@
+/**
+    \file unitsHost.c
+    \brief Host test for the engineering unit conversion.
+    \details Runs src/units.c on the development host against exact
+             rational rounding in 64-bit arithmetic:
+             \par
+             - units_toEu() for every raw value of each range, and three
+               past each end; units_toRaw() for every engineering value
+               of each range, or a thinned-out sweep of wide ones, and
+               three past each end;
+             - a round trip raw to engineering and back where the raw
+               span is at least the engineering span;
+             - the ranges: the signals of app.c, other fixed edge cases,
+               and 3000 random ones up to UNITS_MAX_SPAN_PRODUCT; units_init()
+               accepts exactly the valid ones;
+             - every setpoint percentage of 0 - 100 % survives a round trip;
+             - the cost of a conversion each way.
+             \par
+             Built and run by make -C tools check.
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "hostTest.h"
+#include "units.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Random ranges. */
+#define RANDOM_RANGES (3000u)
+
+/** Engineering spans wider than this are swept in steps. */
+#define SWEEP_LIMIT (200000ll)
+
+/** Conversions of each cost measurement. */
+#define COST_CONVERSIONS (100000000ul)
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Conversions checked. */
+static unsigned long conversions = 0;
+
+/** Conversions that differ from the reference. */
+static unsigned long mismatches = 0;
+
+/** Ranges units_init() judged wrongly. */
+static unsigned long misjudged = 0;
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Check one range.
+    \param rawMin Raw value at the bottom.
+    \param rawMax Raw value at the top.
+    \param euMin Engineering value at the bottom.
+    \param euMax Engineering value at the top.
+    \return None
+ */
+static void checkRange (int16_t rawMin, int16_t rawMax, int32_t euMin,
+                        int32_t euMax);
+
+/**
+    \brief Count a conversion and report it if wrong.
+    \param what Conversion name.
+    \param input Input value.
+    \param got Result.
+    \param want Reference result.
+    \return None
+ */
+static void compare (const char* what, long long input, long long got,
+                     long long want);
+
+/**
+    \brief Time both conversions on the percent range of app.c.
+    \return None
+ */
+static void benchUnits (void);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (void) {
+    UnitsConfig percent = {0, 1023, 0, 100, 0, "%"};
+    UnitsRange range;
+    long long maxEu;
+    long long euSpan;
+    int32_t value;
+    int32_t euMin;
+    int rawMin;
+    int rawMax;
+    unsigned i;
+    bool roundTrips = true;
+
+    /* The signals of app.c and some edges; 524800 is the widest span
+       within UNITS_MAX_SPAN_PRODUCT on 1023 raw steps. */
+    checkRange(0, 1023, 0, 100);
+    checkRange(0, 1023, 0, 1000);
+    checkRange(0, 1023, 0, 10000);
+    checkRange(0, 4095, -400, 1500);
+    checkRange(0, 1023, 0, 330);
+    checkRange(-512, 511, -1000, 1000);
+    checkRange(0, 32767, 0, 16383);
+    checkRange(0, 1, 0, 1);
+    checkRange(0, 1023, 0, 524287);
+    checkRange(0, 1023, 0, 524800);
+    checkRange(0, 32767, -8192, 8191);
+    checkRange(INT16_MIN, INT16_MAX, 0, 8191);
+
+    /* Invalid: one past the span product limit, empty and reversed. */
+    checkRange(0, 1023, 0, 524801);
+    checkRange(0, 1, 0, (int32_t)UNITS_MAX_SPAN_PRODUCT + 1);
+    checkRange(0, 1023, 0, 0);
+    checkRange(100, 100, 0, 10);
+    checkRange(0, 1023, 10, -10);
+
+    srand(1);
+
+    for (i = 0; i < RANDOM_RANGES; i++) {
+        rawMin = (rand() % 2000) - 1000;
+        rawMax = rawMin + 1 + (rand() % (((i % 10u) == 0u) ? 30000 : 2000));
+        rawMax = (rawMax > INT16_MAX) ? INT16_MAX : rawMax;
+        maxEu = (long long)UNITS_MAX_SPAN_PRODUCT / (rawMax - rawMin);
+
+        if (maxEu < 1) {
+            continue;
+        }
+
+        euMin = (rand() % 200000) - 100000;
+
+        /* Half the spans up to the limit, half near the raw span. */
+        if ((i % 2u) != 0u) {
+            euSpan = 1 + (rand() % (rawMax - rawMin + 1));
+        } else {
+            euSpan = 1 + (long long)(((double)rand() / RAND_MAX) *
+                                     (double)(maxEu - 1));
+        }
+
+        checkRange((int16_t)rawMin, (int16_t)rawMax, euMin,
+                   (int32_t)(euMin + euSpan));
+    }
+
+    printf("%lu conversions, %lu mismatches, %lu ranges misjudged\n",
+           conversions, mismatches, misjudged);
+
+    HOST_CHECK(mismatches == 0u);
+    HOST_CHECK(misjudged == 0u);
+
+    /* Every setpoint percentage the operator can enter. */
+    HOST_CHECK(units_init(&range, &percent));
+
+    for (value = 0; value <= 100; value++) {
+        roundTrips = roundTrips &&
+                     (units_toEu(&range, units_toRaw(&range, value)) == value);
+    }
+
+    HOST_CHECK(roundTrips);
+    HOST_CHECK(units_toRaw(&range, 50) == 512);
+
+    benchUnits();
+
+    return hostTest_exit();
+}
+
+static void checkRange (int16_t rawMin, int16_t rawMax, int32_t euMin,
+                        int32_t euMax) {
+    UnitsConfig config;
+    UnitsRange range;
+    long long rawSpan = (long long)rawMax - rawMin;
+    long long euSpan = (long long)euMax - euMin;
+    long long step;
+    long long x;
+    long long d;
+    long long e;
+    int16_t raw;
+    bool valid;
+
+    config.rawMin = rawMin;
+    config.rawMax = rawMax;
+    config.euMin = euMin;
+    config.euMax = euMax;
+    config.decimals = 0;
+    config.unit = "%";
+
+    valid = (rawSpan > 0) && (euSpan > 0) &&
+            ((rawSpan * euSpan) <= (long long)UNITS_MAX_SPAN_PRODUCT);
+
+    if (units_init(&range, &config) != valid) {
+        misjudged++;
+    }
+
+    if (!valid) {
+        return;
+    }
+
+    /* Raw to engineering units: every raw value, clamped outside. */
+    for (x = (long long)rawMin - 3; x <= (long long)rawMax + 3; x++) {
+        if ((x < INT16_MIN) || (x > INT16_MAX)) {
+            continue;
+        }
+
+        d = (x < rawMin) ? 0 : ((x > rawMax) ? rawSpan : (x - rawMin));
+        compare("toEu", x, units_toEu(&range, (int16_t)x),
+                euMin + (((2 * d * euSpan) + rawSpan) / (2 * rawSpan)));
+    }
+
+    /* Engineering units to raw; wide spans in steps, ends in full. */
+    step = (euSpan > SWEEP_LIMIT) ? (euSpan / (SWEEP_LIMIT / 2)) : 1;
+
+    for (e = (long long)euMin - 3; e <= (long long)euMax + 3;
+         e += ((e > (euMin + 2)) && (e < (euMax - 2 - step))) ? step : 1) {
+        d = (e < euMin) ? 0 : ((e > euMax) ? euSpan : (e - euMin));
+        raw = units_toRaw(&range, (int32_t)e);
+        compare("toRaw", e, raw,
+                rawMin + (((2 * d * rawSpan) + euSpan) / (2 * euSpan)));
+
+        /* Fine enough raw steps give every value back. */
+        if ((rawSpan >= euSpan) && (e >= euMin) && (e <= euMax)) {
+            compare("round trip", e, units_toEu(&range, raw), e);
+        }
+    }
+}
+
+static void compare (const char* what, long long input, long long got,
+                     long long want) {
+    conversions++;
+
+    if (got != want) {
+        if (mismatches < 5u) {
+            printf("%s of %lld: got %lld, want %lld\n", what, input, got,
+                   want);
+        }
+
+        mismatches++;
+    }
+}
+
+static void benchUnits (void) {
+    UnitsConfig percent = {0, 1023, 0, 100, 0, "%"};
+    UnitsRange range;
+    volatile int16_t raw;
+    volatile int32_t eu;
+    volatile int32_t sink;
+    unsigned long i;
+    double start;
+    double toEu;
+    double toRaw;
+
+    (void)units_init(&range, &percent);
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CONVERSIONS; i++) {
+        raw = (int16_t)(i & 1023u);
+        sink = units_toEu(&range, raw);
+    }
+
+    toEu = (hostTest_now() - start) / (double)COST_CONVERSIONS;
+    start = hostTest_now();
+
+    for (i = 0; i < COST_CONVERSIONS; i++) {
+        eu = (int32_t)(i % 101u);
+        sink = units_toRaw(&range, eu);
+    }
+
+    toRaw = (hostTest_now() - start) / (double)COST_CONVERSIONS;
+    (void)sink;
+
+    printf("units_toEu %.2f ns, units_toRaw %.2f ns\n", toEu, toRaw);
+}
@@ -0,0 +1,290 @@
+/**
+    \file wcetHost.c
+    \brief Host driver for the execution time measurement harness.
+    \details Runs src/wcet.c against the real controller, units, format,
+             frame buffer and menu sources on the development host, with
+             the stand-in headers of tools/host for the board and kernel.
+             The cases are the ones the target runs; times are in TSC
+             counts on x86 hosts and nanoseconds elsewhere.
+             \par
+             The harness runs HOST_RUNS times; the CSV table of the last
+             run goes to standard output. Given a baseline table from an
+             earlier run, the driver compares the lowest average time of
+             every function over the runs and fails if one grew by more
+             than the tolerance and by more than MIN_GROWTH counts, so a
+             regression in the hot path shows up before flashing. Worst
+             case growth is only reported: host worst cases include
+             preemption by the host OS.
+             \par
+             Built and run by make -C tools check, which leaves the table in
+             tools/build/wcet.csv; to compare against a saved table:
+             \code
+             tools/build/wcetHost baseline.csv
+             \endcode
+    \date Dec 5, 2014
+    \author Luis M. Gallegos C.
+ */
+
+/******************************************************************************
+*                                INCLUDE FILES                                *
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "cpu_core.h"
+#include "os.h"
+#include "platform.h"
+#include "lcd.h"
+#include "S12ADC.h"
+#include "units.h"
+#include "controllerSysControl.h"
+#include "menu.h"
+#include "tickless.h"
+#include "wcet.h"
+
+
+
+/******************************************************************************
+*                                  CONSTANTS                                  *
+******************************************************************************/
+
+/** Harness runs; the first ones also warm the caches. */
+#define HOST_RUNS (8u)
+
+/** Average time growth below this many counts is host timer noise. */
+#define MIN_GROWTH (32u)
+
+/** Default average time growth tolerance, in percent. */
+#define DEFAULT_TOLERANCE (100u)
+
+/** Longest baseline line. */
+#define LINE_SIZE (128u)
+
+
+
+/******************************************************************************
+*                             EXTERNAL VARIABLES                              *
+******************************************************************************/
+
+/* Application state, defined by app.c on the target. */
+
+/** Menu control structure variable. */
+MenuControl menu = {MENU_ON_OFF_VIEW, PID_OFF, PID_MAN, 0, 0};
+
+/** Engineering unit range of each signal; as in app.c. */
+const UnitsConfig signalUnitsConfig[SIGNALS] = {
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_SP */
+    {0, 1023, 0, 100, 0, "%"},      /* SIGNAL_OP */
+    {0, 1023, 0, 100, 0, "%"}       /* SIGNAL_PV */
+};
+
+/** Prepared signal ranges. */
+UnitsRange signalUnits[SIGNALS];
+
+/** PID control structure variable. */
+PIDControl pid = {PID_OFF, PID_MAN, 0, 0, 0, 0, 0, 0};
+
+/* Board and kernel stand-ins. */
+
+volatile uint8_t LED4;
+volatile uint8_t LED7;
+volatile uint8_t LED13;
+
+OS_TCB* OSTCBHighRdyPtr;
+OS_TCB OSIdleTaskTCB;
+OS_CPU_USAGE OSStatTaskCPUUsage;
+OS_CTX_SW_CTR OSTaskCtxSwCtr;
+
+
+
+/******************************************************************************
+*                               LOCAL VARIABLES                               *
+******************************************************************************/
+
+/** Lowest average time of each function over the runs. */
+static unsigned long lowestAverage[WCET_FUNCTIONS];
+
+
+
+/******************************************************************************
+*                          LOCAL FUNCTION PROTOTYPES                          *
+******************************************************************************/
+
+/**
+    \brief Compare the results with a baseline table.
+    \param path Baseline CSV file.
+    \param tolerance Allowed average time growth, in percent.
+    \return Number of regressions, or -1 if the baseline cannot be read.
+ */
+static int compareBaseline (const char* path, unsigned tolerance);
+
+
+
+/******************************************************************************
+*                          FUNCTION IMPLEMENTATIONS                           *
+******************************************************************************/
+
+int main (int argc, char* argv[]) {
+    static char report[WCET_TEXT_SIZE];
+    CPU_ERR err;
+    unsigned tolerance = DEFAULT_TOLERANCE;
+    const WcetResult* result;
+    unsigned long average;
+    uint8_t run;
+    uint8_t i;
+    int regressions;
+
+    if (argc > 3) {
+        fprintf(stderr, "usage: %s [baseline.csv [tolerance%%]]\n", argv[0]);
+        return 2;
+    }
+
+    if (argc == 3) {
+        tolerance = (unsigned)strtoul(argv[2], NULL, 10);
+    }
+
+    initUnits();
+    printMainMenu();
+
+    for (run = 0; run < HOST_RUNS; run++) {
+        wcet_run(CPU_TS_TmrFreqGet(&err));
+
+        for (i = 0; i < WCET_FUNCTIONS; i++) {
+            result = wcet_get(i);
+            average = (result->cases > 0u) ?
+                      (unsigned long)(result->total / result->cases) : 0u;
+
+            if ((run == 0u) || (average < lowestAverage[i])) {
+                lowestAverage[i] = average;
+            }
+        }
+    }
+
+    wcet_format(report);
+    fputs(report, stdout);
+
+    if (argc < 2) {
+        return 0;
+    }
+
+    regressions = compareBaseline(argv[1], tolerance);
+
+    if (regressions < 0) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    return (regressions > 0) ? 1 : 0;
+}
+
+CPU_TS_TMR CPU_TS_TmrRd (void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return (CPU_TS_TMR)__rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (CPU_TS_TMR)((uint32_t)now.tv_sec * 1000000000u +
+                        (uint32_t)now.tv_nsec);
+#endif
+}
+
+CPU_TS_TMR_FREQ CPU_TS_TmrFreqGet (CPU_ERR* p_err) {
+    *p_err = CPU_ERR_NONE;
+
+#if defined(__x86_64__) || defined(__i386__)
+    /* TSC rate unknown. */
+    return 0u;
+#else
+    return 1000000000u;
+#endif
+}
+
+uint32_t tickless_wakeups (void) {
+    return 0u;
+}
+
+void lcd_clear (void) {
+}
+
+void lcd_display (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void lcd_display_inverted (uint16_t position, const uint8_t* string) {
+    (void)position;
+    (void)string;
+}
+
+void pvADC_start (void) {
+}
+
+bool S12ADC_conversion_complete (void) {
+    return true;
+}
+
+uint16_t pvADC_read (void) {
+    return 0u;
+}
+
+static int compareBaseline (const char* path, unsigned tolerance) {
+    char line[LINE_SIZE];
+    char name[LINE_SIZE];
+    unsigned long cases;
+    unsigned long best;
+    unsigned long average;
+    unsigned long worst;
+    const WcetResult* result;
+    int regressions = 0;
+    uint8_t i;
+    FILE* in;
+
+    in = fopen(path, "r");
+
+    if (in == NULL) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (sscanf(line, "%127[^,],%lu,%lu,%lu,%lu", name, &cases, &best,
+                   &average, &worst) != 5) {
+            /* Comment or column header. */
+            continue;
+        }
+
+        for (i = 0; i < WCET_FUNCTIONS; i++) {
+            result = wcet_get(i);
+
+            if (strcmp(result->name, name) != 0) {
+                continue;
+            }
+
+            if (((lowestAverage[i] * 100u) > (average * (100u + tolerance))) &&
+                (lowestAverage[i] > (average + MIN_GROWTH))) {
+                fprintf(stderr, "REGRESSION %s avg %lu -> %lu\n", name,
+                        average, lowestAverage[i]);
+                regressions++;
+            }
+
+            if (result->worst > worst) {
+                fprintf(stderr, "note %s worst %lu -> %lu\n", name, worst,
+                        (unsigned long)result->worst);
+            }
+        }
+    }
+
+    fclose(in);
+
+    return regressions;
+}